@@ -106,15 +106,24 @@ int main ()
   finalSlime.SetPower (1.0 / 32.0);
   finalSlime.SetRoughness (2);
 
-  // Given the slime noise module, create a non-seamless texture map, a
-  // seamless texture map, and a spherical texture map.
+  // Given the slime noise module, create a non-seamless texture map and a
+  // spherical texture map.
   CreatePlanarTexture (finalSlime, false, TEXTURE_HEIGHT,
     "textureplane.bmp");
-  CreatePlanarTexture (finalSlime, true, TEXTURE_HEIGHT,
-    "textureseamless.bmp");
   CreateSphericalTexture (finalSlime, TEXTURE_HEIGHT,
     "texturesphere.bmp");
 
+  // Make each noise module repeat every 2.0 units along the x and z axes,
+  // which is the size of the planar texture map.  The planar texture map
+  // then tiles by itself, so there is no need for the noise map builder to
+  // blend four samples per pixel.
+  largeSlime.SetPeriod (2.0, 0.0, 2.0);
+  smallSlimeBase.SetPeriod (2.0, 0.0, 2.0);
+  slimeMap.SetPeriod (2.0, 0.0, 2.0);
+  finalSlime.SetPeriod (2.0, 0.0, 2.0);
+  CreatePlanarTexture (finalSlime, false, TEXTURE_HEIGHT,
+    "textureseamless.bmp");
+
   return 0;
 }
 
@@ -20,9 +20,36 @@
 // off every 'zig'.)
 //
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#  define NOISEUTILS_HAVE_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
 
 #include <noise/interp.h>
+#include <noise/latlon.h>
 #include <noise/mathconsts.h>
 
 #include "noiseutils.h"
@@ -107,6 +134,203 @@ namespace noise
       return bytes;
     }
 
+    // Allocates a raster buffer of the specified size from an allocator.
+    // The buffer starts on a multiple of RASTER_ALIGNMENT bytes.
+    inline void* AllocRasterBuffer (noise::Allocator* pAllocator,
+      size_t byteCount)
+    {
+      return pAllocator->Allocate (byteCount, RASTER_ALIGNMENT);
+    }
+
+    // Frees a buffer allocated by AllocRasterBuffer().  Does nothing if the
+    // buffer is NULL.
+    inline void FreeRasterBuffer (noise::Allocator* pAllocator,
+      void* pBuffer, size_t byteCount)
+    {
+      if (pBuffer != NULL) {
+        pAllocator->Deallocate (pBuffer, byteCount, RASTER_ALIGNMENT);
+      }
+    }
+
+    // Number of values converted at a time when a noise map stores 16-bit
+    // values.  The buffer of converted values lives on the stack.
+    const int VALUE_CHUNK_SIZE = 256;
+
+    // Converts a value to the 16-bit integer that stands for it in the
+    // FORMAT_UINT16 format.  Values outside the range are clamped to it.
+    inline noise::uint16 QuantizeValue (float value, float scale, float bias)
+    {
+      float q = floorf ((value - bias) / scale + 0.5f);
+      if (!(q > 0.0f)) {
+        // This also catches NaNs.
+        return 0;
+      } else if (q >= 65535.0f) {
+        return 65535;
+      }
+      return (noise::uint16)q;
+    }
+
+    // Readers that convert a pointer to a value stored in a noise map into
+    // a floating-point value, one for each storage format.  Each reader
+    // also returns a pointer to the start of a row.
+    class Float32Reader
+    {
+
+      public:
+
+        typedef float Element;
+
+        const Element* GetSlab (const NoiseMap& noiseMap, noise::int64 y)
+          const
+        {
+          return noiseMap.GetConstSlabPtr (0, y);
+        }
+
+        float operator() (const Element* pValue) const
+        {
+          return *pValue;
+        }
+
+    };
+
+    class UInt16Reader
+    {
+
+      public:
+
+        typedef noise::uint16 Element;
+
+        UInt16Reader (float scale, float bias):
+          m_bias (bias),
+          m_scale (scale)
+        {
+        }
+
+        const Element* GetSlab (const NoiseMap& noiseMap, noise::int64 y)
+          const
+        {
+          return noiseMap.GetConstSlabPtr16 (0, y);
+        }
+
+        float operator() (const Element* pValue) const
+        {
+          return m_bias + m_scale * (float)*pValue;
+        }
+
+      private:
+
+        float m_bias;
+        float m_scale;
+
+    };
+
+    class Float16Reader
+    {
+
+      public:
+
+        typedef noise::uint16 Element;
+
+        const Element* GetSlab (const NoiseMap& noiseMap, noise::int64 y)
+          const
+        {
+          return noiseMap.GetConstSlabPtr16 (0, y);
+        }
+
+        float operator() (const Element* pValue) const
+        {
+          return HalfToFloat (*pValue);
+        }
+
+    };
+
+    // Calls the row callback functions that are set, the 64-bit one last.
+    inline void CallRowCallbacks (NoiseMapCallback pCallback,
+      NoiseMapCallback64 pCallback64, noise::int64 row)
+    {
+      if (pCallback != NULL) {
+        pCallback ((int)row);
+      }
+      if (pCallback64 != NULL) {
+        pCallback64 (row);
+      }
+    }
+
+    // Runs a row method of an object once for each row of a raster.  The
+    // rows are split into contiguous bands, and each band is one part of an
+    // executor task.
+    template <class T>
+    class RowBandTask: public ExecutorTask
+    {
+
+      public:
+
+        RowBandTask (const T& object,
+          void (T::*pRowFunc) (noise::int64) const, noise::int64 rowCount,
+          int bandCount, NoiseMapCallback pCallback,
+          NoiseMapCallback64 pCallback64):
+          m_bandCount (bandCount),
+          m_object (object),
+          m_pCallback (pCallback),
+          m_pCallback64 (pCallback64),
+          m_pRowFunc (pRowFunc),
+          m_rowCount (rowCount)
+        {
+        }
+
+        virtual void Run (int index)
+        {
+          noise::int64 firstRow = (m_rowCount * index) / m_bandCount;
+          noise::int64 lastRow = (m_rowCount * (index + 1)) / m_bandCount;
+          for (noise::int64 y = firstRow; y < lastRow; y++) {
+            (m_object.*m_pRowFunc) (y);
+            if (m_pCallback != NULL || m_pCallback64 != NULL) {
+              std::lock_guard<std::mutex> lock (m_callbackMutex);
+              CallRowCallbacks (m_pCallback, m_pCallback64, y);
+            }
+          }
+        }
+
+      private:
+
+        int m_bandCount;
+        std::mutex m_callbackMutex;
+        const T& m_object;
+        NoiseMapCallback m_pCallback;
+        NoiseMapCallback64 m_pCallback64;
+        void (T::*m_pRowFunc) (noise::int64) const;
+        noise::int64 m_rowCount;
+
+    };
+
+    // Number of row bands submitted to an executor for each part that the
+    // executor can run at once.  More bands than parts lets the executor
+    // balance rows that take longer to compute than others.
+    const int ROW_BANDS_PER_PART = 4;
+
+    // Calls a row method of an object once for each row, either directly on
+    // the calling thread or through an executor.  The callback functions, if
+    // any, are called after each row is complete.
+    template <class T>
+    void RunRows (Executor* pExecutor, const T& object,
+      void (T::*pRowFunc) (noise::int64) const, noise::int64 rowCount,
+      NoiseMapCallback pCallback, NoiseMapCallback64 pCallback64 = NULL)
+    {
+      if (pExecutor == NULL) {
+        for (noise::int64 y = 0; y < rowCount; y++) {
+          (object.*pRowFunc) (y);
+          CallRowCallbacks (pCallback, pCallback64, y);
+        }
+        return;
+      }
+
+      int bandCount = (int)GetMin (rowCount, (noise::int64)(GetMax (
+        pExecutor->GetConcurrency (), 1) * ROW_BANDS_PER_PART));
+      RowBandTask<T> task (object, pRowFunc, rowCount, bandCount, pCallback,
+        pCallback64);
+      pExecutor->Execute (task, bandCount);
+    }
+
   }
 
 }
@@ -116,831 +340,5991 @@ using namespace noise;
 using namespace noise::utils;
 
 //////////////////////////////////////////////////////////////////////////////
-// GradientColor class
+// ThreadPool class
 
-GradientColor::GradientColor ()
+namespace noise
 {
-  m_pGradientPoints = NULL;
-}
 
-GradientColor::~GradientColor ()
-{
-  delete[] m_pGradientPoints;
+  namespace utils
+  {
+
+    // The executor used by builders and renderers that have no executor of
+    // their own.
+    static Executor* g_pDefaultExecutor = NULL;
+
+    // A task submitted to a thread pool through the Execute() method.
+    struct ThreadPoolJob
+    {
+      ExecutorTask* pTask;
+      std::atomic<int> remainingCount;
+      std::mutex doneMutex;
+      std::condition_variable doneCondition;
+      std::exception_ptr pException;
+    };
+
+    // One part of a job, stored in a worker's queue.
+    struct ThreadPoolItem
+    {
+      ThreadPoolJob* pJob;
+      int index;
+    };
+
+    // A worker thread and its queue of parts.  The worker takes parts from
+    // the front of its queue; other workers steal from the back.
+    struct ThreadPoolWorker
+    {
+      std::mutex queueMutex;
+      std::deque<ThreadPoolItem> queue;
+      std::thread thread;
+    };
+
+    class ThreadPoolImpl
+    {
+
+      public:
+
+        explicit ThreadPoolImpl (int threadCount);
+
+        ~ThreadPoolImpl ();
+
+        void Execute (ExecutorTask& task, int partCount);
+
+        int GetConcurrencyLimit () const
+        {
+          return m_concurrencyLimit.load ();
+        }
+
+        int GetThreadCount () const
+        {
+          return (int)m_workers.size ();
+        }
+
+        bool SetAffinity (int workerIndex, int cpu);
+
+        void SetConcurrencyLimit (int limit);
+
+      private:
+
+        // Runs one part and signals its job if it was the last part.
+        void RunItem (const ThreadPoolItem& item);
+
+        // Takes a part from the front of a worker's own queue, or steals one
+        // from the back of another worker's queue.
+        bool TakeItem (int workerIndex, ThreadPoolItem& item);
+
+        // The body of each worker thread.
+        void WorkerMain (int workerIndex);
+
+        // The maximum number of workers that may run parts.
+        std::atomic<int> m_concurrencyLimit;
+
+        // The number of parts queued but not yet taken by a worker.
+        std::atomic<int> m_pendingCount;
+
+        // Index of the next worker to receive parts.
+        std::atomic<unsigned> m_nextWorker;
+
+        // Set when the pool is shutting down.
+        bool m_isStopping;
+
+        // Protects m_isStopping and lets idle workers sleep.
+        std::mutex m_wakeMutex;
+        std::condition_variable m_wakeCondition;
+
+        std::vector<ThreadPoolWorker*> m_workers;
+
+    };
+
+    // The pool that owns the current thread, if the current thread is a
+    // worker thread.
+    static thread_local ThreadPoolImpl* t_pCurrentPool = NULL;
+
+    // The index of the current worker thread within its pool.
+    static thread_local int t_workerIndex = -1;
+
+  }
+
 }
 
-void GradientColor::AddGradientPoint (double gradientPos,
-  const Color& gradientColor)
+ThreadPoolImpl::ThreadPoolImpl (int threadCount):
+  m_concurrencyLimit (threadCount),
+  m_pendingCount (0),
+  m_nextWorker (0),
+  m_isStopping (false)
 {
-  // Find the insertion point for the new gradient point and insert the new
-  // gradient point at that insertion point.  The gradient point array will
-  // remain sorted by gradient position.
-  int insertionPos = FindInsertionPos (gradientPos);
-  InsertAtPos (insertionPos, gradientPos, gradientColor);
+  m_workers.reserve (threadCount);
+  try {
+    for (int i = 0; i < threadCount; i++) {
+      m_workers.push_back (new ThreadPoolWorker);
+    }
+    for (int i = 0; i < threadCount; i++) {
+      m_workers[i]->thread = std::thread (&ThreadPoolImpl::WorkerMain, this,
+        i);
+    }
+  }
+  catch (...) {
+    {
+      std::lock_guard<std::mutex> lock (m_wakeMutex);
+      m_isStopping = true;
+    }
+    m_wakeCondition.notify_all ();
+    for (size_t i = 0; i < m_workers.size (); i++) {
+      if (m_workers[i]->thread.joinable ()) {
+        m_workers[i]->thread.join ();
+      }
+    }
+    for (size_t i = 0; i < m_workers.size (); i++) {
+      delete m_workers[i];
+    }
+    throw noise::ExceptionOutOfMemory ();
+  }
 }
 
-void GradientColor::Clear ()
+ThreadPoolImpl::~ThreadPoolImpl ()
 {
-  delete[] m_pGradientPoints;
-  m_pGradientPoints = NULL;
-  m_gradientPointCount = 0;
+  {
+    std::lock_guard<std::mutex> lock (m_wakeMutex);
+    m_isStopping = true;
+  }
+  m_wakeCondition.notify_all ();
+
+  // Idle workers look into each other's queues, so none of the queues may
+  // be freed until every worker has exited.
+  for (size_t i = 0; i < m_workers.size (); i++) {
+    m_workers[i]->thread.join ();
+  }
+  for (size_t i = 0; i < m_workers.size (); i++) {
+    delete m_workers[i];
+  }
 }
 
-int GradientColor::FindInsertionPos (double gradientPos)
+void ThreadPoolImpl::Execute (ExecutorTask& task, int partCount)
 {
-  int insertionPos;
-  for (insertionPos = 0; insertionPos < m_gradientPointCount;
-    insertionPos++) {
-    if (gradientPos < m_pGradientPoints[insertionPos].pos) {
-      // We found the array index in which to insert the new gradient point.
-      // Exit now.
-      break;
-    } else if (gradientPos == m_pGradientPoints[insertionPos].pos) {
-      // Each gradient point is required to contain a unique gradient
-      // position, so throw an exception.
-      throw noise::ExceptionInvalidParam ();
+  if (partCount <= 0) {
+    return;
+  }
+
+  ThreadPoolJob job;
+  job.pTask = &task;
+  job.remainingCount = partCount;
+
+  // Hand each active worker a contiguous range of parts.  Neighboring parts
+  // usually touch neighboring memory, so a worker that runs its own range in
+  // order has good locality; stealing only happens when a worker runs dry.
+  int activeCount = GetMin (GetConcurrencyLimit (), GetThreadCount ());
+  int firstWorker = (int)(m_nextWorker++ % (unsigned)activeCount);
+  for (int w = 0; w < activeCount; w++) {
+    int firstIndex = (int)(((long long)partCount * w) / activeCount);
+    int lastIndex = (int)(((long long)partCount * (w + 1)) / activeCount);
+    if (firstIndex == lastIndex) {
+      continue;
+    }
+    ThreadPoolWorker* pWorker = m_workers[(firstWorker + w) % activeCount];
+    std::lock_guard<std::mutex> lock (pWorker->queueMutex);
+    for (int i = firstIndex; i < lastIndex; i++) {
+      ThreadPoolItem item;
+      item.pJob = &job;
+      item.index = i;
+      pWorker->queue.push_back (item);
     }
   }
-  return insertionPos;
+  {
+    std::lock_guard<std::mutex> lock (m_wakeMutex);
+    m_pendingCount += partCount;
+  }
+  m_wakeCondition.notify_all ();
+
+  if (t_pCurrentPool == this) {
+    // A worker thread submitted this job.  Sleeping here could leave no
+    // worker to run the parts, so help out until the job is complete.
+    ThreadPoolItem item;
+    while (job.remainingCount.load () > 0) {
+      if (TakeItem (t_workerIndex, item)) {
+        RunItem (item);
+      } else {
+        std::this_thread::yield ();
+      }
+    }
+  }
+  std::unique_lock<std::mutex> lock (job.doneMutex);
+  while (job.remainingCount.load () > 0) {
+    job.doneCondition.wait (lock);
+  }
+  lock.unlock ();
+
+  if (job.pException) {
+    std::rethrow_exception (job.pException);
+  }
 }
 
-const Color& GradientColor::GetColor (double gradientPos) const
+void ThreadPoolImpl::RunItem (const ThreadPoolItem& item)
 {
-  assert (m_gradientPointCount >= 2);
-
-  // Find the first element in the gradient point array that has a gradient
-  // position larger than the gradient position passed to this method.
-  int indexPos;
-  for (indexPos = 0; indexPos < m_gradientPointCount; indexPos++) {
-    if (gradientPos < m_pGradientPoints[indexPos].pos) {
-      break;
+  ThreadPoolJob* pJob = item.pJob;
+  try {
+    pJob->pTask->Run (item.index);
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock (pJob->doneMutex);
+    if (!pJob->pException) {
+      pJob->pException = std::current_exception ();
     }
   }
 
-  // Find the two nearest gradient points so that we can perform linear
-  // interpolation on the color.
-  int index0 = ClampValue (indexPos - 1, 0, m_gradientPointCount - 1);
-  int index1 = ClampValue (indexPos    , 0, m_gradientPointCount - 1);
+  // The job lives on the stack of the thread that submitted it, and that
+  // thread may return as soon as the count reaches zero.  Decrement the
+  // count while holding the lock so that the job outlives this access.
+  std::lock_guard<std::mutex> lock (pJob->doneMutex);
+  if (--pJob->remainingCount == 0) {
+    pJob->doneCondition.notify_all ();
+  }
+}
 
-  // If some gradient points are missing (which occurs if the gradient
-  // position passed to this method is greater than the largest gradient
-  // position or less than the smallest gradient position in the array), get
-  // the corresponding gradient color of the nearest gradient point and exit
-  // now.
-  if (index0 == index1) {
-    m_workingColor = m_pGradientPoints[index1].color;
-    return m_workingColor;
+bool ThreadPoolImpl::SetAffinity (int workerIndex, int cpu)
+{
+  if (workerIndex < 0 || workerIndex >= GetThreadCount ()) {
+    throw noise::ExceptionInvalidParam ();
   }
-  
-  // Compute the alpha value used for linear interpolation.
-  double input0 = m_pGradientPoints[index0].pos;
-  double input1 = m_pGradientPoints[index1].pos;
-  double alpha = (gradientPos - input0) / (input1 - input0);
+  if (cpu < 0) {
+    return false;
+  }
+#if defined(_WIN32)
+  if (cpu >= (int)(sizeof (DWORD_PTR) * 8)) {
+    return false;
+  }
+  HANDLE hThread = (HANDLE)m_workers[workerIndex]->thread.native_handle ();
+  return SetThreadAffinityMask (hThread, (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpuSet;
+  CPU_ZERO (&cpuSet);
+  CPU_SET (cpu, &cpuSet);
+  return pthread_setaffinity_np (m_workers[workerIndex]->thread.native_handle
+    (), sizeof (cpuSet), &cpuSet) == 0;
+#else
+  return false;
+#endif
+}
 
-  // Now perform the linear interpolation given the alpha value.
-  const Color& color0 = m_pGradientPoints[index0].color;
-  const Color& color1 = m_pGradientPoints[index1].color;
-  LinearInterpColor (color0, color1, (float)alpha, m_workingColor);
-  return m_workingColor;
+void ThreadPoolImpl::SetConcurrencyLimit (int limit)
+{
+  {
+    std::lock_guard<std::mutex> lock (m_wakeMutex);
+    m_concurrencyLimit = ClampValue (limit, 1, GetThreadCount ());
+  }
+  m_wakeCondition.notify_all ();
 }
 
-void GradientColor::InsertAtPos (int insertionPos, double gradientPos,
-  const Color& gradientColor)
+bool ThreadPoolImpl::TakeItem (int workerIndex, ThreadPoolItem& item)
 {
-  // Make room for the new gradient point at the specified insertion position
-  // within the gradient point array.  The insertion position is determined by
-  // the gradient point's position; the gradient points must be sorted by
-  // gradient position within that array.
-  GradientPoint* newGradientPoints;
-  newGradientPoints = new GradientPoint[m_gradientPointCount + 1];
-  for (int i = 0; i < m_gradientPointCount; i++) {
-    if (i < insertionPos) {
-      newGradientPoints[i] = m_pGradientPoints[i];
-    } else {
-      newGradientPoints[i + 1] = m_pGradientPoints[i];
+  int workerCount = GetThreadCount ();
+  if (workerIndex >= 0) {
+    ThreadPoolWorker* pWorker = m_workers[workerIndex];
+    std::lock_guard<std::mutex> lock (pWorker->queueMutex);
+    if (!pWorker->queue.empty ()) {
+      item = pWorker->queue.front ();
+      pWorker->queue.pop_front ();
+      --m_pendingCount;
+      return true;
     }
   }
-  delete[] m_pGradientPoints;
-  m_pGradientPoints = newGradientPoints;
-  ++m_gradientPointCount;
 
-  // Now that we've made room for the new gradient point within the array, add
-  // the new gradient point.
-  m_pGradientPoints[insertionPos].pos = gradientPos ;
-  m_pGradientPoints[insertionPos].color = gradientColor;
+  // Our own queue is empty, so steal from the back of another queue.  Parts
+  // may be left in the queue of a worker that is now above the concurrency
+  // limit; they are stolen the same way.
+  for (int i = 1; i <= workerCount; i++) {
+    int victimIndex = (workerIndex + i + workerCount) % workerCount;
+    if (victimIndex == workerIndex) {
+      continue;
+    }
+    ThreadPoolWorker* pVictim = m_workers[victimIndex];
+    std::lock_guard<std::mutex> lock (pVictim->queueMutex);
+    if (!pVictim->queue.empty ()) {
+      item = pVictim->queue.back ();
+      pVictim->queue.pop_back ();
+      --m_pendingCount;
+      return true;
+    }
+  }
+  return false;
 }
 
-//////////////////////////////////////////////////////////////////////////////
-// NoiseMap class
+void ThreadPoolImpl::WorkerMain (int workerIndex)
+{
+  t_pCurrentPool = this;
+  t_workerIndex  = workerIndex;
+
+  for (;;) {
+    ThreadPoolItem item;
+    if (workerIndex < GetConcurrencyLimit ()
+      && TakeItem (workerIndex, item)) {
+      RunItem (item);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock (m_wakeMutex);
+    while (!m_isStopping && !(workerIndex < GetConcurrencyLimit ()
+      && m_pendingCount.load () > 0)) {
+      m_wakeCondition.wait (lock);
+    }
+    if (m_isStopping) {
+      break;
+    }
+  }
+}
 
-NoiseMap::NoiseMap ()
+ThreadPool::ThreadPool (int threadCount):
+  m_pImpl (NULL)
 {
-  InitObj ();
+  if (threadCount < 0) {
+    throw noise::ExceptionInvalidParam ();
+  } else if (threadCount == 0) {
+    threadCount = GetMax ((int)std::thread::hardware_concurrency (), 1);
+  }
+  try {
+    m_pImpl = new ThreadPoolImpl (threadCount);
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
 }
 
-NoiseMap::NoiseMap (int width, int height)
+ThreadPool::~ThreadPool ()
 {
-  InitObj ();
-  SetSize (width, height);
+  delete m_pImpl;
 }
 
-NoiseMap::NoiseMap (const NoiseMap& rhs)
+void ThreadPool::Execute (ExecutorTask& task, int partCount)
 {
-  InitObj ();
-  CopyNoiseMap (rhs);
+  m_pImpl->Execute (task, partCount);
 }
 
-NoiseMap::~NoiseMap ()
+int ThreadPool::GetConcurrencyLimit () const
 {
-  delete[] m_pNoiseMap;
+  return m_pImpl->GetConcurrencyLimit ();
 }
 
-NoiseMap& NoiseMap::operator= (const NoiseMap& rhs)
+int ThreadPool::GetThreadCount () const
 {
-  CopyNoiseMap (rhs);
+  return m_pImpl->GetThreadCount ();
+}
 
-  return *this;
+bool ThreadPool::SetAffinity (int workerIndex, int cpu)
+{
+  return m_pImpl->SetAffinity (workerIndex, cpu);
 }
 
-void NoiseMap::Clear (float value)
+void ThreadPool::SetConcurrencyLimit (int limit)
 {
-  if (m_pNoiseMap != NULL) {
-    for (int y = 0; y < m_height; y++) {
-      float* pDest = GetSlabPtr (0, y);
-      for (int x = 0; x < m_width; x++) {
-        *pDest++ = value;
-      }
-    }
-  }
+  m_pImpl->SetConcurrencyLimit (limit);
 }
 
-void NoiseMap::CopyNoiseMap (const NoiseMap& source)
+Executor* noise::utils::GetDefaultExecutor ()
 {
-  // Resize the noise map buffer, then copy the slabs from the source noise
-  // map buffer to this noise map buffer.
-  SetSize (source.GetWidth (), source.GetHeight ());
-  for (int y = 0; y < source.GetHeight (); y++) {
-    const float* pSource = source.GetConstSlabPtr (0, y);
-    float* pDest = GetSlabPtr (0, y);
-    memcpy (pDest, pSource, (size_t)source.GetWidth () * sizeof (float));
-  }
+  return g_pDefaultExecutor;
+}
 
-  // Copy the border value as well.
-  m_borderValue = source.m_borderValue;
+void noise::utils::SetDefaultExecutor (Executor* pExecutor)
+{
+  g_pDefaultExecutor = pExecutor;
 }
 
-void NoiseMap::DeleteNoiseMapAndReset ()
+//////////////////////////////////////////////////////////////////////////////
+// RasterBufferPool class
+
+namespace noise
 {
-  delete[] m_pNoiseMap;
-  InitObj ();
+
+  namespace utils
+  {
+
+    // The smallest size class holds 2^RASTER_POOL_MIN_SHIFT bytes.  Free
+    // buffers store the link to the next free buffer in their first bytes,
+    // so the smallest class must hold a pointer.
+    const int RASTER_POOL_MIN_SHIFT = 6;
+
+    // The number of size classes for each power of two.
+    const int RASTER_POOL_CLASSES_PER_OCTAVE = 4;
+
+    // The number of size classes.  The largest class holds a quarter of the
+    // address space, which is more than any buffer that can be allocated.
+    const int RASTER_POOL_CLASS_COUNT = ((int)sizeof (size_t) * 8 - 2
+      - RASTER_POOL_MIN_SHIFT) * RASTER_POOL_CLASSES_PER_OCTAVE + 1;
+
+    class RasterBufferPoolImpl
+    {
+
+      public:
+
+        RasterBufferPoolImpl (size_t maxCachedBytes,
+          noise::Allocator* pUpstream);
+
+        ~RasterBufferPoolImpl ();
+
+        void* Allocate (size_t byteCount, size_t alignment);
+
+        void Deallocate (void* pMemory, size_t byteCount, size_t alignment);
+
+        size_t GetMaxCachedBytes () const
+        {
+          std::lock_guard<std::mutex> lock (m_mutex);
+          return m_maxCachedBytes;
+        }
+
+        void GetStats (RasterBufferPoolStats& stats) const
+        {
+          std::lock_guard<std::mutex> lock (m_mutex);
+          stats = m_stats;
+        }
+
+        noise::Allocator* GetUpstream () const
+        {
+          return m_pUpstream;
+        }
+
+        void ResetStats ();
+
+        void SetMaxCachedBytes (size_t maxCachedBytes);
+
+        void Trim (size_t maxCachedBytes);
+
+      private:
+
+        // Returns the index of the smallest size class that holds the
+        // specified number of bytes, or -1 if no size class does.
+        static int GetClassIndex (size_t byteCount);
+
+        // Returns the number of bytes held by a size class.
+        static size_t GetClassSize (int classIndex);
+
+        // Releases cached buffers until no more than the specified number of
+        // bytes are cached.  The mutex must be locked.
+        void TrimLocked (size_t maxCachedBytes);
+
+        // The maximum number of bytes cached.
+        size_t m_maxCachedBytes;
+
+        // Protects the free lists and the statistics.
+        mutable std::mutex m_mutex;
+
+        // The first free buffer of each size class, or NULL.
+        void* m_pFreeList[RASTER_POOL_CLASS_COUNT];
+
+        // The allocator that buffers come from.
+        noise::Allocator* m_pUpstream;
+
+        // The statistics of the pool.
+        RasterBufferPoolStats m_stats;
+
+    };
+
+  }
+
 }
 
-float NoiseMap::GetValue (int x, int y) const
+RasterBufferPoolImpl::RasterBufferPoolImpl (size_t maxCachedBytes,
+  noise::Allocator* pUpstream):
+  m_maxCachedBytes (maxCachedBytes),
+  m_pUpstream (pUpstream)
 {
-  if (m_pNoiseMap != NULL) {
-    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
-      return *(GetConstSlabPtr (x, y));
-    }
+  for (int i = 0; i < RASTER_POOL_CLASS_COUNT; i++) {
+    m_pFreeList[i] = NULL;
   }
-  // The coordinates specified are outside the noise map.  Return the border
-  // value.
-  return m_borderValue;
+  memset (&m_stats, 0, sizeof (m_stats));
 }
 
-void NoiseMap::InitObj ()
+RasterBufferPoolImpl::~RasterBufferPoolImpl ()
 {
-  m_pNoiseMap = NULL;
-  m_height    = 0;
-  m_width     = 0;
-  m_stride    = 0;
-  m_memUsed   = 0;
-  m_borderValue = 0.0;
+  assert (m_stats.bytesInUse == 0);
+  TrimLocked (0);
 }
 
-void NoiseMap::ReclaimMem ()
+void* RasterBufferPoolImpl::Allocate (size_t byteCount, size_t alignment)
 {
-  size_t newMemUsage = CalcMinMemUsage (m_width, m_height);
-  if (m_memUsed > newMemUsage) {
-    // There is wasted memory.  Create the smallest buffer that can fit the
-    // data and copy the data to it.
-    float* pNewNoiseMap = NULL;
-    try {
-      pNewNoiseMap = new float[newMemUsage];
-    }
-    catch (...) {
-      throw noise::ExceptionOutOfMemory ();
+  int classIndex = GetClassIndex (byteCount);
+  if (classIndex < 0 || alignment > RASTER_ALIGNMENT) {
+    // This buffer cannot be pooled.
+    void* pMemory = m_pUpstream->Allocate (byteCount, alignment);
+    std::lock_guard<std::mutex> lock (m_mutex);
+    ++m_stats.allocCount;
+    ++m_stats.upstreamAllocCount;
+    m_stats.bytesInUse += byteCount;
+    m_stats.peakBytesInUse = GetMax (m_stats.peakBytesInUse,
+      m_stats.bytesInUse);
+    return pMemory;
+  }
+
+  size_t classSize = GetClassSize (classIndex);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    ++m_stats.allocCount;
+    m_stats.bytesInUse += classSize;
+    m_stats.peakBytesInUse = GetMax (m_stats.peakBytesInUse,
+      m_stats.bytesInUse);
+    void* pMemory = m_pFreeList[classIndex];
+    if (pMemory != NULL) {
+      m_pFreeList[classIndex] = *(void**)pMemory;
+      ++m_stats.hitCount;
+      m_stats.bytesCached -= classSize;
+      --m_stats.cachedBufferCount;
+      return pMemory;
     }
-    memcpy (pNewNoiseMap, m_pNoiseMap, newMemUsage * sizeof (float));
-    delete[] m_pNoiseMap;
-    m_pNoiseMap = pNewNoiseMap;
-    m_memUsed = newMemUsage;
+    ++m_stats.upstreamAllocCount;
+  }
+
+  // The cache is empty.  Allocate the buffer without holding the lock.
+  try {
+    return m_pUpstream->Allocate (classSize, RASTER_ALIGNMENT);
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stats.bytesInUse -= classSize;
+    throw;
   }
 }
 
-void NoiseMap::SetSize (int width, int height)
+void RasterBufferPoolImpl::Deallocate (void* pMemory, size_t byteCount,
+  size_t alignment)
 {
-  if (width < 0 || height < 0
-    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT) {
-    // Invalid width or height.
-    throw noise::ExceptionInvalidParam ();
-  } else if (width == 0 || height == 0) {
-    // An empty noise map was specified.  Delete it and zero out the size
-    // member variables.
-    DeleteNoiseMapAndReset ();
-  } else {
-    // A new noise map size was specified.  Allocate a new noise map buffer
-    // unless the current buffer is large enough for the new noise map (we
-    // don't want costly reallocations going on.)
-    size_t newMemUsage = CalcMinMemUsage (width, height);
-    if (m_memUsed < newMemUsage) {
-      // The new size is too big for the current noise map buffer.  We need to
-      // reallocate.
-      DeleteNoiseMapAndReset ();
-      try {
-        m_pNoiseMap = new float[newMemUsage];
-      }
-      catch (...) {
-        throw noise::ExceptionOutOfMemory ();
-      }
-      m_memUsed = newMemUsage;
+  int classIndex = GetClassIndex (byteCount);
+  if (classIndex < 0 || alignment > RASTER_ALIGNMENT) {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      ++m_stats.upstreamFreeCount;
+      m_stats.bytesInUse -= byteCount;
     }
-    m_stride = (int)CalcStride (width);
-    m_width  = width;
-    m_height = height;
+    m_pUpstream->Deallocate (pMemory, byteCount, alignment);
+    return;
   }
-}
 
-void NoiseMap::SetValue (int x, int y, float value)
-{
-  if (m_pNoiseMap != NULL) {
-    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
-      *(GetSlabPtr (x, y)) = value;
+  size_t classSize = GetClassSize (classIndex);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stats.bytesInUse -= classSize;
+    if (m_stats.bytesCached + classSize <= m_maxCachedBytes
+      && m_stats.bytesCached + classSize > m_stats.bytesCached) {
+      // Keep the buffer for the next request of this size class.
+      *(void**)pMemory = m_pFreeList[classIndex];
+      m_pFreeList[classIndex] = pMemory;
+      m_stats.bytesCached += classSize;
+      ++m_stats.cachedBufferCount;
+      return;
     }
+    ++m_stats.upstreamFreeCount;
   }
+  m_pUpstream->Deallocate (pMemory, classSize, RASTER_ALIGNMENT);
 }
 
-void NoiseMap::TakeOwnership (NoiseMap& source)
+int RasterBufferPoolImpl::GetClassIndex (size_t byteCount)
 {
-  // Copy the values and the noise map buffer from the source noise map to
-  // this noise map.  Now this noise map pwnz the source buffer.
-  delete[] m_pNoiseMap;
-  m_memUsed   = source.m_memUsed;
-  m_height    = source.m_height;
-  m_pNoiseMap = source.m_pNoiseMap;
-  m_stride    = source.m_stride;
-  m_width     = source.m_width;
-
-  // Now that the source buffer is assigned to this noise map, reset the
-  // source noise map object.
-  source.InitObj ();
-}
-
-//////////////////////////////////////////////////////////////////////////////
-// Image class
+  if (byteCount <= ((size_t)1 << RASTER_POOL_MIN_SHIFT)) {
+    return 0;
+  }
 
-Image::Image ()
-{
-  InitObj ();
+  // Find the power of two at or below the size, then the smallest of its
+  // quarter steps that holds the size.
+  int shift = RASTER_POOL_MIN_SHIFT;
+  while (shift < (int)sizeof (size_t) * 8 - 1
+    && (byteCount >> (shift + 1)) != 0) {
+    ++shift;
+  }
+  size_t octaveSize = (size_t)1 << shift;
+  size_t stepSize = octaveSize / RASTER_POOL_CLASSES_PER_OCTAVE;
+  size_t stepCount = (byteCount - octaveSize + stepSize - 1) / stepSize;
+  int classIndex = (shift - RASTER_POOL_MIN_SHIFT)
+    * RASTER_POOL_CLASSES_PER_OCTAVE + (int)stepCount;
+  return (classIndex < RASTER_POOL_CLASS_COUNT)? classIndex: -1;
 }
 
-Image::Image (int width, int height)
+size_t RasterBufferPoolImpl::GetClassSize (int classIndex)
 {
-  InitObj ();
-  SetSize (width, height);
+  size_t octaveSize = (size_t)1 << (classIndex
+    / RASTER_POOL_CLASSES_PER_OCTAVE + RASTER_POOL_MIN_SHIFT);
+  size_t stepSize = octaveSize / RASTER_POOL_CLASSES_PER_OCTAVE;
+  return octaveSize
+    + stepSize * (size_t)(classIndex % RASTER_POOL_CLASSES_PER_OCTAVE);
 }
 
-Image::Image (const Image& rhs)
+void RasterBufferPoolImpl::ResetStats ()
 {
-  InitObj ();
-  CopyImage (rhs);
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_stats.allocCount         = 0;
+  m_stats.hitCount           = 0;
+  m_stats.upstreamAllocCount = 0;
+  m_stats.upstreamFreeCount  = 0;
+  m_stats.peakBytesInUse     = m_stats.bytesInUse;
 }
 
-Image::~Image ()
+void RasterBufferPoolImpl::SetMaxCachedBytes (size_t maxCachedBytes)
 {
-  delete[] m_pImage;
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_maxCachedBytes = maxCachedBytes;
+  TrimLocked (maxCachedBytes);
 }
 
-Image& Image::operator= (const Image& rhs)
+void RasterBufferPoolImpl::Trim (size_t maxCachedBytes)
 {
-  CopyImage (rhs);
-
-  return *this;
+  std::lock_guard<std::mutex> lock (m_mutex);
+  TrimLocked (maxCachedBytes);
 }
 
-void Image::Clear (const Color& value)
+void RasterBufferPoolImpl::TrimLocked (size_t maxCachedBytes)
 {
-  if (m_pImage != NULL) {
-    for (int y = 0; y < m_height; y++) {
-      Color* pDest = GetSlabPtr (0, y);
-      for (int x = 0; x < m_width; x++) {
-        *pDest++ = value;
-      }
+  // Release the largest buffers first; they free the most memory for the
+  // fewest calls to the upstream allocator.
+  for (int i = RASTER_POOL_CLASS_COUNT - 1;
+    i >= 0 && m_stats.bytesCached > maxCachedBytes; i--) {
+    size_t classSize = GetClassSize (i);
+    while (m_pFreeList[i] != NULL && m_stats.bytesCached > maxCachedBytes) {
+      void* pMemory = m_pFreeList[i];
+      m_pFreeList[i] = *(void**)pMemory;
+      m_stats.bytesCached -= classSize;
+      --m_stats.cachedBufferCount;
+      ++m_stats.upstreamFreeCount;
+      m_pUpstream->Deallocate (pMemory, classSize, RASTER_ALIGNMENT);
     }
   }
 }
 
-void Image::CopyImage (const Image& source)
+RasterBufferPool::RasterBufferPool (size_t maxCachedBytes,
+  noise::Allocator* pUpstream):
+  m_pImpl (NULL)
 {
-  // Resize the image buffer, then copy the slabs from the source image
-  // buffer to this image buffer.
-  SetSize (source.GetWidth (), source.GetHeight ());
-  for (int y = 0; y < source.GetHeight (); y++) {
-    const Color* pSource = source.GetConstSlabPtr (0, y);
-    Color* pDest = GetSlabPtr (0, y);
-    memcpy (pDest, pSource, (size_t)source.GetWidth () * sizeof (float));
+  if (pUpstream == NULL) {
+    pUpstream = noise::GetDefaultAllocator ();
+  }
+  try {
+    m_pImpl = new RasterBufferPoolImpl (maxCachedBytes, pUpstream);
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
   }
+}
 
-  // Copy the border value as well.
-  m_borderValue = source.m_borderValue;
+RasterBufferPool::~RasterBufferPool ()
+{
+  delete m_pImpl;
 }
 
-void Image::DeleteImageAndReset ()
+void* RasterBufferPool::Allocate (size_t byteCount, size_t alignment)
 {
-  delete[] m_pImage;
-  InitObj ();
+  return m_pImpl->Allocate (byteCount, alignment);
 }
 
-Color Image::GetValue (int x, int y) const
+void RasterBufferPool::Deallocate (void* pMemory, size_t byteCount,
+  size_t alignment)
 {
-  if (m_pImage != NULL) {
-    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
-      return *(GetConstSlabPtr (x, y));
-    }
-  }
-  // The coordinates specified are outside the image.  Return the border
-  // value.
-  return m_borderValue;
+  m_pImpl->Deallocate (pMemory, byteCount, alignment);
 }
 
-void Image::InitObj ()
+size_t RasterBufferPool::GetMaxCachedBytes () const
 {
-  m_pImage  = NULL;
-  m_height  = 0;
-  m_width   = 0;
-  m_stride  = 0;
-  m_memUsed = 0;
-  m_borderValue = Color (0, 0, 0, 0);
+  return m_pImpl->GetMaxCachedBytes ();
 }
 
-void Image::ReclaimMem ()
+void RasterBufferPool::GetStats (RasterBufferPoolStats& stats) const
 {
-  size_t newMemUsage = CalcMinMemUsage (m_width, m_height);
-  if (m_memUsed > newMemUsage) {
-    // There is wasted memory.  Create the smallest buffer that can fit the
-    // data and copy the data to it.
-    Color* pNewImage = NULL;
-    try {
-      pNewImage = new Color[newMemUsage];
-    }
-    catch (...) {
-      throw noise::ExceptionOutOfMemory ();
-    }
-    memcpy (pNewImage, m_pImage, newMemUsage * sizeof (float));
-    delete[] m_pImage;
-    m_pImage = pNewImage;
-    m_memUsed = newMemUsage;
-  }
+  m_pImpl->GetStats (stats);
 }
 
-void Image::SetSize (int width, int height)
+noise::Allocator* RasterBufferPool::GetUpstream () const
 {
-  if (width < 0 || height < 0
-    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT) {
-    // Invalid width or height.
-    throw noise::ExceptionInvalidParam ();
-  } else if (width == 0 || height == 0) {
-    // An empty image was specified.  Delete it and zero out the size member
-    // variables.
-    DeleteImageAndReset ();
-  } else {
-    // A new image size was specified.  Allocate a new image buffer unless
-    // the current buffer is large enough for the new image (we don't want
-    // costly reallocations going on.)
-    size_t newMemUsage = CalcMinMemUsage (width, height);
-    if (m_memUsed < newMemUsage) {
-      // The new size is too big for the current image buffer.  We need to
-      // reallocate.
-      DeleteImageAndReset ();
-      try {
-        m_pImage = new Color[newMemUsage];
-      }
-      catch (...) {
-        throw noise::ExceptionOutOfMemory ();
-      }
-      m_memUsed = newMemUsage;
-    }
-    m_stride = (int)CalcStride (width);
-    m_width  = width;
-    m_height = height;
-  }
+  return m_pImpl->GetUpstream ();
 }
 
-void Image::SetValue (int x, int y, const Color& value)
+void RasterBufferPool::ResetStats ()
 {
-  if (m_pImage != NULL) {
-    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
-      *(GetSlabPtr (x, y)) = value;
-    }
-  }
+  m_pImpl->ResetStats ();
 }
 
-void Image::TakeOwnership (Image& source)
+void RasterBufferPool::SetMaxCachedBytes (size_t maxCachedBytes)
 {
-  // Copy the values and the image buffer from the source image to this image.
-  // Now this image pwnz the source buffer.
-  delete[] m_pImage;
-  m_memUsed = source.m_memUsed;
-  m_height  = source.m_height;
-  m_pImage  = source.m_pImage;
-  m_stride  = source.m_stride;
-  m_width   = source.m_width;
+  m_pImpl->SetMaxCachedBytes (maxCachedBytes);
+}
 
-  // Now that the source buffer is assigned to this image, reset the source
-  // image object.
-  source.InitObj ();
+void RasterBufferPool::Trim (size_t maxCachedBytes)
+{
+  m_pImpl->Trim (maxCachedBytes);
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// WriterBMP class
+//////////////////////////////////////////////////////////////////////////////
+// GradientColor class
 
-int WriterBMP::CalcWidthByteCount (int width) const
+GradientColor::GradientColor ():
+  m_pAllocator (noise::GetDefaultAllocator ())
 {
-  return ((width * 3) + 3) & ~0x03;
+  m_gradientPointCount = 0;
+  m_pGradientPoints = NULL;
 }
 
-void WriterBMP::WriteDestFile ()
+GradientColor::~GradientColor ()
 {
-  if (m_pSourceImage == NULL) {
-    throw noise::ExceptionInvalidParam ();
-  }
+  DeallocateArray (m_pAllocator, m_pGradientPoints, m_gradientPointCount);
+}
 
-  int width  = m_pSourceImage->GetWidth  ();
-  int height = m_pSourceImage->GetHeight ();
+void GradientColor::AddGradientPoint (double gradientPos,
+  const Color& gradientColor)
+{
+  // Find the insertion point for the new gradient point and insert the new
+  // gradient point at that insertion point.  The gradient point array will
+  // remain sorted by gradient position.
+  int insertionPos = FindInsertionPos (gradientPos);
+  InsertAtPos (insertionPos, gradientPos, gradientColor);
+}
 
-  // The width of one line in the file must be aligned on a 4-byte boundary.
-  int bufferSize = CalcWidthByteCount (width);
-  int destSize   = bufferSize * height;
+void GradientColor::Clear ()
+{
+  DeallocateArray (m_pAllocator, m_pGradientPoints, m_gradientPointCount);
+  m_pGradientPoints = NULL;
+  m_gradientPointCount = 0;
+}
+
+int GradientColor::FindInsertionPos (double gradientPos)
+{
+  int insertionPos;
+  for (insertionPos = 0; insertionPos < m_gradientPointCount;
+    insertionPos++) {
+    if (gradientPos < m_pGradientPoints[insertionPos].pos) {
+      // We found the array index in which to insert the new gradient point.
+      // Exit now.
+      break;
+    } else if (gradientPos == m_pGradientPoints[insertionPos].pos) {
+      // Each gradient point is required to contain a unique gradient
+      // position, so throw an exception.
+      throw noise::ExceptionInvalidParam ();
+    }
+  }
+  return insertionPos;
+}
+
+const Color& GradientColor::GetColor (double gradientPos) const
+{
+  GetColor (gradientPos, m_workingColor);
+  return m_workingColor;
+}
+
+void GradientColor::GetColor (double gradientPos, Color& color) const
+{
+  assert (m_gradientPointCount >= 2);
+
+  // Find the first element in the gradient point array that has a gradient
+  // position larger than the gradient position passed to this method.
+  int indexPos;
+  for (indexPos = 0; indexPos < m_gradientPointCount; indexPos++) {
+    if (gradientPos < m_pGradientPoints[indexPos].pos) {
+      break;
+    }
+  }
+
+  // Find the two nearest gradient points so that we can perform linear
+  // interpolation on the color.
+  int index0 = ClampValue (indexPos - 1, 0, m_gradientPointCount - 1);
+  int index1 = ClampValue (indexPos    , 0, m_gradientPointCount - 1);
+
+  // If some gradient points are missing (which occurs if the gradient
+  // position passed to this method is greater than the largest gradient
+  // position or less than the smallest gradient position in the array), get
+  // the corresponding gradient color of the nearest gradient point and exit
+  // now.
+  if (index0 == index1) {
+    color = m_pGradientPoints[index1].color;
+    return;
+  }
+  
+  // Compute the alpha value used for linear interpolation.
+  double input0 = m_pGradientPoints[index0].pos;
+  double input1 = m_pGradientPoints[index1].pos;
+  double alpha = (gradientPos - input0) / (input1 - input0);
+
+  // Now perform the linear interpolation given the alpha value.
+  const Color& color0 = m_pGradientPoints[index0].color;
+  const Color& color1 = m_pGradientPoints[index1].color;
+  LinearInterpColor (color0, color1, (float)alpha, color);
+}
+
+void GradientColor::InsertAtPos (int insertionPos, double gradientPos,
+  const Color& gradientColor)
+{
+  // Make room for the new gradient point at the specified insertion position
+  // within the gradient point array.  The insertion position is determined by
+  // the gradient point's position; the gradient points must be sorted by
+  // gradient position within that array.
+  GradientPoint* newGradientPoints;
+  newGradientPoints = AllocateArray<GradientPoint> (m_pAllocator,
+    m_gradientPointCount + 1);
+  for (int i = 0; i < m_gradientPointCount; i++) {
+    if (i < insertionPos) {
+      newGradientPoints[i] = m_pGradientPoints[i];
+    } else {
+      newGradientPoints[i + 1] = m_pGradientPoints[i];
+    }
+  }
+  DeallocateArray (m_pAllocator, m_pGradientPoints, m_gradientPointCount);
+  m_pGradientPoints = newGradientPoints;
+  ++m_gradientPointCount;
+
+  // Now that we've made room for the new gradient point within the array, add
+  // the new gradient point.
+  m_pGradientPoints[insertionPos].pos = gradientPos ;
+  m_pGradientPoints[insertionPos].color = gradientColor;
+}
+
+void GradientColor::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the gradient point array into memory from the new allocator.
+  if (m_pGradientPoints != NULL) {
+    GradientPoint* newGradientPoints = AllocateArray<GradientPoint> (
+      pAllocator, m_gradientPointCount);
+    for (int i = 0; i < m_gradientPointCount; i++) {
+      newGradientPoints[i] = m_pGradientPoints[i];
+    }
+    DeallocateArray (m_pAllocator, m_pGradientPoints, m_gradientPointCount);
+    m_pGradientPoints = newGradientPoints;
+  }
+  m_pAllocator = pAllocator;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// RasterMappingImpl class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    // Size of the header at the start of a raster file.  It is a multiple of
+    // the cache line size so that the first slab stays aligned.
+    const size_t RASTER_FILE_HEADER_SIZE = 64;
+
+    // Identifies a raster file.
+    const char RASTER_FILE_MAGIC[8] = {
+      'L', 'N', 'R', 'A', 'S', 'T', 'E', 'R'
+    };
+
+    // Version of the raster file format.
+    const noise::uint32 RASTER_FILE_VERSION = 1;
+
+    // Types of the values stored in a raster file.
+    enum RasterElementType
+    {
+      RASTER_ELEMENT_FLOAT = 1,
+      RASTER_ELEMENT_COLOR = 2,
+      RASTER_ELEMENT_UINT16 = 3,
+      RASTER_ELEMENT_FLOAT16 = 4
+    };
+
+    // Size of a huge page; anonymous mappings that request huge pages are
+    // rounded up to a multiple of this size.
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    // The header at the start of a raster file.
+    struct RasterFileHeader
+    {
+      char magic[8];
+      noise::uint32 version;
+      noise::uint32 elementType;
+      noise::uint32 elementSize;
+      noise::uint32 padding;
+      noise::int64 width;
+      noise::int64 height;
+      noise::int64 stride;
+      float quantScale;
+      float quantBias;
+      char reserved[RASTER_FILE_HEADER_SIZE - 56];
+    };
+
+    // Mapped memory that stores the buffer of a noise map or an image.  The
+    // memory is either anonymous or backed by a raster file.
+    class RasterMappingImpl
+    {
+
+      public:
+
+        ~RasterMappingImpl ();
+
+        // Creates an anonymous mapping.
+        static RasterMappingImpl* CreateAnonymous (size_t elementSize,
+          bool useHugePages);
+
+        // Opens (or creates) a raster file and maps the buffer it contains.
+        static RasterMappingImpl* OpenFile (const std::string& filename,
+          RasterElementType elementType, size_t elementSize,
+          bool isReadOnly);
+
+        // Returns the capacity of the buffer, in bytes.
+        size_t GetCapacity () const
+        {
+          return m_capacity;
+        }
+
+        // Returns a pointer to the buffer, or NULL if there is none.
+        void* GetData () const
+        {
+          return m_pData;
+        }
+
+        // Returns the quantization of 16-bit integer values stored in the
+        // file.  The scale is zero if the file records none.
+        void GetQuantization (float& scale, float& bias) const
+        {
+          scale = m_quantScale;
+          bias  = m_quantBias;
+        }
+
+        // Returns the size of the raster stored in the file.
+        void GetSize (noise::int64& width, noise::int64& height,
+          noise::int64& stride) const
+        {
+          width  = m_width ;
+          height = m_height;
+          stride = m_stride;
+        }
+
+        bool IsReadOnly () const
+        {
+          return m_isReadOnly;
+        }
+
+        // Frees the buffer.  A raster file is truncated to its header.
+        void Release ();
+
+        // Replaces the buffer with one of at least the specified number of
+        // bytes and returns a pointer to it.  The contents of the new buffer
+        // are undefined.
+        void* Reserve (size_t byteCount);
+
+        // Records the quantization of 16-bit integer values in the header of
+        // the file.
+        void SetQuantization (float scale, float bias);
+
+        // Records the size of the raster in the header of the file.
+        void SetSize (noise::int64 width, noise::int64 height,
+          noise::int64 stride);
+
+        // Writes the modified pages of the file to disk.
+        void Sync ();
+
+      private:
+
+        RasterMappingImpl (size_t elementSize);
+
+        // Unmaps the buffer.
+        void Unmap ();
+
+        // Writes the header to the file.
+        void WriteHeader ();
+
+        // Capacity of the buffer, in bytes.
+        size_t m_capacity;
+
+        // Size of each value in the buffer, in bytes.
+        size_t m_elementSize;
+
+        // Type of each value in the buffer.
+        RasterElementType m_elementType;
+
+        // File descriptor of the raster file, or -1 for anonymous memory.
+        int m_fd;
+
+        // Size of the raster stored in the file.
+        noise::int64 m_height;
+        noise::int64 m_stride;
+        noise::int64 m_width;
+
+        // True if the file is mapped read-only.
+        bool m_isReadOnly;
+
+        // The start of the mapping, which includes the header of a file.
+        void* m_pBase;
+
+        // The start of the buffer.
+        void* m_pData;
+
+        // Size of the mapping, in bytes.
+        size_t m_mappedSize;
+
+        // Quantization of 16-bit integer values stored in the file.
+        float m_quantBias;
+        float m_quantScale;
+
+        // True if huge pages are requested for anonymous memory.
+        bool m_useHugePages;
+
+    };
+
+  }
+
+}
+
+RasterMappingImpl::RasterMappingImpl (size_t elementSize):
+  m_capacity (0),
+  m_elementSize (elementSize),
+  m_elementType (RASTER_ELEMENT_FLOAT),
+  m_fd (-1),
+  m_height (0),
+  m_stride (0),
+  m_width (0),
+  m_isReadOnly (false),
+  m_pBase (NULL),
+  m_pData (NULL),
+  m_mappedSize (0),
+  m_quantBias (0.0f),
+  m_quantScale (0.0f),
+  m_useHugePages (false)
+{
+}
+
+RasterMappingImpl::~RasterMappingImpl ()
+{
+  Unmap ();
+#ifdef NOISEUTILS_HAVE_MMAP
+  if (m_fd >= 0) {
+    close (m_fd);
+  }
+#endif
+}
+
+RasterMappingImpl* RasterMappingImpl::CreateAnonymous (size_t elementSize,
+  bool useHugePages)
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  RasterMappingImpl* pMapping = NULL;
+  try {
+    pMapping = new RasterMappingImpl (elementSize);
+  }
+  catch (...) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  pMapping->m_useHugePages = useHugePages;
+  return pMapping;
+#else
+  throw noise::ExceptionUnknown ();
+#endif
+}
+
+RasterMappingImpl* RasterMappingImpl::OpenFile (const std::string& filename,
+  RasterElementType elementType, size_t elementSize, bool isReadOnly)
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  RasterMappingImpl* pMapping = NULL;
+  try {
+    pMapping = new RasterMappingImpl (elementSize);
+  }
+  catch (...) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  pMapping->m_elementType = elementType;
+  pMapping->m_isReadOnly = isReadOnly;
+  pMapping->m_fd = open (filename.c_str (),
+    isReadOnly? O_RDONLY: (O_RDWR | O_CREAT), 0644);
+  struct stat fileStat;
+  if (pMapping->m_fd < 0 || fstat (pMapping->m_fd, &fileStat) != 0) {
+    delete pMapping;
+    throw noise::ExceptionUnknown ();
+  }
+
+  if (fileStat.st_size == 0) {
+    // A new file; it contains an empty raster.
+    if (!isReadOnly) {
+      try {
+        pMapping->WriteHeader ();
+      }
+      catch (...) {
+        delete pMapping;
+        throw;
+      }
+    }
+    return pMapping;
+  }
+
+  // Read and check the header.
+  RasterFileHeader header;
+  if ((size_t)fileStat.st_size < RASTER_FILE_HEADER_SIZE
+    || pread (pMapping->m_fd, &header, sizeof (header), 0)
+      != (ssize_t)sizeof (header)
+    || memcmp (header.magic, RASTER_FILE_MAGIC, sizeof (header.magic)) != 0
+    || header.version != RASTER_FILE_VERSION
+    || header.elementType != (noise::uint32)elementType
+    || header.elementSize != elementSize
+    || header.width < 0 || header.height < 0
+    || header.stride < header.width) {
+    delete pMapping;
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Make sure that the file is large enough to hold the slabs, then map
+  // all of it.
+  noise::uint64 dataSize = (noise::uint64)fileStat.st_size
+    - RASTER_FILE_HEADER_SIZE;
+  noise::uint64 maxCount = dataSize / elementSize;
+  if (header.width > 0 && header.height > 0
+    && (noise::uint64)header.height
+      > maxCount / (noise::uint64)header.stride) {
+    delete pMapping;
+    throw noise::ExceptionUnknown ();
+  }
+  if ((noise::uint64)fileStat.st_size > (noise::uint64)((size_t)-1)) {
+    delete pMapping;
+    throw noise::ExceptionOutOfMemory ();
+  }
+  pMapping->m_width  = header.width ;
+  pMapping->m_height = header.height;
+  pMapping->m_stride = header.stride;
+  pMapping->m_quantScale = header.quantScale;
+  pMapping->m_quantBias  = header.quantBias;
+  if (dataSize > 0) {
+    size_t mappedSize = (size_t)fileStat.st_size;
+    void* pBase = mmap (NULL, mappedSize,
+      isReadOnly? PROT_READ: (PROT_READ | PROT_WRITE), MAP_SHARED,
+      pMapping->m_fd, 0);
+    if (pBase == MAP_FAILED) {
+      delete pMapping;
+      throw noise::ExceptionOutOfMemory ();
+    }
+    pMapping->m_pBase      = pBase;
+    pMapping->m_mappedSize = mappedSize;
+    pMapping->m_pData      = (noise::uint8*)pBase + RASTER_FILE_HEADER_SIZE;
+    pMapping->m_capacity   = (size_t)dataSize;
+  }
+  return pMapping;
+#else
+  throw noise::ExceptionUnknown ();
+#endif
+}
+
+void RasterMappingImpl::Release ()
+{
+  Unmap ();
+#ifdef NOISEUTILS_HAVE_MMAP
+  if (m_fd >= 0 && !m_isReadOnly) {
+    m_width  = 0;
+    m_height = 0;
+    m_stride = 0;
+    if (ftruncate (m_fd, (off_t)RASTER_FILE_HEADER_SIZE) != 0) {
+      throw noise::ExceptionUnknown ();
+    }
+    WriteHeader ();
+  }
+#endif
+}
+
+void* RasterMappingImpl::Reserve (size_t byteCount)
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  if (m_isReadOnly) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  Unmap ();
+
+  if (m_fd >= 0) {
+    // Grow the file, then map the header and the buffer.
+    if (byteCount > (size_t)-1 - RASTER_FILE_HEADER_SIZE) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    size_t mappedSize = RASTER_FILE_HEADER_SIZE + byteCount;
+    if (ftruncate (m_fd, (off_t)mappedSize) != 0) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    void* pBase = mmap (NULL, mappedSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED, m_fd, 0);
+    if (pBase == MAP_FAILED) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    m_pBase      = pBase;
+    m_mappedSize = mappedSize;
+    m_pData      = (noise::uint8*)pBase + RASTER_FILE_HEADER_SIZE;
+    m_capacity   = byteCount;
+    return m_pData;
+  }
+
+  // Anonymous memory.  Round up to whole pages so that the capacity
+  // reflects everything that is mapped.
+  size_t pageSize = m_useHugePages? HUGE_PAGE_SIZE:
+    (size_t)sysconf (_SC_PAGESIZE);
+  if (byteCount > (size_t)-1 - pageSize) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  size_t mappedSize = (byteCount + pageSize - 1) / pageSize * pageSize;
+  void* pBase = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (m_useHugePages) {
+    pBase = mmap (NULL, mappedSize, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+#endif
+  if (pBase == MAP_FAILED) {
+    // No explicit huge pages are available; use normal pages and let the
+    // kernel promote them to transparent huge pages.
+    pBase = mmap (NULL, mappedSize, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pBase == MAP_FAILED) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+#ifdef MADV_HUGEPAGE
+    if (m_useHugePages) {
+      madvise (pBase, mappedSize, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  m_pBase      = pBase;
+  m_mappedSize = mappedSize;
+  m_pData      = pBase;
+  m_capacity   = mappedSize;
+  return m_pData;
+#else
+  throw noise::ExceptionUnknown ();
+#endif
+}
+
+void RasterMappingImpl::SetQuantization (float scale, float bias)
+{
+  m_quantScale = scale;
+  m_quantBias  = bias;
+  if (m_fd >= 0 && !m_isReadOnly) {
+    WriteHeader ();
+  }
+}
+
+void RasterMappingImpl::SetSize (noise::int64 width, noise::int64 height,
+  noise::int64 stride)
+{
+  m_width  = width ;
+  m_height = height;
+  m_stride = stride;
+  if (m_fd >= 0 && !m_isReadOnly) {
+    WriteHeader ();
+  }
+}
+
+void RasterMappingImpl::Sync ()
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  if (m_fd < 0 || m_isReadOnly) {
+    return;
+  }
+  if ((m_pBase != NULL && msync (m_pBase, m_mappedSize, MS_SYNC) != 0)
+    || fsync (m_fd) != 0) {
+    throw noise::ExceptionUnknown ();
+  }
+#endif
+}
+
+void RasterMappingImpl::Unmap ()
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  if (m_pBase != NULL) {
+    munmap (m_pBase, m_mappedSize);
+  }
+#endif
+  m_pBase      = NULL;
+  m_pData      = NULL;
+  m_mappedSize = 0;
+  m_capacity   = 0;
+}
+
+void RasterMappingImpl::WriteHeader ()
+{
+#ifdef NOISEUTILS_HAVE_MMAP
+  RasterFileHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, RASTER_FILE_MAGIC, sizeof (header.magic));
+  header.version     = RASTER_FILE_VERSION;
+  header.elementType = (noise::uint32)m_elementType;
+  header.elementSize = (noise::uint32)m_elementSize;
+  header.width       = m_width ;
+  header.height      = m_height;
+  header.stride      = m_stride;
+  header.quantScale  = m_quantScale;
+  header.quantBias   = m_quantBias;
+  ssize_t writtenSize = pwrite (m_fd, &header, sizeof (header), 0);
+  if (writtenSize != (ssize_t)sizeof (header)) {
+    throw noise::ExceptionUnknown ();
+  }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Half-precision conversion functions
+
+float noise::utils::HalfToFloat (noise::uint16 half)
+{
+  noise::uint32 sign = (noise::uint32)(half & 0x8000) << 16;
+  noise::uint32 exponent = (half >> 10) & 0x1f;
+  noise::uint32 mantissa = half & 0x03ff;
+  noise::uint32 bits;
+  if (exponent == 0x1f) {
+    // Infinity or NaN.
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    // A normal number.
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa != 0) {
+    // A subnormal number; normalize it.
+    exponent = 113;
+    while ((mantissa & 0x0400) == 0) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x03ff) << 13);
+  } else {
+    // Zero.
+    bits = sign;
+  }
+  float value;
+  memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+noise::uint16 noise::utils::FloatToHalf (float value)
+{
+  noise::uint32 bits;
+  memcpy (&bits, &value, sizeof (bits));
+  noise::uint16 sign = (noise::uint16)((bits >> 16) & 0x8000);
+  noise::int32 exponent = (noise::int32)((bits >> 23) & 0xff);
+  noise::uint32 mantissa = bits & 0x007fffff;
+  if (exponent == 0xff) {
+    // Infinity or NaN; keep NaNs quiet.
+    return (noise::uint16)(sign | 0x7c00 | (mantissa != 0? 0x0200: 0));
+  }
+
+  exponent -= 112;
+  if (exponent >= 0x1f) {
+    // Too large; round to infinity.
+    return (noise::uint16)(sign | 0x7c00);
+  }
+  noise::uint32 shift = 13;
+  if (exponent <= 0) {
+    // A subnormal half, or too small even for that.
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x00800000;
+    shift = (noise::uint32)(14 - exponent);
+    exponent = 0;
+  }
+
+  // Round to the nearest half, with ties rounded to even.  A carry out of
+  // the mantissa correctly increments the exponent.
+  noise::uint32 half = ((noise::uint32)exponent << 10)
+    | ((mantissa >> shift) & (exponent == 0? 0x07ff: 0x03ff));
+  noise::uint32 remainder = mantissa & ((1u << shift) - 1);
+  noise::uint32 halfway = 1u << (shift - 1);
+  if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+    half++;
+  }
+  return (noise::uint16)(sign | half);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// NoiseMap class
+
+NoiseMap::NoiseMap ():
+  m_format (FORMAT_FLOAT32),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL),
+  m_quantBias (-1.0f),
+  m_quantScale (2.0f / 65535.0f)
+{
+  InitObj ();
+}
+
+NoiseMap::NoiseMap (noise::int64 width, noise::int64 height):
+  m_format (FORMAT_FLOAT32),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL),
+  m_quantBias (-1.0f),
+  m_quantScale (2.0f / 65535.0f)
+{
+  InitObj ();
+  SetSize (width, height);
+}
+
+NoiseMap::NoiseMap (const NoiseMap& rhs):
+  m_format (FORMAT_FLOAT32),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL),
+  m_quantBias (-1.0f),
+  m_quantScale (2.0f / 65535.0f)
+{
+  InitObj ();
+  CopyNoiseMap (rhs);
+}
+
+NoiseMap::NoiseMap (float* pBuffer, noise::int64 width, noise::int64 height,
+  noise::int64 stride):
+  m_format (FORMAT_FLOAT32),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL),
+  m_quantBias (-1.0f),
+  m_quantScale (2.0f / 65535.0f)
+{
+  InitObj ();
+  WrapBuffer (pBuffer, width, height, stride);
+}
+
+NoiseMap::NoiseMap (NoiseMap&& rhs):
+  m_format (FORMAT_FLOAT32),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL),
+  m_quantBias (-1.0f),
+  m_quantScale (2.0f / 65535.0f)
+{
+  InitObj ();
+  TakeOwnership (rhs);
+}
+
+NoiseMap::~NoiseMap ()
+{
+  FreeBuffer ();
+}
+
+NoiseMap& NoiseMap::operator= (const NoiseMap& rhs)
+{
+  CopyNoiseMap (rhs);
+
+  return *this;
+}
+
+NoiseMap& NoiseMap::operator= (NoiseMap&& rhs)
+{
+  if (&rhs != this) {
+    TakeOwnership (rhs);
+  }
+
+  return *this;
+}
+
+void NoiseMap::Clear (float value)
+{
+  if (m_pNoiseMap == NULL) {
+    return;
+  }
+  if (m_format == FORMAT_FLOAT32) {
+    for (noise::int64 y = 0; y < m_height; y++) {
+      float* pDest = GetSlabPtr (0, y);
+      for (noise::int64 x = 0; x < m_width; x++) {
+        *pDest++ = value;
+      }
+    }
+  } else {
+    // Convert the value once.
+    noise::uint16 storedValue = (m_format == FORMAT_UINT16)?
+      QuantizeValue (value, m_quantScale, m_quantBias): FloatToHalf (value);
+    for (noise::int64 y = 0; y < m_height; y++) {
+      noise::uint16* pDest = GetSlabPtr16 (0, y);
+      for (noise::int64 x = 0; x < m_width; x++) {
+        *pDest++ = storedValue;
+      }
+    }
+  }
+}
+
+void NoiseMap::CopyNoiseMap (const NoiseMap& source)
+{
+  // A buffer that belongs to the caller or to a file is never freed here.
+  // It keeps its storage format, and the values are converted instead.
+  if (m_format != source.m_format && (m_isWrapped || m_pMapping != NULL)) {
+    SetSize (source.GetWidth (), source.GetHeight ());
+    if (m_width > 0 && m_height > 0) {
+      float* pRow = AllocateArray<float> (m_pAllocator, (size_t)m_width);
+      for (noise::int64 y = 0; y < m_height; y++) {
+        source.GetSlabValues (0, y, m_width, pRow);
+        SetSlabValues (0, y, m_width, pRow);
+      }
+      DeallocateArray (m_pAllocator, pRow, (size_t)m_width);
+    }
+    m_borderValue = source.m_borderValue;
+    return;
+  }
+
+  // Take the storage format of the source noise map so that the slabs can
+  // be copied as they are.
+  if (m_format != source.m_format) {
+    SetFormat (source.m_format);
+  }
+  if (m_format == FORMAT_UINT16) {
+    SetQuantization (source.m_quantScale, source.m_quantBias);
+  }
+
+  // Resize the noise map buffer, then copy the slabs from the source noise
+  // map buffer to this noise map buffer.
+  SetSize (source.GetWidth (), source.GetHeight ());
+  size_t elementSize = GetElementSize ();
+  for (noise::int64 y = 0; y < source.GetHeight (); y++) {
+    const noise::uint8* pSource = (const noise::uint8*)source.m_pNoiseMap
+      + (size_t)source.m_stride * (size_t)y * elementSize;
+    noise::uint8* pDest = (noise::uint8*)m_pNoiseMap
+      + (size_t)m_stride * (size_t)y * elementSize;
+    memcpy (pDest, pSource, (size_t)source.GetWidth () * elementSize);
+  }
+
+  // Copy the border value as well.
+  m_borderValue = source.m_borderValue;
+}
+
+void NoiseMap::DeleteNoiseMapAndReset ()
+{
+  if (m_pMapping != NULL) {
+    m_pMapping->Release ();
+  } else if (!m_isWrapped) {
+    FreeRasterBuffer (m_pAllocator, m_pNoiseMap, m_memUsed * GetElementSize ());
+  }
+
+  // Keep the border value; a builder may fill masked-out points with it.
+  float borderValue = m_borderValue;
+  InitObj ();
+  m_borderValue = borderValue;
+}
+
+void NoiseMap::FreeBuffer ()
+{
+  // A mapped file keeps its contents after it is unmapped, and wrapped
+  // memory belongs to the caller.
+  if (m_pMapping != NULL) {
+    delete m_pMapping;
+    m_pMapping = NULL;
+  } else if (!m_isWrapped) {
+    FreeRasterBuffer (m_pAllocator, m_pNoiseMap, m_memUsed * GetElementSize ());
+  }
+}
+
+float NoiseMap::GetValue (noise::int64 x, noise::int64 y) const
+{
+  if (m_pNoiseMap != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+      float value;
+      GetSlabValues (x, y, 1, &value);
+      return value;
+    }
+  }
+  // The coordinates specified are outside the noise map.  Return the border
+  // value.
+  return m_borderValue;
+}
+
+void NoiseMap::GetSlabValues (noise::int64 x, noise::int64 y,
+  noise::int64 count, float* pDest) const
+{
+  switch (m_format) {
+    case FORMAT_FLOAT32:
+      memcpy (pDest, GetConstSlabPtr (x, y), (size_t)count * sizeof (float));
+      break;
+    case FORMAT_UINT16: {
+      const noise::uint16* pSource = GetConstSlabPtr16 (x, y);
+      for (noise::int64 i = 0; i < count; i++) {
+        *pDest++ = m_quantBias + m_quantScale * (float)*pSource++;
+      }
+      break;
+    }
+    case FORMAT_FLOAT16: {
+      const noise::uint16* pSource = GetConstSlabPtr16 (x, y);
+      for (noise::int64 i = 0; i < count; i++) {
+        *pDest++ = HalfToFloat (*pSource++);
+      }
+      break;
+    }
+  }
+}
+
+void NoiseMap::InitObj ()
+{
+  m_isWrapped = false;
+  m_pNoiseMap = NULL;
+  m_height    = 0;
+  m_width     = 0;
+  m_stride    = 0;
+  m_memUsed   = 0;
+  m_borderValue = 0.0;
+}
+
+void NoiseMap::MapAnonymous (bool useHugePages)
+{
+  RasterMappingImpl* pMapping = RasterMappingImpl::CreateAnonymous (
+    GetElementSize (), useHugePages);
+  SetMapping (pMapping);
+}
+
+void NoiseMap::MapFile (const std::string& filename, bool isReadOnly)
+{
+  RasterElementType elementType = RASTER_ELEMENT_FLOAT;
+  if (m_format == FORMAT_UINT16) {
+    elementType = RASTER_ELEMENT_UINT16;
+  } else if (m_format == FORMAT_FLOAT16) {
+    elementType = RASTER_ELEMENT_FLOAT16;
+  }
+  RasterMappingImpl* pMapping = RasterMappingImpl::OpenFile (filename,
+    elementType, GetElementSize (), isReadOnly);
+  SetMapping (pMapping);
+
+  // A file of quantized values records its quantization; a new file takes
+  // the quantization of this noise map.
+  if (m_format == FORMAT_UINT16) {
+    float scale, bias;
+    m_pMapping->GetQuantization (scale, bias);
+    if (scale > 0.0f) {
+      m_quantScale = scale;
+      m_quantBias  = bias;
+    } else if (!isReadOnly) {
+      m_pMapping->SetQuantization (m_quantScale, m_quantBias);
+    }
+  }
+
+  // Take the size and values of the noise map stored in the file.
+  noise::int64 width, height, stride;
+  m_pMapping->GetSize (width, height, stride);
+  if (width > 0 && height > 0) {
+    m_pNoiseMap = m_pMapping->GetData ();
+    m_memUsed = m_pMapping->GetCapacity () / GetElementSize ();
+    m_width   = width ;
+    m_height  = height;
+    m_stride  = stride;
+  }
+}
+
+void NoiseMap::ReclaimMem ()
+{
+  if (m_pMapping != NULL || m_isWrapped) {
+    return;
+  }
+
+  size_t newMemUsage = CalcMinMemUsage (m_width, m_height);
+  if (m_memUsed > newMemUsage) {
+    // There is wasted memory.  Create the smallest buffer that can fit the
+    // data and copy the data to it.
+    void* pNewNoiseMap = AllocRasterBuffer (m_pAllocator,
+      newMemUsage * GetElementSize ());
+    memcpy (pNewNoiseMap, m_pNoiseMap, newMemUsage * GetElementSize ());
+    FreeRasterBuffer (m_pAllocator, m_pNoiseMap, m_memUsed * GetElementSize ());
+    m_pNoiseMap = pNewNoiseMap;
+    m_memUsed = newMemUsage;
+  }
+}
+
+void NoiseMap::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy a heap buffer into memory from the new allocator.  Mapped and
+  // wrapped buffers do not come from the allocator.
+  if (m_pNoiseMap != NULL && m_pMapping == NULL && !m_isWrapped) {
+    void* pNewBuffer = AllocRasterBuffer (pAllocator,
+      m_memUsed * GetElementSize ());
+    memcpy (pNewBuffer, m_pNoiseMap, m_memUsed * GetElementSize ());
+    FreeRasterBuffer (m_pAllocator, m_pNoiseMap, m_memUsed * GetElementSize ());
+    m_pNoiseMap = pNewBuffer;
+  }
+  m_pAllocator = pAllocator;
+}
+
+void NoiseMap::SetFormat (NoiseMapFormat format)
+{
+  if (format != FORMAT_FLOAT32 && format != FORMAT_UINT16
+    && format != FORMAT_FLOAT16) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Free the buffer while its size is still measured in the old format.
+  float borderValue = m_borderValue;
+  SetMapping (NULL);
+  m_format = format;
+  m_borderValue = borderValue;
+}
+
+void NoiseMap::SetMapping (RasterMappingImpl* pMapping)
+{
+  FreeBuffer ();
+  m_pMapping = pMapping;
+  InitObj ();
+}
+
+void NoiseMap::SetQuantization (float scale, float bias)
+{
+  if (!(scale > 0.0f)
+    || (m_pMapping != NULL && m_pMapping->IsReadOnly ())) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  m_quantScale = scale;
+  m_quantBias  = bias;
+  if (m_pMapping != NULL && m_format == FORMAT_UINT16) {
+    m_pMapping->SetQuantization (scale, bias);
+  }
+}
+
+void NoiseMap::SetQuantizationRange (float minValue, float maxValue)
+{
+  if (!(minValue < maxValue)) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  SetQuantization ((maxValue - minValue) / 65535.0f, minValue);
+}
+
+void NoiseMap::SetSize (noise::int64 width, noise::int64 height)
+{
+  if (width < 0 || height < 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT
+    || (m_pMapping != NULL && m_pMapping->IsReadOnly ())) {
+    // Invalid width or height.
+    throw noise::ExceptionInvalidParam ();
+  } else if (width == 0 || height == 0) {
+    // An empty noise map was specified.  Delete it and zero out the size
+    // member variables.
+    DeleteNoiseMapAndReset ();
+  } else if (m_isWrapped) {
+    // The wrapped buffer cannot grow.  Keep the stride chosen by the
+    // caller so that the slabs stay where the caller expects them.
+    if (width > m_stride
+      || (noise::uint64)height > (noise::uint64)m_memUsed
+        / (noise::uint64)m_stride) {
+      throw noise::ExceptionInvalidParam ();
+    }
+    m_width  = width;
+    m_height = height;
+  } else {
+    // A new noise map size was specified.  Allocate a new noise map buffer
+    // unless the current buffer is large enough for the new noise map (we
+    // don't want costly reallocations going on.)
+    size_t newMemUsage = CalcMinMemUsage (width, height);
+    if (m_memUsed < newMemUsage) {
+      // The new size is too big for the current noise map buffer.  We need to
+      // reallocate.
+      DeleteNoiseMapAndReset ();
+      if (m_pMapping != NULL) {
+        m_pNoiseMap = m_pMapping->Reserve (
+          newMemUsage * GetElementSize ());
+        newMemUsage = m_pMapping->GetCapacity () / GetElementSize ();
+      } else {
+        m_pNoiseMap = AllocRasterBuffer (m_pAllocator,
+          newMemUsage * GetElementSize ());
+      }
+      m_memUsed = newMemUsage;
+    }
+    m_stride = (noise::int64)CalcStride (width);
+    m_width  = width;
+    m_height = height;
+    if (m_pMapping != NULL) {
+      m_pMapping->SetSize (m_width, m_height, m_stride);
+    }
+  }
+}
+
+void NoiseMap::SetValue (noise::int64 x, noise::int64 y, float value)
+{
+  if (m_pNoiseMap != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+      SetSlabValues (x, y, 1, &value);
+    }
+  }
+}
+
+void NoiseMap::SetSlabValues (noise::int64 x, noise::int64 y,
+  noise::int64 count, const float* pSource)
+{
+  switch (m_format) {
+    case FORMAT_FLOAT32:
+      memcpy (GetSlabPtr (x, y), pSource, (size_t)count * sizeof (float));
+      break;
+    case FORMAT_UINT16: {
+      noise::uint16* pDest = GetSlabPtr16 (x, y);
+      for (noise::int64 i = 0; i < count; i++) {
+        *pDest++ = QuantizeValue (*pSource++, m_quantScale, m_quantBias);
+      }
+      break;
+    }
+    case FORMAT_FLOAT16: {
+      noise::uint16* pDest = GetSlabPtr16 (x, y);
+      for (noise::int64 i = 0; i < count; i++) {
+        *pDest++ = FloatToHalf (*pSource++);
+      }
+      break;
+    }
+  }
+}
+
+void NoiseMap::SyncFile ()
+{
+  if (m_pMapping != NULL) {
+    m_pMapping->Sync ();
+  }
+}
+
+void NoiseMap::TakeOwnership (NoiseMap& source)
+{
+  // Copy the values and the noise map buffer from the source noise map to
+  // this noise map.  Now this noise map pwnz the source buffer.
+  FreeBuffer ();
+  m_borderValue = source.m_borderValue;
+  m_format    = source.m_format;
+  m_quantBias  = source.m_quantBias;
+  m_quantScale = source.m_quantScale;
+  m_isWrapped = source.m_isWrapped;
+  m_pAllocator = source.m_pAllocator;
+  m_pMapping  = source.m_pMapping;
+  m_memUsed   = source.m_memUsed;
+  m_height    = source.m_height;
+  m_pNoiseMap = source.m_pNoiseMap;
+  m_stride    = source.m_stride;
+  m_width     = source.m_width;
+
+  // Now that the source buffer is assigned to this noise map, reset the
+  // source noise map object.
+  source.m_pMapping = NULL;
+  source.InitObj ();
+}
+
+void NoiseMap::Unmap ()
+{
+  SetMapping (NULL);
+}
+
+void NoiseMap::WrapBuffer (float* pBuffer, noise::int64 width,
+  noise::int64 height, noise::int64 stride)
+{
+  if (m_format != FORMAT_FLOAT32) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  WrapBytes (pBuffer, width, height, stride);
+}
+
+void NoiseMap::WrapBuffer (noise::uint16* pBuffer, noise::int64 width,
+  noise::int64 height, noise::int64 stride)
+{
+  if (m_format == FORMAT_FLOAT32) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  WrapBytes (pBuffer, width, height, stride);
+}
+
+void NoiseMap::WrapBytes (void* pBuffer, noise::int64 width,
+  noise::int64 height, noise::int64 stride)
+{
+  if (pBuffer == NULL || width <= 0 || height <= 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT
+    || stride < width
+    || (noise::uint64)height
+      > (noise::uint64)((size_t)-1 / GetElementSize ())
+      / (noise::uint64)stride) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Release the current buffer, but keep the border value.
+  float borderValue = m_borderValue;
+  SetMapping (NULL);
+  m_pNoiseMap = pBuffer;
+  m_isWrapped = true;
+  m_memUsed   = (size_t)stride * (size_t)height;
+  m_stride    = stride;
+  m_width     = width ;
+  m_height    = height;
+  m_borderValue = borderValue;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// NoiseVolume class
+
+NoiseVolume::NoiseVolume ():
+  m_pAllocator (noise::GetDefaultAllocator ())
+{
+  InitObj ();
+}
+
+NoiseVolume::NoiseVolume (noise::int64 width, noise::int64 height,
+  noise::int64 depth):
+  m_pAllocator (noise::GetDefaultAllocator ())
+{
+  InitObj ();
+  SetSize (width, height, depth);
+}
+
+NoiseVolume::NoiseVolume (const NoiseVolume& rhs):
+  m_pAllocator (noise::GetDefaultAllocator ())
+{
+  InitObj ();
+  CopyNoiseVolume (rhs);
+}
+
+NoiseVolume::NoiseVolume (NoiseVolume&& rhs):
+  m_pAllocator (noise::GetDefaultAllocator ())
+{
+  InitObj ();
+  TakeOwnership (rhs);
+}
+
+NoiseVolume::~NoiseVolume ()
+{
+  DeleteNoiseVolumeAndReset ();
+}
+
+NoiseVolume& NoiseVolume::operator= (const NoiseVolume& rhs)
+{
+  if (&rhs != this) {
+    CopyNoiseVolume (rhs);
+  }
+
+  return *this;
+}
+
+NoiseVolume& NoiseVolume::operator= (NoiseVolume&& rhs)
+{
+  if (&rhs != this) {
+    TakeOwnership (rhs);
+  }
+
+  return *this;
+}
+
+size_t NoiseVolume::CalcMinMemUsage (noise::int64 width, noise::int64 height,
+  noise::int64 depth) const
+{
+  // Calculate in 64 bits and make sure that the size in bytes can be
+  // addressed on this platform before converting to size_t.
+  noise::uint64 stride = ((noise::uint64)width + RASTER_STRIDE_BOUNDARY - 1)
+    / RASTER_STRIDE_BOUNDARY * RASTER_STRIDE_BOUNDARY;
+  noise::uint64 maxCount = (noise::uint64)((size_t)-1 / sizeof (float));
+  if (stride > maxCount || (noise::uint64)height > maxCount / stride) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  noise::uint64 layerStride = stride * (noise::uint64)height;
+  if ((noise::uint64)depth > maxCount / layerStride) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  return (size_t)(layerStride * (noise::uint64)depth);
+}
+
+void NoiseVolume::Clear (float value)
+{
+  for (noise::int64 z = 0; z < m_depth; z++) {
+    for (noise::int64 y = 0; y < m_height; y++) {
+      float* pDest = GetSlabPtr (0, y, z);
+      for (noise::int64 x = 0; x < m_width; x++) {
+        *pDest++ = value;
+      }
+    }
+  }
+}
+
+void NoiseVolume::CopyNoiseVolume (const NoiseVolume& source)
+{
+  // Resize the noise volume buffer, then copy the slabs from the source
+  // noise volume buffer to this noise volume buffer.
+  SetSize (source.m_width, source.m_height, source.m_depth);
+  for (noise::int64 z = 0; z < source.m_depth; z++) {
+    for (noise::int64 y = 0; y < source.m_height; y++) {
+      memcpy (GetSlabPtr (0, y, z), source.GetConstSlabPtr (0, y, z),
+        (size_t)source.m_width * sizeof (float));
+    }
+  }
+
+  // Copy the border value as well.
+  m_borderValue = source.m_borderValue;
+}
+
+void NoiseVolume::DeleteNoiseVolumeAndReset ()
+{
+  FreeRasterBuffer (m_pAllocator, m_pNoiseVolume,
+    m_memUsed * sizeof (float));
+
+  // Keep the border value; a builder may fill a uniform volume with it.
+  float borderValue = m_borderValue;
+  InitObj ();
+  m_borderValue = borderValue;
+}
+
+float NoiseVolume::GetValue (noise::int64 x, noise::int64 y, noise::int64 z)
+  const
+{
+  if (m_pNoiseVolume != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height
+      && z >= 0 && z < m_depth) {
+      return *GetConstSlabPtr (x, y, z);
+    }
+  }
+  // The coordinates specified are outside the noise volume.  Return the
+  // border value.
+  return m_borderValue;
+}
+
+void NoiseVolume::InitObj ()
+{
+  m_pNoiseVolume = NULL;
+  m_width        = 0;
+  m_height       = 0;
+  m_depth        = 0;
+  m_stride       = 0;
+  m_layerStride  = 0;
+  m_memUsed      = 0;
+  m_borderValue  = 0.0;
+}
+
+void NoiseVolume::ReclaimMem ()
+{
+  size_t newMemUsage = CalcMinMemUsage (m_width, m_height, m_depth);
+  if (m_memUsed > newMemUsage) {
+    // There is wasted memory.  Create the smallest buffer that can fit the
+    // data and copy the data to it.
+    float* pNewNoiseVolume = (float*)AllocRasterBuffer (m_pAllocator,
+      newMemUsage * sizeof (float));
+    memcpy (pNewNoiseVolume, m_pNoiseVolume, newMemUsage * sizeof (float));
+    FreeRasterBuffer (m_pAllocator, m_pNoiseVolume,
+      m_memUsed * sizeof (float));
+    m_pNoiseVolume = pNewNoiseVolume;
+    m_memUsed = newMemUsage;
+  }
+}
+
+void NoiseVolume::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the buffer into memory from the new allocator.
+  if (m_pNoiseVolume != NULL) {
+    float* pNewBuffer = (float*)AllocRasterBuffer (pAllocator,
+      m_memUsed * sizeof (float));
+    memcpy (pNewBuffer, m_pNoiseVolume, m_memUsed * sizeof (float));
+    FreeRasterBuffer (m_pAllocator, m_pNoiseVolume,
+      m_memUsed * sizeof (float));
+    m_pNoiseVolume = pNewBuffer;
+  }
+  m_pAllocator = pAllocator;
+}
+
+void NoiseVolume::SetSize (noise::int64 width, noise::int64 height,
+  noise::int64 depth)
+{
+  if (width < 0 || height < 0 || depth < 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT
+    || depth > RASTER_MAX_HEIGHT) {
+    // Invalid width, height or depth.
+    throw noise::ExceptionInvalidParam ();
+  } else if (width == 0 || height == 0 || depth == 0) {
+    // An empty noise volume was specified.  Delete it and zero out the
+    // size member variables.
+    DeleteNoiseVolumeAndReset ();
+  } else {
+    // A new noise volume size was specified.  Allocate a new buffer unless
+    // the current buffer is large enough for the new noise volume.
+    size_t newMemUsage = CalcMinMemUsage (width, height, depth);
+    if (m_memUsed < newMemUsage) {
+      DeleteNoiseVolumeAndReset ();
+      m_pNoiseVolume = (float*)AllocRasterBuffer (m_pAllocator,
+        newMemUsage * sizeof (float));
+      m_memUsed = newMemUsage;
+    }
+    m_stride = (width + RASTER_STRIDE_BOUNDARY - 1) / RASTER_STRIDE_BOUNDARY
+      * RASTER_STRIDE_BOUNDARY;
+    m_layerStride = m_stride * height;
+    m_width  = width ;
+    m_height = height;
+    m_depth  = depth ;
+  }
+}
+
+void NoiseVolume::SetValue (noise::int64 x, noise::int64 y, noise::int64 z,
+  float value)
+{
+  if (m_pNoiseVolume != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height
+      && z >= 0 && z < m_depth) {
+      *GetSlabPtr (x, y, z) = value;
+    }
+  }
+}
+
+void NoiseVolume::TakeOwnership (NoiseVolume& source)
+{
+  DeleteNoiseVolumeAndReset ();
+  m_pAllocator   = source.m_pAllocator  ;
+  m_pNoiseVolume = source.m_pNoiseVolume;
+  m_memUsed      = source.m_memUsed     ;
+  m_width        = source.m_width       ;
+  m_height       = source.m_height      ;
+  m_depth        = source.m_depth       ;
+  m_stride       = source.m_stride      ;
+  m_layerStride  = source.m_layerStride ;
+  m_borderValue  = source.m_borderValue ;
+
+  // The source noise volume no longer owns the buffer.
+  source.m_pNoiseVolume = NULL;
+  source.DeleteNoiseVolumeAndReset ();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Image class
+
+Image::Image ():
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL)
+{
+  InitObj ();
+}
+
+Image::Image (noise::int64 width, noise::int64 height):
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL)
+{
+  InitObj ();
+  SetSize (width, height);
+}
+
+Image::Image (const Image& rhs):
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL)
+{
+  InitObj ();
+  CopyImage (rhs);
+}
+
+Image::Image (Color* pBuffer, noise::int64 width, noise::int64 height,
+  noise::int64 stride):
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL)
+{
+  InitObj ();
+  WrapBuffer (pBuffer, width, height, stride);
+}
+
+Image::Image (Image&& rhs):
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pMapping (NULL)
+{
+  InitObj ();
+  TakeOwnership (rhs);
+}
+
+Image::~Image ()
+{
+  FreeBuffer ();
+}
+
+Image& Image::operator= (const Image& rhs)
+{
+  CopyImage (rhs);
+
+  return *this;
+}
+
+Image& Image::operator= (Image&& rhs)
+{
+  if (&rhs != this) {
+    TakeOwnership (rhs);
+  }
+
+  return *this;
+}
+
+void Image::Clear (const Color& value)
+{
+  if (m_pImage != NULL) {
+    for (noise::int64 y = 0; y < m_height; y++) {
+      Color* pDest = GetSlabPtr (0, y);
+      for (noise::int64 x = 0; x < m_width; x++) {
+        *pDest++ = value;
+      }
+    }
+  }
+}
+
+void Image::CopyImage (const Image& source)
+{
+  // Resize the image buffer, then copy the slabs from the source image
+  // buffer to this image buffer.
+  SetSize (source.GetWidth (), source.GetHeight ());
+  for (noise::int64 y = 0; y < source.GetHeight (); y++) {
+    const Color* pSource = source.GetConstSlabPtr (0, y);
+    Color* pDest = GetSlabPtr (0, y);
+    memcpy (pDest, pSource, (size_t)source.GetWidth () * sizeof (float));
+  }
+
+  // Copy the border value as well.
+  m_borderValue = source.m_borderValue;
+}
+
+void Image::DeleteImageAndReset ()
+{
+  if (m_pMapping != NULL) {
+    m_pMapping->Release ();
+  } else if (!m_isWrapped) {
+    FreeRasterBuffer (m_pAllocator, m_pImage, m_memUsed * sizeof (Color));
+  }
+  InitObj ();
+}
+
+void Image::FreeBuffer ()
+{
+  // A mapped file keeps its contents after it is unmapped, and wrapped
+  // memory belongs to the caller.
+  if (m_pMapping != NULL) {
+    delete m_pMapping;
+    m_pMapping = NULL;
+  } else if (!m_isWrapped) {
+    FreeRasterBuffer (m_pAllocator, m_pImage, m_memUsed * sizeof (Color));
+  }
+}
+
+Color Image::GetValue (noise::int64 x, noise::int64 y) const
+{
+  if (m_pImage != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+      return *(GetConstSlabPtr (x, y));
+    }
+  }
+  // The coordinates specified are outside the image.  Return the border
+  // value.
+  return m_borderValue;
+}
+
+void Image::InitObj ()
+{
+  m_isWrapped = false;
+  m_pImage  = NULL;
+  m_height  = 0;
+  m_width   = 0;
+  m_stride  = 0;
+  m_memUsed = 0;
+  m_borderValue = Color (0, 0, 0, 0);
+}
+
+void Image::MapAnonymous (bool useHugePages)
+{
+  RasterMappingImpl* pMapping = RasterMappingImpl::CreateAnonymous (
+    sizeof (Color), useHugePages);
+  SetMapping (pMapping);
+}
+
+void Image::MapFile (const std::string& filename, bool isReadOnly)
+{
+  RasterMappingImpl* pMapping = RasterMappingImpl::OpenFile (filename,
+    RASTER_ELEMENT_COLOR, sizeof (Color), isReadOnly);
+  SetMapping (pMapping);
+
+  // Take the size and values of the image stored in the file.
+  noise::int64 width, height, stride;
+  m_pMapping->GetSize (width, height, stride);
+  if (width > 0 && height > 0) {
+    m_pImage = (Color*)m_pMapping->GetData ();
+    m_memUsed = m_pMapping->GetCapacity () / sizeof (Color);
+    m_width   = width ;
+    m_height  = height;
+    m_stride  = stride;
+  }
+}
+
+void Image::ReclaimMem ()
+{
+  if (m_pMapping != NULL || m_isWrapped) {
+    return;
+  }
+
+  size_t newMemUsage = CalcMinMemUsage (m_width, m_height);
+  if (m_memUsed > newMemUsage) {
+    // There is wasted memory.  Create the smallest buffer that can fit the
+    // data and copy the data to it.
+    Color* pNewImage = (Color*)AllocRasterBuffer (m_pAllocator,
+      newMemUsage * sizeof (Color));
+    memcpy (pNewImage, m_pImage, newMemUsage * sizeof (Color));
+    FreeRasterBuffer (m_pAllocator, m_pImage, m_memUsed * sizeof (Color));
+    m_pImage = pNewImage;
+    m_memUsed = newMemUsage;
+  }
+}
+
+void Image::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy a heap buffer into memory from the new allocator.  Mapped and
+  // wrapped buffers do not come from the allocator.
+  if (m_pImage != NULL && m_pMapping == NULL && !m_isWrapped) {
+    Color* pNewBuffer = (Color*)AllocRasterBuffer (pAllocator,
+      m_memUsed * sizeof (Color));
+    memcpy (pNewBuffer, m_pImage, m_memUsed * sizeof (Color));
+    FreeRasterBuffer (m_pAllocator, m_pImage, m_memUsed * sizeof (Color));
+    m_pImage = pNewBuffer;
+  }
+  m_pAllocator = pAllocator;
+}
+
+void Image::SetMapping (RasterMappingImpl* pMapping)
+{
+  FreeBuffer ();
+  m_pMapping = pMapping;
+  InitObj ();
+}
+
+void Image::SetSize (noise::int64 width, noise::int64 height)
+{
+  if (width < 0 || height < 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT
+    || (m_pMapping != NULL && m_pMapping->IsReadOnly ())) {
+    // Invalid width or height.
+    throw noise::ExceptionInvalidParam ();
+  } else if (width == 0 || height == 0) {
+    // An empty image was specified.  Delete it and zero out the size member
+    // variables.
+    DeleteImageAndReset ();
+  } else if (m_isWrapped) {
+    // The wrapped buffer cannot grow.  Keep the stride chosen by the
+    // caller so that the slabs stay where the caller expects them.
+    if (width > m_stride
+      || (noise::uint64)height > (noise::uint64)m_memUsed
+        / (noise::uint64)m_stride) {
+      throw noise::ExceptionInvalidParam ();
+    }
+    m_width  = width;
+    m_height = height;
+  } else {
+    // A new image size was specified.  Allocate a new image buffer unless
+    // the current buffer is large enough for the new image (we don't want
+    // costly reallocations going on.)
+    size_t newMemUsage = CalcMinMemUsage (width, height);
+    if (m_memUsed < newMemUsage) {
+      // The new size is too big for the current image buffer.  We need to
+      // reallocate.
+      DeleteImageAndReset ();
+      if (m_pMapping != NULL) {
+        m_pImage = (Color*)m_pMapping->Reserve (
+          newMemUsage * sizeof (Color));
+        newMemUsage = m_pMapping->GetCapacity () / sizeof (Color);
+      } else {
+        m_pImage = (Color*)AllocRasterBuffer (m_pAllocator,
+          newMemUsage * sizeof (Color));
+      }
+      m_memUsed = newMemUsage;
+    }
+    m_stride = (noise::int64)CalcStride (width);
+    m_width  = width;
+    m_height = height;
+    if (m_pMapping != NULL) {
+      m_pMapping->SetSize (m_width, m_height, m_stride);
+    }
+  }
+}
+
+void Image::SetValue (noise::int64 x, noise::int64 y, const Color& value)
+{
+  if (m_pImage != NULL) {
+    if (x >= 0 && x < m_width && y >= 0 && y < m_height) {
+      *(GetSlabPtr (x, y)) = value;
+    }
+  }
+}
+
+void Image::SyncFile ()
+{
+  if (m_pMapping != NULL) {
+    m_pMapping->Sync ();
+  }
+}
+
+void Image::TakeOwnership (Image& source)
+{
+  // Copy the values and the image buffer from the source image to this image.
+  // Now this image pwnz the source buffer.
+  FreeBuffer ();
+  m_borderValue = source.m_borderValue;
+  m_isWrapped = source.m_isWrapped;
+  m_pAllocator = source.m_pAllocator;
+  m_pMapping  = source.m_pMapping;
+  m_memUsed = source.m_memUsed;
+  m_height  = source.m_height;
+  m_pImage  = source.m_pImage;
+  m_stride  = source.m_stride;
+  m_width   = source.m_width;
+
+  // Now that the source buffer is assigned to this image, reset the source
+  // image object.
+  source.m_pMapping = NULL;
+  source.InitObj ();
+}
+
+void Image::Unmap ()
+{
+  SetMapping (NULL);
+}
+
+void Image::WrapBuffer (Color* pBuffer, noise::int64 width,
+  noise::int64 height, noise::int64 stride)
+{
+  if (pBuffer == NULL || width <= 0 || height <= 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT
+    || stride < width
+    || (noise::uint64)height > (noise::uint64)((size_t)-1 / sizeof (Color))
+      / (noise::uint64)stride) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Release the current buffer, but keep the border value.
+  Color borderValue = m_borderValue;
+  SetMapping (NULL);
+  m_pImage = pBuffer;
+  m_isWrapped = true;
+  m_memUsed   = (size_t)stride * (size_t)height;
+  m_stride    = stride;
+  m_width     = width ;
+  m_height    = height;
+  m_borderValue = borderValue;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WriterBMP class
+
+noise::int64 WriterBMP::CalcWidthByteCount (noise::int64 width) const
+{
+  return ((width * 3) + 3) & ~0x03;
+}
+
+void WriterBMP::WriteDestFile ()
+{
+  if (m_pSourceImage == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  noise::int64 width  = m_pSourceImage->GetWidth  ();
+  noise::int64 height = m_pSourceImage->GetHeight ();
+
+  // The width of one line in the file must be aligned on a 4-byte boundary.
+  noise::int64 bufferSize = CalcWidthByteCount (width);
+  noise::int64 destSize   = bufferSize * height;
+
+  // The header stores the dimensions as signed 32-bit integers and the file
+  // size as an unsigned 32-bit integer.
+  if (width > 0x7fffffffLL || height > 0x7fffffffLL
+    || destSize + BMP_HEADER_SIZE > 0xffffffffLL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // This buffer holds one horizontal line in the destination file.
+  noise::uint8* pLineBuffer = NULL;
+
+  // File object used to write the file.
+  std::ofstream os;
+  os.clear ();
+  
+  // Allocate a buffer to hold one horizontal line in the bitmap.
+  pLineBuffer = AllocateArray<noise::uint8> (m_pAllocator,
+    (size_t)bufferSize);
+
+  // Open the destination file.
+  os.open (m_destFilename.c_str (), std::ios::out | std::ios::binary);
+  if (os.fail () || os.bad ()) {
+    DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Build the header.
+  noise::uint8 d[4];
+  os.write ("BM", 2);
+  os.write ((char*)UnpackLittle32 (d,
+    (noise::uint32)(destSize + BMP_HEADER_SIZE)), 4);
+  os.write ("\0\0\0\0", 4);
+  os.write ((char*)UnpackLittle32 (d, (noise::uint32)BMP_HEADER_SIZE), 4);
+  os.write ((char*)UnpackLittle32 (d, 40), 4);   // Palette offset
+  os.write ((char*)UnpackLittle32 (d, (noise::uint32)width ), 4);
+  os.write ((char*)UnpackLittle32 (d, (noise::uint32)height), 4);
+  os.write ((char*)UnpackLittle16 (d, 1 ), 2);   // Planes per pixel
+  os.write ((char*)UnpackLittle16 (d, 24), 2);   // Bits per plane
+  os.write ("\0\0\0\0", 4); // Compression (0 = none)
+  os.write ((char*)UnpackLittle32 (d, (noise::uint32)destSize), 4);
+  os.write ((char*)UnpackLittle32 (d, 2834), 4); // X pixels per meter
+  os.write ((char*)UnpackLittle32 (d, 2834), 4); // Y pixels per meter
+  os.write ("\0\0\0\0", 4);
+  os.write ("\0\0\0\0", 4);
+  if (os.fail () || os.bad ()) {
+    os.clear ();
+    os.close ();
+    os.clear ();
+    DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Build and write each horizontal line to the file.
+  for (noise::int64 y = 0; y < height; y++) {
+    memset (pLineBuffer, 0, bufferSize);
+    Color* pSource = m_pSourceImage->GetSlabPtr (y);
+    noise::uint8* pDest   = pLineBuffer;
+    for (noise::int64 x = 0; x < width; x++) {
+      *pDest++ = pSource->blue ;
+      *pDest++ = pSource->green;
+      *pDest++ = pSource->red  ;
+      ++pSource;
+    }
+    os.write ((char*)pLineBuffer, (size_t)bufferSize);
+    if (os.fail () || os.bad ()) {
+      os.clear ();
+      os.close ();
+      os.clear ();
+      DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+      throw noise::ExceptionUnknown ();
+    }
+  }
+
+  os.close ();
+  os.clear ();
+  DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WriterTER class
+
+noise::int64 WriterTER::CalcWidthByteCount (noise::int64 width) const
+{
+  return (width * sizeof (int16));
+}
+
+void WriterTER::WriteDestFile ()
+{
+  if (m_pSourceNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  noise::int64 width  = m_pSourceNoiseMap->GetWidth  ();
+  noise::int64 height = m_pSourceNoiseMap->GetHeight ();
+
+  // The header stores the dimensions as unsigned 16-bit integers.
+  if (width > 0xffff || height > 0xffff) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  noise::int64 bufferSize = CalcWidthByteCount (width);
+
+  // This buffer holds one horizontal line in the destination file.
+  noise::uint8* pLineBuffer = NULL;
+
+  // File object used to write the file.
+  std::ofstream os;
+  os.clear ();
+
+  // Allocate a buffer to hold one horizontal line in the height map.
+  pLineBuffer = AllocateArray<noise::uint8> (m_pAllocator,
+    (size_t)bufferSize);
+
+  // Open the destination file.
+  os.open (m_destFilename.c_str (), std::ios::out | std::ios::binary);
+  if (os.fail () || os.bad ()) {
+    os.clear ();
+    DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Build the header.
+  noise::uint8 d[4];
+  int16 heightScale = (int16)(floor (32768.0 / (double)m_metersPerPoint));
+  os.write ("TERRAGENTERRAIN ", 16);
+  os.write ("SIZE", 4);
+  os.write ((char*)UnpackLittle16 (d,
+    (noise::uint16)(GetMin (width, height) - 1)), 2);
+  os.write ("\0\0", 2);
+  os.write ("XPTS", 4);
+  os.write ((char*)UnpackLittle16 (d, (noise::uint16)width), 2);
+  os.write ("\0\0", 2);
+  os.write ("YPTS", 4);
+  os.write ((char*)UnpackLittle16 (d, (noise::uint16)height), 2);
+  os.write ("\0\0", 2);
+  os.write ("SCAL", 4);
+  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
+  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
+  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
+  os.write ("ALTW", 4);
+  os.write ((char*)UnpackLittle16 (d, heightScale), 2);
+  os.write ("\0\0", 2);
+  if (os.fail () || os.bad ()) {
+    os.clear ();
+    os.close ();
+    os.clear ();
+    DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Build and write each horizontal line to the file.  The values are
+  // converted from the storage format of the noise map a chunk at a time.
+  float values[VALUE_CHUNK_SIZE];
+  for (noise::int64 y = 0; y < height; y++) {
+    noise::uint8* pDest   = pLineBuffer;
+    for (noise::int64 x = 0; x < width; x += VALUE_CHUNK_SIZE) {
+      noise::int64 count = GetMin (width - x,
+        (noise::int64)VALUE_CHUNK_SIZE);
+      m_pSourceNoiseMap->GetSlabValues (x, y, count, values);
+      for (noise::int64 i = 0; i < count; i++) {
+        int16 scaledHeight = (int16)(floor (values[i] * 2.0));
+        UnpackLittle16 (pDest, scaledHeight);
+        pDest += 2;
+      }
+    }
+    os.write ((char*)pLineBuffer, (size_t)bufferSize);
+    if (os.fail () || os.bad ()) {
+      os.clear ();
+      os.close ();
+      os.clear ();
+      DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+      throw noise::ExceptionUnknown ();
+    }
+  }
+
+  os.close ();
+  os.clear ();
+  DeallocateArray (m_pAllocator, pLineBuffer, (size_t)bufferSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RegionMaskBitmap class
+
+RegionMaskBitmap::RegionMaskBitmap ():
+  m_blockCountX (0),
+  m_height (0),
+  m_width (0),
+  m_wordStride (0)
+{
+}
+
+RegionMaskBitmap::RegionMaskBitmap (noise::int64 width, noise::int64 height):
+  m_blockCountX (0),
+  m_height (0),
+  m_width (0),
+  m_wordStride (0)
+{
+  SetSize (width, height);
+}
+
+void RegionMaskBitmap::Clear (bool value)
+{
+  std::fill (m_bits.begin (), m_bits.end (),
+    value? ~(noise::uint64)0: (noise::uint64)0);
+  for (size_t i = 0; i < m_blockCounts.size (); i++) {
+    m_blockCounts[i] = value? GetBlockArea ((noise::int64)i % m_blockCountX,
+      (noise::int64)i / m_blockCountX): 0;
+  }
+}
+
+noise::uint32 RegionMaskBitmap::GetBlockArea (noise::int64 blockX,
+  noise::int64 blockY) const
+{
+  noise::int64 width  = GetMin (MASK_BLOCK_SIZE,
+    m_width  - blockX * MASK_BLOCK_SIZE);
+  noise::int64 height = GetMin (MASK_BLOCK_SIZE,
+    m_height - blockY * MASK_BLOCK_SIZE);
+  return (noise::uint32)(width * height);
+}
+
+MaskCoverage RegionMaskBitmap::GetCoverage (noise::int64 x, noise::int64 y,
+  noise::int64 width, noise::int64 height) const
+{
+  // Points outside the bitmap are never set.
+  noise::int64 x0 = GetMax (x, (noise::int64)0);
+  noise::int64 y0 = GetMax (y, (noise::int64)0);
+  noise::int64 x1 = GetMin (x + width , m_width );
+  noise::int64 y1 = GetMin (y + height, m_height);
+  if (x0 >= x1 || y0 >= y1) {
+    return MASK_COVERAGE_NONE;
+  }
+  bool isInside = (x0 == x && y0 == y && x1 == x + width
+    && y1 == y + height);
+
+  // A block that is all clear or all set decides its part of the
+  // rectangle; any other block may leave it partly covered.
+  bool isAnySet = false;
+  bool isAllSet = isInside;
+  for (noise::int64 blockY = y0 / MASK_BLOCK_SIZE;
+    blockY <= (y1 - 1) / MASK_BLOCK_SIZE; blockY++) {
+    for (noise::int64 blockX = x0 / MASK_BLOCK_SIZE;
+      blockX <= (x1 - 1) / MASK_BLOCK_SIZE; blockX++) {
+      noise::uint32 count
+        = m_blockCounts[(size_t)(blockY * m_blockCountX + blockX)];
+      if (count != 0) {
+        isAnySet = true;
+      }
+      if (count != GetBlockArea (blockX, blockY)) {
+        isAllSet = false;
+      }
+      if (isAnySet && !isAllSet) {
+        return MASK_COVERAGE_PARTIAL;
+      }
+    }
+  }
+  if (!isAnySet) {
+    return MASK_COVERAGE_NONE;
+  }
+  return isAllSet? MASK_COVERAGE_FULL: MASK_COVERAGE_PARTIAL;
+}
+
+void RegionMaskBitmap::GetRun (noise::int64 x, noise::int64 y,
+  noise::int64 count, bool* pDest) const
+{
+  for (noise::int64 i = 0; i < count; i++) {
+    pDest[i] = GetValue (x + i, y);
+  }
+}
+
+bool RegionMaskBitmap::GetValue (noise::int64 x, noise::int64 y) const
+{
+  if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+    return false;
+  }
+  noise::uint64 word = m_bits[(size_t)(y * m_wordStride + (x >> 6))];
+  return ((word >> (x & 63)) & 1) != 0;
+}
+
+void RegionMaskBitmap::SetSize (noise::int64 width, noise::int64 height)
+{
+  if (width < 0 || height < 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  noise::int64 wordStride = (width + 63) / 64;
+  noise::int64 blockCountX = (width  + MASK_BLOCK_SIZE - 1) / MASK_BLOCK_SIZE;
+  noise::int64 blockCountY = (height + MASK_BLOCK_SIZE - 1) / MASK_BLOCK_SIZE;
+  try {
+    m_bits.assign ((size_t)(wordStride * height), 0);
+    m_blockCounts.assign ((size_t)(blockCountX * blockCountY), 0);
+  }
+  catch (...) {
+    m_bits.clear ();
+    m_blockCounts.clear ();
+    m_blockCountX = 0;
+    m_width  = 0;
+    m_height = 0;
+    m_wordStride = 0;
+    throw noise::ExceptionOutOfMemory ();
+  }
+  m_blockCountX = blockCountX;
+  m_width  = width ;
+  m_height = height;
+  m_wordStride = wordStride;
+}
+
+void RegionMaskBitmap::SetValue (noise::int64 x, noise::int64 y, bool value)
+{
+  if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+    return;
+  }
+  noise::uint64& word = m_bits[(size_t)(y * m_wordStride + (x >> 6))];
+  noise::uint64 bit = (noise::uint64)1 << (x & 63);
+  if (((word & bit) != 0) == value) {
+    return;
+  }
+  word ^= bit;
+  noise::uint32& count = m_blockCounts[(size_t)(y / MASK_BLOCK_SIZE
+    * m_blockCountX + x / MASK_BLOCK_SIZE)];
+  if (value) {
+    ++count;
+  } else {
+    --count;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RegionMaskPolygon class
+
+RegionMaskPolygon::RegionMaskPolygon ()
+{
+}
+
+void RegionMaskPolygon::AddPolygon (const double* pVertices,
+  size_t vertexCount)
+{
+  if (pVertices == NULL || vertexCount < 3) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  size_t oldSize = m_edges.size ();
+  try {
+    for (size_t i = 0; i < vertexCount; i++) {
+      size_t next = (i + 1) % vertexCount;
+      m_edges.push_back (pVertices[i    * 2    ]);
+      m_edges.push_back (pVertices[i    * 2 + 1]);
+      m_edges.push_back (pVertices[next * 2    ]);
+      m_edges.push_back (pVertices[next * 2 + 1]);
+    }
+  }
+  catch (const std::bad_alloc&) {
+    m_edges.resize (oldSize);
+    throw noise::ExceptionOutOfMemory ();
+  }
+}
+
+void RegionMaskPolygon::Clear ()
+{
+  m_edges.clear ();
+}
+
+MaskCoverage RegionMaskPolygon::GetCoverage (noise::int64 x, noise::int64 y,
+  noise::int64 width, noise::int64 height) const
+{
+  if (width <= 0 || height <= 0) {
+    return MASK_COVERAGE_NONE;
+  }
+
+  // If no edge touches the rectangle spanned by the centers of the points,
+  // every center lies on the same side of every edge, so the first point
+  // decides the whole rectangle.
+  double x0 = (double)x + 0.5;
+  double y0 = (double)y + 0.5;
+  double x1 = (double)(x + width ) - 0.5;
+  double y1 = (double)(y + height) - 0.5;
+  for (size_t i = 0; i < m_edges.size (); i += 4) {
+    if (IsEdgeInRect (&m_edges[i], x0, y0, x1, y1)) {
+      return MASK_COVERAGE_PARTIAL;
+    }
+  }
+  return IsInside (x0, y0)? MASK_COVERAGE_FULL: MASK_COVERAGE_NONE;
+}
+
+void RegionMaskPolygon::GetRun (noise::int64 x, noise::int64 y,
+  noise::int64 count, bool* pDest) const
+{
+  // Find where the edges cross the line through the centers of the row,
+  // then walk along the row counting the crossings passed.
+  double yCenter = (double)y + 0.5;
+  std::vector<double> crossings;
+  for (size_t i = 0; i < m_edges.size (); i += 4) {
+    const double* pEdge = &m_edges[i];
+    if ((pEdge[1] <= yCenter) != (pEdge[3] <= yCenter)) {
+      crossings.push_back (pEdge[0] + (yCenter - pEdge[1])
+        * (pEdge[2] - pEdge[0]) / (pEdge[3] - pEdge[1]));
+    }
+  }
+  std::sort (crossings.begin (), crossings.end ());
+
+  size_t passedCount = 0;
+  for (noise::int64 i = 0; i < count; i++) {
+    double xCenter = (double)(x + i) + 0.5;
+    while (passedCount < crossings.size ()
+      && crossings[passedCount] <= xCenter) {
+      ++passedCount;
+    }
+    pDest[i] = ((crossings.size () - passedCount) & 1) != 0;
+  }
+}
+
+bool RegionMaskPolygon::IsEdgeInRect (const double* pEdge, double x0,
+  double y0, double x1, double y1)
+{
+  // Clip the edge against each side of the rectangle in turn.
+  double dx = pEdge[2] - pEdge[0];
+  double dy = pEdge[3] - pEdge[1];
+  double p[4] = {-dx, dx, -dy, dy};
+  double q[4] = {pEdge[0] - x0, x1 - pEdge[0], pEdge[1] - y0, y1 - pEdge[1]};
+  double tMin = 0.0;
+  double tMax = 1.0;
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0.0) {
+      if (q[i] < 0.0) {
+        return false;
+      }
+    } else {
+      double t = q[i] / p[i];
+      if (p[i] < 0.0) {
+        if (t > tMax) {
+          return false;
+        }
+        tMin = GetMax (tMin, t);
+      } else {
+        if (t < tMin) {
+          return false;
+        }
+        tMax = GetMin (tMax, t);
+      }
+    }
+  }
+  return true;
+}
+
+bool RegionMaskPolygon::IsInside (double x, double y) const
+{
+  bool isInside = false;
+  for (size_t i = 0; i < m_edges.size (); i += 4) {
+    const double* pEdge = &m_edges[i];
+    if ((pEdge[1] <= y) != (pEdge[3] <= y)) {
+      double xCrossing = pEdge[0] + (y - pEdge[1])
+        * (pEdge[2] - pEdge[0]) / (pEdge[3] - pEdge[1]);
+      if (xCrossing > x) {
+        isInside = !isInside;
+      }
+    }
+  }
+  return isInside;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilder class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    // Number of points along each side of the grid that finds the box
+    // containing the input values of a region of a noise map.
+    const noise::int64 RESAMPLE_BOUNDS_GRID_SIZE = 64;
+
+    // Returns the number of points on a grid with the given spacing along
+    // a side of the window with the given number of points.  The last
+    // point of the grid lies on the edge of the window.
+    inline noise::int64 GetLatticeCount (noise::int64 pointCount,
+      noise::int64 step)
+    {
+      return (pointCount - 2) / step + 2;
+    }
+
+    // Finds the cells, along a side of a grid with the given spacing, that
+    // touch a point at the given coordinate.  Returns true if the point
+    // does not lie on the grid, in which case a single cell touches it.
+    inline bool GetAdjacentCells (noise::int64 coord,
+      noise::int64 pointCount, noise::int64 step, noise::int64& cell0,
+      noise::int64& cell1)
+    {
+      if (coord == pointCount - 1) {
+        cell0 = cell1 = (pointCount - 2) / step;
+        return false;
+      }
+      cell1 = coord / step;
+      if (coord % step != 0) {
+        cell0 = cell1;
+        return true;
+      }
+      cell0 = (coord > 0)? cell1 - 1: cell1;
+      return false;
+    }
+
+    // Determines if a noise module passes input values to its source
+    // modules other than those it was given.
+    inline bool IsPointMovingModule (const module::Module* pModule)
+    {
+      return dynamic_cast<const module::Displace*> (pModule) != NULL
+        || dynamic_cast<const module::RotatePoint*> (pModule) != NULL
+        || dynamic_cast<const module::ScalePoint*> (pModule) != NULL
+        || dynamic_cast<const module::TranslatePoint*> (pModule) != NULL
+        || dynamic_cast<const module::Turbulence*> (pModule) != NULL;
+    }
+
+    // Finds the resampling modules in a source module graph that receive
+    // the input values of a builder unchanged.  Builders hold the graph
+    // through const pointers like every libnoise module, but preparing a
+    // lattice is an explicit step that changes the resampling module, so
+    // the modules are returned as non-const pointers.
+    void FindResampleModules (const module::Module* pSourceModule,
+      std::vector<module::Resample*>& resampleModules)
+    {
+      std::vector<const module::Module*> pendingModules (1, pSourceModule);
+      std::vector<const module::Module*> visitedModules;
+      while (!pendingModules.empty ()) {
+        const module::Module* pModule = pendingModules.back ();
+        pendingModules.pop_back ();
+        if (std::find (visitedModules.begin (), visitedModules.end (),
+          pModule) != visitedModules.end () || IsPointMovingModule (pModule)) {
+          continue;
+        }
+        visitedModules.push_back (pModule);
+        const module::Resample* pResample
+          = dynamic_cast<const module::Resample*> (pModule);
+        if (pResample != NULL) {
+          resampleModules.push_back (const_cast<module::Resample*> (
+            pResample));
+        }
+        for (int i = 0; i < pModule->GetSourceModuleCount (); i++) {
+          try {
+            pendingModules.push_back (&pModule->GetSourceModule (i));
+          }
+          catch (const noise::ExceptionNoModule&) {
+          }
+        }
+      }
+    }
+
+  }
+
+}
+
+NoiseMapBuilder::NoiseMapBuilder ():
+  m_pCallback (NULL),
+  m_pCallback64 (NULL),
+  m_adaptiveCellSize (DEFAULT_ADAPTIVE_CELL_SIZE),
+  m_adaptiveTolerance (0.0),
+  m_builtPointCount (0),
+  m_destHeight (0),
+  m_destWidth  (0),
+  m_pDestNoiseMap (NULL),
+  m_builtLastOctave (0),
+  m_firstOctave (0),
+  m_lastOctave (0),
+  m_maskBlockCountX (0),
+  m_maskFirstBlockX (0),
+  m_maskFirstBlockY (0),
+  m_pExecutor (NULL),
+  m_pMask (NULL),
+  m_pOctaveBillow (NULL),
+  m_pOctavePerlin (NULL),
+  m_pOctaveRidged (NULL),
+  m_pPassCallback (NULL),
+  m_pPassContext (NULL),
+  m_passStep (1),
+  m_progressiveStep (1),
+  m_pSourceModule (NULL),
+  m_windowHeight (0),
+  m_windowWidth  (0),
+  m_windowX (0),
+  m_windowY (0)
+{
+}
+
+void NoiseMapBuilder::BuildRows ()
+{
+  noise::int64 width  = GetDestWindowWidth  ();
+  noise::int64 height = GetDestWindowHeight ();
+
+  // A range of octaves that does not start at octave 0 is added to the
+  // values of the previous build, so the destination noise map keeps them.
+  // Find the type of the source module once, so that the rows do not
+  // cast it for each slab.
+  bool isAdding = (m_lastOctave > 0 && m_firstOctave > 0);
+  m_pOctaveBillow = NULL;
+  m_pOctavePerlin = NULL;
+  m_pOctaveRidged = NULL;
+  const module::RidgedMulti* pRidged = NULL;
+  if (m_lastOctave > 0) {
+    int maxOctave;
+    pRidged = dynamic_cast<const module::RidgedMulti*> (m_pSourceModule);
+    m_pOctavePerlin = dynamic_cast<const module::Perlin*> (m_pSourceModule);
+    m_pOctaveBillow = dynamic_cast<const module::Billow*> (m_pSourceModule);
+    m_pOctaveRidged = pRidged;
+    if (pRidged != NULL) {
+      maxOctave = module::RIDGED_MAX_OCTAVE;
+    } else if (m_pOctavePerlin != NULL) {
+      maxOctave = module::PERLIN_MAX_OCTAVE;
+    } else if (m_pOctaveBillow != NULL) {
+      maxOctave = module::BILLOW_MAX_OCTAVE;
+    } else {
+      throw noise::ExceptionInvalidParam ();
+    }
+    double inputX, inputY, inputZ;
+    if (m_lastOctave > maxOctave
+      || !GetPointPosition (m_windowX, m_windowY, inputX, inputY, inputZ)) {
+      throw noise::ExceptionInvalidParam ();
+    }
+    if (isAdding && (m_builtLastOctave != m_firstOctave
+      || m_pDestNoiseMap->GetWidth  () != width
+      || m_pDestNoiseMap->GetHeight () != height
+      || (pRidged != NULL
+        && m_octaveWeights.size () != (size_t)(width * height)))) {
+      throw noise::ExceptionInvalidParam ();
+    }
+  }
+  m_builtLastOctave = 0;
+  PrepareResampleModules (m_windowX, m_windowY, width, height);
+
+  if (!isAdding) {
+    // Resize the destination noise map so that it can store the new output
+    // values from the source model.
+    m_pDestNoiseMap->SetSize (width, height);
+
+    // Every point of a ridged-multifractal noise module starts with a
+    // weight of 1.0.
+    if (pRidged != NULL) {
+      try {
+        m_octaveWeights.assign ((size_t)(width * height), 1.0);
+      }
+      catch (const std::bad_alloc&) {
+        throw noise::ExceptionOutOfMemory ();
+      }
+    } else {
+      std::vector<double> ().swap (m_octaveWeights);
+    }
+  }
+
+  // Find the coverage of each mask block once, so that the rows only look
+  // at the mask where a block is partly covered.
+  if (m_pMask != NULL) {
+    noise::int64 x0 = m_windowX;
+    noise::int64 y0 = m_windowY;
+    noise::int64 x1 = m_windowX + GetDestWindowWidth  ();
+    noise::int64 y1 = m_windowY + GetDestWindowHeight ();
+    m_maskFirstBlockX = x0 / MASK_BLOCK_SIZE;
+    m_maskFirstBlockY = y0 / MASK_BLOCK_SIZE;
+    m_maskBlockCountX = (x1 - 1) / MASK_BLOCK_SIZE - m_maskFirstBlockX + 1;
+    noise::int64 blockCountY = (y1 - 1) / MASK_BLOCK_SIZE
+      - m_maskFirstBlockY + 1;
+    try {
+      m_maskCoverage.resize ((size_t)(m_maskBlockCountX * blockCountY));
+    }
+    catch (const std::bad_alloc&) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    for (noise::int64 blockY = 0; blockY < blockCountY; blockY++) {
+      for (noise::int64 blockX = 0; blockX < m_maskBlockCountX; blockX++) {
+        noise::int64 left   = GetMax (x0,
+          (m_maskFirstBlockX + blockX) * MASK_BLOCK_SIZE);
+        noise::int64 right  = GetMin (x1,
+          (m_maskFirstBlockX + blockX + 1) * MASK_BLOCK_SIZE);
+        noise::int64 bottom = GetMax (y0,
+          (m_maskFirstBlockY + blockY) * MASK_BLOCK_SIZE);
+        noise::int64 top    = GetMin (y1,
+          (m_maskFirstBlockY + blockY + 1) * MASK_BLOCK_SIZE);
+        m_maskCoverage[(size_t)(blockY * m_maskBlockCountX + blockX)]
+          = (noise::uint8)m_pMask->GetCoverage (left, bottom, right - left,
+            top - bottom);
+      }
+    }
+  }
+
+  if (m_adaptiveTolerance > 0.0 && m_lastOctave == 0 && width > 1
+    && height > 1) {
+    // Calculate the corners of a coarse grid of cells.  Then, one level at
+    // a time, test each cell against the points that would divide it, and
+    // divide it only if interpolation between its corners is not accurate
+    // enough.
+    m_passStep = m_adaptiveCellSize;
+    noise::int64 cellCountX = GetLatticeCount (width,  m_passStep) - 1;
+    noise::int64 cellCountY = GetLatticeCount (height, m_passStep) - 1;
+    try {
+      m_adaptiveTested.assign ((size_t)(cellCountX * cellCountY), 1);
+    }
+    catch (const std::bad_alloc&) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    try {
+      m_rowCounts.assign ((size_t)(cellCountY + 1), 0);
+    }
+    catch (const std::bad_alloc&) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    RunRows (GetExecutor (), *this, &NoiseMapBuilder::BuildAdaptiveGridRow,
+      cellCountY + 1, NULL);
+    m_builtPointCount = GetRowCountTotal ();
+
+    for (; m_passStep > 1; m_passStep /= 2) {
+      noise::int64 nextStep = m_passStep / 2;
+      noise::int64 nextRowCount = GetLatticeCount (height, nextStep);
+      try {
+        m_rowCounts.assign ((size_t)nextRowCount, 0);
+        m_adaptiveNextTested.assign ((size_t)((nextStep > 1)
+          ? (GetLatticeCount (width, nextStep) - 1) * (nextRowCount - 1)
+          : 0), 0);
+      }
+      catch (const std::bad_alloc&) {
+        throw noise::ExceptionOutOfMemory ();
+      }
+      RunRows (GetExecutor (), *this,
+        &NoiseMapBuilder::BuildAdaptivePointRow, nextRowCount, NULL);
+      RunRows (GetExecutor (), *this, &NoiseMapBuilder::TestAdaptiveCellRow,
+        GetLatticeCount (height, m_passStep) - 1, NULL);
+      m_builtPointCount += GetRowCountTotal ();
+      m_adaptiveTested.swap (m_adaptiveNextTested);
+    }
+    std::vector<noise::uint8> ().swap (m_adaptiveTested);
+    std::vector<noise::uint8> ().swap (m_adaptiveNextTested);
+    if (m_pPassCallback != NULL) {
+      m_pPassCallback (1, m_pPassContext);
+    }
+    return;
+  }
+
+  // Calculate the points on a coarse grid first, then halve the spacing of
+  // the grid in each pass.  A build with a step of 1, or of a range of
+  // octaves, has a single pass.
+  m_passStep = (m_lastOctave > 0)? 1: m_progressiveStep;
+  try {
+    m_rowCounts.assign ((size_t)height, 0);
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  m_builtPointCount = 0;
+  for (; m_passStep > 1; m_passStep /= 2) {
+    std::fill (m_rowCounts.begin (), m_rowCounts.end (), 0);
+    RunRows (GetExecutor (), *this, &NoiseMapBuilder::BuildPassRow,
+      (height - 1) / m_passStep + 1, NULL);
+    RunRows (GetExecutor (), *this, &NoiseMapBuilder::UpsampleRow, height,
+      NULL);
+    m_builtPointCount += GetRowCountTotal ();
+    if (m_pPassCallback != NULL
+      && !m_pPassCallback (m_passStep, m_pPassContext)) {
+      return;
+    }
+  }
+  std::fill (m_rowCounts.begin (), m_rowCounts.end (), 0);
+  RunRows (GetExecutor (), *this, &NoiseMapBuilder::BuildPassRow, height,
+    m_pCallback, m_pCallback64);
+  m_builtLastOctave = m_lastOctave;
+  m_builtPointCount += GetRowCountTotal ();
+  if (m_pPassCallback != NULL) {
+    m_pPassCallback (1, m_pPassContext);
+  }
+}
+
+void NoiseMapBuilder::BuildAdaptiveGridRow (noise::int64 index) const
+{
+  // The last row and column of the grid lie on the edges of the window.
+  noise::int64 width  = GetDestWindowWidth  ();
+  noise::int64 height = GetDestWindowHeight ();
+  noise::int64 step = m_passStep;
+  noise::int64 y = GetMin (index * step, height - 1);
+  noise::int64 evalCount = 0;
+  for (noise::int64 i = 0; i < GetLatticeCount (width, step); i++) {
+    evalCount += BuildRowPart (y, GetMin (i * step, width - 1), 1);
+  }
+  m_rowCounts[(size_t)index] = evalCount;
+}
+
+void NoiseMapBuilder::BuildAdaptivePointRow (noise::int64 index) const
+{
+  noise::int64 width  = GetDestWindowWidth  ();
+  noise::int64 height = GetDestWindowHeight ();
+  noise::int64 step = m_passStep;
+  noise::int64 nextStep = step / 2;
+
+  // Calculate each point of the next level that is not a point of the
+  // current level, if a cell that touches it is being tested.
+  noise::int64 y = GetMin (index * nextStep, height - 1);
+  noise::int64 cellY0, cellY1;
+  bool isNewRow = GetAdjacentCells (y, height, step, cellY0, cellY1);
+  noise::int64 evalCount = 0;
+  for (noise::int64 i = 0; i < GetLatticeCount (width, nextStep); i++) {
+    noise::int64 x = GetMin (i * nextStep, width - 1);
+    noise::int64 cellX0, cellX1;
+    bool isNewColumn = GetAdjacentCells (x, width, step, cellX0, cellX1);
+    if (!isNewRow && !isNewColumn) {
+      continue;
+    }
+    if (IsAdaptiveCellTested (cellX0, cellY0)
+      || IsAdaptiveCellTested (cellX1, cellY0)
+      || IsAdaptiveCellTested (cellX0, cellY1)
+      || IsAdaptiveCellTested (cellX1, cellY1)) {
+      evalCount += BuildRowPart (y, x, 1);
+    }
+  }
+  m_rowCounts[(size_t)index] = evalCount;
+}
+
+void NoiseMapBuilder::BuildPassRow (noise::int64 index) const
+{
+  noise::int64 width = GetDestWindowWidth ();
+  noise::int64 step = m_passStep;
+  noise::int64 row = index * step;
+  noise::int64 evalCount = 0;
+  if (step == m_progressiveStep || index % 2 != 0) {
+    // No earlier pass calculated any point of this row.
+    if (step == 1) {
+      m_rowCounts[(size_t)index] = BuildRowPart (row, 0, width);
+      return;
+    }
+    for (noise::int64 x = 0; x < width; x += step) {
+      evalCount += BuildRowPart (row, x, 1);
+    }
+  } else {
+    // The earlier passes calculated every other point of this pass.
+    for (noise::int64 x = step; x < width; x += step * 2) {
+      evalCount += BuildRowPart (row, x, 1);
+    }
+  }
+  m_rowCounts[(size_t)index] = evalCount;
+}
+
+noise::int64 NoiseMapBuilder::BuildRow (noise::int64 row) const
+{
+  return BuildRowPart (row, 0, GetDestWindowWidth ());
+}
+
+noise::int64 NoiseMapBuilder::BuildRowPart (noise::int64 row, noise::int64 x,
+  noise::int64 count) const
+{
+  if (m_pDestNoiseMap->GetFormat () == FORMAT_FLOAT32) {
+    return FillMaskedSlab (m_pDestNoiseMap->GetSlabPtr (x, row),
+      m_windowX + x, m_windowY + row, count);
+  }
+
+  // Fill a chunk of floating-point values, then convert them to the
+  // storage format of the destination noise map.
+  float values[VALUE_CHUNK_SIZE];
+  noise::int64 evalCount = 0;
+  noise::int64 end = x + count;
+  for (noise::int64 i = x; i < end; i += VALUE_CHUNK_SIZE) {
+    noise::int64 chunkCount = GetMin (end - i,
+      (noise::int64)VALUE_CHUNK_SIZE);
+    evalCount += FillMaskedSlab (values, m_windowX + i, m_windowY + row,
+      chunkCount);
+    m_pDestNoiseMap->SetSlabValues (i, row, chunkCount, values);
+  }
+  return evalCount;
+}
+
+void NoiseMapBuilder::FillAngleTable (AngleTable& table, double lowerBound,
+  double upperBound, noise::int64 count)
+{
+  if (table.cosines.size () == (size_t)count
+    && table.lowerBound == lowerBound
+    && table.upperBound == upperBound) {
+    return;
+  }
+
+  // Calculate each angle from its index, exactly as GetTableAngle() does
+  // without a table.
+  double delta = (upperBound - lowerBound) / (double)count;
+  table.cosines.resize ((size_t)count);
+  table.sines.resize ((size_t)count);
+  for (noise::int64 i = 0; i < count; i++) {
+    double angle = lowerBound + (double)i * delta;
+    table.cosines[(size_t)i] = cos (angle * DEG_TO_RAD);
+    table.sines  [(size_t)i] = sin (angle * DEG_TO_RAD);
+  }
+  table.lowerBound = lowerBound;
+  table.upperBound = upperBound;
+}
+
+noise::int64 NoiseMapBuilder::FillMaskedSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  if (m_pMask == NULL) {
+    if (m_lastOctave > 0) {
+      FillOctaveSlab (pDest, x, y, count);
+    } else {
+      FillSlab (pDest, x, y, count);
+    }
+    return count;
+  }
+
+  // Handle the part of the slab in each mask block on its own.
+  float borderValue = m_pDestNoiseMap->GetBorderValue ();
+  const noise::uint8* pCoverage = &m_maskCoverage[(size_t)((y
+    / MASK_BLOCK_SIZE - m_maskFirstBlockY) * m_maskBlockCountX)];
+  noise::int64 evalCount = 0;
+  noise::int64 end = x + count;
+  while (x < end) {
+    noise::int64 blockX = x / MASK_BLOCK_SIZE;
+    noise::int64 runCount = GetMin (end, (blockX + 1) * MASK_BLOCK_SIZE) - x;
+    switch ((MaskCoverage)pCoverage[blockX - m_maskFirstBlockX]) {
+      case MASK_COVERAGE_NONE:
+        std::fill (pDest, pDest + runCount, borderValue);
+        break;
+      case MASK_COVERAGE_FULL:
+        if (m_lastOctave > 0) {
+          FillOctaveSlab (pDest, x, y, runCount);
+        } else {
+          FillSlab (pDest, x, y, runCount);
+        }
+        evalCount += runCount;
+        break;
+      case MASK_COVERAGE_PARTIAL: {
+        // Calculate each run of set points with a single call.
+        bool isSet[MASK_BLOCK_SIZE];
+        m_pMask->GetRun (x, y, runCount, isSet);
+        noise::int64 i = 0;
+        while (i < runCount) {
+          noise::int64 j = i + 1;
+          while (j < runCount && isSet[j] == isSet[i]) {
+            ++j;
+          }
+          if (isSet[i] && m_lastOctave > 0) {
+            FillOctaveSlab (pDest + i, x + i, y, j - i);
+          } else if (isSet[i]) {
+            FillSlab (pDest + i, x + i, y, j - i);
+          } else {
+            std::fill (pDest + i, pDest + j, borderValue);
+          }
+          if (isSet[i]) {
+            evalCount += j - i;
+          }
+          i = j;
+        }
+        break;
+      }
+    }
+    pDest += runCount;
+    x += runCount;
+  }
+  return evalCount;
+}
+
+void NoiseMapBuilder::FillOctaveSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  const module::Perlin* pPerlin = m_pOctavePerlin;
+  const module::Billow* pBillow = m_pOctaveBillow;
+  const module::RidgedMulti* pRidged = m_pOctaveRidged;
+
+  // The weights and the values of the previous build are stored relative
+  // to the window.
+  noise::int64 windowX = x - m_windowX;
+  noise::int64 windowY = y - m_windowY;
+  double* pWeights = NULL;
+  if (pRidged != NULL) {
+    pWeights = &m_octaveWeights[(size_t)(windowY * GetDestWindowWidth ()
+      + windowX)];
+  }
+
+  for (noise::int64 i = 0; i < count; i++) {
+    double inputX, inputY, inputZ;
+    GetPointPosition (x + i, y, inputX, inputY, inputZ);
+    double value;
+    if (pRidged != NULL) {
+      value = pRidged->GetOctaveRangeValue (inputX, inputY, inputZ,
+        m_firstOctave, m_lastOctave, pWeights[i]);
+    } else if (pPerlin != NULL) {
+      value = pPerlin->GetOctaveRangeValue (inputX, inputY, inputZ,
+        m_firstOctave, m_lastOctave);
+    } else {
+      value = pBillow->GetOctaveRangeValue (inputX, inputY, inputZ,
+        m_firstOctave, m_lastOctave);
+    }
+    if (m_firstOctave > 0) {
+      value += m_pDestNoiseMap->GetValue (windowX + i, windowY);
+    }
+    pDest[i] = (float)value;
+  }
+}
+
+bool NoiseMapBuilder::GetPointPosition (noise::int64 /* x */,
+  noise::int64 /* y */, double& /* inputX */, double& /* inputY */,
+  double& /* inputZ */) const
+{
+  return false;
+}
+
+noise::int64 NoiseMapBuilder::GetRowCountTotal () const
+{
+  noise::int64 total = 0;
+  for (size_t i = 0; i < m_rowCounts.size (); i++) {
+    total += m_rowCounts[i];
+  }
+  return total;
+}
+
+void NoiseMapBuilder::GetSlabValues (noise::int64 x, noise::int64 y,
+  noise::int64 count, float* pDest) const
+{
+  if (m_pSourceModule == NULL || m_destWidth <= 0 || m_destHeight <= 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  FillSlab (pDest, x, y, count);
+}
+
+void NoiseMapBuilder::GetTableAngle (const AngleTable& table,
+  double lowerBound, double upperBound, noise::int64 count,
+  noise::int64 index, double& cosAngle, double& sinAngle)
+{
+  if (table.cosines.size () == (size_t)count
+    && table.lowerBound == lowerBound
+    && table.upperBound == upperBound
+    && index >= 0 && index < count) {
+    cosAngle = table.cosines[(size_t)index];
+    sinAngle = table.sines  [(size_t)index];
+  } else {
+    double angle = lowerBound + (double)index
+      * ((upperBound - lowerBound) / (double)count);
+    cosAngle = cos (angle * DEG_TO_RAD);
+    sinAngle = sin (angle * DEG_TO_RAD);
+  }
+}
+
+bool NoiseMapBuilder::IsAdaptiveCellTested (noise::int64 cellX,
+  noise::int64 cellY) const
+{
+  noise::int64 cellCountX = GetLatticeCount (GetDestWindowWidth (),
+    m_passStep) - 1;
+  noise::int64 cellCountY = GetLatticeCount (GetDestWindowHeight (),
+    m_passStep) - 1;
+  if (cellX < 0 || cellX >= cellCountX || cellY < 0 || cellY >= cellCountY) {
+    return false;
+  }
+  return m_adaptiveTested[(size_t)(cellY * cellCountX + cellX)] != 0;
+}
+
+bool NoiseMapBuilder::IsPointSelected (noise::int64 x, noise::int64 y) const
+{
+  if (m_pMask == NULL) {
+    return true;
+  }
+
+  x += m_windowX;
+  y += m_windowY;
+  switch ((MaskCoverage)m_maskCoverage[(size_t)((y / MASK_BLOCK_SIZE
+    - m_maskFirstBlockY) * m_maskBlockCountX + x / MASK_BLOCK_SIZE
+    - m_maskFirstBlockX)]) {
+    case MASK_COVERAGE_NONE:
+      return false;
+    case MASK_COVERAGE_FULL:
+      return true;
+    default: {
+      bool isSet;
+      m_pMask->GetRun (x, y, 1, &isSet);
+      return isSet;
+    }
+  }
+}
+
+bool NoiseMapBuilder::IsDestWindowValid () const
+{
+  return m_destWidth > 0
+    && m_destHeight > 0
+    && m_windowX >= 0
+    && m_windowY >= 0
+    && m_windowX <= m_destWidth  - GetDestWindowWidth  ()
+    && m_windowY <= m_destHeight - GetDestWindowHeight ();
+}
+
+void NoiseMapBuilder::PrepareResampleModules (noise::int64 x,
+  noise::int64 y, noise::int64 width, noise::int64 height) const
+{
+  if (m_pSourceModule == NULL || width <= 0 || height <= 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Find the resampling modules that receive the input values of the
+  // builder unchanged.
+  std::vector<module::Resample*> resampleModules;
+  FindResampleModules (m_pSourceModule, resampleModules);
+  if (resampleModules.empty ()) {
+    return;
+  }
+
+  // Find the box that contains the input values at a grid of points in
+  // the region.
+  noise::int64 stepX = GetMax<noise::int64> (1,
+    (width  - 1) / RESAMPLE_BOUNDS_GRID_SIZE);
+  noise::int64 stepY = GetMax<noise::int64> (1,
+    (height - 1) / RESAMPLE_BOUNDS_GRID_SIZE);
+  double lower[3];
+  double upper[3];
+  for (noise::int64 j = 0; j < height; j += stepY) {
+    noise::int64 curY = y + ((j + stepY < height)? j: height - 1);
+    for (noise::int64 i = 0; i < width; i += stepX) {
+      noise::int64 curX = x + ((i + stepX < width)? i: width - 1);
+      double position[3];
+      if (!GetPointPosition (curX, curY, position[0], position[1],
+        position[2])) {
+        return;
+      }
+      for (int axis = 0; axis < 3; axis++) {
+        if (i == 0 && j == 0) {
+          lower[axis] = upper[axis] = position[axis];
+        } else {
+          lower[axis] = GetMin (lower[axis], position[axis]);
+          upper[axis] = GetMax (upper[axis], position[axis]);
+        }
+      }
+    }
+  }
+
+  // A curved surface may bulge out of the box between the grid points, so
+  // pad the box a little.
+  double padding = 0.0;
+  for (int axis = 0; axis < 3; axis++) {
+    padding = GetMax (padding, (upper[axis] - lower[axis])
+      / (double)RESAMPLE_BOUNDS_GRID_SIZE);
+  }
+  for (size_t i = 0; i < resampleModules.size (); i++) {
+    resampleModules[i]->Prepare (lower[0] - padding, lower[1] - padding,
+      lower[2] - padding, upper[0] + padding, upper[1] + padding,
+      upper[2] + padding);
+  }
+}
+
+void NoiseMapBuilder::SetCallback (NoiseMapCallback pCallback)
+{
+  m_pCallback = pCallback;
+}
+
+void NoiseMapBuilder::SetCallback64 (NoiseMapCallback64 pCallback)
+{
+  m_pCallback64 = pCallback;
+}
+
+void NoiseMapBuilder::TestAdaptiveCellRow (noise::int64 index) const
+{
+  noise::int64 width  = GetDestWindowWidth  ();
+  noise::int64 height = GetDestWindowHeight ();
+  noise::int64 step = m_passStep;
+  noise::int64 nextStep = step / 2;
+  noise::int64 cellCountX = GetLatticeCount (width, step) - 1;
+  noise::int64 nextCellCountX = GetLatticeCount (width, nextStep) - 1;
+  float borderValue = m_pDestNoiseMap->GetBorderValue ();
+
+  // Find the points of the next level that divide the cells of this row.
+  noise::int64 ys[3];
+  int yCount = 2;
+  ys[0] = index * step;
+  ys[1] = GetMin (ys[0] + step, height - 1);
+  ys[2] = ys[1];
+  if (ys[0] + nextStep < ys[1]) {
+    ys[1] = ys[0] + nextStep;
+    yCount = 3;
+  }
+  noise::int64 y0 = ys[0];
+  noise::int64 y1 = ys[yCount - 1];
+
+  for (noise::int64 cellX = 0; cellX < cellCountX; cellX++) {
+    if (!IsAdaptiveCellTested (cellX, index)) {
+      continue;
+    }
+    noise::int64 xs[3];
+    int xCount = 2;
+    xs[0] = cellX * step;
+    xs[1] = GetMin (xs[0] + step, width - 1);
+    xs[2] = xs[1];
+    if (xs[0] + nextStep < xs[1]) {
+      xs[1] = xs[0] + nextStep;
+      xCount = 3;
+    }
+    noise::int64 x0 = xs[0];
+    noise::int64 x1 = xs[xCount - 1];
+    if (xCount == 2 && yCount == 2) {
+      // A cell on the edge of the window may be too narrow to divide at
+      // this level, so test it again at the next level.
+      if (nextStep > 1) {
+        m_adaptiveNextTested[(size_t)(index * 2 * nextCellCountX
+          + cellX * 2)] = 1;
+      }
+      continue;
+    }
+
+    // Compare the points that divide the cell with the values interpolated
+    // from its corners.  A cell that straddles the edge of the mask is
+    // always divided, since its border values do not predict the rest.
+    double values[3][3];
+    int selectedCount = 0;
+    for (int j = 0; j < yCount; j++) {
+      for (int i = 0; i < xCount; i++) {
+        values[j][i] = m_pDestNoiseMap->GetValue (xs[i], ys[j]);
+        if (IsPointSelected (xs[i], ys[j])) {
+          selectedCount++;
+        }
+      }
+    }
+    bool isSelected = (selectedCount == xCount * yCount);
+    double v00 = values[0         ][0         ];
+    double v10 = values[0         ][xCount - 1];
+    double v01 = values[yCount - 1][0         ];
+    double v11 = values[yCount - 1][xCount - 1];
+    double error = 0.0;
+    for (int j = 0; j < yCount; j++) {
+      double yAlpha = (double)(ys[j] - y0) / (double)(y1 - y0);
+      for (int i = 0; i < xCount; i++) {
+        double xAlpha = (double)(xs[i] - x0) / (double)(x1 - x0);
+        double predicted = LinearInterp (LinearInterp (v00, v10, xAlpha),
+          LinearInterp (v01, v11, xAlpha), yAlpha);
+        error = GetMax (error, fabs (values[j][i] - predicted));
+      }
+    }
+
+    if (error > m_adaptiveTolerance || (selectedCount > 0 && !isSelected)) {
+      // Test the parts of the cell at the next level.  The parts of the
+      // last level hold no points but their corners.
+      if (nextStep > 1) {
+        for (int j = 0; j < yCount - 1; j++) {
+          for (int i = 0; i < xCount - 1; i++) {
+            m_adaptiveNextTested[(size_t)((index * 2 + j) * nextCellCountX
+              + cellX * 2 + i)] = 1;
+          }
+        }
+      }
+      continue;
+    }
+
+    // Interpolate the rest of the cell.  Selected points in a cell that lies
+    // outside the mask are calculated instead.
+    noise::int64 evalCount = 0;
+    noise::int64 xEnd = (x1 == width  - 1)? x1: x1 - 1;
+    noise::int64 yEnd = (y1 == height - 1)? y1: y1 - 1;
+    for (noise::int64 y = y0; y <= yEnd; y++) {
+      bool isDivRow = (y == ys[0] || y == ys[1] || y == ys[2]);
+      double yAlpha = (double)(y - y0) / (double)(y1 - y0);
+      double left  = LinearInterp (v00, v01, yAlpha);
+      double right = LinearInterp (v10, v11, yAlpha);
+      for (noise::int64 x = x0; x <= xEnd; x++) {
+        if (isDivRow && (x == xs[0] || x == xs[1] || x == xs[2])) {
+          continue;
+        }
+        if (!IsPointSelected (x, y)) {
+          m_pDestNoiseMap->SetValue (x, y, borderValue);
+        } else if (!isSelected) {
+          evalCount += BuildRowPart (y, x, 1);
+        } else {
+          double xAlpha = (double)(x - x0) / (double)(x1 - x0);
+          m_pDestNoiseMap->SetValue (x, y,
+            (float)LinearInterp (left, right, xAlpha));
+        }
+      }
+    }
+    // No other row of cells counts its points in this row of the grid of
+    // the next level.
+    m_rowCounts[(size_t)(index * 2)] += evalCount;
+  }
+}
+
+void NoiseMapBuilder::UpsampleRow (noise::int64 row) const
+{
+  noise::int64 width  = GetDestWindowWidth  ();
+  noise::int64 height = GetDestWindowHeight ();
+  noise::int64 step = m_passStep;
+
+  // Find the rows of calculated points below and above this row.  Beyond
+  // the last calculated row or column, the values are extended.
+  noise::int64 lastX = ((width  - 1) / step) * step;
+  noise::int64 lastY = ((height - 1) / step) * step;
+  noise::int64 y0 = row - row % step;
+  noise::int64 y1 = GetMin (y0 + step, lastY);
+  double yAlpha = (y1 > y0)? (double)(row - y0) / (double)step: 0.0;
+  bool isCalcRow = (row == y0);
+
+  for (noise::int64 x0 = 0; x0 < width; x0 += step) {
+    noise::int64 x1 = GetMin (x0 + step, lastX);
+    double left = LinearInterp (m_pDestNoiseMap->GetValue (x0, y0),
+      m_pDestNoiseMap->GetValue (x0, y1), yAlpha);
+    double right = LinearInterp (m_pDestNoiseMap->GetValue (x1, y0),
+      m_pDestNoiseMap->GetValue (x1, y1), yAlpha);
+    noise::int64 xEnd = GetMin (x0 + step, width);
+    for (noise::int64 x = isCalcRow? x0 + 1: x0; x < xEnd; x++) {
+      double xAlpha = (x1 > x0)? (double)(x - x0) / (double)step: 0.0;
+      m_pDestNoiseMap->SetValue (x, row,
+        (float)LinearInterp (left, right, xAlpha));
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilderCube class
+
+NoiseMapBuilderCube::NoiseMapBuilderCube ():
+  m_face (CUBE_FACE_POS_X),
+  m_isAtlasEnabled (false)
+{
+}
+
+void NoiseMapBuilderCube::Build ()
+{
+  noise::int64 faceCount = m_isAtlasEnabled? CUBE_FACE_COUNT: 1;
+  if ( m_destWidth != faceCount * m_destHeight
+    || !IsDestWindowValid ()
+    || m_pSourceModule == NULL
+    || m_pDestNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Fill every point in the noise map with the output values from the model.
+  BuildRows ();
+}
+
+void NoiseMapBuilderCube::FillSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  for (noise::int64 i = 0; i < count; i++) {
+    double inputX, inputY, inputZ;
+    GetPointPosition (x + i, y, inputX, inputY, inputZ);
+    *pDest++ = (float)m_pSourceModule->GetValue (inputX, inputY, inputZ);
+  }
+}
+
+bool NoiseMapBuilderCube::GetPointPosition (noise::int64 x,
+  noise::int64 y, double& inputX, double& inputY, double& inputZ) const
+{
+  // The face is as tall as the noise map, and the faces of an atlas lie
+  // side by side.  Each point lies at the center of its cell.
+  noise::int64 faceSize = m_destHeight;
+  CubeFace face = m_face;
+  if (m_isAtlasEnabled) {
+    face = (CubeFace)ClampValue ((int)(x / faceSize), 0,
+      CUBE_FACE_COUNT - 1);
+    x -= (noise::int64)face * faceSize;
+  }
+  double delta = 2.0 / (double)faceSize;
+  double s = -1.0 + ((double)x + 0.5) * delta;
+  double t = -1.0 + ((double)y + 0.5) * delta;
+  CubeFaceToXYZ (face, s, t, inputX, inputY, inputZ);
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilderCylinder class
+
+NoiseMapBuilderCylinder::NoiseMapBuilderCylinder ():
+  m_lowerAngleBound  (0.0),
+  m_lowerHeightBound (0.0),
+  m_upperAngleBound  (0.0),
+  m_upperHeightBound (0.0)
+{
+}
+
+void NoiseMapBuilderCylinder::Build ()
+{
+  if ( m_upperAngleBound <= m_lowerAngleBound
+    || m_upperHeightBound <= m_lowerHeightBound
+    || !IsDestWindowValid ()
+    || m_pSourceModule == NULL
+    || m_pDestNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // The angle only depends on the column, so calculate its cosine and sine
+  // once per column rather than once per point.
+  FillAngleTable (m_angleTable, m_lowerAngleBound, m_upperAngleBound,
+    m_destWidth);
+
+  // Fill every point in the noise map with the output values from the model.
+  BuildRows ();
+}
+
+void NoiseMapBuilderCylinder::FillSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  // This is the mapping of the cylinder model, with the cosine and sine of
+  // the angle taken from the table.
+  double heightExtent = m_upperHeightBound - m_lowerHeightBound;
+  double yDelta = heightExtent / (double)m_destHeight;
+  double curHeight = m_lowerHeightBound + (double)y * yDelta;
+
+  for (noise::int64 i = 0; i < count; i++) {
+    double cosAngle, sinAngle;
+    GetTableAngle (m_angleTable, m_lowerAngleBound, m_upperAngleBound,
+      m_destWidth, x + i, cosAngle, sinAngle);
+    float curValue = (float)m_pSourceModule->GetValue (cosAngle, curHeight,
+      sinAngle);
+    *pDest++ = curValue;
+  }
+}
+
+bool NoiseMapBuilderCylinder::GetPointPosition (noise::int64 x,
+  noise::int64 y, double& inputX, double& inputY, double& inputZ) const
+{
+  // This is the mapping of the cylinder model.
+  double xDelta = (m_upperAngleBound - m_lowerAngleBound)
+    / (double)m_destWidth;
+  double yDelta = (m_upperHeightBound - m_lowerHeightBound)
+    / (double)m_destHeight;
+  double curAngle = m_lowerAngleBound + (double)x * xDelta;
+  inputX = cos (curAngle * DEG_TO_RAD);
+  inputY = m_lowerHeightBound + (double)y * yDelta;
+  inputZ = sin (curAngle * DEG_TO_RAD);
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilderHealpix class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    // The ring of the northern corner of each base pixel, counted from
+    // the north pole in units of nside.
+    const int HEALPIX_FACE_RINGS[12] = {
+      2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4
+    };
+
+    // The longitude of the center of each base pixel, in units of PI / 4.
+    const int HEALPIX_FACE_COLUMNS[12] = {
+      1, 3, 5, 7, 0, 2, 4, 6, 1, 3, 5, 7
+    };
+
+    // Returns the nside of a HEALPix noise map, or 0 if the noise map is
+    // not nside points wide and 12 nside points tall for a power of two
+    // nside.
+    inline noise::int64 GetHealpixNside (const NoiseMap& noiseMap)
+    {
+      noise::int64 nside = noiseMap.GetWidth ();
+      if (nside <= 0 || (nside & (nside - 1)) != 0
+        || noiseMap.GetHeight () != 12 * nside) {
+        return 0;
+      }
+      return nside;
+    }
+
+  }
+
+}
+
+NoiseMapBuilderHealpix::NoiseMapBuilderHealpix ()
+{
+}
+
+void NoiseMapBuilderHealpix::Build ()
+{
+  if ( GetOrder () < 0
+    || m_destHeight != 12 * m_destWidth
+    || !IsDestWindowValid ()
+    || m_pSourceModule == NULL
+    || m_pDestNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Fill every point in the noise map with the output values from the model.
+  BuildRows ();
+}
+
+void NoiseMapBuilderHealpix::Coarsen (const NoiseMap& sourceNoiseMap,
+  NoiseMap& destNoiseMap)
+{
+  noise::int64 nside = GetHealpixNside (sourceNoiseMap);
+  if (nside < 2 || &sourceNoiseMap == &destNoiseMap) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // The four pixels that make up a pixel of the next lower order form a
+  // 2 by 2 block, and all pixels have the same area, so the value of the
+  // larger pixel is the plain average of the block.
+  noise::int64 destWidth = nside / 2;
+  destNoiseMap.SetSize (destWidth, 12 * destWidth);
+  std::vector<float> lowerRow ((size_t)nside);
+  std::vector<float> upperRow ((size_t)nside);
+  std::vector<float> destRow ((size_t)destWidth);
+  for (noise::int64 y = 0; y < 12 * destWidth; y++) {
+    sourceNoiseMap.GetSlabValues (0, 2 * y    , nside, &lowerRow[0]);
+    sourceNoiseMap.GetSlabValues (0, 2 * y + 1, nside, &upperRow[0]);
+    for (noise::int64 x = 0; x < destWidth; x++) {
+      size_t i = (size_t)(2 * x);
+      destRow[(size_t)x] = (lowerRow[i] + lowerRow[i + 1] + upperRow[i]
+        + upperRow[i + 1]) * 0.25f;
+    }
+    destNoiseMap.SetSlabValues (0, y, destWidth, &destRow[0]);
+  }
+}
+
+void NoiseMapBuilderHealpix::FillSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  for (noise::int64 i = 0; i < count; i++) {
+    double inputX, inputY, inputZ;
+    GetPointPosition (x + i, y, inputX, inputY, inputZ);
+    *pDest++ = (float)m_pSourceModule->GetValue (inputX, inputY, inputZ);
+  }
+}
+
+noise::int64 NoiseMapBuilderHealpix::GetNestedIndex (noise::int64 nside,
+  noise::int64 x, noise::int64 y)
+{
+  // Within a base pixel, the nested index interleaves the bits of the x
+  // coordinate with the bits of the y coordinate.
+  noise::int64 face = y / nside;
+  noise::int64 ix = x;
+  noise::int64 iy = y - face * nside;
+  noise::int64 index = 0;
+  for (int bit = 0; (nside >> bit) > 1; bit++) {
+    index |= ((ix >> bit) & 1) << (2 * bit    );
+    index |= ((iy >> bit) & 1) << (2 * bit + 1);
+  }
+  return face * nside * nside + index;
+}
+
+void NoiseMapBuilderHealpix::GetNestedValues (
+  const NoiseMap& sourceNoiseMap, float* pDest)
+{
+  noise::int64 nside = GetHealpixNside (sourceNoiseMap);
+  if (nside == 0 || pDest == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  std::vector<float> row ((size_t)nside);
+  for (noise::int64 y = 0; y < 12 * nside; y++) {
+    sourceNoiseMap.GetSlabValues (0, y, nside, &row[0]);
+    for (noise::int64 x = 0; x < nside; x++) {
+      pDest[GetNestedIndex (nside, x, y)] = row[(size_t)x];
+    }
+  }
+}
+
+int NoiseMapBuilderHealpix::GetOrder () const
+{
+  if (m_destWidth <= 0 || (m_destWidth & (m_destWidth - 1)) != 0) {
+    return -1;
+  }
+  int order = 0;
+  while (((noise::int64)1 << order) < m_destWidth) {
+    order++;
+  }
+  return order;
+}
+
+bool NoiseMapBuilderHealpix::GetPointPosition (noise::int64 x,
+  noise::int64 y, double& inputX, double& inputY, double& inputZ) const
+{
+  // This is the mapping of the HEALPix library's pix2ang_nest() function,
+  // applied to the base pixel and the coordinates within it.  The ring of
+  // the pixel, counted from the north pole, gives its height above the
+  // equator; the polar caps and the equatorial belt space their rings
+  // differently so that every pixel has the same area.
+  noise::int64 nside = m_destWidth;
+  int face = ClampValue ((int)(y / nside), 0, 11);
+  noise::int64 ix = x;
+  noise::int64 iy = y - (noise::int64)face * nside;
+  noise::int64 ring = HEALPIX_FACE_RINGS[face] * nside - ix - iy - 1;
+  double ringScale = 1.0 / (3.0 * (double)nside * (double)nside);
+  noise::int64 ringSize;
+  noise::int64 shift = 0;
+  double height;
+  double radius;
+  if (ring < nside) {
+    ringSize = ring;
+    double depth = (double)(ringSize * ringSize) * ringScale;
+    height = 1.0 - depth;
+    radius = sqrt (depth * (2.0 - depth));
+  } else if (ring > 3 * nside) {
+    ringSize = 4 * nside - ring;
+    double depth = (double)(ringSize * ringSize) * ringScale;
+    height = depth - 1.0;
+    radius = sqrt (depth * (2.0 - depth));
+  } else {
+    ringSize = nside;
+    height = (double)(2 * nside - ring) * 2.0 / (3.0 * (double)nside);
+    radius = sqrt ((1.0 - height) * (1.0 + height));
+    shift = (ring - nside) & 1;
+  }
+  noise::int64 column = (HEALPIX_FACE_COLUMNS[face] * ringSize + ix - iy + 1
+    + shift) / 2;
+  double lon = ((double)column - (double)(shift + 1) * 0.5) * (PI / 2.0)
+    / (double)ringSize;
+  inputX = radius * cos (lon);
+  inputY = height;
+  inputZ = radius * sin (lon);
+  return true;
+}
+
+void NoiseMapBuilderHealpix::SetOrder (int order)
+{
+  if (order < 0 || order > HEALPIX_MAX_ORDER) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  SetDestSize ((noise::int64)1 << order, (noise::int64)12 << order);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilderPlane class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    // Largest relative difference between the point spacings of two builds
+    // that an incremental build treats as the same spacing.
+    const double INCREMENTAL_SPACING_TOLERANCE = 1.0e-9;
+
+    // Largest difference, in points, between the offset of two builds and
+    // the nearest whole number of points that an incremental build treats
+    // as a whole-point offset.
+    const double INCREMENTAL_SHIFT_TOLERANCE = 1.0e-6;
+
+    // Finds the offset, in points, between two lower bounds.  Returns false
+    // if the offset is not a whole number of points smaller than the size
+    // of the window.
+    inline bool GetWholeShift (double prevLowerBound, double lowerBound,
+      double delta, noise::int64 windowSize, noise::int64& shift)
+    {
+      double offset = (lowerBound - prevLowerBound) / delta;
+      if (!(fabs (offset) < (double)windowSize)) {
+        return false;
+      }
+      shift = (noise::int64)floor (offset + 0.5);
+      return fabs (offset - (double)shift) <= INCREMENTAL_SHIFT_TOLERANCE;
+    }
+
+  }
+
+}
+
+NoiseMapBuilderPlane::NoiseMapBuilderPlane ():
+  m_hasPrevBuild (false),
+  m_isIncrementalEnabled (false),
+  m_isSeamlessEnabled (false),
+  m_keptX0 (0),
+  m_keptX1 (0),
+  m_keptY0 (0),
+  m_keptY1 (0),
+  m_lowerXBound  (0.0),
+  m_lowerZBound  (0.0),
+  m_upperXBound  (0.0),
+  m_upperZBound  (0.0)
+{
+}
+
+void NoiseMapBuilderPlane::Build ()
+{
+  if ( m_upperXBound <= m_lowerXBound
+    || m_upperZBound <= m_lowerZBound
+    || !IsDestWindowValid ()
+    || m_pSourceModule == NULL
+    || m_pDestNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  noise::int64 width  = GetDestWindowWidth ();
+  noise::int64 height = GetDestWindowHeight ();
+  if (m_isIncrementalEnabled && ShiftPrevBuild ()) {
+    // Fill only the points that the previous build did not calculate.
+    // These points are few, so they are calculated in a single pass.
+    m_hasPrevBuild = false;
+    m_passStep = 1;
+    PrepareResampleModules (m_windowX, m_windowY, width, height);
+    try {
+      m_rowCounts.assign ((size_t)height, 0);
+    }
+    catch (const std::bad_alloc&) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    RunRows (GetExecutor (), *this, &NoiseMapBuilderPlane::BuildExposedRow,
+      height, m_pCallback, m_pCallback64);
+    m_builtPointCount = GetRowCountTotal ();
+    if (m_pPassCallback != NULL) {
+      m_pPassCallback (1, m_pPassContext);
+    }
+  } else {
+    // Fill every point in the noise map with the output values from the
+    // model.
+    m_hasPrevBuild = false;
+    BuildRows ();
+  }
+
+  if (m_isIncrementalEnabled && !IsBuildStopped () && m_lastOctave == 0) {
+    m_prevBuild = GetBuildState ();
+    m_hasPrevBuild = true;
+  }
+}
+
+void NoiseMapBuilderPlane::BuildExposedRow (noise::int64 row) const
+{
+  if (row < m_keptY0 || row >= m_keptY1) {
+    m_rowCounts[(size_t)row] = BuildRow (row);
+    return;
+  }
+  noise::int64 evalCount = 0;
+  if (m_keptX0 > 0) {
+    evalCount += BuildRowPart (row, 0, m_keptX0);
+  }
+  noise::int64 width = GetDestWindowWidth ();
+  if (m_keptX1 < width) {
+    evalCount += BuildRowPart (row, m_keptX1, width - m_keptX1);
+  }
+  m_rowCounts[(size_t)row] = evalCount;
+}
+
+NoiseMapBuilderPlane::BuildState NoiseMapBuilderPlane::GetBuildState ()
+  const
+{
+  BuildState state;
+  state.pDestNoiseMap = m_pDestNoiseMap;
+  state.pSourceModule = m_pSourceModule;
+  state.destWidth     = m_destWidth;
+  state.destHeight    = m_destHeight;
+  state.windowX       = m_windowX;
+  state.windowY       = m_windowY;
+  state.windowWidth   = GetDestWindowWidth ();
+  state.windowHeight  = GetDestWindowHeight ();
+  state.format        = m_pDestNoiseMap->GetFormat ();
+  state.quantizationScale = m_pDestNoiseMap->GetQuantizationScale ();
+  state.quantizationBias  = m_pDestNoiseMap->GetQuantizationBias ();
+  state.lowerXBound   = m_lowerXBound;
+  state.lowerZBound   = m_lowerZBound;
+  state.upperXBound   = m_upperXBound;
+  state.upperZBound   = m_upperZBound;
+  return state;
+}
+
+bool NoiseMapBuilderPlane::ShiftPrevBuild ()
+{
+  if (!m_hasPrevBuild || m_pMask != NULL || m_isSeamlessEnabled
+    || m_lastOctave > 0) {
+    return false;
+  }
+
+  // Every setting except the bounds must match the previous build, and the
+  // destination noise map must still hold the values of that build.
+  const BuildState& prev = m_prevBuild;
+  BuildState cur = GetBuildState ();
+  if ( cur.pDestNoiseMap != prev.pDestNoiseMap
+    || cur.pSourceModule != prev.pSourceModule
+    || cur.destWidth     != prev.destWidth
+    || cur.destHeight    != prev.destHeight
+    || cur.windowX       != prev.windowX
+    || cur.windowY       != prev.windowY
+    || cur.windowWidth   != prev.windowWidth
+    || cur.windowHeight  != prev.windowHeight
+    || cur.format        != prev.format
+    || cur.quantizationScale != prev.quantizationScale
+    || cur.quantizationBias  != prev.quantizationBias
+    || m_pDestNoiseMap->GetWidth  () != cur.windowWidth
+    || m_pDestNoiseMap->GetHeight () != cur.windowHeight) {
+    return false;
+  }
+
+  // The spacing between points must be the same, and the bounds must have
+  // moved by a whole number of points.
+  double xDelta = (cur.upperXBound - cur.lowerXBound) / (double)cur.destWidth;
+  double zDelta = (cur.upperZBound - cur.lowerZBound)
+    / (double)cur.destHeight;
+  double prevXDelta = (prev.upperXBound - prev.lowerXBound)
+    / (double)prev.destWidth;
+  double prevZDelta = (prev.upperZBound - prev.lowerZBound)
+    / (double)prev.destHeight;
+  if (fabs (xDelta - prevXDelta) > xDelta * INCREMENTAL_SPACING_TOLERANCE
+    || fabs (zDelta - prevZDelta) > zDelta * INCREMENTAL_SPACING_TOLERANCE) {
+    return false;
+  }
+  noise::int64 shiftX, shiftY;
+  noise::int64 width  = cur.windowWidth;
+  noise::int64 height = cur.windowHeight;
+  if (!GetWholeShift (prev.lowerXBound, cur.lowerXBound, xDelta, width,
+      shiftX)
+    || !GetWholeShift (prev.lowerZBound, cur.lowerZBound, zDelta, height,
+      shiftY)) {
+    return false;
+  }
+
+  // The value at (x, y) in this build is the value at (x + shiftX,
+  // y + shiftY) in the previous build.  Move the rows in an order that
+  // reads each row before it is overwritten.
+  m_keptX0 = GetMax (-shiftX, (noise::int64)0);
+  m_keptX1 = GetMin (width - shiftX, width);
+  m_keptY0 = GetMax (-shiftY, (noise::int64)0);
+  m_keptY1 = GetMin (height - shiftY, height);
+  if (shiftX == 0 && shiftY == 0) {
+    return true;
+  }
+  size_t elementSize = m_pDestNoiseMap->GetElementSize ();
+  size_t rowBytes = (size_t)(m_keptX1 - m_keptX0) * elementSize;
+  noise::uint8* pValues = (cur.format == FORMAT_FLOAT32)
+    ? (noise::uint8*)m_pDestNoiseMap->GetSlabPtr (0, 0)
+    : (noise::uint8*)m_pDestNoiseMap->GetSlabPtr16 (0, 0);
+  size_t strideBytes = (size_t)m_pDestNoiseMap->GetStride () * elementSize;
+  for (noise::int64 i = 0; i < m_keptY1 - m_keptY0; i++) {
+    noise::int64 y = (shiftY > 0)? m_keptY0 + i: m_keptY1 - 1 - i;
+    noise::uint8* pDest = pValues + (size_t)y * strideBytes
+      + (size_t)m_keptX0 * elementSize;
+    const noise::uint8* pSource = pValues + (size_t)(y + shiftY)
+      * strideBytes + (size_t)(m_keptX0 + shiftX) * elementSize;
+    memmove (pDest, pSource, rowBytes);
+  }
+  return true;
+}
+
+void NoiseMapBuilderPlane::FillSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  // Create the plane model.
+  model::Plane planeModel;
+  planeModel.SetModule (*m_pSourceModule);
+
+  double xExtent = m_upperXBound - m_lowerXBound;
+  double zExtent = m_upperZBound - m_lowerZBound;
+  double xDelta  = xExtent / (double)m_destWidth ;
+  double zDelta  = zExtent / (double)m_destHeight;
+  double zCur    = m_lowerZBound + (double)y * zDelta;
+
+  for (noise::int64 i = 0; i < count; i++) {
+    double xCur = m_lowerXBound + (double)(x + i) * xDelta;
+    float finalValue;
+    if (!m_isSeamlessEnabled) {
+      finalValue = planeModel.GetValue (xCur, zCur);
+    } else {
+      double swValue, seValue, nwValue, neValue;
+      swValue = planeModel.GetValue (xCur          , zCur          );
+      seValue = planeModel.GetValue (xCur + xExtent, zCur          );
+      nwValue = planeModel.GetValue (xCur          , zCur + zExtent);
+      neValue = planeModel.GetValue (xCur + xExtent, zCur + zExtent);
+      double xBlend = 1.0 - ((xCur - m_lowerXBound) / xExtent);
+      double zBlend = 1.0 - ((zCur - m_lowerZBound) / zExtent);
+      double z0 = LinearInterp (swValue, seValue, xBlend);
+      double z1 = LinearInterp (nwValue, neValue, xBlend);
+      finalValue = (float)LinearInterp (z0, z1, zBlend);
+    }
+    *pDest++ = finalValue;
+  }
+}
+
+bool NoiseMapBuilderPlane::GetPointPosition (noise::int64 x,
+  noise::int64 y, double& inputX, double& inputY, double& inputZ) const
+{
+  // Each point of a seamless noise map blends four input values.
+  if (m_isSeamlessEnabled) {
+    return false;
+  }
+
+  double xDelta = (m_upperXBound - m_lowerXBound) / (double)m_destWidth ;
+  double zDelta = (m_upperZBound - m_lowerZBound) / (double)m_destHeight;
+  inputX = m_lowerXBound + (double)x * xDelta;
+  inputY = 0.0;
+  inputZ = m_lowerZBound + (double)y * zDelta;
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NoiseMapBuilderSphere class
+
+NoiseMapBuilderSphere::NoiseMapBuilderSphere ():
+  m_eastLonBound  (0.0),
+  m_northLatBound (0.0),
+  m_southLatBound (0.0),
+  m_westLonBound  (0.0)
+{
+}
+
+void NoiseMapBuilderSphere::Build ()
+{
+  if ( m_eastLonBound <= m_westLonBound
+    || m_northLatBound <= m_southLatBound
+    || !IsDestWindowValid ()
+    || m_pSourceModule == NULL
+    || m_pDestNoiseMap == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // The latitude only depends on the row and the longitude only depends on
+  // the column, so calculate their cosines and sines once per row and once
+  // per column rather than once per point.
+  FillAngleTable (m_latTable, m_southLatBound, m_northLatBound,
+    m_destHeight);
+  FillAngleTable (m_lonTable, m_westLonBound, m_eastLonBound, m_destWidth);
+
+  // Fill every point in the noise map with the output values from the model.
+  BuildRows ();
+}
+
+void NoiseMapBuilderSphere::FillSlab (float* pDest, noise::int64 x,
+  noise::int64 y, noise::int64 count) const
+{
+  // This is the mapping of the sphere model, with the cosines and sines of
+  // the latitude and longitude taken from the tables.
+  double cosLat, sinLat;
+  GetTableAngle (m_latTable, m_southLatBound, m_northLatBound, m_destHeight,
+    y, cosLat, sinLat);
+
+  for (noise::int64 i = 0; i < count; i++) {
+    double cosLon, sinLon;
+    GetTableAngle (m_lonTable, m_westLonBound, m_eastLonBound, m_destWidth,
+      x + i, cosLon, sinLon);
+    float curValue = (float)m_pSourceModule->GetValue (cosLat * cosLon,
+      sinLat, cosLat * sinLon);
+    *pDest++ = curValue;
+  }
+}
 
-  // This buffer holds one horizontal line in the destination file.
-  noise::uint8* pLineBuffer = NULL;
+bool NoiseMapBuilderSphere::GetPointPosition (noise::int64 x,
+  noise::int64 y, double& inputX, double& inputY, double& inputZ) const
+{
+  // This is the mapping of the sphere model.
+  double xDelta = (m_eastLonBound  - m_westLonBound ) / (double)m_destWidth ;
+  double yDelta = (m_northLatBound - m_southLatBound) / (double)m_destHeight;
+  double curLat = m_southLatBound + (double)y * yDelta;
+  double curLon = m_westLonBound  + (double)x * xDelta;
+  LatLonToXYZ (curLat, curLon, inputX, inputY, inputZ);
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// NoiseVolumeBuilder class
+
+NoiseVolumeBuilder::NoiseVolumeBuilder ():
+  m_builtPointCount (0),
+  m_chunkX (0),
+  m_chunkY (0),
+  m_chunkZ (0),
+  m_contents (VOLUME_MIXED),
+  m_destDepth (0),
+  m_destHeight (0),
+  m_destWidth (0),
+  m_isoLevel (0.0),
+  m_maxSlope (-1.0),
+  m_originX (0.0),
+  m_originY (0.0),
+  m_originZ (0.0),
+  m_pDestNoiseVolume (NULL),
+  m_pExecutor (NULL),
+  m_pSourceModule (NULL),
+  m_probeStep (DEFAULT_VOLUME_PROBE_STEP),
+  m_spacingX (1.0),
+  m_spacingY (1.0),
+  m_spacingZ (1.0)
+{
+}
+
+void NoiseVolumeBuilder::Build ()
+{
+  if (m_pSourceModule == NULL || m_pDestNoiseVolume == NULL
+    || m_destWidth <= 0 || m_destHeight <= 0 || m_destDepth <= 0
+    || m_destWidth > RASTER_MAX_WIDTH || m_destHeight > RASTER_MAX_HEIGHT
+    || m_destDepth > RASTER_MAX_HEIGHT) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // Resize the destination noise volume so that it can store the new
+  // output values from the source module.
+  m_pDestNoiseVolume->SetSize (m_destWidth, m_destHeight, m_destDepth);
+  m_contents = VOLUME_MIXED;
+  m_builtPointCount = 0;
+
+  // Prepare the resampling modules for the box that holds the noise
+  // volume.  The spacing is positive, so the first point is the lower
+  // corner of the box and the last point is the upper corner.
+  std::vector<module::Resample*> resampleModules;
+  FindResampleModules (m_pSourceModule, resampleModules);
+  if (!resampleModules.empty ()) {
+    double lowerX, lowerY, lowerZ;
+    double upperX, upperY, upperZ;
+    GetPointPosition (0, 0, 0, lowerX, lowerY, lowerZ);
+    GetPointPosition (m_destWidth - 1, m_destHeight - 1, m_destDepth - 1,
+      upperX, upperY, upperZ);
+    for (size_t i = 0; i < resampleModules.size (); i++) {
+      resampleModules[i]->Prepare (lowerX, lowerY, lowerZ, upperX, upperY,
+        upperZ);
+    }
+  }
+
+  if (m_maxSlope >= 0.0) {
+    // Calculate the coarse grid of the early-out.
+    noise::int64 layerCount = GetProbeCount (m_destDepth);
+    m_probeMaxes.resize ((size_t)layerCount);
+    m_probeMins.resize ((size_t)layerCount);
+    RunRows (GetExecutor (), *this, &NoiseVolumeBuilder::ProbeLayer,
+      layerCount, NULL);
+    m_builtPointCount = GetProbeCount (m_destWidth)
+      * GetProbeCount (m_destHeight) * layerCount;
+    double minValue = *std::min_element (m_probeMins.begin (),
+      m_probeMins.end ());
+    double maxValue = *std::max_element (m_probeMaxes.begin (),
+      m_probeMaxes.end ());
+
+    // No point of the noise volume lies farther from a point of the grid
+    // than half the diagonal of a grid cell, so its value lies within the
+    // slope times that distance of the values at the grid.
+    double halfX = 0.5 * m_spacingX
+      * (double)GetMin (m_probeStep, m_destWidth  - 1);
+    double halfY = 0.5 * m_spacingY
+      * (double)GetMin (m_probeStep, m_destHeight - 1);
+    double halfZ = 0.5 * m_spacingZ
+      * (double)GetMin (m_probeStep, m_destDepth  - 1);
+    double margin = m_maxSlope
+      * sqrt (halfX * halfX + halfY * halfY + halfZ * halfZ);
+    if (maxValue + margin < m_isoLevel) {
+      m_contents = VOLUME_EMPTY;
+    } else if (minValue - margin >= m_isoLevel) {
+      m_contents = VOLUME_SOLID;
+    }
+    if (m_contents != VOLUME_MIXED) {
+      // Fill the noise volume with the probe value farthest from the iso
+      // level, so that a mesher reading the values classifies every point
+      // the same way as GetContents().  In the unlikely case that rounding
+      // to float moves that value across the iso level, build every point.
+      float fillValue = (float)((m_contents == VOLUME_EMPTY)? minValue:
+        maxValue);
+      if ((fillValue < m_isoLevel) == (m_contents == VOLUME_EMPTY)) {
+        m_pDestNoiseVolume->Clear (fillValue);
+        return;
+      }
+      m_contents = VOLUME_MIXED;
+    }
+  }
+
+  // Calculate the x coordinate of each column once; the rows differ only
+  // in their y and z coordinates.
+  m_xCoords.resize ((size_t)m_destWidth);
+  for (noise::int64 x = 0; x < m_destWidth; x++) {
+    m_xCoords[(size_t)x] = GetLatticeCoord (m_originX, m_spacingX,
+      m_chunkX + x);
+  }
+
+  noise::int64 rowCount = m_destHeight * m_destDepth;
+  m_rowContents.resize ((size_t)rowCount);
+  RunRows (GetExecutor (), *this, &NoiseVolumeBuilder::BuildRow, rowCount,
+    NULL);
+  m_builtPointCount += m_destWidth * rowCount;
+
+  // Combine the contents of the rows.
+  int contents = 0;
+  for (size_t i = 0; i < m_rowContents.size (); i++) {
+    contents |= m_rowContents[i];
+  }
+  m_contents = (contents == VOLUME_EMPTY || contents == VOLUME_SOLID)?
+    (VolumeContents)contents: VOLUME_MIXED;
+}
+
+void NoiseVolumeBuilder::BuildRow (noise::int64 row) const
+{
+  noise::int64 y = row % m_destHeight;
+  noise::int64 z = row / m_destHeight;
+  double curY = GetLatticeCoord (m_originY, m_spacingY, m_chunkY + y);
+  double curZ = GetLatticeCoord (m_originZ, m_spacingZ, m_chunkZ + z);
+  const double* pX = &m_xCoords[0];
+  float* pDest = m_pDestNoiseVolume->GetSlabPtr (0, y, z);
+  int contents = 0;
+  for (noise::int64 x = 0; x < m_destWidth; x++) {
+    float curValue = (float)m_pSourceModule->GetValue (pX[x], curY, curZ);
+    contents |= (curValue < m_isoLevel)? VOLUME_EMPTY: VOLUME_SOLID;
+    *pDest++ = curValue;
+  }
+  m_rowContents[(size_t)row] = (noise::uint8)contents;
+}
+
+void NoiseVolumeBuilder::ProbeLayer (noise::int64 index) const
+{
+  noise::int64 z = GetProbeIndex (index, m_destDepth);
+  noise::int64 countX = GetProbeCount (m_destWidth );
+  noise::int64 countY = GetProbeCount (m_destHeight);
+  double minValue = 0.0;
+  double maxValue = 0.0;
+  for (noise::int64 j = 0; j < countY; j++) {
+    noise::int64 y = GetProbeIndex (j, m_destHeight);
+    for (noise::int64 i = 0; i < countX; i++) {
+      double inputX, inputY, inputZ;
+      GetPointPosition (GetProbeIndex (i, m_destWidth), y, z, inputX,
+        inputY, inputZ);
+      double curValue = m_pSourceModule->GetValue (inputX, inputY, inputZ);
+      if (i == 0 && j == 0) {
+        minValue = maxValue = curValue;
+      } else {
+        minValue = GetMin (minValue, curValue);
+        maxValue = GetMax (maxValue, curValue);
+      }
+    }
+  }
+  m_probeMaxes[(size_t)index] = maxValue;
+  m_probeMins [(size_t)index] = minValue;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// TileSinkRawFile class
+
+TileSinkRawFile::TileSinkRawFile ():
+  m_pStream (NULL),
+  m_width (0)
+{
+}
+
+TileSinkRawFile::~TileSinkRawFile ()
+{
+  delete m_pStream;
+}
+
+void TileSinkRawFile::BeginMap (noise::int64 width, noise::int64 height)
+{
+  if (width <= 0 || height <= 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  delete m_pStream;
+  m_pStream = NULL;
+  try {
+    m_pStream = new std::fstream ();
+  }
+  catch (...) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+
+  // Open the destination file.
+  m_pStream->open (m_destFilename.c_str (),
+    std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+  if (m_pStream->fail () || m_pStream->bad ()) {
+    delete m_pStream;
+    m_pStream = NULL;
+    throw noise::ExceptionUnknown ();
+  }
+  m_width = width;
+}
+
+void TileSinkRawFile::EndMap ()
+{
+  if (m_pStream == NULL) {
+    return;
+  }
+
+  m_pStream->close ();
+  bool isFailed = m_pStream->fail () || m_pStream->bad ();
+  delete m_pStream;
+  m_pStream = NULL;
+  if (isFailed) {
+    throw noise::ExceptionUnknown ();
+  }
+}
+
+void TileSinkRawFile::WriteTile (const NoiseMap& tile, noise::int64 x,
+  noise::int64 y)
+{
+  if (m_pStream == NULL) {
+    throw noise::ExceptionUnknown ();
+  }
+
+  // Each row of the tile goes to its own place in the file; the offset is
+  // calculated in 64 bits because the file may exceed 4 GB.
+  // The file always stores 32-bit floating-point values, so a tile that
+  // stores 16-bit values is converted a chunk at a time.
+  noise::int64 tileWidth  = tile.GetWidth  ();
+  noise::int64 tileHeight = tile.GetHeight ();
+  float values[VALUE_CHUNK_SIZE];
+  for (noise::int64 row = 0; row < tileHeight; row++) {
+    std::streamoff offset = ((std::streamoff)(y + row)
+      * (std::streamoff)m_width + (std::streamoff)x)
+      * (std::streamoff)sizeof (float);
+    m_pStream->seekp (offset);
+    if (tile.GetFormat () == FORMAT_FLOAT32) {
+      m_pStream->write ((const char*)tile.GetConstSlabPtr (row),
+        (std::streamsize)tileWidth * sizeof (float));
+    } else {
+      for (noise::int64 col = 0; col < tileWidth; col += VALUE_CHUNK_SIZE) {
+        noise::int64 count = GetMin (tileWidth - col,
+          (noise::int64)VALUE_CHUNK_SIZE);
+        tile.GetSlabValues (col, row, count, values);
+        m_pStream->write ((const char*)values,
+          (std::streamsize)count * sizeof (float));
+      }
+    }
+    if (m_pStream->fail () || m_pStream->bad ()) {
+      m_pStream->clear ();
+      throw noise::ExceptionUnknown ();
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CompressedNoiseMap class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    // The largest width or height of a tile of a compressed or virtual
+    // noise map.
+    const noise::int64 CACHED_TILE_MAX_SIZE = 4096;
+
+    // A tile of a compressed noise map.
+    struct CompressedTile
+    {
+      // The bit-packed differences, or NULL if the tile is constant.
+      noise::uint8* pData;
+
+      // The number of bytes of bit-packed differences.
+      size_t dataSize;
+
+      // The value of every point of a constant tile.
+      float constantValue;
+
+      // The values are multiples of this step, or 0 if they are stored
+      // losslessly.
+      float step;
+    };
+
+    // A tile decoded or calculated into a cache.
+    struct DecodedTile
+    {
+      // The index of the tile, or -1 if this entry is unused.
+      noise::int64 tileIndex;
+
+      // The value of the use counter when the tile was last read.
+      noise::uint64 lastUse;
+
+      // The decoded values, with a stride of the tile width.
+      float* pValues;
+    };
+
+    // Returns true if a value rounded to a multiple of the step fits in a
+    // 32-bit code.  This is false for infinities and NaNs.
+    inline bool IsTileValueQuantizable (float value, float step)
+    {
+      double q = (double)value / (double)step;
+      return q > -2147483648.0 && q < 2147483647.0;
+    }
+
+    // Converts a value to an unsigned integer code.  Lossless codes keep
+    // the order of the values, so that close values have close codes.  A
+    // value is only rounded to a multiple of a step if
+    // IsTileValueQuantizable() is true for it.
+    inline noise::uint32 EncodeTileValue (float value, float step)
+    {
+      if (step > 0.0f) {
+        return (noise::uint32)(noise::int32)floor ((double)value
+          / (double)step + 0.5);
+      }
+      noise::uint32 bits;
+      memcpy (&bits, &value, sizeof (bits));
+      return ((bits & 0x80000000) != 0)? ~bits: (bits | 0x80000000);
+    }
+
+    // Converts an unsigned integer code back to a value.
+    inline float DecodeTileValue (noise::uint32 code, float step)
+    {
+      if (step > 0.0f) {
+        return (float)((double)(noise::int32)code * (double)step);
+      }
+      noise::uint32 bits = ((code & 0x80000000) != 0)? (code & 0x7fffffff):
+        ~code;
+      float value;
+      memcpy (&value, &bits, sizeof (value));
+      return value;
+    }
+
+    class CompressedNoiseMapImpl
+    {
+
+      public:
+
+        CompressedNoiseMapImpl ();
+
+        ~CompressedNoiseMapImpl ();
+
+        void DecompressRegion (NoiseMap& dest, noise::int64 x,
+          noise::int64 y, noise::int64 width, noise::int64 height) const;
+
+        size_t GetCacheSize () const
+        {
+          return m_cache.size ();
+        }
+
+        size_t GetCompressedSize () const;
+
+        noise::int64 GetConstantTileCount () const;
+
+        float GetValue (noise::int64 x, noise::int64 y) const;
+
+        void SetAllocator (noise::Allocator* pAllocator);
+
+        void SetCacheSize (size_t tileCount);
+
+        void SetSize (noise::int64 width, noise::int64 height);
+
+        void SetTileSize (noise::int64 tileWidth, noise::int64 tileHeight);
+
+        void WriteTile (const NoiseMap& tile, noise::int64 x,
+          noise::int64 y);
+
+        // Value used for all positions outside of the noise map.
+        float m_borderValue;
+
+        // Size of the noise map.
+        noise::int64 m_height;
+        noise::int64 m_width;
+
+        // The allocator of the compressed tiles and the cache.
+        noise::Allocator* m_pAllocator;
+
+        // Size of a tile.
+        noise::int64 m_tileHeight;
+        noise::int64 m_tileWidth;
+
+        // The largest change to a value, or 0 for lossless compression.
+        float m_tolerance;
+
+      private:
+
+        // Returns the decoded values of a tile, decoding the tile into the
+        // least recently used entry of the cache if it is not there.  The
+        // mutex must be locked.
+        const float* AcquireTile (noise::int64 tileIndex) const;
+
+        // Compresses values with the specified stride into a tile,
+        // replacing its previous contents.  The codes and the packed bytes
+        // are scratch buffers of the sizes that WriteTile() allocates.
+        void EncodeTile (noise::int64 tileIndex, const float* pSource,
+          noise::int64 sourceStride, noise::uint32* pCodes,
+          noise::uint8* pPacked);
+
+        // Decodes a tile into values with a stride of the tile width.
+        void DecodeTile (noise::int64 tileIndex, float* pDest) const;
+
+        // Empties the cache and frees its buffers.
+        void FreeCache ();
+
+        // Frees every tile.
+        void FreeTiles ();
+
+        // Returns the size of a tile, which is smaller along the right and
+        // top edges of the noise map.
+        void GetTileExtent (noise::int64 tileIndex, noise::int64& width,
+          noise::int64& height) const;
+
+        // The decoded tiles.
+        mutable std::vector<DecodedTile> m_cache;
+
+        // Protects the cache.
+        mutable std::mutex m_mutex;
+
+        // The number of tiles across the noise map.
+        noise::int64 m_tileCountX;
+
+        // The tiles, row by row from the bottom.
+        std::vector<CompressedTile> m_tiles;
+
+        // Incremented each time a tile is read from the cache.
+        mutable noise::uint64 m_useCounter;
+
+    };
+
+  }
+
+}
+
+CompressedNoiseMapImpl::CompressedNoiseMapImpl ():
+  m_borderValue (0.0f),
+  m_height (0),
+  m_width (0),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_tileHeight (64),
+  m_tileWidth (64),
+  m_tolerance (0.0f),
+  m_cache (16),
+  m_tileCountX (0),
+  m_useCounter (0)
+{
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    m_cache[i].tileIndex = -1;
+    m_cache[i].lastUse = 0;
+    m_cache[i].pValues = NULL;
+  }
+}
+
+CompressedNoiseMapImpl::~CompressedNoiseMapImpl ()
+{
+  FreeCache ();
+  FreeTiles ();
+}
+
+const float* CompressedNoiseMapImpl::AcquireTile (noise::int64 tileIndex)
+  const
+{
+  DecodedTile* pEntry = &m_cache[0];
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    if (m_cache[i].tileIndex == tileIndex) {
+      m_cache[i].lastUse = ++m_useCounter;
+      return m_cache[i].pValues;
+    }
+    if (m_cache[i].lastUse < pEntry->lastUse) {
+      pEntry = &m_cache[i];
+    }
+  }
+
+  // Decode the tile into the least recently used entry.
+  if (pEntry->pValues == NULL) {
+    pEntry->pValues = AllocateArray<float> (m_pAllocator,
+      (size_t)(m_tileWidth * m_tileHeight));
+  }
+  pEntry->tileIndex = -1;
+  DecodeTile (tileIndex, pEntry->pValues);
+  pEntry->tileIndex = tileIndex;
+  pEntry->lastUse = ++m_useCounter;
+  return pEntry->pValues;
+}
+
+void CompressedNoiseMapImpl::DecodeTile (noise::int64 tileIndex,
+  float* pDest) const
+{
+  const CompressedTile& tile = m_tiles[(size_t)tileIndex];
+  noise::int64 width, height;
+  GetTileExtent (tileIndex, width, height);
+  if (tile.pData == NULL) {
+    for (noise::int64 y = 0; y < height; y++) {
+      float* pRow = pDest + y * m_tileWidth;
+      for (noise::int64 x = 0; x < width; x++) {
+        pRow[x] = tile.constantValue;
+      }
+    }
+    return;
+  }
+
+  // Each row starts with its bit width, followed by the zigzag-encoded
+  // differences packed from the least significant bit up.
+  const noise::uint8* pSource = tile.pData;
+  noise::uint32 rowStartCode = 0;
+  for (noise::int64 y = 0; y < height; y++) {
+    float* pRow = pDest + y * m_tileWidth;
+    int bitCount = *pSource++;
+    noise::uint64 mask = ((noise::uint64)1 << bitCount) - 1;
+    noise::uint64 bits = 0;
+    int bitsHeld = 0;
+    noise::uint32 code = rowStartCode;
+    for (noise::int64 x = 0; x < width; x++) {
+      while (bitsHeld < bitCount) {
+        bits |= (noise::uint64)*pSource++ << bitsHeld;
+        bitsHeld += 8;
+      }
+      noise::uint32 zigzag = (noise::uint32)(bits & mask);
+      bits >>= bitCount;
+      bitsHeld -= bitCount;
+      code += (zigzag >> 1) ^ (noise::uint32)(-(noise::int32)(zigzag & 1));
+      if (x == 0) {
+        rowStartCode = code;
+      }
+      pRow[x] = DecodeTileValue (code, tile.step);
+    }
+  }
+}
+
+void CompressedNoiseMapImpl::DecompressRegion (NoiseMap& dest,
+  noise::int64 x, noise::int64 y, noise::int64 width, noise::int64 height)
+  const
+{
+  if (width < 0 || height < 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  dest.SetSize (width, height);
+  if (width == 0 || height == 0) {
+    return;
+  }
+  dest.Clear (m_borderValue);
+
+  // Copy the part of each tile that overlaps the region.
+  noise::int64 x0 = GetMax (x, (noise::int64)0);
+  noise::int64 y0 = GetMax (y, (noise::int64)0);
+  noise::int64 x1 = GetMin (x + width , m_width );
+  noise::int64 y1 = GetMin (y + height, m_height);
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (noise::int64 tileY = y0 / m_tileHeight;
+    tileY <= (y1 - 1) / m_tileHeight; tileY++) {
+    for (noise::int64 tileX = x0 / m_tileWidth;
+      tileX <= (x1 - 1) / m_tileWidth; tileX++) {
+      const float* pValues = AcquireTile (tileY * m_tileCountX + tileX);
+      noise::int64 left   = GetMax (x0, tileX * m_tileWidth);
+      noise::int64 right  = GetMin (x1, (tileX + 1) * m_tileWidth);
+      noise::int64 bottom = GetMax (y0, tileY * m_tileHeight);
+      noise::int64 top    = GetMin (y1, (tileY + 1) * m_tileHeight);
+      for (noise::int64 row = bottom; row < top; row++) {
+        dest.SetSlabValues (left - x, row - y, right - left, pValues
+          + (row - tileY * m_tileHeight) * m_tileWidth
+          + (left - tileX * m_tileWidth));
+      }
+    }
+  }
+}
+
+void CompressedNoiseMapImpl::EncodeTile (noise::int64 tileIndex,
+  const float* pSource, noise::int64 sourceStride, noise::uint32* pCodes,
+  noise::uint8* pPacked)
+{
+  noise::int64 width, height;
+  GetTileExtent (tileIndex, width, height);
+  float step = 2.0f * m_tolerance;
+
+  // A tile with a value that cannot be rounded to a multiple of the step
+  // is stored losslessly, so that no value changes by more than the
+  // tolerance.
+  for (noise::int64 y = 0; y < height && step > 0.0f; y++) {
+    const float* pRow = pSource + y * sourceStride;
+    for (noise::int64 x = 0; x < width; x++) {
+      if (!IsTileValueQuantizable (pRow[x], step)) {
+        step = 0.0f;
+        break;
+      }
+    }
+  }
+
+  // Convert the values to codes, and find out whether they are all equal.
+  bool isConstant = true;
+  for (noise::int64 y = 0; y < height; y++) {
+    const float* pRow = pSource + y * sourceStride;
+    noise::uint32* pRowCodes = pCodes + y * width;
+    for (noise::int64 x = 0; x < width; x++) {
+      pRowCodes[x] = EncodeTileValue (pRow[x], step);
+      isConstant = isConstant && (pRowCodes[x] == pCodes[0]);
+    }
+  }
+
+  CompressedTile newTile;
+  newTile.pData = NULL;
+  newTile.dataSize = 0;
+  newTile.constantValue = DecodeTileValue (pCodes[0], step);
+  newTile.step = step;
+  if (!isConstant) {
+    // Replace each code with the zigzag-encoded difference from the code
+    // to its left, or below it at the start of a row, and pack each row
+    // with the fewest bits that hold all of its differences.
+    noise::uint8* pDest = pPacked;
+    noise::uint32 rowStartCode = 0;
+    for (noise::int64 y = 0; y < height; y++) {
+      noise::uint32* pRowCodes = pCodes + y * width;
+      noise::uint32 prevCode = rowStartCode;
+      rowStartCode = pRowCodes[0];
+      noise::uint32 allBits = 0;
+      for (noise::int64 x = 0; x < width; x++) {
+        noise::uint32 delta = pRowCodes[x] - prevCode;
+        prevCode = pRowCodes[x];
+        pRowCodes[x] = (delta << 1)
+          ^ (noise::uint32)((noise::int32)delta >> 31);
+        allBits |= pRowCodes[x];
+      }
+      int bitCount = 0;
+      while (bitCount < 32 && (allBits >> bitCount) != 0) {
+        ++bitCount;
+      }
+      *pDest++ = (noise::uint8)bitCount;
+      noise::uint64 bits = 0;
+      int bitsHeld = 0;
+      for (noise::int64 x = 0; x < width; x++) {
+        bits |= (noise::uint64)pRowCodes[x] << bitsHeld;
+        bitsHeld += bitCount;
+        while (bitsHeld >= 8) {
+          *pDest++ = (noise::uint8)bits;
+          bits >>= 8;
+          bitsHeld -= 8;
+        }
+      }
+      if (bitsHeld > 0) {
+        *pDest++ = (noise::uint8)bits;
+      }
+    }
+    newTile.dataSize = (size_t)(pDest - pPacked);
+    newTile.pData = AllocateArray<noise::uint8> (m_pAllocator,
+      newTile.dataSize);
+    memcpy (newTile.pData, pPacked, newTile.dataSize);
+  }
+
+  // Replace the tile, and drop its decoded values from the cache.
+  CompressedTile& tile = m_tiles[(size_t)tileIndex];
+  DeallocateArray (m_pAllocator, tile.pData, tile.dataSize);
+  tile = newTile;
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    if (m_cache[i].tileIndex == tileIndex) {
+      m_cache[i].tileIndex = -1;
+      m_cache[i].lastUse = 0;
+    }
+  }
+}
+
+void CompressedNoiseMapImpl::FreeCache ()
+{
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    DeallocateArray (m_pAllocator, m_cache[i].pValues,
+      (size_t)(m_tileWidth * m_tileHeight));
+    m_cache[i].tileIndex = -1;
+    m_cache[i].lastUse = 0;
+    m_cache[i].pValues = NULL;
+  }
+}
+
+void CompressedNoiseMapImpl::FreeTiles ()
+{
+  for (size_t i = 0; i < m_tiles.size (); i++) {
+    DeallocateArray (m_pAllocator, m_tiles[i].pData, m_tiles[i].dataSize);
+  }
+  m_tiles.clear ();
+  m_tileCountX = 0;
+  m_width  = 0;
+  m_height = 0;
+}
+
+size_t CompressedNoiseMapImpl::GetCompressedSize () const
+{
+  size_t byteCount = m_tiles.size () * sizeof (CompressedTile);
+  for (size_t i = 0; i < m_tiles.size (); i++) {
+    byteCount += m_tiles[i].dataSize;
+  }
+  return byteCount;
+}
+
+noise::int64 CompressedNoiseMapImpl::GetConstantTileCount () const
+{
+  noise::int64 tileCount = 0;
+  for (size_t i = 0; i < m_tiles.size (); i++) {
+    if (m_tiles[i].pData == NULL) {
+      ++tileCount;
+    }
+  }
+  return tileCount;
+}
+
+void CompressedNoiseMapImpl::GetTileExtent (noise::int64 tileIndex,
+  noise::int64& width, noise::int64& height) const
+{
+  noise::int64 tileX = tileIndex % m_tileCountX;
+  noise::int64 tileY = tileIndex / m_tileCountX;
+  width  = GetMin (m_tileWidth , m_width  - tileX * m_tileWidth );
+  height = GetMin (m_tileHeight, m_height - tileY * m_tileHeight);
+}
+
+float CompressedNoiseMapImpl::GetValue (noise::int64 x, noise::int64 y)
+  const
+{
+  if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+    // The coordinates specified are outside the noise map.  Return the
+    // border value.
+    return m_borderValue;
+  }
+
+  noise::int64 tileIndex = (y / m_tileHeight) * m_tileCountX
+    + x / m_tileWidth;
+  const CompressedTile& tile = m_tiles[(size_t)tileIndex];
+  if (tile.pData == NULL) {
+    return tile.constantValue;
+  }
+  std::lock_guard<std::mutex> lock (m_mutex);
+  const float* pValues = AcquireTile (tileIndex);
+  return pValues[(y % m_tileHeight) * m_tileWidth + x % m_tileWidth];
+}
+
+void CompressedNoiseMapImpl::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Move the compressed tiles one at a time; the cache is rebuilt on
+  // demand.
+  FreeCache ();
+  for (size_t i = 0; i < m_tiles.size (); i++) {
+    CompressedTile& tile = m_tiles[i];
+    if (tile.pData != NULL) {
+      noise::uint8* pNewData = AllocateArray<noise::uint8> (pAllocator,
+        tile.dataSize);
+      memcpy (pNewData, tile.pData, tile.dataSize);
+      DeallocateArray (m_pAllocator, tile.pData, tile.dataSize);
+      tile.pData = pNewData;
+    }
+  }
+  m_pAllocator = pAllocator;
+}
+
+void CompressedNoiseMapImpl::SetCacheSize (size_t tileCount)
+{
+  if (tileCount == 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  FreeCache ();
+  DecodedTile unused;
+  unused.tileIndex = -1;
+  unused.lastUse = 0;
+  unused.pValues = NULL;
+  try {
+    m_cache.resize (tileCount, unused);
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+}
+
+void CompressedNoiseMapImpl::SetSize (noise::int64 width,
+  noise::int64 height)
+{
+  if (width < 0 || height < 0
+    || width > RASTER_MAX_WIDTH || height > RASTER_MAX_HEIGHT) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  FreeCache ();
+  FreeTiles ();
+  if (width == 0 || height == 0) {
+    return;
+  }
 
-  // File object used to write the file.
-  std::ofstream os;
-  os.clear ();
-  
-  // Allocate a buffer to hold one horizontal line in the bitmap.
+  // Every tile starts out as a constant tile of zeros.
+  noise::int64 tileCountX = (width  + m_tileWidth  - 1) / m_tileWidth ;
+  noise::int64 tileCountY = (height + m_tileHeight - 1) / m_tileHeight;
+  CompressedTile emptyTile;
+  emptyTile.pData = NULL;
+  emptyTile.dataSize = 0;
+  emptyTile.constantValue = 0.0f;
+  emptyTile.step = 0.0f;
   try {
-    pLineBuffer = new noise::uint8[bufferSize];
+    m_tiles.resize ((size_t)(tileCountX * tileCountY), emptyTile);
   }
-  catch (...) {
+  catch (const std::bad_alloc&) {
     throw noise::ExceptionOutOfMemory ();
   }
+  m_tileCountX = tileCountX;
+  m_width  = width ;
+  m_height = height;
+}
 
-  // Open the destination file.
-  os.open (m_destFilename.c_str (), std::ios::out | std::ios::binary);
-  if (os.fail () || os.bad ()) {
-    delete[] pLineBuffer;
-    throw noise::ExceptionUnknown ();
+void CompressedNoiseMapImpl::SetTileSize (noise::int64 tileWidth,
+  noise::int64 tileHeight)
+{
+  if (tileWidth  <= 0 || tileWidth  > CACHED_TILE_MAX_SIZE
+    || tileHeight <= 0 || tileHeight > CACHED_TILE_MAX_SIZE) {
+    throw noise::ExceptionInvalidParam ();
   }
+  FreeCache ();
+  FreeTiles ();
+  m_tileWidth  = tileWidth ;
+  m_tileHeight = tileHeight;
+}
 
-  // Build the header.
-  noise::uint8 d[4];
-  os.write ("BM", 2);
-  os.write ((char*)UnpackLittle32 (d, destSize + BMP_HEADER_SIZE), 4);
-  os.write ("\0\0\0\0", 4);
-  os.write ((char*)UnpackLittle32 (d, (noise::uint32)BMP_HEADER_SIZE), 4);
-  os.write ((char*)UnpackLittle32 (d, 40), 4);   // Palette offset
-  os.write ((char*)UnpackLittle32 (d, (noise::uint32)width ), 4);
-  os.write ((char*)UnpackLittle32 (d, (noise::uint32)height), 4);
-  os.write ((char*)UnpackLittle16 (d, 1 ), 2);   // Planes per pixel
-  os.write ((char*)UnpackLittle16 (d, 24), 2);   // Bits per plane
-  os.write ("\0\0\0\0", 4); // Compression (0 = none)
-  os.write ((char*)UnpackLittle32 (d, (noise::uint32)destSize), 4);
-  os.write ((char*)UnpackLittle32 (d, 2834), 4); // X pixels per meter
-  os.write ((char*)UnpackLittle32 (d, 2834), 4); // Y pixels per meter
-  os.write ("\0\0\0\0", 4);
-  os.write ("\0\0\0\0", 4);
-  if (os.fail () || os.bad ()) {
-    os.clear ();
-    os.close ();
-    os.clear ();
-    delete[] pLineBuffer;
-    throw noise::ExceptionUnknown ();
+void CompressedNoiseMapImpl::WriteTile (const NoiseMap& tile,
+  noise::int64 x, noise::int64 y)
+{
+  // Clip the written rectangle to the noise map.
+  noise::int64 x0 = GetMax (x, (noise::int64)0);
+  noise::int64 y0 = GetMax (y, (noise::int64)0);
+  noise::int64 x1 = GetMin (x + tile.GetWidth  (), m_width );
+  noise::int64 y1 = GetMin (y + tile.GetHeight (), m_height);
+  if (x0 >= x1 || y0 >= y1) {
+    return;
   }
 
-  // Build and write each horizontal line to the file.
-  for (int y = 0; y < height; y++) {
-    memset (pLineBuffer, 0, bufferSize);
-    Color* pSource = m_pSourceImage->GetSlabPtr (y);
-    noise::uint8* pDest   = pLineBuffer;
-    for (int x = 0; x < width; x++) {
-      *pDest++ = pSource->blue ;
-      *pDest++ = pSource->green;
-      *pDest++ = pSource->red  ;
-      ++pSource;
-    }
-    os.write ((char*)pLineBuffer, (size_t)bufferSize);
-    if (os.fail () || os.bad ()) {
-      os.clear ();
-      os.close ();
-      os.clear ();
-      delete[] pLineBuffer;
-      throw noise::ExceptionUnknown ();
+  // Allocate the scratch buffers once for all of the tiles.  A packed row
+  // holds its bit width and at most four bytes per value.
+  size_t valueCount = (size_t)(m_tileWidth * m_tileHeight);
+  size_t packedSize = (size_t)(m_tileHeight * (1 + m_tileWidth * 4));
+  float* pValues = NULL;
+  noise::uint32* pCodes = NULL;
+  noise::uint8* pPacked = NULL;
+  try {
+    pValues = AllocateArray<float> (m_pAllocator, valueCount);
+    pCodes  = AllocateArray<noise::uint32> (m_pAllocator, valueCount);
+    pPacked = AllocateArray<noise::uint8> (m_pAllocator, packedSize);
+    for (noise::int64 tileY = y0 / m_tileHeight;
+      tileY <= (y1 - 1) / m_tileHeight; tileY++) {
+      for (noise::int64 tileX = x0 / m_tileWidth;
+        tileX <= (x1 - 1) / m_tileWidth; tileX++) {
+        noise::int64 tileIndex = tileY * m_tileCountX + tileX;
+        noise::int64 left   = GetMax (x0, tileX * m_tileWidth);
+        noise::int64 right  = GetMin (x1, (tileX + 1) * m_tileWidth);
+        noise::int64 bottom = GetMax (y0, tileY * m_tileHeight);
+        noise::int64 top    = GetMin (y1, (tileY + 1) * m_tileHeight);
+        noise::int64 width, height;
+        GetTileExtent (tileIndex, width, height);
+        if (right - left < width || top - bottom < height) {
+          // Only part of the tile is written; keep the rest of it.
+          DecodeTile (tileIndex, pValues);
+        }
+        for (noise::int64 row = bottom; row < top; row++) {
+          tile.GetSlabValues (left - x, row - y, right - left, pValues
+            + (row - tileY * m_tileHeight) * m_tileWidth
+            + (left - tileX * m_tileWidth));
+        }
+        EncodeTile (tileIndex, pValues, m_tileWidth, pCodes, pPacked);
+      }
     }
   }
+  catch (...) {
+    DeallocateArray (m_pAllocator, pValues, valueCount);
+    DeallocateArray (m_pAllocator, pCodes , valueCount);
+    DeallocateArray (m_pAllocator, pPacked, packedSize);
+    throw;
+  }
+  DeallocateArray (m_pAllocator, pValues, valueCount);
+  DeallocateArray (m_pAllocator, pCodes , valueCount);
+  DeallocateArray (m_pAllocator, pPacked, packedSize);
+}
 
-  os.close ();
-  os.clear ();
-  delete[] pLineBuffer;
+CompressedNoiseMap::CompressedNoiseMap ():
+  m_pImpl (NULL)
+{
+  try {
+    m_pImpl = new CompressedNoiseMapImpl ();
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// WriterTER class
+CompressedNoiseMap::~CompressedNoiseMap ()
+{
+  delete m_pImpl;
+}
 
-int WriterTER::CalcWidthByteCount (int width) const
+void CompressedNoiseMap::BeginMap (noise::int64 width, noise::int64 height)
 {
-  return (width * sizeof (int16));
+  m_pImpl->SetSize (width, height);
 }
 
-void WriterTER::WriteDestFile ()
+void CompressedNoiseMap::Compress (const NoiseMap& source)
 {
-  if (m_pSourceNoiseMap == NULL) {
+  m_pImpl->SetSize (source.GetWidth (), source.GetHeight ());
+  m_pImpl->WriteTile (source, 0, 0);
+}
+
+void CompressedNoiseMap::DecompressRegion (NoiseMap& dest, noise::int64 x,
+  noise::int64 y, noise::int64 width, noise::int64 height) const
+{
+  m_pImpl->DecompressRegion (dest, x, y, width, height);
+}
+
+noise::Allocator* CompressedNoiseMap::GetAllocator () const
+{
+  return m_pImpl->m_pAllocator;
+}
+
+float CompressedNoiseMap::GetBorderValue () const
+{
+  return m_pImpl->m_borderValue;
+}
+
+size_t CompressedNoiseMap::GetCacheSize () const
+{
+  return m_pImpl->GetCacheSize ();
+}
+
+size_t CompressedNoiseMap::GetCompressedSize () const
+{
+  return m_pImpl->GetCompressedSize ();
+}
+
+noise::int64 CompressedNoiseMap::GetConstantTileCount () const
+{
+  return m_pImpl->GetConstantTileCount ();
+}
+
+noise::int64 CompressedNoiseMap::GetHeight () const
+{
+  return m_pImpl->m_height;
+}
+
+noise::int64 CompressedNoiseMap::GetTileHeight () const
+{
+  return m_pImpl->m_tileHeight;
+}
+
+noise::int64 CompressedNoiseMap::GetTileWidth () const
+{
+  return m_pImpl->m_tileWidth;
+}
+
+float CompressedNoiseMap::GetTolerance () const
+{
+  return m_pImpl->m_tolerance;
+}
+
+float CompressedNoiseMap::GetValue (noise::int64 x, noise::int64 y) const
+{
+  return m_pImpl->GetValue (x, y);
+}
+
+noise::int64 CompressedNoiseMap::GetWidth () const
+{
+  return m_pImpl->m_width;
+}
+
+void CompressedNoiseMap::SetAllocator (noise::Allocator* pAllocator)
+{
+  m_pImpl->SetAllocator (pAllocator);
+}
+
+void CompressedNoiseMap::SetBorderValue (float borderValue)
+{
+  m_pImpl->m_borderValue = borderValue;
+}
+
+void CompressedNoiseMap::SetCacheSize (size_t tileCount)
+{
+  m_pImpl->SetCacheSize (tileCount);
+}
+
+void CompressedNoiseMap::SetSize (noise::int64 width, noise::int64 height)
+{
+  m_pImpl->SetSize (width, height);
+}
+
+void CompressedNoiseMap::SetTileSize (noise::int64 tileWidth,
+  noise::int64 tileHeight)
+{
+  m_pImpl->SetTileSize (tileWidth, tileHeight);
+}
+
+void CompressedNoiseMap::SetTolerance (float tolerance)
+{
+  if (!(tolerance >= 0.0f)) {
     throw noise::ExceptionInvalidParam ();
   }
+  m_pImpl->m_tolerance = tolerance;
+}
+
+void CompressedNoiseMap::WriteTile (const NoiseMap& tile, noise::int64 x,
+  noise::int64 y)
+{
+  m_pImpl->WriteTile (tile, x, y);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// VirtualNoiseMap class
+
+namespace noise
+{
+
+  namespace utils
+  {
+
+    class VirtualNoiseMapImpl
+    {
+
+      public:
+
+        VirtualNoiseMapImpl ();
+
+        ~VirtualNoiseMapImpl ();
+
+        size_t GetCacheSize () const
+        {
+          return m_cache.size ();
+        }
+
+        noise::int64 GetHeight () const
+        {
+          return (m_pBuilder != NULL)?
+            (noise::int64)m_pBuilder->GetDestHeight (): 0;
+        }
+
+        void GetRegion (NoiseMap& dest, noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
+
+        noise::uint64 GetTileBuildCount () const
+        {
+          std::lock_guard<std::mutex> lock (m_mutex);
+          return m_buildCount;
+        }
+
+        float GetValue (noise::int64 x, noise::int64 y) const;
+
+        noise::int64 GetWidth () const
+        {
+          return (m_pBuilder != NULL)?
+            (noise::int64)m_pBuilder->GetDestWidth (): 0;
+        }
+
+        void Invalidate ();
+
+        void SetAllocator (noise::Allocator* pAllocator);
+
+        void SetCacheSize (size_t tileCount);
+
+        void SetTileSize (noise::int64 tileWidth, noise::int64 tileHeight);
+
+        // Value used for all positions outside of the noise map.
+        float m_borderValue;
+
+        // The allocator of the cache.
+        noise::Allocator* m_pAllocator;
+
+        // The noise-map builder that calculates the tiles.
+        const NoiseMapBuilder* m_pBuilder;
+
+        // Size of a tile.
+        noise::int64 m_tileHeight;
+        noise::int64 m_tileWidth;
+
+      private:
+
+        // Returns the values of several different tiles, calculating the
+        // tiles that are not in the cache.  There must be no more tiles
+        // than the cache holds.  The mutex must be locked.
+        void AcquireTiles (const noise::int64* pTileIndices, size_t count,
+          const float** ppValues) const;
+
+        // Calculates one of the pending tiles.
+        void BuildPendingTile (noise::int64 index) const;
+
+        // Empties the cache and frees its buffers.
+        void FreeCache ();
+
+        // Prepares the resampling modules of the builder for the region
+        // that holds the pending tiles.
+        void PrepareResampleModules () const;
+
+        // The calculated tiles.
+        mutable std::vector<DecodedTile> m_cache;
+
+        // The number of tiles calculated so far.
+        mutable noise::uint64 m_buildCount;
+
+        // Protects the cache.
+        mutable std::mutex m_mutex;
+
+        // The cache entries of the tiles being calculated.
+        mutable std::vector<DecodedTile*> m_pending;
+
+        // Incremented each time a tile is read from the cache.
+        mutable noise::uint64 m_useCounter;
+
+    };
+
+  }
 
-  int width  = m_pSourceNoiseMap->GetWidth  ();
-  int height = m_pSourceNoiseMap->GetHeight ();
+}
 
-  int bufferSize = CalcWidthByteCount (width);
-  int destSize   = bufferSize * height;
+VirtualNoiseMapImpl::VirtualNoiseMapImpl ():
+  m_borderValue (0.0f),
+  m_pAllocator (noise::GetDefaultAllocator ()),
+  m_pBuilder (NULL),
+  m_tileHeight (64),
+  m_tileWidth (64),
+  m_cache (64),
+  m_buildCount (0),
+  m_useCounter (0)
+{
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    m_cache[i].tileIndex = -1;
+    m_cache[i].lastUse = 0;
+    m_cache[i].pValues = NULL;
+  }
+}
 
-  // This buffer holds one horizontal line in the destination file.
-  noise::uint8* pLineBuffer = NULL;
+VirtualNoiseMapImpl::~VirtualNoiseMapImpl ()
+{
+  FreeCache ();
+}
 
-  // File object used to write the file.
-  std::ofstream os;
-  os.clear ();
+void VirtualNoiseMapImpl::AcquireTiles (const noise::int64* pTileIndices,
+  size_t count, const float** ppValues) const
+{
+  if (m_pBuilder == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
 
-  // Allocate a buffer to hold one horizontal line in the height map.
+  // Find the tiles that are already in the cache.  Every entry read by
+  // this call is used more recently than the start of the call, so it is
+  // not replaced by another tile of the same call.
+  noise::uint64 startUse = m_useCounter;
+  size_t missingCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    ppValues[i] = NULL;
+    for (size_t j = 0; j < m_cache.size (); j++) {
+      if (m_cache[j].tileIndex == pTileIndices[i]) {
+        m_cache[j].lastUse = ++m_useCounter;
+        ppValues[i] = m_cache[j].pValues;
+        break;
+      }
+    }
+    if (ppValues[i] == NULL) {
+      ++missingCount;
+    }
+  }
+  if (missingCount == 0) {
+    return;
+  }
+
+  // Give each missing tile the least recently used entry.
+  m_pending.clear ();
+  for (size_t i = 0; i < count; i++) {
+    if (ppValues[i] != NULL) {
+      continue;
+    }
+    DecodedTile* pEntry = NULL;
+    for (size_t j = 0; j < m_cache.size (); j++) {
+      if (m_cache[j].lastUse <= startUse
+        && (pEntry == NULL || m_cache[j].lastUse < pEntry->lastUse)) {
+        pEntry = &m_cache[j];
+      }
+    }
+    assert (pEntry != NULL);
+    if (pEntry->pValues == NULL) {
+      pEntry->pValues = AllocateArray<float> (m_pAllocator,
+        (size_t)(m_tileWidth * m_tileHeight));
+    }
+    pEntry->tileIndex = pTileIndices[i];
+    pEntry->lastUse = ++m_useCounter;
+    ppValues[i] = pEntry->pValues;
+    m_pending.push_back (pEntry);
+  }
+
+  // Calculate the missing tiles, several at once if there is an executor.
+  // The resampling modules are prepared for the region that holds them
+  // first, since they cannot be prepared while the tiles are calculated.
   try {
-    pLineBuffer = new noise::uint8[bufferSize];
+    PrepareResampleModules ();
+    RunRows ((m_pending.size () > 1)? m_pBuilder->GetExecutor (): NULL,
+      *this, &VirtualNoiseMapImpl::BuildPendingTile,
+      (noise::int64)m_pending.size (), NULL);
   }
   catch (...) {
-    throw noise::ExceptionOutOfMemory ();
+    for (size_t i = 0; i < m_pending.size (); i++) {
+      m_pending[i]->tileIndex = -1;
+      m_pending[i]->lastUse = 0;
+    }
+    m_pending.clear ();
+    throw;
   }
+  m_buildCount += m_pending.size ();
+  m_pending.clear ();
+}
 
-  // Open the destination file.
-  os.open (m_destFilename.c_str (), std::ios::out | std::ios::binary);
-  if (os.fail () || os.bad ()) {
-    os.clear ();
-    delete[] pLineBuffer;
-    throw noise::ExceptionUnknown ();
+void VirtualNoiseMapImpl::BuildPendingTile (noise::int64 index) const
+{
+  DecodedTile* pEntry = m_pending[(size_t)index];
+  noise::int64 width  = GetWidth  ();
+  noise::int64 height = GetHeight ();
+  noise::int64 tileCountX = (width + m_tileWidth - 1) / m_tileWidth;
+  noise::int64 x = (pEntry->tileIndex % tileCountX) * m_tileWidth ;
+  noise::int64 y = (pEntry->tileIndex / tileCountX) * m_tileHeight;
+  noise::int64 tileWidth  = GetMin (m_tileWidth , width  - x);
+  noise::int64 tileHeight = GetMin (m_tileHeight, height - y);
+  for (noise::int64 row = 0; row < tileHeight; row++) {
+    m_pBuilder->GetSlabValues (x, y + row, tileWidth,
+      pEntry->pValues + row * m_tileWidth);
   }
+}
 
-  // Build the header.
-  noise::uint8 d[4];
-  int16 heightScale = (int16)(floor (32768.0 / (double)m_metersPerPoint));
-  os.write ("TERRAGENTERRAIN ", 16);
-  os.write ("SIZE", 4);
-  os.write ((char*)UnpackLittle16 (d, GetMin (width, height) - 1), 2);
-  os.write ("\0\0", 2);
-  os.write ("XPTS", 4);
-  os.write ((char*)UnpackLittle16 (d, width), 2);
-  os.write ("\0\0", 2);
-  os.write ("YPTS", 4);
-  os.write ((char*)UnpackLittle16 (d, height), 2);
-  os.write ("\0\0", 2);
-  os.write ("SCAL", 4);
-  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
-  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
-  os.write ((char*)UnpackFloat (d, m_metersPerPoint), 4);
-  os.write ("ALTW", 4);
-  os.write ((char*)UnpackLittle16 (d, heightScale), 2);
-  os.write ("\0\0", 2);
-  if (os.fail () || os.bad ()) {
-    os.clear ();
-    os.close ();
-    os.clear ();
-    delete[] pLineBuffer;
-    throw noise::ExceptionUnknown ();
+void VirtualNoiseMapImpl::FreeCache ()
+{
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    DeallocateArray (m_pAllocator, m_cache[i].pValues,
+      (size_t)(m_tileWidth * m_tileHeight));
+    m_cache[i].tileIndex = -1;
+    m_cache[i].lastUse = 0;
+    m_cache[i].pValues = NULL;
   }
+}
 
-  // Build and write each horizontal line to the file.
-  for (int y = 0; y < height; y++) {
-    float* pSource = m_pSourceNoiseMap->GetSlabPtr (y);
-    noise::uint8* pDest   = pLineBuffer;
-    for (int x = 0; x < width; x++) {
-      int16 scaledHeight = (int16)(floor (*pSource * 2.0));
-      UnpackLittle16 (pDest, scaledHeight);
-      pDest += 2;
-      ++pSource;
+void VirtualNoiseMapImpl::GetRegion (NoiseMap& dest, noise::int64 x,
+  noise::int64 y, noise::int64 width, noise::int64 height) const
+{
+  if (width < 0 || height < 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  dest.SetSize (width, height);
+  if (width == 0 || height == 0) {
+    return;
+  }
+  dest.Clear (m_borderValue);
+
+  noise::int64 x0 = GetMax (x, (noise::int64)0);
+  noise::int64 y0 = GetMax (y, (noise::int64)0);
+  noise::int64 x1 = GetMin (x + width , GetWidth  ());
+  noise::int64 y1 = GetMin (y + height, GetHeight ());
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  // List the tiles that overlap the region, then acquire and copy them in
+  // batches that fit in the cache.
+  noise::int64 tileCountX = (GetWidth () + m_tileWidth - 1) / m_tileWidth;
+  std::vector<noise::int64> tileIndices;
+  std::vector<const float*> tileValues;
+  try {
+    for (noise::int64 tileY = y0 / m_tileHeight;
+      tileY <= (y1 - 1) / m_tileHeight; tileY++) {
+      for (noise::int64 tileX = x0 / m_tileWidth;
+        tileX <= (x1 - 1) / m_tileWidth; tileX++) {
+        tileIndices.push_back (tileY * tileCountX + tileX);
+      }
     }
-    os.write ((char*)pLineBuffer, (size_t)bufferSize);
-    if (os.fail () || os.bad ()) {
-      os.clear ();
-      os.close ();
-      os.clear ();
-      delete[] pLineBuffer;
-      throw noise::ExceptionUnknown ();
+    tileValues.resize (tileIndices.size ());
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (size_t first = 0; first < tileIndices.size ();
+    first += m_cache.size ()) {
+    size_t count = GetMin (tileIndices.size () - first, m_cache.size ());
+    AcquireTiles (&tileIndices[first], count, &tileValues[first]);
+    for (size_t i = first; i < first + count; i++) {
+      noise::int64 tileX = tileIndices[i] % tileCountX;
+      noise::int64 tileY = tileIndices[i] / tileCountX;
+      noise::int64 left   = GetMax (x0, tileX * m_tileWidth);
+      noise::int64 right  = GetMin (x1, (tileX + 1) * m_tileWidth);
+      noise::int64 bottom = GetMax (y0, tileY * m_tileHeight);
+      noise::int64 top    = GetMin (y1, (tileY + 1) * m_tileHeight);
+      for (noise::int64 row = bottom; row < top; row++) {
+        dest.SetSlabValues (left - x, row - y, right - left, tileValues[i]
+          + (row - tileY * m_tileHeight) * m_tileWidth
+          + (left - tileX * m_tileWidth));
+      }
     }
   }
-
-  os.close ();
-  os.clear ();
-  delete[] pLineBuffer;
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// NoiseMapBuilder class
+float VirtualNoiseMapImpl::GetValue (noise::int64 x, noise::int64 y) const
+{
+  if (x < 0 || x >= GetWidth () || y < 0 || y >= GetHeight ()) {
+    // The coordinates specified are outside the noise map.  Return the
+    // border value.
+    return m_borderValue;
+  }
 
-NoiseMapBuilder::NoiseMapBuilder ():
-  m_pCallback (NULL),
-  m_destHeight (0),
-  m_destWidth  (0),
-  m_pDestNoiseMap (NULL),
-  m_pSourceModule (NULL)
+  noise::int64 tileCountX = (GetWidth () + m_tileWidth - 1) / m_tileWidth;
+  noise::int64 tileIndex = (y / m_tileHeight) * tileCountX
+    + x / m_tileWidth;
+  const float* pValues;
+  std::lock_guard<std::mutex> lock (m_mutex);
+  AcquireTiles (&tileIndex, 1, &pValues);
+  return pValues[(y % m_tileHeight) * m_tileWidth + x % m_tileWidth];
+}
+
+void VirtualNoiseMapImpl::Invalidate ()
 {
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (size_t i = 0; i < m_cache.size (); i++) {
+    m_cache[i].tileIndex = -1;
+    m_cache[i].lastUse = 0;
+  }
 }
 
-void NoiseMapBuilder::SetCallback (NoiseMapCallback pCallback)
+void VirtualNoiseMapImpl::PrepareResampleModules () const
 {
-  m_pCallback = pCallback;
+  noise::int64 width  = GetWidth  ();
+  noise::int64 height = GetHeight ();
+  noise::int64 tileCountX = (width + m_tileWidth - 1) / m_tileWidth;
+  noise::int64 x0 = width;
+  noise::int64 y0 = height;
+  noise::int64 x1 = 0;
+  noise::int64 y1 = 0;
+  for (size_t i = 0; i < m_pending.size (); i++) {
+    noise::int64 tileIndex = m_pending[i]->tileIndex;
+    noise::int64 x = (tileIndex % tileCountX) * m_tileWidth ;
+    noise::int64 y = (tileIndex / tileCountX) * m_tileHeight;
+    x0 = GetMin (x0, x);
+    y0 = GetMin (y0, y);
+    x1 = GetMax (x1, GetMin (x + m_tileWidth , width ));
+    y1 = GetMax (y1, GetMin (y + m_tileHeight, height));
+  }
+  m_pBuilder->PrepareResampleModules (x0, y0, x1 - x0, y1 - y0);
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// NoiseMapBuilderCylinder class
+void VirtualNoiseMapImpl::SetAllocator (noise::Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = noise::GetDefaultAllocator ();
+  }
+  FreeCache ();
+  m_pAllocator = pAllocator;
+}
 
-NoiseMapBuilderCylinder::NoiseMapBuilderCylinder ():
-  m_lowerAngleBound  (0.0),
-  m_lowerHeightBound (0.0),
-  m_upperAngleBound  (0.0),
-  m_upperHeightBound (0.0)
+void VirtualNoiseMapImpl::SetCacheSize (size_t tileCount)
 {
+  if (tileCount == 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  FreeCache ();
+  DecodedTile unused;
+  unused.tileIndex = -1;
+  unused.lastUse = 0;
+  unused.pValues = NULL;
+  try {
+    m_cache.resize (tileCount, unused);
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
 }
 
-void NoiseMapBuilderCylinder::Build ()
+void VirtualNoiseMapImpl::SetTileSize (noise::int64 tileWidth,
+  noise::int64 tileHeight)
 {
-  if ( m_upperAngleBound <= m_lowerAngleBound
-    || m_upperHeightBound <= m_lowerHeightBound
-    || m_destWidth <= 0
-    || m_destHeight <= 0
-    || m_pSourceModule == NULL
-    || m_pDestNoiseMap == NULL) {
+  if (tileWidth  <= 0 || tileWidth  > CACHED_TILE_MAX_SIZE
+    || tileHeight <= 0 || tileHeight > CACHED_TILE_MAX_SIZE) {
     throw noise::ExceptionInvalidParam ();
   }
+  FreeCache ();
+  m_tileWidth  = tileWidth ;
+  m_tileHeight = tileHeight;
+}
 
-  // Resize the destination noise map so that it can store the new output
-  // values from the source model.
-  m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
+VirtualNoiseMap::VirtualNoiseMap ():
+  m_pImpl (NULL)
+{
+  try {
+    m_pImpl = new VirtualNoiseMapImpl ();
+  }
+  catch (const std::bad_alloc&) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+}
 
-  // Create the cylinder model.
-  model::Cylinder cylinderModel;
-  cylinderModel.SetModule (*m_pSourceModule);
+VirtualNoiseMap::~VirtualNoiseMap ()
+{
+  delete m_pImpl;
+}
 
-  double angleExtent  = m_upperAngleBound  - m_lowerAngleBound ;
-  double heightExtent = m_upperHeightBound - m_lowerHeightBound;
-  double xDelta = angleExtent  / (double)m_destWidth ;
-  double yDelta = heightExtent / (double)m_destHeight;
-  double curAngle  = m_lowerAngleBound ;
-  double curHeight = m_lowerHeightBound;
+noise::Allocator* VirtualNoiseMap::GetAllocator () const
+{
+  return m_pImpl->m_pAllocator;
+}
 
-  // Fill every point in the noise map with the output values from the model.
-  for (int y = 0; y < m_destHeight; y++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (y);
-    curAngle = m_lowerAngleBound;
-    for (int x = 0; x < m_destWidth; x++) {
-      float curValue = (float)cylinderModel.GetValue (curAngle, curHeight);
-      *pDest++ = curValue;
-      curAngle += xDelta;
-    }
-    curHeight += yDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (y);
-    }
-  }
+float VirtualNoiseMap::GetBorderValue () const
+{
+  return m_pImpl->m_borderValue;
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// NoiseMapBuilderPlane class
+size_t VirtualNoiseMap::GetCacheSize () const
+{
+  return m_pImpl->GetCacheSize ();
+}
 
-NoiseMapBuilderPlane::NoiseMapBuilderPlane ():
-  m_isSeamlessEnabled (false),
-  m_lowerXBound  (0.0),
-  m_lowerZBound  (0.0),
-  m_upperXBound  (0.0),
-  m_upperZBound  (0.0)
+noise::int64 VirtualNoiseMap::GetHeight () const
 {
+  return m_pImpl->GetHeight ();
 }
 
-void NoiseMapBuilderPlane::Build ()
+void VirtualNoiseMap::GetRegion (NoiseMap& dest, noise::int64 x,
+  noise::int64 y, noise::int64 width, noise::int64 height) const
 {
-  if ( m_upperXBound <= m_lowerXBound
-    || m_upperZBound <= m_lowerZBound
-    || m_destWidth <= 0
-    || m_destHeight <= 0
-    || m_pSourceModule == NULL
-    || m_pDestNoiseMap == NULL) {
-    throw noise::ExceptionInvalidParam ();
-  }
+  m_pImpl->GetRegion (dest, x, y, width, height);
+}
 
-  // Resize the destination noise map so that it can store the new output
-  // values from the source model.
-  m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
+noise::uint64 VirtualNoiseMap::GetTileBuildCount () const
+{
+  return m_pImpl->GetTileBuildCount ();
+}
 
-  // Create the plane model.
-  model::Plane planeModel;
-  planeModel.SetModule (*m_pSourceModule);
+noise::int64 VirtualNoiseMap::GetTileHeight () const
+{
+  return m_pImpl->m_tileHeight;
+}
 
-  double xExtent = m_upperXBound - m_lowerXBound;
-  double zExtent = m_upperZBound - m_lowerZBound;
-  double xDelta  = xExtent / (double)m_destWidth ;
-  double zDelta  = zExtent / (double)m_destHeight;
-  double xCur    = m_lowerXBound;
-  double zCur    = m_lowerZBound;
+noise::int64 VirtualNoiseMap::GetTileWidth () const
+{
+  return m_pImpl->m_tileWidth;
+}
 
-  // Fill every point in the noise map with the output values from the model.
-  for (int z = 0; z < m_destHeight; z++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (z);
-    xCur = m_lowerXBound;
-    for (int x = 0; x < m_destWidth; x++) {
-      float finalValue;
-      if (!m_isSeamlessEnabled) {
-        finalValue = planeModel.GetValue (xCur, zCur);
-      } else {
-        double swValue, seValue, nwValue, neValue;
-        swValue = planeModel.GetValue (xCur          , zCur          );
-        seValue = planeModel.GetValue (xCur + xExtent, zCur          );
-        nwValue = planeModel.GetValue (xCur          , zCur + zExtent);
-        neValue = planeModel.GetValue (xCur + xExtent, zCur + zExtent);
-        double xBlend = 1.0 - ((xCur - m_lowerXBound) / xExtent);
-        double zBlend = 1.0 - ((zCur - m_lowerZBound) / zExtent);
-        double z0 = LinearInterp (swValue, seValue, xBlend);
-        double z1 = LinearInterp (nwValue, neValue, xBlend);
-        finalValue = (float)LinearInterp (z0, z1, zBlend);
-      }
-      *pDest++ = finalValue;
-      xCur += xDelta;
-    }
-    zCur += zDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (z);
-    }
-  }
+float VirtualNoiseMap::GetValue (noise::int64 x, noise::int64 y) const
+{
+  return m_pImpl->GetValue (x, y);
 }
 
-/////////////////////////////////////////////////////////////////////////////
-// NoiseMapBuilderSphere class
+noise::int64 VirtualNoiseMap::GetWidth () const
+{
+  return m_pImpl->GetWidth ();
+}
 
-NoiseMapBuilderSphere::NoiseMapBuilderSphere ():
-  m_eastLonBound  (0.0),
-  m_northLatBound (0.0),
-  m_southLatBound (0.0),
-  m_westLonBound  (0.0)
+void VirtualNoiseMap::Invalidate ()
 {
+  m_pImpl->Invalidate ();
 }
 
-void NoiseMapBuilderSphere::Build ()
+void VirtualNoiseMap::SetAllocator (noise::Allocator* pAllocator)
 {
-  if ( m_eastLonBound <= m_westLonBound
-    || m_northLatBound <= m_southLatBound
-    || m_destWidth <= 0
-    || m_destHeight <= 0
-    || m_pSourceModule == NULL
-    || m_pDestNoiseMap == NULL) {
+  m_pImpl->SetAllocator (pAllocator);
+}
+
+void VirtualNoiseMap::SetBorderValue (float borderValue)
+{
+  m_pImpl->m_borderValue = borderValue;
+}
+
+void VirtualNoiseMap::SetBuilder (const NoiseMapBuilder& builder)
+{
+  m_pImpl->m_pBuilder = &builder;
+  m_pImpl->Invalidate ();
+}
+
+void VirtualNoiseMap::SetCacheSize (size_t tileCount)
+{
+  m_pImpl->SetCacheSize (tileCount);
+}
+
+void VirtualNoiseMap::SetTileSize (noise::int64 tileWidth,
+  noise::int64 tileHeight)
+{
+  m_pImpl->SetTileSize (tileWidth, tileHeight);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// TiledNoiseMapBuilder class
+
+TiledNoiseMapBuilder::TiledNoiseMapBuilder ():
+  m_memoryBudget (0),
+  m_pBuilder (NULL),
+  m_pTileSink (NULL),
+  m_tileHeight (0),
+  m_tileWidth  (0)
+{
+}
+
+void TiledNoiseMapBuilder::Build ()
+{
+  if (m_pBuilder == NULL || m_pTileSink == NULL) {
     throw noise::ExceptionInvalidParam ();
   }
 
-  // Resize the destination noise map so that it can store the new output
-  // values from the source model.
-  m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
+  noise::int64 destWidth  = (noise::int64)m_pBuilder->GetDestWidth  ();
+  noise::int64 destHeight = (noise::int64)m_pBuilder->GetDestHeight ();
+  if (destWidth <= 0 || destHeight <= 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
 
-  // Create the plane model.
-  model::Sphere sphereModel;
-  sphereModel.SetModule (*m_pSourceModule);
+  noise::int64 tileWidth;
+  noise::int64 tileHeight;
+  CalcTileSize (tileWidth, tileHeight);
 
-  double lonExtent = m_eastLonBound  - m_westLonBound ;
-  double latExtent = m_northLatBound - m_southLatBound;
-  double xDelta = lonExtent / (double)m_destWidth ;
-  double yDelta = latExtent / (double)m_destHeight;
-  double curLon = m_westLonBound ;
-  double curLat = m_southLatBound;
+  // The same noise map stores every tile.  Because the tiles along the
+  // right and top edges are never larger than the others, it is only
+  // allocated once.  The builder gets its own destination back afterwards.
+  NoiseMap* pPrevDestNoiseMap = m_pBuilder->GetDestNoiseMap ();
+  m_pBuilder->SetDestNoiseMap (m_tile);
 
-  // Fill every point in the noise map with the output values from the model.
-  for (int y = 0; y < m_destHeight; y++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (y);
-    curLon = m_westLonBound;
-    for (int x = 0; x < m_destWidth; x++) {
-      float curValue = (float)sphereModel.GetValue (curLat, curLon);
-      *pDest++ = curValue;
-      curLon += xDelta;
+  try {
+    // Every tile interpolates the same lattices, so the tiles have no seams.
+    m_pBuilder->PrepareResampleModules ();
+
+    m_pTileSink->BeginMap (destWidth, destHeight);
+    for (noise::int64 y = 0; y < destHeight; y += tileHeight) {
+      noise::int64 curHeight = GetMin (tileHeight, destHeight - y);
+      for (noise::int64 x = 0; x < destWidth; x += tileWidth) {
+        noise::int64 curWidth = GetMin (tileWidth, destWidth - x);
+        m_pBuilder->SetDestWindow (x, y, curWidth, curHeight);
+        m_pBuilder->Build ();
+        m_pTileSink->WriteTile (m_tile, x, y);
+      }
+    }
+    m_pTileSink->EndMap ();
+  }
+  catch (...) {
+    RestoreBuilder (pPrevDestNoiseMap);
+    throw;
+  }
+  RestoreBuilder (pPrevDestNoiseMap);
+}
+
+void TiledNoiseMapBuilder::CalcTileSize (noise::int64& tileWidth,
+  noise::int64& tileHeight) const
+{
+  tileWidth  = m_tileWidth ;
+  tileHeight = m_tileHeight;
+  if (tileWidth == 0) {
+    // Use the largest square tile that fits in the memory budget, or the
+    // default tile size if there is no budget.
+    tileWidth = DEFAULT_TILE_SIZE;
+    if (m_memoryBudget > 0) {
+      double side = floor (sqrt ((double)(m_memoryBudget / sizeof (float))));
+      tileWidth = (noise::int64)GetMin (side, (double)RASTER_MAX_WIDTH);
+      tileWidth -= tileWidth % RASTER_STRIDE_BOUNDARY;
+    }
+    tileHeight = GetMin (tileWidth, RASTER_MAX_HEIGHT);
+    if (tileWidth <= 0) {
+      throw noise::ExceptionInvalidParam ();
     }
-    curLat += yDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (y);
+  }
+
+  if (m_memoryBudget > 0) {
+    // Calculate in 64 bits and compare the number of values so that the
+    // size of a large tile cannot overflow before the comparison.
+    noise::uint64 stride = ((noise::uint64)tileWidth
+      + RASTER_STRIDE_BOUNDARY - 1)
+      / RASTER_STRIDE_BOUNDARY * RASTER_STRIDE_BOUNDARY;
+    noise::uint64 maxCount = (noise::uint64)(m_memoryBudget / sizeof (float));
+    if (stride > maxCount || (noise::uint64)tileHeight > maxCount / stride) {
+      throw noise::ExceptionInvalidParam ();
     }
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////
+void TiledNoiseMapBuilder::RestoreBuilder (NoiseMap* pDestNoiseMap)
+{
+  m_pBuilder->ClearDestWindow ();
+  if (pDestNoiseMap != NULL) {
+    m_pBuilder->SetDestNoiseMap (*pDestNoiseMap);
+  } else {
+    m_pBuilder->ClearDestNoiseMap ();
+  }
+  m_tile.SetSize (0, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
 // RendererImage class
 
 RendererImage::RendererImage ():
@@ -954,6 +6338,7 @@ RendererImage::RendererImage ():
   m_lightIntensity    (1.0),
   m_pBackgroundImage  (NULL),
   m_pDestImage        (NULL),
+  m_pExecutor         (NULL),
   m_pSourceNoiseMap   (NULL),
   m_recalcLightValues (true)
 {
@@ -1038,17 +6423,6 @@ Color RendererImage::CalcDestColor (const Color& sourceColor,
 double RendererImage::CalcLightIntensity (double center, double left,
   double right, double down, double up) const
 {
-  // Recalculate the sine and cosine of the various light values if
-  // necessary so it does not have to be calculated each time this method is
-  // called.
-  if (m_recalcLightValues) {
-    m_cosAzimuth = cos (m_lightAzimuth * DEG_TO_RAD);
-    m_sinAzimuth = sin (m_lightAzimuth * DEG_TO_RAD);
-    m_cosElev    = cos (m_lightElev    * DEG_TO_RAD);
-    m_sinElev    = sin (m_lightElev    * DEG_TO_RAD);
-    m_recalcLightValues = false;
-  }
-
   // Now do the lighting calculations.
   const double I_MAX = 1.0;
   double io = I_MAX * SQRT_2 * m_sinElev / 2.0;
@@ -1063,6 +6437,19 @@ double RendererImage::CalcLightIntensity (double center, double left,
   return intensity;
 }
 
+void RendererImage::CalcLightValues () const
+{
+  // Recalculate the sine and cosine of the various light values if
+  // necessary so it does not have to be calculated for each point.
+  if (m_recalcLightValues) {
+    m_cosAzimuth = cos (m_lightAzimuth * DEG_TO_RAD);
+    m_sinAzimuth = sin (m_lightAzimuth * DEG_TO_RAD);
+    m_cosElev    = cos (m_lightElev    * DEG_TO_RAD);
+    m_sinElev    = sin (m_lightElev    * DEG_TO_RAD);
+    m_recalcLightValues = false;
+  }
+}
+
 void RendererImage::ClearGradient ()
 {
   m_gradient.Clear ();
@@ -1078,8 +6465,8 @@ void RendererImage::Render ()
     throw noise::ExceptionInvalidParam ();
   }
 
-  int width  = m_pSourceNoiseMap->GetWidth  ();
-  int height = m_pSourceNoiseMap->GetHeight ();
+  noise::int64 width  = m_pSourceNoiseMap->GetWidth  ();
+  noise::int64 height = m_pSourceNoiseMap->GetHeight ();
 
   // If a background image was provided, make sure it is the same size the
   // source noise map.
@@ -1096,108 +6483,138 @@ void RendererImage::Render ()
     m_pDestImage->SetSize (width, height);
   }
 
-  for (int y = 0; y < height; y++) {
-    const Color* pBackground = NULL;
-    if (m_pBackgroundImage != NULL) {
-      pBackground = m_pBackgroundImage->GetConstSlabPtr (y);
-    }
-    const float* pSource = m_pSourceNoiseMap->GetConstSlabPtr (y);
-    Color* pDest = m_pDestImage->GetSlabPtr (y);
-    for (int x = 0; x < width; x++) {
-
-      // Get the color based on the value at the current point in the noise
-      // map.
-      Color destColor = m_gradient.GetColor (*pSource);
-
-      // If lighting is enabled, calculate the light intensity based on the
-      // rate of change at the current point in the noise map.
-      double lightIntensity;
-      if (m_isLightEnabled) {
-
-        // Calculate the positions of the current point's four-neighbors.
-        int xLeftOffset, xRightOffset;
-        int yUpOffset  , yDownOffset ;
-        if (m_isWrapEnabled) {
-          if (x == 0) {
-            xLeftOffset  = (int)width - 1;
-            xRightOffset = 1;
-          } else if (x == (int)width - 1) {
-            xLeftOffset  = -1;
-            xRightOffset = -((int)width - 1);
-          } else {
-            xLeftOffset  = -1;
-            xRightOffset = 1;
-          }
-          if (y == 0) {
-            yDownOffset = (int)height - 1;
-            yUpOffset   = 1;
-          } else if (y == (int)height - 1) {
-            yDownOffset = -1;
-            yUpOffset   = -((int)height - 1);
-          } else {
-            yDownOffset = -1;
-            yUpOffset   = 1;
-          }
+  if (m_isLightEnabled) {
+    CalcLightValues ();
+  }
+
+  RunRows (GetExecutor (), *this, &RendererImage::RenderRow, height, NULL);
+}
+
+void RendererImage::RenderRow (noise::int64 y) const
+{
+  switch (m_pSourceNoiseMap->GetFormat ()) {
+    case FORMAT_FLOAT32:
+      RenderRowFrom (y, Float32Reader ());
+      break;
+    case FORMAT_UINT16:
+      RenderRowFrom (y, UInt16Reader (
+        m_pSourceNoiseMap->GetQuantizationScale (),
+        m_pSourceNoiseMap->GetQuantizationBias ()));
+      break;
+    case FORMAT_FLOAT16:
+      RenderRowFrom (y, Float16Reader ());
+      break;
+  }
+}
+
+template <class Reader>
+void RendererImage::RenderRowFrom (noise::int64 y, const Reader& reader) const
+{
+  noise::int64 width  = m_pSourceNoiseMap->GetWidth  ();
+  noise::int64 height = m_pSourceNoiseMap->GetHeight ();
+
+  const Color* pBackground = NULL;
+  if (m_pBackgroundImage != NULL) {
+    pBackground = m_pBackgroundImage->GetConstSlabPtr (y);
+  }
+  const typename Reader::Element* pSource = reader.GetSlab (
+    *m_pSourceNoiseMap, y);
+  Color* pDest = m_pDestImage->GetSlabPtr (y);
+  for (noise::int64 x = 0; x < width; x++) {
+
+    // Get the color based on the value at the current point in the noise
+    // map.
+    Color destColor;
+    m_gradient.GetColor (reader (pSource), destColor);
+
+    // If lighting is enabled, calculate the light intensity based on the
+    // rate of change at the current point in the noise map.
+    double lightIntensity;
+    if (m_isLightEnabled) {
+
+      // Calculate the positions of the current point's four-neighbors.
+      noise::int64 xLeftOffset, xRightOffset;
+      noise::int64 yUpOffset  , yDownOffset ;
+      if (m_isWrapEnabled) {
+        if (x == 0) {
+          xLeftOffset  = (noise::int64)width - 1;
+          xRightOffset = 1;
+        } else if (x == (noise::int64)width - 1) {
+          xLeftOffset  = -1;
+          xRightOffset = -((noise::int64)width - 1);
         } else {
-          if (x == 0) {
-            xLeftOffset  = 0;
-            xRightOffset = 1;
-          } else if (x == (int)width - 1) {
-            xLeftOffset  = -1;
-            xRightOffset = 0;
-          } else {
-            xLeftOffset  = -1;
-            xRightOffset = 1;
-          }
-          if (y == 0) {
-            yDownOffset = 0;
-            yUpOffset   = 1;
-          } else if (y == (int)height - 1) {
-            yDownOffset = -1;
-            yUpOffset   = 0;
-          } else {
-            yDownOffset = -1;
-            yUpOffset   = 1;
-          }
+          xLeftOffset  = -1;
+          xRightOffset = 1;
+        }
+        if (y == 0) {
+          yDownOffset = (noise::int64)height - 1;
+          yUpOffset   = 1;
+        } else if (y == (noise::int64)height - 1) {
+          yDownOffset = -1;
+          yUpOffset   = -((noise::int64)height - 1);
+        } else {
+          yDownOffset = -1;
+          yUpOffset   = 1;
+        }
+      } else {
+        if (x == 0) {
+          xLeftOffset  = 0;
+          xRightOffset = 1;
+        } else if (x == (noise::int64)width - 1) {
+          xLeftOffset  = -1;
+          xRightOffset = 0;
+        } else {
+          xLeftOffset  = -1;
+          xRightOffset = 1;
+        }
+        if (y == 0) {
+          yDownOffset = 0;
+          yUpOffset   = 1;
+        } else if (y == (noise::int64)height - 1) {
+          yDownOffset = -1;
+          yUpOffset   = 0;
+        } else {
+          yDownOffset = -1;
+          yUpOffset   = 1;
         }
-        yDownOffset *= m_pSourceNoiseMap->GetStride ();
-        yUpOffset   *= m_pSourceNoiseMap->GetStride ();
+      }
+      yDownOffset *= m_pSourceNoiseMap->GetStride ();
+      yUpOffset   *= m_pSourceNoiseMap->GetStride ();
 
-        // Get the noise value of the current point in the source noise map
-        // and the noise values of its four-neighbors.
-        double nc = (double)(*pSource);
-        double nl = (double)(*(pSource + xLeftOffset ));
-        double nr = (double)(*(pSource + xRightOffset));
-        double nd = (double)(*(pSource + yDownOffset ));
-        double nu = (double)(*(pSource + yUpOffset   ));
+      // Get the noise value of the current point in the source noise map
+      // and the noise values of its four-neighbors.
+      double nc = (double)reader (pSource);
+      double nl = (double)reader (pSource + xLeftOffset );
+      double nr = (double)reader (pSource + xRightOffset);
+      double nd = (double)reader (pSource + yDownOffset );
+      double nu = (double)reader (pSource + yUpOffset   );
 
-        // Now we can calculate the lighting intensity.
-        lightIntensity = CalcLightIntensity (nc, nl, nr, nd, nu);
-        lightIntensity *= m_lightBrightness;
+      // Now we can calculate the lighting intensity.
+      lightIntensity = CalcLightIntensity (nc, nl, nr, nd, nu);
+      lightIntensity *= m_lightBrightness;
 
-      } else {
+    } else {
 
-        // These values will apply no lighting to the destination image.
-        lightIntensity = 1.0;
-      }
+      // These values will apply no lighting to the destination image.
+      lightIntensity = 1.0;
+    }
 
-      // Get the current background color from the background image.
-      Color backgroundColor (255, 255, 255, 255);
-      if (m_pBackgroundImage != NULL) {
-        backgroundColor = *pBackground;
-      }
+    // Get the current background color from the background image.
+    Color backgroundColor (255, 255, 255, 255);
+    if (m_pBackgroundImage != NULL) {
+      backgroundColor = *pBackground;
+    }
 
-      // Blend the destination color, background color, and the light
-      // intensity together, then update the destination image with that
-      // color.
-      *pDest = CalcDestColor (destColor, backgroundColor, lightIntensity);
+    // Blend the destination color, background color, and the light
+    // intensity together, then update the destination image with that
+    // color.
+    *pDest = CalcDestColor (destColor, backgroundColor, lightIntensity);
 
-      // Go to the next point.
-      ++pSource;
-      ++pDest;
-      if (m_pBackgroundImage != NULL) {
-        ++pBackground;
-      }
+    // Go to the next point.
+    ++pSource;
+    ++pDest;
+    if (m_pBackgroundImage != NULL) {
+      ++pBackground;
     }
   }
 }
@@ -1209,6 +6626,7 @@ RendererNormalMap::RendererNormalMap ():
   m_bumpHeight      (1.0),
   m_isWrapEnabled   (false),
   m_pDestImage      (NULL),
+  m_pExecutor       (NULL),
   m_pSourceNoiseMap (NULL)
 {
 }
@@ -1246,54 +6664,80 @@ void RendererNormalMap::Render ()
     throw noise::ExceptionInvalidParam ();
   }
 
-  int width  = m_pSourceNoiseMap->GetWidth  ();
-  int height = m_pSourceNoiseMap->GetHeight ();
+  noise::int64 height = m_pSourceNoiseMap->GetHeight ();
 
-  for (int y = 0; y < height; y++) {
-    const float* pSource = m_pSourceNoiseMap->GetConstSlabPtr (y);
-    Color* pDest = m_pDestImage->GetSlabPtr (y);
-    for (int x = 0; x < width; x++) {
+  RunRows (GetExecutor (), *this, &RendererNormalMap::RenderRow, height,
+    NULL);
+}
 
-      // Calculate the positions of the current point's right and up
-      // neighbors.
-      int xRightOffset, yUpOffset;
-      if (m_isWrapEnabled) {
-        if (x == (int)width - 1) {
-          xRightOffset = -((int)width - 1);
-        } else {
-          xRightOffset = 1;
-        }
-        if (y == (int)height - 1) {
-          yUpOffset = -((int)height - 1);
-        } else {
-          yUpOffset = 1;
-        }
+void RendererNormalMap::RenderRow (noise::int64 y) const
+{
+  switch (m_pSourceNoiseMap->GetFormat ()) {
+    case FORMAT_FLOAT32:
+      RenderRowFrom (y, Float32Reader ());
+      break;
+    case FORMAT_UINT16:
+      RenderRowFrom (y, UInt16Reader (
+        m_pSourceNoiseMap->GetQuantizationScale (),
+        m_pSourceNoiseMap->GetQuantizationBias ()));
+      break;
+    case FORMAT_FLOAT16:
+      RenderRowFrom (y, Float16Reader ());
+      break;
+  }
+}
+
+template <class Reader>
+void RendererNormalMap::RenderRowFrom (noise::int64 y,
+  const Reader& reader) const
+{
+  noise::int64 width  = m_pSourceNoiseMap->GetWidth  ();
+  noise::int64 height = m_pSourceNoiseMap->GetHeight ();
+
+  const typename Reader::Element* pSource = reader.GetSlab (
+    *m_pSourceNoiseMap, y);
+  Color* pDest = m_pDestImage->GetSlabPtr (y);
+  for (noise::int64 x = 0; x < width; x++) {
+
+    // Calculate the positions of the current point's right and up
+    // neighbors.
+    noise::int64 xRightOffset, yUpOffset;
+    if (m_isWrapEnabled) {
+      if (x == (noise::int64)width - 1) {
+        xRightOffset = -((noise::int64)width - 1);
       } else {
-        if (x == (int)width - 1) {
-          xRightOffset = 0;
-        } else {
-          xRightOffset = 1;
-        }
-        if (y == (int)height - 1) {
-          yUpOffset = 0;
-        } else {
-          yUpOffset = 1;
-        }
+        xRightOffset = 1;
+      }
+      if (y == (noise::int64)height - 1) {
+        yUpOffset = -((noise::int64)height - 1);
+      } else {
+        yUpOffset = 1;
+      }
+    } else {
+      if (x == (noise::int64)width - 1) {
+        xRightOffset = 0;
+      } else {
+        xRightOffset = 1;
+      }
+      if (y == (noise::int64)height - 1) {
+        yUpOffset = 0;
+      } else {
+        yUpOffset = 1;
       }
-      yUpOffset *= m_pSourceNoiseMap->GetStride ();
+    }
+    yUpOffset *= m_pSourceNoiseMap->GetStride ();
 
-      // Get the noise value of the current point in the source noise map
-      // and the noise values of its right and up neighbors.
-      double nc = (double)(*pSource);
-      double nr = (double)(*(pSource + xRightOffset));
-      double nu = (double)(*(pSource + yUpOffset   ));
+    // Get the noise value of the current point in the source noise map
+    // and the noise values of its right and up neighbors.
+    double nc = (double)reader (pSource);
+    double nr = (double)reader (pSource + xRightOffset);
+    double nu = (double)reader (pSource + yUpOffset   );
 
-      // Calculate the normal product.
-      *pDest = CalcNormalColor (nc, nr, nu, m_bumpHeight);
+    // Calculate the normal product.
+    *pDest = CalcNormalColor (nc, nr, nu, m_bumpHeight);
 
-      // Go to the next point.
-      ++pSource;
-      ++pDest;
-    }
+    // Go to the next point.
+    ++pSource;
+    ++pDest;
   }
 }
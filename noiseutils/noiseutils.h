@@ -25,8 +25,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <fstream>
 #include <string>
+#include <vector>
 
+#include <noise/cubeface.h>
 #include <noise/noise.h>
 
 using namespace noise;
@@ -63,11 +66,25 @@ namespace noise
     ///   the input value along the surface of a specific mathematical object.
     ///   Each of these classes implements a different mathematical object,
     ///   such as a plane, a cylinder, or a sphere.
+    /// - A <i>noise volume</i> class and a <i>noise-volume builder</i>
+    ///   class: These classes store and fill a three-dimensional array of
+    ///   coherent-noise values, such as a chunk of a voxel world.
     /// - An <i>image</i> class: This class implements a two-dimensional array
     ///   that stores color values.
     /// - Several <i>image-renderer</i> classes: these classes render images
     ///   given the contents of a noise map.  Each of these classes renders an
     ///   image in a different way.
+    /// - A <i>tiled noise-map builder</i> class: This class builds noise
+    ///   maps too large to fit in memory one tile at a time and passes each
+    ///   tile to a <i>tile sink</i>, such as a raw file.
+    /// - A <i>compressed noise map</i> class: This class stores a noise map
+    ///   in compressed tiles and is also a tile sink, so more of a world
+    ///   fits in memory.
+    /// - A <i>virtual noise map</i> class: This class calculates the tiles
+    ///   of a noise map only when they are read and caches them.
+    /// - An <i>executor</i> interface and a work-stealing thread pool: the
+    ///   builders and renderers submit their rows to an executor so that
+    ///   several threads can fill a single noise map or image.
     ///
     /// @section contact Contact
     ///
@@ -76,16 +93,73 @@ namespace noise
     /// <a href=http://www.planettribes.com/allyourbase/story.shtml>zig</a>.)
 
     /// The maximum width of a raster.
-    const int RASTER_MAX_WIDTH = 32767;
+    ///
+    /// This limit is the size of the address space of current 64-bit
+    /// platforms, so in practice the size of a raster is limited by memory.
+    /// The classes that allocate rasters also check that the total number
+    /// of bytes does not overflow.
+    const noise::int64 RASTER_MAX_WIDTH = 0x7fffffffffffLL;
 
     /// The maximum height of a raster.
-    const int RASTER_MAX_HEIGHT = 32767;
+    ///
+    /// See RASTER_MAX_WIDTH.
+    const noise::int64 RASTER_MAX_HEIGHT = 0x7fffffffffffLL;
+
+    #ifndef NOISEUTILS_RASTER_ALIGNMENT
+    /// The alignment of raster buffers and slabs, in bytes.
+    ///
+    /// Define this macro to a power of two that is at least 4 to change the
+    /// alignment, for example to 32 for AVX or to 4 to save memory on narrow
+    /// rasters.  The library and every application that includes this file
+    /// must use the same value; the CMake build exports the value that the
+    /// library was built with.
+    #define NOISEUTILS_RASTER_ALIGNMENT 64
+    #endif
+
+    #if NOISEUTILS_RASTER_ALIGNMENT < 4 \
+      || (NOISEUTILS_RASTER_ALIGNMENT & (NOISEUTILS_RASTER_ALIGNMENT - 1)) != 0
+    #error NOISEUTILS_RASTER_ALIGNMENT must be a power of two of at least 4
+    #endif
+
+    /// The alignment of raster buffers and slabs, in bytes.
+    ///
+    /// The buffers that noise maps and images allocate start on a multiple
+    /// of this alignment, and their strides are padded so that every slab
+    /// starts on a multiple of it as well.  The default of 64 bytes is a
+    /// cache line and a full AVX-512 vector, so row kernels can use aligned
+    /// vector loads without peeling.  Buffers wrapped with WrapBuffer() are
+    /// only as aligned as the caller made them, and buffers mapped with
+    /// MapFile() start 64 bytes past a page boundary.
+    const size_t RASTER_ALIGNMENT = NOISEUTILS_RASTER_ALIGNMENT;
 
     #ifndef DOXYGEN_SHOULD_SKIP_THIS
-    // The raster's stride length must be a multiple of this constant.
-    const int RASTER_STRIDE_BOUNDARY = 4;
+    // The raster's stride length must be a multiple of this constant.  Both
+    // float values and Color objects are four bytes long.
+    const int RASTER_STRIDE_BOUNDARY = NOISEUTILS_RASTER_ALIGNMENT / 4;
     #endif
 
+    /// The width and height of the blocks in which noise-map builders
+    /// check a region mask.
+    const noise::int64 MASK_BLOCK_SIZE = 64;
+
+    /// The default width and height of the cells of the coarse grid that
+    /// noise-map builders calculate first when adaptive sampling is
+    /// enabled.
+    const noise::int64 DEFAULT_ADAPTIVE_CELL_SIZE = 16;
+
+    /// The highest order of the grid of the NoiseMapBuilderHealpix class,
+    /// the highest order for which HEALPix nested indices fit in 64 bits.
+    const int HEALPIX_MAX_ORDER = 29;
+
+    /// The default spacing, in points, of the points at which the
+    /// NoiseVolumeBuilder class probes a volume before building it.
+    const noise::int64 DEFAULT_VOLUME_PROBE_STEP = 4;
+
+    /// The default width and height, in points, of the tiles that the
+    /// TiledNoiseMapBuilder class builds when neither a tile size nor a
+    /// memory budget is set.
+    const noise::int64 DEFAULT_TILE_SIZE = 1024;
+
     /// A pointer to a callback function used by the NoiseMapBuilder class.
     ///
     /// The NoiseMapBuilder::Build() method calls this callback function each
@@ -95,8 +169,382 @@ namespace noise
     /// a count of the rows that have been completed.  It returns void.  Pass
     /// a function with this signature to the NoiseMapBuilder::SetCallback()
     /// method.
+    ///
+    /// The row count is truncated to an @a int, so noise maps taller than
+    /// @a INT_MAX rows should use a NoiseMapCallback64 function instead.
     typedef void(*NoiseMapCallback) (int row);
 
+    /// A pointer to a callback function used by the NoiseMapBuilder class
+    /// for noise maps of any height.
+    ///
+    /// This is the same as NoiseMapCallback, but the count of the rows that
+    /// have been completed is a 64-bit integer.  Pass a function with this
+    /// signature to the NoiseMapBuilder::SetCallback64() method.
+    typedef void(*NoiseMapCallback64) (noise::int64 row);
+
+    /// A pointer to a callback function that the NoiseMapBuilder class
+    /// calls after each pass of a progressive build.
+    ///
+    /// The parameters are the spacing, in points, of the points that the
+    /// pass calculated, and the context pointer passed to the
+    /// NoiseMapBuilder::SetPassCallback() method.  The function returns
+    /// @a false to stop the build after this pass.
+    typedef bool(*NoiseMapPassCallback) (noise::int64 step, void* pContext);
+
+    /// Abstract base class for a unit of work submitted to an executor.
+    ///
+    /// A task is split into a number of independent parts, each identified
+    /// by a zero-based index.  An executor calls the Run() method once for
+    /// each part, possibly from several threads at the same time.
+    class ExecutorTask
+    {
+
+      public:
+
+        /// Destructor.
+        virtual ~ExecutorTask ()
+        {
+        }
+
+        /// Runs one part of the task.
+        ///
+        /// @param index The zero-based index of the part to run.
+        ///
+        /// This method may be called concurrently for different indices, so
+        /// it must not modify state shared between the parts without
+        /// synchronization.
+        virtual void Run (int index) = 0;
+
+    };
+
+    /// Abstract base class for an executor.
+    ///
+    /// An executor runs the parts of an ExecutorTask, usually in parallel.
+    /// The noise-map builders and the image renderers submit their rows to
+    /// an executor as tasks.
+    ///
+    /// An application that already owns a scheduler can derive a class from
+    /// this class and pass it to the SetDefaultExecutor() function or to the
+    /// SetExecutor() method of a builder or renderer.  The ThreadPool class
+    /// is the executor supplied by this library.
+    class Executor
+    {
+
+      public:
+
+        /// Destructor.
+        virtual ~Executor ()
+        {
+        }
+
+        /// Runs all parts of a task and waits for them to complete.
+        ///
+        /// @param task The task to run.
+        /// @param partCount The number of parts in the task.
+        ///
+        /// This method calls task.Run() once for each index from 0 to
+        /// ( @a partCount - 1 ), in any order and on any thread, and returns
+        /// after all of these calls have returned.
+        ///
+        /// If a part throws an exception, the remaining parts still run and
+        /// the first exception is rethrown from this method.
+        virtual void Execute (ExecutorTask& task, int partCount) = 0;
+
+        /// Returns the number of parts this executor may run at once.
+        ///
+        /// @returns The number of parts this executor may run at once.
+        ///
+        /// Callers use this value to decide how finely to split a task.
+        virtual int GetConcurrency () const = 0;
+
+    };
+
+    #ifndef DOXYGEN_SHOULD_SKIP_THIS
+    class CompressedNoiseMapImpl;
+    class ThreadPoolImpl;
+    class RasterBufferPoolImpl;
+    class RasterMappingImpl;
+    class VirtualNoiseMapImpl;
+    #endif
+
+    /// A work-stealing thread pool.
+    ///
+    /// A thread pool owns a fixed set of worker threads.  Each worker has
+    /// its own queue of task parts; a worker that empties its queue steals
+    /// parts from the back of the other workers' queues, so uneven rows
+    /// (such as rows near the poles of a planet) balance out.
+    ///
+    /// Several threads may submit tasks to the same pool at the same time.
+    /// Sharing one pool between every builder and renderer in a process
+    /// keeps the total number of busy threads under a single limit; pass
+    /// the pool to the SetDefaultExecutor() function to do so.
+    ///
+    /// <b>Concurrency limit</b>
+    ///
+    /// The concurrency limit is the number of workers that may run task
+    /// parts.  The remaining workers sleep.  The limit may be changed at any
+    /// time by calling the SetConcurrencyLimit() method.
+    ///
+    /// The thread that calls the Execute() method sleeps until the task is
+    /// complete, so it does not count against the limit.  A worker thread
+    /// that calls the Execute() method runs parts of the task itself while
+    /// it waits.
+    ///
+    /// <b>CPU affinity</b>
+    ///
+    /// Call the SetAffinity() method to pin a worker to a specific CPU.
+    /// CPU affinity is supported on Linux and Windows; on other platforms
+    /// the SetAffinity() method does nothing and returns @a false.
+    class ThreadPool: public Executor
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// @param threadCount The number of worker threads to create, or 0
+        /// to create one worker for each hardware thread.
+        ///
+        /// @pre The number of worker threads is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The concurrency limit is initially equal to the number of
+        /// worker threads.
+        ThreadPool (int threadCount = 0);
+
+        /// Destructor.
+        ///
+        /// Waits for the worker threads to exit.  No task may be running in
+        /// this pool when it is destroyed.
+        virtual ~ThreadPool ();
+
+        virtual void Execute (ExecutorTask& task, int partCount);
+
+        virtual int GetConcurrency () const
+        {
+          return GetConcurrencyLimit ();
+        }
+
+        /// Returns the concurrency limit of this pool.
+        ///
+        /// @returns The maximum number of workers that may run task parts
+        /// at the same time.
+        int GetConcurrencyLimit () const;
+
+        /// Returns the number of worker threads in this pool.
+        ///
+        /// @returns The number of worker threads in this pool.
+        int GetThreadCount () const;
+
+        /// Pins a worker thread to a CPU.
+        ///
+        /// @param workerIndex The zero-based index of the worker thread.
+        /// @param cpu The zero-based index of the CPU.
+        ///
+        /// @returns
+        /// - @a true if the worker is now pinned to the CPU.
+        /// - @a false if the platform does not support CPU affinity or the
+        ///   CPU does not exist.
+        ///
+        /// @pre The worker index ranges from 0 to one less than the number
+        /// of worker threads.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        bool SetAffinity (int workerIndex, int cpu);
+
+        /// Sets the concurrency limit of this pool.
+        ///
+        /// @param limit The maximum number of workers that may run task
+        /// parts at the same time.
+        ///
+        /// The limit is clamped to the range 1 to the number of worker
+        /// threads.  Parts that are already running are not interrupted.
+        void SetConcurrencyLimit (int limit);
+
+      private:
+
+        /// Copy constructor.
+        ///
+        /// A thread pool cannot be copied.
+        ThreadPool (const ThreadPool& rhs);
+
+        /// Assignment operator.
+        ///
+        /// A thread pool cannot be copied.
+        ThreadPool& operator= (const ThreadPool& rhs);
+
+        /// The worker threads and their queues.
+        ThreadPoolImpl* m_pImpl;
+
+    };
+
+    /// Returns the executor used by builders and renderers that have no
+    /// executor of their own.
+    ///
+    /// @returns The default executor, or @a NULL if builders and renderers
+    /// run on the calling thread.
+    ///
+    /// There is no default executor until the application calls the
+    /// SetDefaultExecutor() function.
+    Executor* GetDefaultExecutor ();
+
+    /// Sets the executor used by builders and renderers that have no
+    /// executor of their own.
+    ///
+    /// @param pExecutor The executor, or @a NULL to run builders and
+    /// renderers on the calling thread.
+    ///
+    /// The executor must exist until it is replaced.  Call this function
+    /// during initialization, before any builder or renderer is running.
+    void SetDefaultExecutor (Executor* pExecutor);
+
+    /// Statistics kept by a raster buffer pool.
+    ///
+    /// Call the GetStats() method of a RasterBufferPool object to retrieve
+    /// them.
+    struct RasterBufferPoolStats
+    {
+
+      /// The number of buffers handed out by the pool.
+      noise::uint64 allocCount;
+
+      /// The number of buffers handed out from the pool's cache, without
+      /// calling the upstream allocator.
+      noise::uint64 hitCount;
+
+      /// The number of buffers allocated from the upstream allocator.
+      noise::uint64 upstreamAllocCount;
+
+      /// The number of buffers returned to the upstream allocator.
+      noise::uint64 upstreamFreeCount;
+
+      /// The number of bytes in buffers that are handed out.
+      size_t bytesInUse;
+
+      /// The largest number of bytes that were handed out at once.
+      size_t peakBytesInUse;
+
+      /// The number of bytes in buffers that are cached by the pool.
+      size_t bytesCached;
+
+      /// The number of buffers that are cached by the pool.
+      size_t cachedBufferCount;
+
+    };
+
+    /// A pool of raster buffers.
+    ///
+    /// A raster buffer pool is an allocator that keeps the buffers returned
+    /// to it and hands them out again, so an application that builds and
+    /// renders maps of similar sizes over and over, such as a tile server,
+    /// stops allocating memory once the pool is warm.  Reused buffers are
+    /// already mapped in, so they do not page-fault again either.
+    ///
+    /// To use the pool, pass it to the SetDefaultAllocator() function, or to
+    /// the SetAllocator() method of the noise maps and images that builders
+    /// and renderers write to and of a TiledNoiseMapBuilder object.
+    ///
+    /// <b>Size classes</b>
+    ///
+    /// Requests are rounded up to a size class.  There are four size
+    /// classes for each power of two, starting at 64 bytes, so at most 25
+    /// percent of a buffer is unused.  Each size class keeps its own list
+    /// of cached buffers.  A buffer that does not fit in the largest size
+    /// class, or that needs a larger alignment than RASTER_ALIGNMENT, goes
+    /// straight to the upstream allocator.
+    ///
+    /// <b>Memory cap</b>
+    ///
+    /// The pool never caches more than a maximum number of bytes.  A
+    /// buffer returned while the cache is full goes back to the upstream
+    /// allocator.  Call the Trim() method to release cached buffers at any
+    /// other time.
+    ///
+    /// Several threads may use the same pool at the same time.
+    class RasterBufferPool: public noise::Allocator
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// @param maxCachedBytes The maximum number of bytes that this pool
+        /// caches.
+        /// @param pUpstream The allocator that this pool allocates buffers
+        /// from, or @a NULL to use the default allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        RasterBufferPool (size_t maxCachedBytes = (size_t)-1,
+          noise::Allocator* pUpstream = NULL);
+
+        /// Destructor.
+        ///
+        /// Releases the cached buffers.  Every buffer handed out by this
+        /// pool must be returned before the pool is destroyed.
+        virtual ~RasterBufferPool ();
+
+        virtual void* Allocate (size_t byteCount, size_t alignment);
+
+        virtual void Deallocate (void* pMemory, size_t byteCount,
+          size_t alignment);
+
+        /// Returns the maximum number of bytes that this pool caches.
+        ///
+        /// @returns The maximum number of bytes that this pool caches.
+        size_t GetMaxCachedBytes () const;
+
+        /// Retrieves the statistics of this pool.
+        ///
+        /// @param stats On exit, the statistics of this pool.
+        void GetStats (RasterBufferPoolStats& stats) const;
+
+        /// Returns the allocator that this pool allocates buffers from.
+        ///
+        /// @returns The upstream allocator.
+        noise::Allocator* GetUpstream () const;
+
+        /// Resets the counters of this pool.
+        ///
+        /// The allocation counters and the peak are reset; the byte and
+        /// buffer counts that describe the current state are kept.
+        void ResetStats ();
+
+        /// Sets the maximum number of bytes that this pool caches.
+        ///
+        /// @param maxCachedBytes The maximum number of bytes that this pool
+        /// caches.
+        ///
+        /// If the pool caches more than this number of bytes, it trims the
+        /// cache to this number of bytes.
+        void SetMaxCachedBytes (size_t maxCachedBytes);
+
+        /// Releases cached buffers to the upstream allocator.
+        ///
+        /// @param maxCachedBytes The number of bytes that may stay cached.
+        ///
+        /// Buffers from the largest size classes are released first.
+        /// Buffers that are handed out are not affected.
+        void Trim (size_t maxCachedBytes = 0);
+
+      private:
+
+        /// Copy constructor.
+        ///
+        /// A raster buffer pool cannot be copied.
+        RasterBufferPool (const RasterBufferPool& rhs);
+
+        /// Assignment operator.
+        ///
+        /// A raster buffer pool cannot be copied.
+        RasterBufferPool& operator= (const RasterBufferPool& rhs);
+
+        /// The size classes and their cached buffers.
+        RasterBufferPoolImpl* m_pImpl;
+
+    };
+
     /// Number of meters per point in a Terragen terrain (TER) file.
     const double DEFAULT_METERS_PER_POINT = 30.0;
 
@@ -226,6 +674,17 @@ namespace noise
         /// @post All gradient points from this gradient object are deleted.
         void Clear ();
 
+        /// Returns the allocator used by this gradient object.
+        ///
+        /// @returns The allocator used by this gradient object.
+        ///
+        /// A gradient object takes the default allocator when it is
+        /// constructed.
+        noise::Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
         /// Returns the color at the specified position in the color gradient.
         ///
         /// @param gradientPos The specified position.
@@ -233,6 +692,17 @@ namespace noise
         /// @returns The color at that position.
         const Color& GetColor (double gradientPos) const;
 
+        /// Calculates the color at the specified position in the color
+        /// gradient.
+        ///
+        /// @param gradientPos The specified position.
+        /// @param color On exit, the color at that position.
+        ///
+        /// Unlike the other GetColor() method, this method does not use the
+        /// working color of this object, so it may be called from several
+        /// threads at the same time.
+        void GetColor (double gradientPos, Color& color) const;
+
         /// Returns a pointer to the array of gradient points in this object.
         ///
         /// @returns A pointer to the array of gradient points.
@@ -256,6 +726,16 @@ namespace noise
           return m_gradientPointCount;
         }
 
+        /// Sets the allocator used by this gradient object.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The gradient points are moved to the new allocator.
+        void SetAllocator (noise::Allocator* pAllocator);
+
       private:
 
         /// Determines the array index in which to insert the gradient point
@@ -296,6 +776,9 @@ namespace noise
         /// Number of gradient points.
         int m_gradientPointCount;
 
+        /// The allocator that owns the gradient-point array.
+        noise::Allocator* m_pAllocator;
+
         /// Array that stores the gradient points.
         GradientPoint* m_pGradientPoints;
 
@@ -304,6 +787,48 @@ namespace noise
         mutable Color m_workingColor;
     };
 
+    /// Enumerates the formats in which a noise map stores its values.
+    enum NoiseMapFormat
+    {
+
+      /// Stores each value as a 32-bit IEEE floating-point number.  This is
+      /// the default format.
+      FORMAT_FLOAT32 = 0,
+
+      /// Stores each value as a 16-bit unsigned integer @a q that stands
+      /// for the value @a bias + @a scale * @a q.  Values outside the range
+      /// that these integers can represent are clamped to it.
+      FORMAT_UINT16 = 1,
+
+      /// Stores each value as a 16-bit IEEE half-precision floating-point
+      /// number.  Half-precision numbers have an 11-bit significand, so
+      /// values between -1 and +1 keep about three decimal digits.
+      FORMAT_FLOAT16 = 2
+
+    };
+
+    /// Converts a half-precision floating-point number to a single-precision
+    /// floating-point number.
+    ///
+    /// @param half The bits of the half-precision number.
+    ///
+    /// @returns The single-precision number.
+    ///
+    /// The conversion is exact.
+    float HalfToFloat (noise::uint16 half);
+
+    /// Converts a single-precision floating-point number to a
+    /// half-precision floating-point number.
+    ///
+    /// @param value The single-precision number.
+    ///
+    /// @returns The bits of the half-precision number.
+    ///
+    /// The number is rounded to the nearest half-precision number, with
+    /// ties rounded to even.  Numbers too large for half precision become
+    /// infinities.
+    noise::uint16 FloatToHalf (float value);
+
     /// Implements a noise map, a 2-dimensional array of floating-point
     /// values.
     ///
@@ -326,6 +851,32 @@ namespace noise
     /// reallocated.
     /// Call ReclaimMem() to reclaim the wasted memory.
     ///
+    /// <b>Memory-Mapped Storage</b>
+    ///
+    /// By default, the values are stored on the heap, in memory from the
+    /// allocator returned by the GetAllocator() method.  To store them in a
+    /// memory-mapped file instead, call the MapFile() method.  The values
+    /// then live in the page cache and can be larger than physical memory;
+    /// SetSize() grows the file as necessary.  The file keeps the size and
+    /// the values of the noise map, so calling MapFile() on the same file
+    /// later, even from another process, restores the noise map.  Several
+    /// processes may map the same file read-only at the same time without
+    /// copying it.
+    ///
+    /// To store the values in anonymous mapped memory, optionally backed by
+    /// huge pages, call the MapAnonymous() method.  To return to the heap,
+    /// call the Unmap() method.
+    ///
+    /// <b>External Memory</b>
+    ///
+    /// A noise map can also wrap memory owned by the application, such as a
+    /// staging buffer of a graphics API, with a stride chosen by the
+    /// application.  Pass the buffer to the WrapBuffer() method or to the
+    /// matching constructor.  The noise map never allocates or frees that
+    /// memory; SetSize() only accepts sizes that fit inside the wrapped
+    /// buffer and keeps its stride.  Noise-map builders then write their
+    /// values straight into the application's buffer.
+    ///
     /// <b>Border Values</b>
     ///
     /// All of the values outside of the noise map are assumed to have a
@@ -346,12 +897,30 @@ namespace noise
     ///
     /// The offset between the starting points of any two adjacent slabs is
     /// called the <i>stride amount</i>.  The stride amount is measured by
-    /// the number of @a float values between these two starting points, not
-    /// by the number of bytes.  For efficiency reasons, the stride is often a
+    /// the number of values between these two starting points, not by the
+    /// number of bytes.  For efficiency reasons, the stride is often a
     /// multiple of the machine word size.
     ///
     /// The GetSlabPtr() and GetConstSlabPtr() methods allow you to retrieve
     /// pointers to the slabs themselves.
+    ///
+    /// <b>Storage Formats</b>
+    ///
+    /// By default, each value is stored as a @a float.  To halve the memory
+    /// and bandwidth that a large noise map needs, pass FORMAT_UINT16 or
+    /// FORMAT_FLOAT16 to the SetFormat() method.  The values are then
+    /// stored as 16-bit numbers; the stride amount is measured in these
+    /// numbers.  Noise-map builders convert their values while writing, and
+    /// renderers and writers read the 16-bit numbers directly.
+    ///
+    /// In these formats, retrieve pointers to the slabs with the
+    /// GetSlabPtr16() and GetConstSlabPtr16() methods instead, or convert
+    /// whole runs of values with the GetSlabValues() and SetSlabValues()
+    /// methods.  The GetValue() and SetValue() methods work in any format.
+    ///
+    /// FORMAT_UINT16 maps the integers onto a range of values with a scale
+    /// and a bias, which are set with the SetQuantization() or
+    /// SetQuantizationRange() method.  The default range is -1 to +1.
     class NoiseMap
     {
 
@@ -378,13 +947,32 @@ namespace noise
         ///
         /// It is considered an error if the specified dimensions are not
         /// positive.
-        NoiseMap (int width, int height);
+        NoiseMap (noise::int64 width, noise::int64 height);
 
         /// Copy constructor.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.
         NoiseMap (const NoiseMap& rhs);
 
+        /// Constructor.
+        ///
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the noise map.
+        /// @param height The height of the noise map.
+        /// @param stride The stride amount, in @a float values.
+        ///
+        /// @throw noise::ExceptionInvalidParam See WrapBuffer().
+        ///
+        /// Creates a noise map that wraps memory owned by the caller.
+        NoiseMap (float* pBuffer, noise::int64 width, noise::int64 height,
+          noise::int64 stride);
+
+        /// Move constructor.
+        ///
+        /// The source noise map becomes empty; its buffer, whether allocated,
+        /// mapped or wrapped, moves to this noise map.
+        NoiseMap (NoiseMap&& rhs);
+
         /// Destructor.
         ///
         /// Frees the allocated memory for the noise map.
@@ -399,12 +987,33 @@ namespace noise
         /// Creates a copy of the noise map.
         NoiseMap& operator= (const NoiseMap& rhs);
 
+        /// Move assignment operator.
+        ///
+        /// @returns Reference to self.
+        ///
+        /// Frees the buffer of this noise map, then moves the buffer of the
+        /// source noise map, whether allocated, mapped or wrapped, to this
+        /// noise map.  The source noise map becomes empty.
+        NoiseMap& operator= (NoiseMap&& rhs);
+
         /// Clears the noise map to a specified value.
         ///
         /// @param value The value that all positions within the noise map are
         /// cleared to.
         void Clear (float value);
 
+        /// Returns the allocator used by this noise map.
+        ///
+        /// @returns The allocator used by this noise map.
+        ///
+        /// A noise map takes the default allocator when it is constructed, and
+        /// takes the allocator of the source when it takes ownership of a
+        /// buffer.
+        noise::Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
         /// Returns the value used for all positions outside of the noise map.
         ///
         /// @returns The value used for all positions outside of the noise
@@ -423,7 +1032,8 @@ namespace noise
         /// @a NULL if the noise map is empty.
         const float* GetConstSlabPtr () const
         {
-          return m_pNoiseMap;
+          assert (m_format == FORMAT_FLOAT32);
+          return (float*)m_pNoiseMap;
         }
 
         /// Returns a const pointer to a slab at the specified row.
@@ -438,7 +1048,7 @@ namespace noise
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        const float* GetConstSlabPtr (int row) const
+        const float* GetConstSlabPtr (noise::int64 row) const
         {
           return GetConstSlabPtr (0, row);
         }
@@ -456,15 +1066,59 @@ namespace noise
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        const float* GetConstSlabPtr (int x, int y) const
+        const float* GetConstSlabPtr (noise::int64 x, noise::int64 y) const
+        {
+          assert (m_format == FORMAT_FLOAT32);
+          return (float*)m_pNoiseMap + (size_t)x + (size_t)m_stride
+            * (size_t)y;
+        }
+
+        /// Returns a const pointer to a slab of 16-bit values at the
+        /// specified position.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns A const pointer to a slab at the position ( @a x, @a y ),
+        /// or @a NULL if the noise map is empty.
+        ///
+        /// @pre The noise map stores its values in the FORMAT_UINT16 or
+        /// FORMAT_FLOAT16 format.
+        /// @pre The coordinates must exist within the bounds of the noise
+        /// map.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        const noise::uint16* GetConstSlabPtr16 (noise::int64 x,
+          noise::int64 y) const
+        {
+          assert (m_format != FORMAT_FLOAT32);
+          return (noise::uint16*)m_pNoiseMap + (size_t)x + (size_t)m_stride
+            * (size_t)y;
+        }
+
+        /// Returns the number of bytes that stores each value.
+        ///
+        /// @returns 4 for the FORMAT_FLOAT32 format, or 2 for the 16-bit
+        /// formats.
+        size_t GetElementSize () const
+        {
+          return (m_format == FORMAT_FLOAT32)? sizeof (float):
+            sizeof (noise::uint16);
+        }
+
+        /// Returns the format in which the noise map stores its values.
+        ///
+        /// @returns The storage format.
+        NoiseMapFormat GetFormat () const
         {
-          return m_pNoiseMap + (size_t)x + (size_t)m_stride * (size_t)y;
+          return m_format;
         }
 
         /// Returns the height of the noise map.
         ///
         /// @returns The height of the noise map.
-        int GetHeight () const
+        noise::int64 GetHeight () const
         {
           return m_height;
         }
@@ -473,19 +1127,38 @@ namespace noise
         ///
         /// @returns The amount of memory allocated for this noise map.
         ///
-        /// This method returns the number of @a float values allocated.
+        /// This method returns the number of values allocated, each of which
+        /// is GetElementSize() bytes long.
         size_t GetMemUsed () const
         {
           return m_memUsed;
         }
 
-        /// Returns a pointer to a slab.
+        /// Returns the bias of the FORMAT_UINT16 format.
         ///
-        /// @returns A pointer to a slab at the position (0, 0), or @a NULL if
-        /// the noise map is empty.
+        /// @returns The value that the integer 0 stands for.
+        float GetQuantizationBias () const
+        {
+          return m_quantBias;
+        }
+
+        /// Returns the scale of the FORMAT_UINT16 format.
+        ///
+        /// @returns The difference between the values that two adjacent
+        /// integers stand for.
+        float GetQuantizationScale () const
+        {
+          return m_quantScale;
+        }
+
+        /// Returns a pointer to a slab.
+        ///
+        /// @returns A pointer to a slab at the position (0, 0), or @a NULL if
+        /// the noise map is empty.
         float* GetSlabPtr ()
         {
-          return m_pNoiseMap;
+          assert (m_format == FORMAT_FLOAT32);
+          return (float*)m_pNoiseMap;
         }
 
         /// Returns a pointer to a slab at the specified row.
@@ -500,7 +1173,7 @@ namespace noise
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        float* GetSlabPtr (int row)
+        float* GetSlabPtr (noise::int64 row)
         {
           return GetSlabPtr (0, row);
         }
@@ -518,20 +1191,59 @@ namespace noise
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        float* GetSlabPtr (int x, int y)
+        float* GetSlabPtr (noise::int64 x, noise::int64 y)
+        {
+          assert (m_format == FORMAT_FLOAT32);
+          return (float*)m_pNoiseMap + (size_t)x + (size_t)m_stride
+            * (size_t)y;
+        }
+
+        /// Returns a pointer to a slab of 16-bit values at the specified
+        /// position.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns A pointer to a slab at the position ( @a x, @a y ) or
+        /// @a NULL if the noise map is empty.
+        ///
+        /// @pre The noise map stores its values in the FORMAT_UINT16 or
+        /// FORMAT_FLOAT16 format.
+        /// @pre The coordinates must exist within the bounds of the noise
+        /// map.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        noise::uint16* GetSlabPtr16 (noise::int64 x, noise::int64 y)
         {
-          return m_pNoiseMap + (size_t)x + (size_t)m_stride * (size_t)y;
+          assert (m_format != FORMAT_FLOAT32);
+          return (noise::uint16*)m_pNoiseMap + (size_t)x + (size_t)m_stride
+            * (size_t)y;
         }
 
+        /// Retrieves a run of values from a slab in any storage format.
+        ///
+        /// @param x The x coordinate of the first value.
+        /// @param y The y coordinate of the values.
+        /// @param count The number of values to retrieve.
+        /// @param pDest On exit, the values.
+        ///
+        /// @pre The run lies within the bounds of the noise map.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        void GetSlabValues (noise::int64 x, noise::int64 y, noise::int64 count,
+          float* pDest) const;
+
         /// Returns the stride amount of the noise map.
         ///
         /// @returns The stride amount of the noise map.
         ///
         /// - The <i>stride amount</i> is the offset between the starting
         ///   points of any two adjacent slabs in a noise map.
-        /// - The stride amount is measured by the number of @a float values
-        ///   between these two points, not by the number of bytes.
-        int GetStride () const
+        /// - The stride amount is measured by the number of values between
+        ///   these two points, not by the number of bytes.
+        noise::int64 GetStride () const
         {
           return m_stride;
         }
@@ -545,16 +1257,76 @@ namespace noise
         ///
         /// This method returns the border value if the coordinates exist
         /// outside of the noise map.
-        float GetValue (int x, int y) const;
+        float GetValue (noise::int64 x, noise::int64 y) const;
 
         /// Returns the width of the noise map.
         ///
         /// @returns The width of the noise map.
-        int GetWidth () const
+        noise::int64 GetWidth () const
         {
           return m_width;
         }
 
+        /// Determines if the noise map is stored in mapped memory.
+        ///
+        /// @returns
+        /// - @a true if MapFile() or MapAnonymous() was called more recently
+        ///   than Unmap().
+        /// - @a false if the noise map is stored on the heap.
+        bool IsMapped () const
+        {
+          return m_pMapping != NULL;
+        }
+
+        /// Determines if the noise map wraps memory owned by the caller.
+        ///
+        /// @returns
+        /// - @a true if WrapBuffer() was called and the noise map was not
+        ///   emptied since.
+        /// - @a false otherwise.
+        bool IsWrapped () const
+        {
+          return m_isWrapped;
+        }
+
+        /// Stores the noise map in anonymous mapped memory.
+        ///
+        /// @param useHugePages Request huge pages for the mapped memory.
+        ///
+        /// @throw noise::ExceptionUnknown Mapped memory is not available on
+        /// this platform.
+        ///
+        /// On exit, the noise map is empty.  Buffers allocated by later
+        /// calls to SetSize() are mapped directly from the operating system
+        /// instead of the heap.  If @a useHugePages is true, this object
+        /// first asks for explicit huge pages and, if none are available,
+        /// falls back to normal pages with transparent huge pages enabled.
+        void MapAnonymous (bool useHugePages = false);
+
+        /// Stores the noise map in a memory-mapped file.
+        ///
+        /// @param filename The name of the file.
+        /// @param isReadOnly Map the file read-only.
+        ///
+        /// @throw noise::ExceptionUnknown The file could not be opened or
+        /// mapped, it is not a raster file, it stores values of another
+        /// type, or mapped memory is not available on this platform.
+        ///
+        /// If the file exists and contains a noise map, this object takes
+        /// its size and values.  If the file is empty or does not exist, it
+        /// is created and this noise map becomes empty.  Buffers allocated by
+        /// later calls to SetSize() grow the file.
+        ///
+        /// The file starts with a 64-byte header that stores the width,
+        /// height and stride of the noise map, followed by the slabs.  All
+        /// values are stored in the byte order of the host.
+        ///
+        /// If @a isReadOnly is true, the file must exist.  Several processes
+        /// may then share its pages; SetSize() throws
+        /// noise::ExceptionInvalidParam, and writing to the noise map through
+        /// any other method is not allowed.
+        void MapFile (const std::string& filename, bool isReadOnly = false);
+
         /// Reallocates the noise map to recover wasted memory.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.  (Yes, this
@@ -562,8 +1334,23 @@ namespace noise
         /// maps will temporarily exist in memory during this call.)
         ///
         /// The contents of the noise map is unaffected.
+        ///
+        /// This method does nothing if the noise map is stored in mapped
+        /// memory or wraps memory owned by the caller.
         void ReclaimMem ();
 
+        /// Sets the allocator used by this noise map.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// A buffer on the heap is copied into memory from the new allocator,
+        /// so the contents of the noise map are unaffected.  Mapped and wrapped
+        /// buffers do not come from an allocator and are left alone.
+        void SetAllocator (noise::Allocator* pAllocator);
+
         /// Sets the value to use for all positions outside of the noise map.
         ///
         /// @param borderValue The value to use for all positions outside of
@@ -576,6 +1363,46 @@ namespace noise
           m_borderValue = borderValue;
         }
 
+        /// Sets the format in which the noise map stores its values.
+        ///
+        /// @param format The storage format.
+        ///
+        /// On exit, the noise map is empty.  If it was stored in mapped
+        /// memory or wrapped memory owned by the caller, it is stored on the
+        /// heap again; call this method before MapFile(), MapAnonymous() or
+        /// WrapBuffer().
+        void SetFormat (NoiseMapFormat format);
+
+        /// Sets the scale and the bias of the FORMAT_UINT16 format.
+        ///
+        /// @param scale The difference between the values that two adjacent
+        /// integers stand for.
+        /// @param bias The value that the integer 0 stands for.
+        ///
+        /// @pre The scale is positive.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.  This
+        /// exception also occurs if the noise map is stored in a file mapped
+        /// read-only.
+        ///
+        /// The stored integers are not changed, so the values they stand
+        /// for change.  Set the quantization before building the noise map.
+        /// A mapped file records the quantization in its header.
+        void SetQuantization (float scale, float bias);
+
+        /// Sets the range of values of the FORMAT_UINT16 format.
+        ///
+        /// @param minValue The value that the integer 0 stands for.
+        /// @param maxValue The value that the integer 65535 stands for.
+        ///
+        /// @pre The minimum value is less than the maximum value.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// This method calls SetQuantization() with the scale and bias that
+        /// map the integers evenly onto the range.
+        void SetQuantizationRange (float minValue, float maxValue);
+
         /// Sets the new size for the noise map.
         ///
         /// @param width The new width for the noise map.
@@ -594,8 +1421,25 @@ namespace noise
         /// becomes empty.
         ///
         /// If the @a INVALID_PARAM exception occurs, the noise map is
-        /// unmodified.
-        void SetSize (int width, int height);
+        /// unmodified.  This exception also occurs if the noise map is
+        /// stored in a file mapped read-only, or if it wraps a buffer that
+        /// is too small for the new size.
+        void SetSize (noise::int64 width, noise::int64 height);
+
+        /// Stores a run of values in a slab in any storage format.
+        ///
+        /// @param x The x coordinate of the first value.
+        /// @param y The y coordinate of the values.
+        /// @param count The number of values to store.
+        /// @param pSource The values.
+        ///
+        /// @pre The run lies within the bounds of the noise map.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.  Runs that do not overlap may be stored from several
+        /// threads at the same time.
+        void SetSlabValues (noise::int64 x, noise::int64 y, noise::int64 count,
+          const float* pSource);
 
         /// Sets a value at a specified position in the noise map.
         ///
@@ -605,7 +1449,16 @@ namespace noise
         ///
         /// This method does nothing if the noise map object is empty or the
         /// position is outside the bounds of the noise map.
-        void SetValue (int x, int y, float value);
+        void SetValue (noise::int64 x, noise::int64 y, float value);
+
+        /// Writes the values of a memory-mapped file to disk.
+        ///
+        /// @throw noise::ExceptionUnknown The file could not be written.
+        ///
+        /// This method blocks until every modified page of the file is
+        /// written.  It does nothing if the noise map is not stored in a
+        /// file.
+        void SyncFile ();
 
         /// Takes ownership of the buffer within the source noise map.
         ///
@@ -614,9 +1467,63 @@ namespace noise
         /// On exit, the source noise map object becomes empty.
         ///
         /// This method only moves the buffer pointer so this method is very
-        /// quick.
+        /// quick.  A mapped or wrapped buffer moves along with its storage:
+        /// this noise map then owns the mapping, or wraps the caller's
+        /// memory.
         void TakeOwnership (NoiseMap& source);
 
+        /// Stores the noise map on the heap again.
+        ///
+        /// On exit, the noise map is empty.  If the noise map was stored in a
+        /// file, the file is closed and keeps its contents.
+        void Unmap ();
+
+        /// Wraps memory owned by the caller.
+        ///
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the noise map.
+        /// @param height The height of the noise map.
+        /// @param stride The stride amount, in @a float values.
+        ///
+        /// @pre @a pBuffer is not @a NULL.
+        /// @pre The width and height values are positive.
+        /// @pre The width and height values do not exceed the maximum
+        /// possible width and height for the noise map.
+        /// @pre The stride amount is not less than the width.
+        /// @pre The noise map stores its values in the FORMAT_FLOAT32
+        /// format.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The buffer must hold @a height slabs of @a stride @a float values
+        /// each and must exist until this noise map is emptied, wraps another
+        /// buffer, or is destroyed.  This object never frees the buffer.
+        ///
+        /// SetSize() keeps using the buffer as long as the new width does
+        /// not exceed the stride amount and the new size fits in the
+        /// buffer; otherwise, it throws noise::ExceptionInvalidParam.
+        /// SetSize (0, 0) releases the buffer and returns to the heap.
+        void WrapBuffer (float* pBuffer, noise::int64 width,
+          noise::int64 height, noise::int64 stride);
+
+        /// Wraps 16-bit memory owned by the caller.
+        ///
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the noise map.
+        /// @param height The height of the noise map.
+        /// @param stride The stride amount, in 16-bit values.
+        ///
+        /// @pre The noise map stores its values in the FORMAT_UINT16 or
+        /// FORMAT_FLOAT16 format.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions and
+        /// the preconditions of the other WrapBuffer() method.
+        ///
+        /// This method behaves like the other WrapBuffer() method, which
+        /// requires the FORMAT_FLOAT32 format.
+        void WrapBuffer (noise::uint16* pBuffer, noise::int64 width,
+          noise::int64 height, noise::int64 stride);
+
       private:
 
         /// Returns the minimum amount of memory required to store a noise map
@@ -628,11 +1535,24 @@ namespace noise
         /// @returns The minimum amount of memory required to store the noise
         /// map.
         ///
-        /// The returned value is measured by the number of @a float values
-        /// required to store the noise map, not by the number of bytes.
-        size_t CalcMinMemUsage (int width, int height) const
+        /// The returned value is measured by the number of values required
+        /// to store the noise map, not by the number of bytes.
+        ///
+        /// @throw noise::ExceptionOutOfMemory The noise map is too large to
+        /// be addressed on this platform.
+        size_t CalcMinMemUsage (noise::int64 width, noise::int64 height)
+          const
         {
-          return CalcStride ((size_t)width) * (size_t)height;
+          // Calculate in 64 bits and make sure that the size in bytes can
+          // be addressed on this platform before converting to size_t.
+          noise::uint64 stride = (noise::uint64)CalcStride (width);
+          noise::uint64 maxCount
+            = (noise::uint64)((size_t)-1 / GetElementSize ());
+          if (stride > maxCount || (stride > 0
+            && (noise::uint64)height > maxCount / stride)) {
+            throw noise::ExceptionOutOfMemory ();
+          }
+          return (size_t)(stride * (noise::uint64)height);
         }
 
         /// Calculates the stride amount for a noise map.
@@ -643,12 +1563,15 @@ namespace noise
         ///
         /// - The <i>stride amount</i> is the offset between the starting
         ///   points of any two adjacent slabs in a noise map.
-        /// - The stride amount is measured by the number of @a float values
-        ///   between these two points, not by the number of bytes.
-        size_t CalcStride (int width) const
+        /// - The stride amount is measured by the number of values between
+        ///   these two points, not by the number of bytes.
+        /// - The stride amount is padded so that every slab starts on a
+        ///   multiple of RASTER_ALIGNMENT bytes.
+        size_t CalcStride (noise::int64 width) const
         {
-          return (size_t)(((width + RASTER_STRIDE_BOUNDARY - 1)
-            / RASTER_STRIDE_BOUNDARY) * RASTER_STRIDE_BOUNDARY);
+          noise::int64 boundary
+            = (noise::int64)(RASTER_ALIGNMENT / GetElementSize ());
+          return (size_t)(((width + boundary - 1) / boundary) * boundary);
         }
 
         /// Copies the contents of the buffer in the source noise map into
@@ -657,9 +1580,14 @@ namespace noise
         /// @param source The source noise map.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.
+        /// @throw noise::ExceptionInvalidParam This noise map wraps or maps
+        /// a buffer that is too small for the source noise map.
         ///
         /// This method reallocates the buffer in this noise map object if
-        /// necessary.
+        /// necessary, and takes the storage format of the source noise
+        /// map.  A noise map that wraps a buffer with WrapBuffer() or maps
+        /// a file keeps its buffer and storage format instead, and the
+        /// values are converted to that format.
         ///
         /// @warning This method calls the standard library function
         /// @a memcpy, which probably violates the DMCA because it can be used
@@ -670,122 +1598,164 @@ namespace noise
         /// Resets the noise map object.
         ///
         /// This method is similar to the InitObj() method, except this method
-        /// deletes the buffer in this noise map.
+        /// deletes the buffer in this noise map and keeps the border value.
         void DeleteNoiseMapAndReset ();
 
+        /// Frees the buffer of the noise map.
+        ///
+        /// A mapped file keeps its contents and wrapped memory is left
+        /// alone.  The caller must reset the noise map afterwards.
+        void FreeBuffer ();
+
         /// Initializes the noise map object.
         ///
         /// @pre Must be called during object construction.
         /// @pre The noise map buffer must not exist.
         void InitObj ();
 
+        /// Replaces the storage of the noise map.
+        ///
+        /// @param pMapping The mapped memory to use, or @a NULL to use the
+        /// heap.
+        ///
+        /// On exit, the noise map is empty.  This object takes ownership of
+        /// the mapped memory.
+        void SetMapping (RasterMappingImpl* pMapping);
+
+        /// Wraps memory owned by the caller in the current storage format.
+        ///
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the noise map.
+        /// @param height The height of the noise map.
+        /// @param stride The stride amount, in values.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions of the
+        /// WrapBuffer() method.
+        void WrapBytes (void* pBuffer, noise::int64 width,
+          noise::int64 height, noise::int64 stride);
+
         /// Value used for all positions outside of the noise map.
         float m_borderValue;
 
+        /// The format in which the noise map stores its values.
+        NoiseMapFormat m_format;
+
+        /// Determines if the noise map wraps memory owned by the caller.
+        bool m_isWrapped;
+
         /// The current height of the noise map.
-        int m_height;
+        noise::int64 m_height;
 
         /// The amount of memory allocated for this noise map.
         ///
-        /// This value is equal to the number of @a float values allocated for
-        /// the noise map, not the number of bytes.
+        /// This value is equal to the number of values allocated for the
+        /// noise map, not the number of bytes.
         size_t m_memUsed;
 
+        /// The allocator that owns the buffer when it is stored on the heap.
+        noise::Allocator* m_pAllocator;
+
+        /// The mapped memory that stores the noise map buffer, or @a NULL
+        /// if the buffer is stored on the heap.
+        RasterMappingImpl* m_pMapping;
+
         /// A pointer to the noise map buffer.
-        float* m_pNoiseMap;
+        void* m_pNoiseMap;
+
+        /// The bias of the FORMAT_UINT16 format.
+        float m_quantBias;
+
+        /// The scale of the FORMAT_UINT16 format.
+        float m_quantScale;
 
         /// The stride amount of the noise map.
-        int m_stride;
+        noise::int64 m_stride;
 
         /// The current width of the noise map.
-        int m_width;
+        noise::int64 m_width;
 
     };
 
-    /// Implements an image, a 2-dimensional array of color values.
-    ///
-    /// An image can be used to store a color texture.
-    ///
-    /// These color values are of type Color.
+    /// Implements a noise volume, a 3-dimensional array of floating-point
+    /// values.
     ///
-    /// The size (width and height) of the image can be specified during
-    /// object construction or at any other time.
+    /// A noise volume is designed to store coherent-noise values generated
+    /// by a noise module over a box, such as the density of a chunk of a
+    /// voxel world.  A noise volume is filled by the NoiseVolumeBuilder
+    /// class.
     ///
-    /// The GetValue() and SetValue() methods can be used to access individual
-    /// color values stored in the image.
+    /// The size (width, height and depth) of the noise volume can be
+    /// specified during object construction or at any other time.
     ///
-    /// This class manages its own memory.  If you copy an image object into
-    /// another image object, the original contents of the image object will
-    /// be freed.
+    /// The GetValue() and SetValue() methods can be used to access
+    /// individual values stored in the noise volume.
     ///
-    /// If you specify a new size for the image and the new size is smaller
-    /// than the current size, the allocated memory will not be reallocated.
-    /// Call ReclaimMem() to reclaim the wasted memory.
+    /// This class manages its own memory, which it takes from its
+    /// allocator.  If you specify a new size for the noise volume and the
+    /// new size is smaller than the current size, the allocated memory will
+    /// not be reallocated.  Call ReclaimMem() to reclaim the wasted memory.
     ///
     /// <b>Border Values</b>
     ///
-    /// All of the color values outside of the image are assumed to have a
-    /// common color value known as the <i>border value</i>.
+    /// All of the values outside of the noise volume are assumed to have a
+    /// common value known as the <i>border value</i>.
     ///
     /// To set the border value, call the SetBorderValue() method.
     ///
-    /// The GetValue() method returns the border value if the specified
-    /// position lies outside of the image.
-    ///
-    /// <b>Internal Image Structure</b>
-    ///
-    /// Internally, the color values are organized into horizontal rows called
-    /// @a slabs.  Slabs are ordered from bottom to top.
+    /// <b>Internal Noise Volume Structure</b>
     ///
-    /// Each slab contains a contiguous row of color values in memory.  The
-    /// color values in a slab are organized left to right.  These values are
-    /// of type Color.
+    /// Internally, the values are organized into <i>layers</i> of constant
+    /// @a z, ordered from front to back.  Each layer is organized like a
+    /// noise map, into slabs of constant @a y ordered from bottom to top,
+    /// and the values in a slab are organized left to right.
     ///
     /// The offset between the starting points of any two adjacent slabs is
-    /// called the <i>stride amount</i>.  The stride amount is measured by the
-    /// number of Color objects between these two starting points, not by the
-    /// number of bytes.  For efficiency reasons, the stride is often a
-    /// multiple of the machine word size.
-    ///
-    /// The GetSlabPtr() methods allow you to retrieve pointers to the slabs
-    /// themselves.
-    class Image
+    /// the <i>stride amount</i>, which is padded so that every slab starts
+    /// on a multiple of RASTER_ALIGNMENT bytes.  The offset between the
+    /// starting points of any two adjacent layers is the <i>layer stride
+    /// amount</i>.  Both are measured in values, not in bytes.
+    class NoiseVolume
     {
 
       public:
 
         /// Constructor.
         ///
-        /// Creates an empty image.
-        Image ();
+        /// Creates an empty noise volume.
+        NoiseVolume ();
 
         /// Constructor.
         ///
-        /// @param width The width of the new image.
-        /// @param height The height of the new image.
+        /// @param width The width of the new noise volume.
+        /// @param height The height of the new noise volume.
+        /// @param depth The depth of the new noise volume.
         ///
-        /// @pre The width and height values are positive.
-        /// @pre The width and height values do not exceed the maximum
-        /// possible width and height for the image.
+        /// @pre The width, height and depth values are positive.
+        /// @pre The width, height and depth values do not exceed the
+        /// maximum possible size of a raster.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
         /// @throw noise::ExceptionOutOfMemory Out of memory.
         ///
-        /// Creates an image with uninitialized color values.
-        ///
-        /// It is considered an error if the specified dimensions are not
-        /// positive.
-        Image (int width, int height);
+        /// Creates a noise volume with uninitialized values.
+        NoiseVolume (noise::int64 width, noise::int64 height,
+          noise::int64 depth);
 
         /// Copy constructor.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.
-        Image  (const Image& rhs);
+        NoiseVolume (const NoiseVolume& rhs);
+
+        /// Move constructor.
+        ///
+        /// The source noise volume becomes empty; its buffer moves to this
+        /// noise volume.
+        NoiseVolume (NoiseVolume&& rhs);
 
         /// Destructor.
         ///
-        /// Frees the allocated memory for the image.
-        ~Image ();
+        /// Frees the allocated memory for the noise volume.
+        ~NoiseVolume ();
 
         /// Assignment operator.
         ///
@@ -793,1027 +1763,4616 @@ namespace noise
         ///
         /// @returns Reference to self.
         ///
-        /// Creates a copy of the image.
-        Image& operator= (const Image& rhs);
+        /// Creates a copy of the noise volume.
+        NoiseVolume& operator= (const NoiseVolume& rhs);
 
-        /// Clears the image to a specified color value.
+        /// Move assignment operator.
         ///
-        /// @param value The color value that all positions within the image
-        /// are cleared to.
-        void Clear (const Color& value);
-
-        /// Returns the color value used for all positions outside of the
-        /// image.
+        /// @returns Reference to self.
         ///
-        /// @returns The color value used for all positions outside of the
-        /// image.
+        /// Frees the buffer of this noise volume, then moves the buffer of
+        /// the source noise volume to this noise volume.  The source noise
+        /// volume becomes empty.
+        NoiseVolume& operator= (NoiseVolume&& rhs);
+
+        /// Clears the noise volume to a specified value.
         ///
-        /// All positions outside of the image are assumed to have a common
-        /// color value known as the <i>border value</i>.
-        Color GetBorderValue () const
-        {
-          return m_borderValue;
-        }
+        /// @param value The value that all positions within the noise
+        /// volume are cleared to.
+        void Clear (float value);
 
-        /// Returns a const pointer to a slab.
+        /// Returns the allocator used by this noise volume.
         ///
-        /// @returns A const pointer to a slab at the position (0, 0), or
-        /// @a NULL if the image is empty.
-        const Color* GetConstSlabPtr () const
+        /// @returns The allocator used by this noise volume.
+        noise::Allocator* GetAllocator () const
         {
-          return m_pImage;
+          return m_pAllocator;
         }
 
-        /// Returns a const pointer to a slab at the specified row.
-        ///
-        /// @param row The row, or @a y coordinate.
-        ///
-        /// @returns A const pointer to a slab at the position ( 0, @a row ),
-        /// or @a NULL if the image is empty.
+        /// Returns the value used for all positions outside of the noise
+        /// volume.
         ///
-        /// @pre The coordinates must exist within the bounds of the image.
-        ///
-        /// This method does not perform bounds checking so be careful when
-        /// calling it.
-        const Color* GetConstSlabPtr (int row) const
+        /// @returns The value used for all positions outside of the noise
+        /// volume.
+        float GetBorderValue () const
         {
-          return GetConstSlabPtr (0, row);
+          return m_borderValue;
         }
 
         /// Returns a const pointer to a slab at the specified position.
         ///
         /// @param x The x coordinate of the position.
         /// @param y The y coordinate of the position.
+        /// @param z The z coordinate of the position.
         ///
-        /// @returns A const pointer to a slab at the position ( @a x, @a y ),
-        /// or @a NULL if the image is empty.
+        /// @returns A const pointer to a slab at the position ( @a x, @a y,
+        /// @a z ), or @a NULL if the noise volume is empty.
         ///
-        /// @pre The coordinates must exist within the bounds of the image.
+        /// @pre The coordinates must exist within the bounds of the noise
+        /// volume.
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        const Color* GetConstSlabPtr (int x, int y) const
+        const float* GetConstSlabPtr (noise::int64 x, noise::int64 y,
+          noise::int64 z) const
         {
-          return m_pImage + (size_t)x + (size_t)m_stride * (size_t)y;
+          return m_pNoiseVolume + (size_t)x + (size_t)m_stride * (size_t)y
+            + (size_t)m_layerStride * (size_t)z;
         }
 
-        /// Returns the height of the image.
+        /// Returns the depth of the noise volume.
         ///
-        /// @returns The height of the image.
-        int GetHeight () const
+        /// @returns The depth of the noise volume.
+        noise::int64 GetDepth () const
         {
-          return m_height;
+          return m_depth;
         }
 
-        /// Returns the amount of memory allocated for this image.
-        ///
-        /// @returns The amount of memory allocated for this image.
+        /// Returns the height of the noise volume.
         ///
-        /// This method returns the number of Color objects allocated.
-        size_t GetMemUsed () const
+        /// @returns The height of the noise volume.
+        noise::int64 GetHeight () const
         {
-          return m_memUsed;
+          return m_height;
         }
 
-        /// Returns a pointer to a slab.
+        /// Returns the layer stride amount of the noise volume.
         ///
-        /// @returns A pointer to a slab at the position (0, 0), or @a NULL if
-        /// the image is empty.
-        Color* GetSlabPtr ()
+        /// @returns The number of values between the starting points of any
+        /// two adjacent layers.
+        noise::int64 GetLayerStride () const
         {
-          return m_pImage;
+          return m_layerStride;
         }
 
-        /// Returns a pointer to a slab at the specified row.
-        ///
-        /// @param row The row, or @a y coordinate.
-        ///
-        /// @returns A pointer to a slab at the position ( 0, @a row ), or
-        /// @a NULL if the image is empty.
-        ///
-        /// @pre The coordinates must exist within the bounds of the image.
+        /// Returns the amount of memory allocated for this noise volume.
         ///
-        /// This method does not perform bounds checking so be careful when
-        /// calling it.
-        Color* GetSlabPtr (int row)
+        /// @returns The number of @a float values allocated for this noise
+        /// volume.
+        size_t GetMemUsed () const
         {
-          return GetSlabPtr (0, row);
+          return m_memUsed;
         }
 
         /// Returns a pointer to a slab at the specified position.
         ///
         /// @param x The x coordinate of the position.
         /// @param y The y coordinate of the position.
+        /// @param z The z coordinate of the position.
         ///
-        /// @returns A pointer to a slab at the position ( @a x, @a y ), or
-        /// @a NULL if the image is empty.
+        /// @returns A pointer to a slab at the position ( @a x, @a y, @a z ),
+        /// or @a NULL if the noise volume is empty.
         ///
-        /// @pre The coordinates must exist within the bounds of the image.
+        /// @pre The coordinates must exist within the bounds of the noise
+        /// volume.
         ///
         /// This method does not perform bounds checking so be careful when
         /// calling it.
-        Color* GetSlabPtr (int x, int y)
+        float* GetSlabPtr (noise::int64 x, noise::int64 y, noise::int64 z)
         {
-          return m_pImage + (size_t)x + (size_t)m_stride * (size_t)y;
+          return m_pNoiseVolume + (size_t)x + (size_t)m_stride * (size_t)y
+            + (size_t)m_layerStride * (size_t)z;
         }
 
-        /// Returns the stride amount of the image.
+        /// Returns the stride amount of the noise volume.
         ///
-        /// @returns The stride amount of the image.
-        ///
-        /// - The <i>stride amount</i> is the offset between the starting
-        ///   points of any two adjacent slabs in an image.
-        /// - The stride amount is measured by the number of Color objects
-        ///   between these two points, not by the number of bytes.
-        int GetStride () const
+        /// @returns The number of values between the starting points of any
+        /// two adjacent slabs of a layer.
+        noise::int64 GetStride () const
         {
           return m_stride;
         }
 
-        /// Returns a color value from the specified position in the image.
+        /// Returns a value from the specified position in the noise volume.
         ///
         /// @param x The x coordinate of the position.
         /// @param y The y coordinate of the position.
+        /// @param z The z coordinate of the position.
         ///
-        /// @returns The color value at that position.
+        /// @returns The value at that position.
         ///
         /// This method returns the border value if the coordinates exist
-        /// outside of the image.
-        Color GetValue (int x, int y) const;
+        /// outside of the noise volume.
+        float GetValue (noise::int64 x, noise::int64 y, noise::int64 z) const;
 
-        /// Returns the width of the image.
+        /// Returns the width of the noise volume.
         ///
-        /// @returns The width of the image.
-        int GetWidth () const
+        /// @returns The width of the noise volume.
+        noise::int64 GetWidth () const
         {
           return m_width;
         }
 
-        /// Reallocates the image to recover wasted memory.
+        /// Reallocates the noise volume to recover wasted memory.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.  (Yes, this
-        /// method can return an out-of-memory exception because two images
-        /// will exist temporarily in memory during this call.)
+        /// method can return an out-of-memory exception because two noise
+        /// volumes will temporarily exist in memory during this call.)
         ///
-        /// The contents of the image is unaffected.
+        /// The contents of the noise volume is unaffected.
         void ReclaimMem ();
 
-        /// Sets the color value to use for all positions outside of the
-        /// image.
+        /// Sets the allocator used by this noise volume.
         ///
-        /// @param borderValue The color value to use for all positions
-        /// outside of the image.
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
         ///
-        /// All positions outside of the image are assumed to have a common
-        /// color value known as the <i>border value</i>.
-        void SetBorderValue (const Color& borderValue)
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The values are copied into memory from the new allocator.
+        void SetAllocator (noise::Allocator* pAllocator);
+
+        /// Sets the value to use for all positions outside of the noise
+        /// volume.
+        ///
+        /// @param borderValue The value to use for all positions outside of
+        /// the noise volume.
+        void SetBorderValue (float borderValue)
         {
           m_borderValue = borderValue;
         }
 
-        /// Sets the new size for the image.
+        /// Sets the new size for the noise volume.
         ///
-        /// @param width The new width for the image.
-        /// @param height The new height for the image.
+        /// @param width The new width for the noise volume.
+        /// @param height The new height for the noise volume.
+        /// @param depth The new depth for the noise volume.
         ///
-        /// @pre The width and height values are positive.
-        /// @pre The width and height values do not exceed the maximum
-        /// possible width and height for the image.
+        /// @pre The width, height and depth values are not negative.
+        /// @pre The width, height and depth values do not exceed the
+        /// maximum possible size of a raster.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
         /// @throw noise::ExceptionOutOfMemory Out of memory.
         ///
-        /// On exit, the contents of the image are undefined.
-        ///
-        /// If the @a OUT_OF_MEMORY exception occurs, this image becomes
-        /// empty.
+        /// On exit, the contents of the noise volume are undefined.
         ///
-        /// If the @a INVALID_PARAM exception occurs, the image is unmodified.
-        void SetSize (int width, int height);
+        /// If any size is 0, the noise volume becomes empty and its memory
+        /// is freed.
+        void SetSize (noise::int64 width, noise::int64 height,
+          noise::int64 depth);
 
-        /// Sets a color value at a specified position in the image.
+        /// Sets a value at a specified position in the noise volume.
         ///
         /// @param x The x coordinate of the position.
         /// @param y The y coordinate of the position.
-        /// @param value The color value to set at the given position.
-        ///
-        /// This method does nothing if the image is empty or the position is
-        /// outside the bounds of the image.
-        void SetValue (int x, int y, const Color& value);
-
-        /// Takes ownership of the buffer within the source image.
-        ///
-        /// @param source The source image.
-        ///
-        /// On exit, the source image object becomes empty.
+        /// @param z The z coordinate of the position.
+        /// @param value The value to set at the given position.
         ///
-        /// This method only moves the buffer pointer so this method is very
-        /// quick.
-        void TakeOwnership (Image& source);
-
-      private:
+        /// This method does nothing if the noise volume object is empty or
+        /// the position is outside the bounds of the noise volume.
+        void SetValue (noise::int64 x, noise::int64 y, noise::int64 z,
+          float value);
 
-        /// Returns the minimum amount of memory required to store an image of
-        /// the specified size.
-        ///
-        /// @param width The width of the image.
-        /// @param height The height of the image.
-        ///
-        /// @returns The minimum amount of memory required to store the image.
-        ///
-        /// The returned color value is measured by the number of Color
-        /// objects required to store the image, not by the number of bytes.
-        size_t CalcMinMemUsage (int width, int height) const
-        {
-          return CalcStride ((size_t)width) * (size_t)height;
-        }
+      protected:
 
-        /// Calculates the stride amount for an image.
+        /// Returns the minimum number of values required to store a noise
+        /// volume of the specified size.
         ///
-        /// @param width The width of the image.
+        /// @param width The width of the noise volume.
+        /// @param height The height of the noise volume.
+        /// @param depth The depth of the noise volume.
         ///
-        /// @returns The stride amount.
+        /// @returns The minimum number of values required to store the noise
+        /// volume.
         ///
-        /// - The <i>stride amount</i> is the offset between the starting
-        ///   points of any two adjacent slabs in an image.
-        /// - The stride amount is measured by the number of Color objects
-        ///   between these two points, not by the number of bytes.
-        size_t CalcStride (int width) const
-        {
-          return (size_t)(((width + RASTER_STRIDE_BOUNDARY - 1)
-            / RASTER_STRIDE_BOUNDARY) * RASTER_STRIDE_BOUNDARY);
-        }
+        /// @throw noise::ExceptionOutOfMemory The size of the noise volume
+        /// in bytes cannot be addressed on this platform.
+        size_t CalcMinMemUsage (noise::int64 width, noise::int64 height,
+          noise::int64 depth) const;
 
-        /// Copies the contents of the buffer in the source image into this
-        /// image.
+        /// Copies the contents of the buffer in the source noise volume into
+        /// this noise volume.
         ///
-        /// @param source The source image.
+        /// @param source The source noise volume.
         ///
         /// @throw noise::ExceptionOutOfMemory Out of memory.
-        ///
-        /// This method reallocates the buffer in this image object if
-        /// necessary.
-        ///
-        /// @warning This method calls the standard library function
-        /// @a memcpy, which probably violates the DMCA because it can be used
-        /// to make a bitwise copy of anything, like, say, a DVD.  Don't call
-        /// this method if you live in the USA.
-        void CopyImage (const Image& source);
+        void CopyNoiseVolume (const NoiseVolume& source);
 
-        /// Resets the image object.
+        /// Frees the buffer of this noise volume and resets its size to 0.
         ///
-        /// This method is similar to the InitObj() method, except this method
-        /// deletes the memory allocated to the image.
-        void DeleteImageAndReset ();
+        /// The border value is kept.
+        void DeleteNoiseVolumeAndReset ();
 
-        /// Initializes the image object.
+        /// Initializes the noise volume object.
         ///
         /// @pre Must be called during object construction.
-        /// @pre The image buffer must not exist.
+        /// @pre The noise volume buffer must not exist.
         void InitObj ();
 
-        /// The Color value used for all positions outside of the image.
-        Color m_borderValue;
+        /// Moves the buffer of another noise volume to this noise volume.
+        ///
+        /// @param source The source noise volume, which becomes empty.
+        ///
+        /// The buffer of this noise volume is freed first.  The allocator
+        /// and the border value move with the buffer.
+        void TakeOwnership (NoiseVolume& source);
 
-        /// The current height of the image.
-        int m_height;
+        /// Value used for all positions outside of the noise volume.
+        float m_borderValue;
 
-        /// The amount of memory allocated for the image.
-        ///
-        /// This value is equal to the number of Color objects allocated for
-        /// the image, not the number of bytes.
+        /// The current depth of the noise volume.
+        noise::int64 m_depth;
+
+        /// The current height of the noise volume.
+        noise::int64 m_height;
+
+        /// The layer stride amount of the noise volume.
+        noise::int64 m_layerStride;
+
+        /// The number of values allocated for this noise volume.
         size_t m_memUsed;
 
-        /// A pointer to the image buffer.
-        Color* m_pImage;
+        /// The allocator that owns the buffer.
+        noise::Allocator* m_pAllocator;
 
-        /// The stride amount of the image.
-        int m_stride;
+        /// A pointer to the noise volume buffer.
+        float* m_pNoiseVolume;
 
-        /// The current width of the image.
-        int m_width;
+        /// The stride amount of the noise volume.
+        noise::int64 m_stride;
+
+        /// The current width of the noise volume.
+        noise::int64 m_width;
 
     };
 
-    /// Windows bitmap image writer class.
+    /// Implements an image, a 2-dimensional array of color values.
     ///
-    /// This class creates a file in Windows bitmap (*.bmp) format given the
-    /// contents of an image object.
+    /// An image can be used to store a color texture.
     ///
-    /// <b>Writing the image</b>
+    /// These color values are of type Color.
     ///
-    /// To write the image to a file, perform the following steps:
-    /// - Pass the filename to the SetDestFilename() method.
-    /// - Pass an Image object to the SetSourceImage() method.
-    /// - Call the WriteDestFile() method.
+    /// The size (width and height) of the image can be specified during
+    /// object construction or at any other time.
     ///
-    /// The SetDestFilename() and SetSourceImage() methods must be called
-    /// before calling the WriteDestFile() method.
-    class WriterBMP
+    /// The GetValue() and SetValue() methods can be used to access individual
+    /// color values stored in the image.
+    ///
+    /// This class manages its own memory.  If you copy an image object into
+    /// another image object, the original contents of the image object will
+    /// be freed.
+    ///
+    /// If you specify a new size for the image and the new size is smaller
+    /// than the current size, the allocated memory will not be reallocated.
+    /// Call ReclaimMem() to reclaim the wasted memory.
+    ///
+    /// <b>Memory-Mapped Storage</b>
+    ///
+    /// An image can store its color values in a memory-mapped file or in
+    /// anonymous mapped memory instead of the heap.  See the MapFile(),
+    /// MapAnonymous() and Unmap() methods, which behave like those of the
+    /// NoiseMap class.
+    ///
+    /// <b>External Memory</b>
+    ///
+    /// An image can also wrap memory owned by the application, with a
+    /// stride chosen by the application.  See the WrapBuffer() method,
+    /// which behaves like that of the NoiseMap class.  Renderers then write
+    /// their colors straight into the application's buffer.
+    ///
+    /// <b>Border Values</b>
+    ///
+    /// All of the color values outside of the image are assumed to have a
+    /// common color value known as the <i>border value</i>.
+    ///
+    /// To set the border value, call the SetBorderValue() method.
+    ///
+    /// The GetValue() method returns the border value if the specified
+    /// position lies outside of the image.
+    ///
+    /// <b>Internal Image Structure</b>
+    ///
+    /// Internally, the color values are organized into horizontal rows called
+    /// @a slabs.  Slabs are ordered from bottom to top.
+    ///
+    /// Each slab contains a contiguous row of color values in memory.  The
+    /// color values in a slab are organized left to right.  These values are
+    /// of type Color.
+    ///
+    /// The offset between the starting points of any two adjacent slabs is
+    /// called the <i>stride amount</i>.  The stride amount is measured by the
+    /// number of Color objects between these two starting points, not by the
+    /// number of bytes.  For efficiency reasons, the stride is often a
+    /// multiple of the machine word size.
+    ///
+    /// The GetSlabPtr() methods allow you to retrieve pointers to the slabs
+    /// themselves.
+    class Image
     {
 
       public:
 
         /// Constructor.
-        WriterBMP ():
-          m_pSourceImage (NULL)
-        {
-        }
-
-        /// Returns the name of the file to write.
-        ///
-        /// @returns The name of the file to write.
-        std::string GetDestFilename () const
-        {
-          return m_destFilename;
-        }
-
-        /// Sets the name of the file to write.
-        ///
-        /// @param filename The name of the file to write.
         ///
-        /// Call this method before calling the WriteDestFile() method.
-        void SetDestFilename (const std::string& filename)
-        {
-          m_destFilename = filename;
-        }
+        /// Creates an empty image.
+        Image ();
 
-        /// Sets the image object that is written to the file.
-        ///
-        /// @param sourceImage The image object to write.
+        /// Constructor.
         ///
-        /// This object only stores a pointer to an image object, so make sure
-        /// this object exists before calling the WriteDestFile() method.
-        void SetSourceImage (Image& sourceImage)
-        {
-          m_pSourceImage = &sourceImage;
-        }
-
-        /// Writes the contents of the image object to the file.
+        /// @param width The width of the new image.
+        /// @param height The height of the new image.
         ///
-        /// @pre SetDestFilename() has been previously called.
-        /// @pre SetSourceImage() has been previously called.
+        /// @pre The width and height values are positive.
+        /// @pre The width and height values do not exceed the maximum
+        /// possible width and height for the image.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
         /// @throw noise::ExceptionOutOfMemory Out of memory.
-        /// @throw noise::ExceptionUnknown An unknown exception occurred.
-        /// Possibly the file could not be written.
         ///
-        /// This method encodes the contents of the image and writes it to a
-        /// file.  Before calling this method, call the SetSourceImage()
-        /// method to specify the image, then call the SetDestFilename()
-        /// method to specify the name of the file to write.
-        void WriteDestFile ();
+        /// Creates an image with uninitialized color values.
+        ///
+        /// It is considered an error if the specified dimensions are not
+        /// positive.
+        Image (noise::int64 width, noise::int64 height);
 
-      protected:
+        /// Copy constructor.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        Image  (const Image& rhs);
 
-        /// Calculates the width of one horizontal line in the file, in bytes.
+        /// Constructor.
         ///
-        /// @param width The width of the image, in points.
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the image.
+        /// @param height The height of the image.
+        /// @param stride The stride amount, in Color objects.
         ///
-        /// @returns The width of one horizontal line in the file.
+        /// @throw noise::ExceptionInvalidParam See WrapBuffer().
         ///
-        /// Windows bitmap files require that the width of one horizontal line
-        /// must be aligned to a 32-bit boundary.
-        int CalcWidthByteCount (int width) const;
-
-        /// Name of the file to write.
-        std::string m_destFilename;
+        /// Creates an image that wraps memory owned by the caller.
+        Image (Color* pBuffer, noise::int64 width, noise::int64 height,
+          noise::int64 stride);
 
-        /// A pointer to the image object that will be written to the file.
-        Image* m_pSourceImage;
+        /// Move constructor.
+        ///
+        /// The source image becomes empty; its buffer, whether allocated,
+        /// mapped or wrapped, moves to this image.
+        Image (Image&& rhs);
 
-    };
+        /// Destructor.
+        ///
+        /// Frees the allocated memory for the image.
+        ~Image ();
 
-    /// Terragen Terrain writer class.
-    ///
-    /// This class creates a file in Terrage Terrain (*.ter) format given the
-    /// contents of a noise map object.  This class treats the values in the
+        /// Assignment operator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// @returns Reference to self.
+        ///
+        /// Creates a copy of the image.
+        Image& operator= (const Image& rhs);
+
+        /// Move assignment operator.
+        ///
+        /// @returns Reference to self.
+        ///
+        /// Frees the buffer of this image, then moves the buffer of the
+        /// source image, whether allocated, mapped or wrapped, to this
+        /// image.  The source image becomes empty.
+        Image& operator= (Image&& rhs);
+
+        /// Clears the image to a specified color value.
+        ///
+        /// @param value The color value that all positions within the image
+        /// are cleared to.
+        void Clear (const Color& value);
+
+        /// Returns the allocator used by this image.
+        ///
+        /// @returns The allocator used by this image.
+        ///
+        /// A image takes the default allocator when it is constructed, and
+        /// takes the allocator of the source when it takes ownership of a
+        /// buffer.
+        noise::Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
+        /// Returns the color value used for all positions outside of the
+        /// image.
+        ///
+        /// @returns The color value used for all positions outside of the
+        /// image.
+        ///
+        /// All positions outside of the image are assumed to have a common
+        /// color value known as the <i>border value</i>.
+        Color GetBorderValue () const
+        {
+          return m_borderValue;
+        }
+
+        /// Returns a const pointer to a slab.
+        ///
+        /// @returns A const pointer to a slab at the position (0, 0), or
+        /// @a NULL if the image is empty.
+        const Color* GetConstSlabPtr () const
+        {
+          return m_pImage;
+        }
+
+        /// Returns a const pointer to a slab at the specified row.
+        ///
+        /// @param row The row, or @a y coordinate.
+        ///
+        /// @returns A const pointer to a slab at the position ( 0, @a row ),
+        /// or @a NULL if the image is empty.
+        ///
+        /// @pre The coordinates must exist within the bounds of the image.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        const Color* GetConstSlabPtr (noise::int64 row) const
+        {
+          return GetConstSlabPtr (0, row);
+        }
+
+        /// Returns a const pointer to a slab at the specified position.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns A const pointer to a slab at the position ( @a x, @a y ),
+        /// or @a NULL if the image is empty.
+        ///
+        /// @pre The coordinates must exist within the bounds of the image.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        const Color* GetConstSlabPtr (noise::int64 x, noise::int64 y) const
+        {
+          return m_pImage + (size_t)x + (size_t)m_stride * (size_t)y;
+        }
+
+        /// Returns the height of the image.
+        ///
+        /// @returns The height of the image.
+        noise::int64 GetHeight () const
+        {
+          return m_height;
+        }
+
+        /// Returns the amount of memory allocated for this image.
+        ///
+        /// @returns The amount of memory allocated for this image.
+        ///
+        /// This method returns the number of Color objects allocated.
+        size_t GetMemUsed () const
+        {
+          return m_memUsed;
+        }
+
+        /// Returns a pointer to a slab.
+        ///
+        /// @returns A pointer to a slab at the position (0, 0), or @a NULL if
+        /// the image is empty.
+        Color* GetSlabPtr ()
+        {
+          return m_pImage;
+        }
+
+        /// Returns a pointer to a slab at the specified row.
+        ///
+        /// @param row The row, or @a y coordinate.
+        ///
+        /// @returns A pointer to a slab at the position ( 0, @a row ), or
+        /// @a NULL if the image is empty.
+        ///
+        /// @pre The coordinates must exist within the bounds of the image.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        Color* GetSlabPtr (noise::int64 row)
+        {
+          return GetSlabPtr (0, row);
+        }
+
+        /// Returns a pointer to a slab at the specified position.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns A pointer to a slab at the position ( @a x, @a y ), or
+        /// @a NULL if the image is empty.
+        ///
+        /// @pre The coordinates must exist within the bounds of the image.
+        ///
+        /// This method does not perform bounds checking so be careful when
+        /// calling it.
+        Color* GetSlabPtr (noise::int64 x, noise::int64 y)
+        {
+          return m_pImage + (size_t)x + (size_t)m_stride * (size_t)y;
+        }
+
+        /// Returns the stride amount of the image.
+        ///
+        /// @returns The stride amount of the image.
+        ///
+        /// - The <i>stride amount</i> is the offset between the starting
+        ///   points of any two adjacent slabs in an image.
+        /// - The stride amount is measured by the number of Color objects
+        ///   between these two points, not by the number of bytes.
+        noise::int64 GetStride () const
+        {
+          return m_stride;
+        }
+
+        /// Returns a color value from the specified position in the image.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns The color value at that position.
+        ///
+        /// This method returns the border value if the coordinates exist
+        /// outside of the image.
+        Color GetValue (noise::int64 x, noise::int64 y) const;
+
+        /// Returns the width of the image.
+        ///
+        /// @returns The width of the image.
+        noise::int64 GetWidth () const
+        {
+          return m_width;
+        }
+
+        /// Determines if the image is stored in mapped memory.
+        ///
+        /// @returns
+        /// - @a true if MapFile() or MapAnonymous() was called more recently
+        ///   than Unmap().
+        /// - @a false if the image is stored on the heap.
+        bool IsMapped () const
+        {
+          return m_pMapping != NULL;
+        }
+
+        /// Determines if the image wraps memory owned by the caller.
+        ///
+        /// @returns
+        /// - @a true if WrapBuffer() was called and the image was not
+        ///   emptied since.
+        /// - @a false otherwise.
+        bool IsWrapped () const
+        {
+          return m_isWrapped;
+        }
+
+        /// Stores the image in anonymous mapped memory.
+        ///
+        /// @param useHugePages Request huge pages for the mapped memory.
+        ///
+        /// @throw noise::ExceptionUnknown Mapped memory is not available on
+        /// this platform.
+        ///
+        /// On exit, the image is empty.  Buffers allocated by later
+        /// calls to SetSize() are mapped directly from the operating system
+        /// instead of the heap.  If @a useHugePages is true, this object
+        /// first asks for explicit huge pages and, if none are available,
+        /// falls back to normal pages with transparent huge pages enabled.
+        void MapAnonymous (bool useHugePages = false);
+
+        /// Stores the image in a memory-mapped file.
+        ///
+        /// @param filename The name of the file.
+        /// @param isReadOnly Map the file read-only.
+        ///
+        /// @throw noise::ExceptionUnknown The file could not be opened or
+        /// mapped, it is not a raster file, it stores values of another
+        /// type, or mapped memory is not available on this platform.
+        ///
+        /// If the file exists and contains an image, this object takes
+        /// its size and values.  If the file is empty or does not exist, it
+        /// is created and this image becomes empty.  Buffers allocated by
+        /// later calls to SetSize() grow the file.
+        ///
+        /// The file starts with a 64-byte header that stores the width,
+        /// height and stride of the image, followed by the slabs.  All
+        /// values are stored in the byte order of the host.
+        ///
+        /// If @a isReadOnly is true, the file must exist.  Several processes
+        /// may then share its pages; SetSize() throws
+        /// noise::ExceptionInvalidParam, and writing to the image through
+        /// any other method is not allowed.
+        void MapFile (const std::string& filename, bool isReadOnly = false);
+
+        /// Reallocates the image to recover wasted memory.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.  (Yes, this
+        /// method can return an out-of-memory exception because two images
+        /// will exist temporarily in memory during this call.)
+        ///
+        /// The contents of the image is unaffected.
+        ///
+        /// This method does nothing if the image is stored in mapped memory
+        /// or wraps memory owned by the caller.
+        void ReclaimMem ();
+
+        /// Sets the allocator used by this image.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// A buffer on the heap is copied into memory from the new allocator,
+        /// so the contents of the image are unaffected.  Mapped and wrapped
+        /// buffers do not come from an allocator and are left alone.
+        void SetAllocator (noise::Allocator* pAllocator);
+
+        /// Sets the color value to use for all positions outside of the
+        /// image.
+        ///
+        /// @param borderValue The color value to use for all positions
+        /// outside of the image.
+        ///
+        /// All positions outside of the image are assumed to have a common
+        /// color value known as the <i>border value</i>.
+        void SetBorderValue (const Color& borderValue)
+        {
+          m_borderValue = borderValue;
+        }
+
+        /// Sets the new size for the image.
+        ///
+        /// @param width The new width for the image.
+        /// @param height The new height for the image.
+        ///
+        /// @pre The width and height values are positive.
+        /// @pre The width and height values do not exceed the maximum
+        /// possible width and height for the image.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// On exit, the contents of the image are undefined.
+        ///
+        /// If the @a OUT_OF_MEMORY exception occurs, this image becomes
+        /// empty.
+        ///
+        /// If the @a INVALID_PARAM exception occurs, the image is unmodified.
+        /// This exception also occurs if the image is stored in a file
+        /// mapped read-only, or if it wraps a buffer that is too small for
+        /// the new size.
+        void SetSize (noise::int64 width, noise::int64 height);
+
+        /// Sets a color value at a specified position in the image.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        /// @param value The color value to set at the given position.
+        ///
+        /// This method does nothing if the image is empty or the position is
+        /// outside the bounds of the image.
+        void SetValue (noise::int64 x, noise::int64 y, const Color& value);
+
+        /// Writes the values of a memory-mapped file to disk.
+        ///
+        /// @throw noise::ExceptionUnknown The file could not be written.
+        ///
+        /// This method blocks until every modified page of the file is
+        /// written.  It does nothing if the image is not stored in a file.
+        void SyncFile ();
+
+        /// Takes ownership of the buffer within the source image.
+        ///
+        /// @param source The source image.
+        ///
+        /// On exit, the source image object becomes empty.
+        ///
+        /// This method only moves the buffer pointer so this method is very
+        /// quick.  A mapped or wrapped buffer moves along with its storage:
+        /// this image then owns the mapping, or wraps the caller's memory.
+        void TakeOwnership (Image& source);
+
+        /// Stores the image on the heap again.
+        ///
+        /// On exit, the image is empty.  If the image was stored in a
+        /// file, the file is closed and keeps its contents.
+        void Unmap ();
+
+        /// Wraps memory owned by the caller.
+        ///
+        /// @param pBuffer A pointer to the first value of the bottom slab.
+        /// @param width The width of the image.
+        /// @param height The height of the image.
+        /// @param stride The stride amount, in Color objects.
+        ///
+        /// @pre @a pBuffer is not @a NULL.
+        /// @pre The width and height values are positive.
+        /// @pre The width and height values do not exceed the maximum
+        /// possible width and height for the image.
+        /// @pre The stride amount is not less than the width.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The buffer must hold @a height slabs of @a stride Color objects
+        /// each and must exist until this image is emptied, wraps another
+        /// buffer, or is destroyed.  This object never frees the buffer.
+        ///
+        /// SetSize() keeps using the buffer as long as the new width does
+        /// not exceed the stride amount and the new size fits in the
+        /// buffer; otherwise, it throws noise::ExceptionInvalidParam.
+        /// SetSize (0, 0) releases the buffer and returns to the heap.
+        void WrapBuffer (Color* pBuffer, noise::int64 width,
+          noise::int64 height, noise::int64 stride);
+
+      private:
+
+        /// Returns the minimum amount of memory required to store an image of
+        /// the specified size.
+        ///
+        /// @param width The width of the image.
+        /// @param height The height of the image.
+        ///
+        /// @returns The minimum amount of memory required to store the image.
+        ///
+        /// The returned color value is measured by the number of Color
+        /// objects required to store the image, not by the number of bytes.
+        ///
+        /// @throw noise::ExceptionOutOfMemory The image is too large to be
+        /// addressed on this platform.
+        size_t CalcMinMemUsage (noise::int64 width, noise::int64 height)
+          const
+        {
+          // Calculate in 64 bits and make sure that the size in bytes can
+          // be addressed on this platform before converting to size_t.
+          noise::uint64 stride = ((noise::uint64)width
+            + RASTER_STRIDE_BOUNDARY - 1) / RASTER_STRIDE_BOUNDARY
+            * RASTER_STRIDE_BOUNDARY;
+          noise::uint64 maxCount
+            = (noise::uint64)((size_t)-1 / sizeof (Color));
+          if (stride > maxCount || (stride > 0
+            && (noise::uint64)height > maxCount / stride)) {
+            throw noise::ExceptionOutOfMemory ();
+          }
+          return (size_t)(stride * (noise::uint64)height);
+        }
+
+        /// Calculates the stride amount for an image.
+        ///
+        /// @param width The width of the image.
+        ///
+        /// @returns The stride amount.
+        ///
+        /// - The <i>stride amount</i> is the offset between the starting
+        ///   points of any two adjacent slabs in an image.
+        /// - The stride amount is measured by the number of Color objects
+        ///   between these two points, not by the number of bytes.
+        size_t CalcStride (noise::int64 width) const
+        {
+          return (size_t)(((width + RASTER_STRIDE_BOUNDARY - 1)
+            / RASTER_STRIDE_BOUNDARY) * RASTER_STRIDE_BOUNDARY);
+        }
+
+        /// Copies the contents of the buffer in the source image into this
+        /// image.
+        ///
+        /// @param source The source image.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// This method reallocates the buffer in this image object if
+        /// necessary.
+        ///
+        /// @warning This method calls the standard library function
+        /// @a memcpy, which probably violates the DMCA because it can be used
+        /// to make a bitwise copy of anything, like, say, a DVD.  Don't call
+        /// this method if you live in the USA.
+        void CopyImage (const Image& source);
+
+        /// Resets the image object.
+        ///
+        /// This method is similar to the InitObj() method, except this method
+        /// deletes the memory allocated to the image.
+        void DeleteImageAndReset ();
+
+        /// Frees the buffer of the image.
+        ///
+        /// A mapped file keeps its contents and wrapped memory is left
+        /// alone.  The caller must reset the image afterwards.
+        void FreeBuffer ();
+
+        /// Initializes the image object.
+        ///
+        /// @pre Must be called during object construction.
+        /// @pre The image buffer must not exist.
+        void InitObj ();
+
+        /// Replaces the storage of the image.
+        ///
+        /// @param pMapping The mapped memory to use, or @a NULL to use the
+        /// heap.
+        ///
+        /// On exit, the image is empty.  This object takes ownership of the
+        /// mapped memory.
+        void SetMapping (RasterMappingImpl* pMapping);
+
+        /// The Color value used for all positions outside of the image.
+        Color m_borderValue;
+
+        /// Determines if the image wraps memory owned by the caller.
+        bool m_isWrapped;
+
+        /// The current height of the image.
+        noise::int64 m_height;
+
+        /// The amount of memory allocated for the image.
+        ///
+        /// This value is equal to the number of Color objects allocated for
+        /// the image, not the number of bytes.
+        size_t m_memUsed;
+
+        /// The allocator that owns the buffer when it is stored on the heap.
+        noise::Allocator* m_pAllocator;
+
+        /// The mapped memory that stores the image buffer, or @a NULL if
+        /// the buffer is stored on the heap.
+        RasterMappingImpl* m_pMapping;
+
+        /// A pointer to the image buffer.
+        Color* m_pImage;
+
+        /// The stride amount of the image.
+        noise::int64 m_stride;
+
+        /// The current width of the image.
+        noise::int64 m_width;
+
+    };
+
+    /// Windows bitmap image writer class.
+    ///
+    /// This class creates a file in Windows bitmap (*.bmp) format given the
+    /// contents of an image object.
+    ///
+    /// <b>Writing the image</b>
+    ///
+    /// To write the image to a file, perform the following steps:
+    /// - Pass the filename to the SetDestFilename() method.
+    /// - Pass an Image object to the SetSourceImage() method.
+    /// - Call the WriteDestFile() method.
+    ///
+    /// The SetDestFilename() and SetSourceImage() methods must be called
+    /// before calling the WriteDestFile() method.
+    class WriterBMP
+    {
+
+      public:
+
+        /// Constructor.
+        WriterBMP ():
+          m_pAllocator (noise::GetDefaultAllocator ()),
+          m_pSourceImage (NULL)
+        {
+        }
+
+        /// Returns the allocator used for the line buffer.
+        ///
+        /// @returns The allocator used for the line buffer.
+        noise::Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
+        /// Returns the name of the file to write.
+        ///
+        /// @returns The name of the file to write.
+        std::string GetDestFilename () const
+        {
+          return m_destFilename;
+        }
+
+        /// Sets the allocator used for the line buffer.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// The WriteDestFile() method allocates a buffer that holds one
+        /// horizontal line of the file from this allocator.
+        void SetAllocator (noise::Allocator* pAllocator)
+        {
+          m_pAllocator = (pAllocator != NULL)? pAllocator:
+            noise::GetDefaultAllocator ();
+        }
+
+        /// Sets the name of the file to write.
+        ///
+        /// @param filename The name of the file to write.
+        ///
+        /// Call this method before calling the WriteDestFile() method.
+        void SetDestFilename (const std::string& filename)
+        {
+          m_destFilename = filename;
+        }
+
+        /// Sets the image object that is written to the file.
+        ///
+        /// @param sourceImage The image object to write.
+        ///
+        /// This object only stores a pointer to an image object, so make sure
+        /// this object exists before calling the WriteDestFile() method.
+        void SetSourceImage (Image& sourceImage)
+        {
+          m_pSourceImage = &sourceImage;
+        }
+
+        /// Writes the contents of the image object to the file.
+        ///
+        /// @pre SetDestFilename() has been previously called.
+        /// @pre SetSourceImage() has been previously called.
+        /// @pre The image fits in a Windows bitmap file: its width and
+        /// height do not exceed 2147483647 points and the file does not
+        /// exceed 4 GB.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        /// @throw noise::ExceptionUnknown An unknown exception occurred.
+        /// Possibly the file could not be written.
+        ///
+        /// This method encodes the contents of the image and writes it to a
+        /// file.  Before calling this method, call the SetSourceImage()
+        /// method to specify the image, then call the SetDestFilename()
+        /// method to specify the name of the file to write.
+        void WriteDestFile ();
+
+      protected:
+
+        /// Calculates the width of one horizontal line in the file, in bytes.
+        ///
+        /// @param width The width of the image, in points.
+        ///
+        /// @returns The width of one horizontal line in the file.
+        ///
+        /// Windows bitmap files require that the width of one horizontal line
+        /// must be aligned to a 32-bit boundary.
+        noise::int64 CalcWidthByteCount (noise::int64 width) const;
+
+        /// The allocator used for the line buffer.
+        noise::Allocator* m_pAllocator;
+
+        /// Name of the file to write.
+        std::string m_destFilename;
+
+        /// A pointer to the image object that will be written to the file.
+        Image* m_pSourceImage;
+
+    };
+
+    /// Terragen Terrain writer class.
+    ///
+    /// This class creates a file in Terrage Terrain (*.ter) format given the
+    /// contents of a noise map object.  This class treats the values in the
     /// noise map as elevations measured in meters.
     ///
-    /// <a href=http://www.planetside.co.uk/terragen/>Terragen</a> is a
-    /// terrain application that renders realistic landscapes.  Terragen is
-    /// available for Windows and MacOS; unfortunately, Terragen does not have
-    /// UN*X versions.
+    /// <a href=http://www.planetside.co.uk/terragen/>Terragen</a> is a
+    /// terrain application that renders realistic landscapes.  Terragen is
+    /// available for Windows and MacOS; unfortunately, Terragen does not have
+    /// UN*X versions.
+    ///
+    /// <b>Writing the noise map</b>
+    ///
+    /// To write the noise map, perform the following steps:
+    /// - Pass the filename to the SetDestFilename() method.
+    /// - Pass a NoiseMap object to the SetSourceNoiseMap() method.
+    /// - Call the WriteDestFile() method.
+    ///
+    /// The SetDestFilename() and SetSourceNoiseMap() methods must be called
+    /// before calling the WriteDestFile() method.
+    class WriterTER
+    {
+
+      public:
+
+        /// Constructor.
+        WriterTER ():
+          m_pAllocator (noise::GetDefaultAllocator ()),
+          m_metersPerPoint (DEFAULT_METERS_PER_POINT),
+          m_pSourceNoiseMap (NULL)
+        {
+        }
+
+        /// Returns the allocator used for the line buffer.
+        ///
+        /// @returns The allocator used for the line buffer.
+        noise::Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
+        /// Returns the name of the file to write.
+        ///
+        /// @returns The name of the file to write.
+        std::string GetDestFilename () const
+        {
+          return m_destFilename;
+        }
+
+        /// Returns the distance separating adjacent points in the noise map,
+        /// in meters.
+        ///
+        /// @returns The distance separating adjacent points in the noise map.
+        float GetMetersPerPoint () const
+        {
+          return m_metersPerPoint;
+        }
+
+        /// Sets the allocator used for the line buffer.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// The WriteDestFile() method allocates a buffer that holds one
+        /// horizontal line of the file from this allocator.
+        void SetAllocator (noise::Allocator* pAllocator)
+        {
+          m_pAllocator = (pAllocator != NULL)? pAllocator:
+            noise::GetDefaultAllocator ();
+        }
+
+        /// Sets the name of the file to write.
+        ///
+        /// @param filename The name of the file to write.
+        ///
+        /// Call this method before calling the WriteDestFile() method.
+        void SetDestFilename (const std::string& filename)
+        {
+          m_destFilename = filename;
+        }
+
+        /// Sets the distance separating adjacent points in the noise map, in
+        /// meters.
+        ///
+        /// @param metersPerPoint The distance separating adjacent points in
+        /// the noise map.
+        void SetMetersPerPoint (float metersPerPoint)
+        {
+          m_metersPerPoint = metersPerPoint;
+        }
+
+        /// Sets the noise map object that is written to the file.
+        ///
+        /// @param sourceNoiseMap The noise map object to write.
+        ///
+        /// This object only stores a pointer to a noise map object, so make
+        /// sure this object exists before calling the WriteDestFile() method.
+        void SetSourceNoiseMap (NoiseMap& sourceNoiseMap)
+        {
+          m_pSourceNoiseMap = &sourceNoiseMap;
+        }
+
+        /// Writes the contents of the noise map object to the file.
+        ///
+        /// @pre SetDestFilename() has been previously called.
+        /// @pre SetSourceNoiseMap() has been previously called.
+        /// @pre The width and height of the noise map do not exceed 65535
+        /// points, the largest size a Terragen Terrain file can store.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        /// @throw noise::ExceptionUnknown An unknown exception occurred.
+        /// Possibly the file could not be written.
+        ///
+        /// This method encodes the contents of the noise map and writes it to
+        /// a file.  Before calling this method, call the SetSourceNoiseMap()
+        /// method to specify the noise map, then call the SetDestFilename()
+        /// method to specify the name of the file to write.
+        ///
+        /// This object assumes that the noise values represent elevations in
+        /// meters.
+        void WriteDestFile ();
+
+      protected:
+    
+        /// Calculates the width of one horizontal line in the file, in bytes.
+        ///
+        /// @param width The width of the noise map, in points.
+        ///
+        /// @returns The width of one horizontal line in the file.
+        noise::int64 CalcWidthByteCount (noise::int64 width) const;
+
+        /// The allocator used for the line buffer.
+        noise::Allocator* m_pAllocator;
+
+        /// Name of the file to write.
+        std::string m_destFilename;
+
+        /// The distance separating adjacent points in the noise map, in
+        /// meters.
+        float m_metersPerPoint;
+
+        /// A pointer to the noise map that will be written to the file.
+        NoiseMap* m_pSourceNoiseMap;
+
+    };
+
+    /// Enumerates how much of a rectangle a region mask covers.
+    enum MaskCoverage
+    {
+
+      /// No point of the rectangle is set.
+      MASK_COVERAGE_NONE = 0,
+
+      /// Some points of the rectangle may be set.
+      MASK_COVERAGE_PARTIAL = 1,
+
+      /// Every point of the rectangle is set.
+      MASK_COVERAGE_FULL = 2
+
+    };
+
+    /// Abstract base class for a region mask, which selects the points of
+    /// a noise map that a noise-map builder calculates.
+    ///
+    /// Pass a region mask to the NoiseMapBuilder::SetMask() method.  The
+    /// noise-map builder divides the noise map into blocks of
+    /// MASK_BLOCK_SIZE x MASK_BLOCK_SIZE points and calls GetCoverage() once
+    /// for each block.  It skips blocks that are not covered at all,
+    /// calculates blocks that are fully covered without looking at the mask
+    /// again, and calls GetRun() for the rows of the other blocks.
+    ///
+    /// The coordinates are positions in the whole noise map, not in the
+    /// window of the noise-map builder.  The methods of a region mask may be
+    /// called from several threads at the same time.
+    class RegionMask
+    {
+
+      public:
+
+        /// Destructor.
+        virtual ~RegionMask ()
+        {
+        }
+
+        /// Returns how much of a rectangle the mask covers.
+        ///
+        /// @param x The x coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param y The y coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param width The width of the rectangle.
+        /// @param height The height of the rectangle.
+        ///
+        /// @returns The coverage of the rectangle.
+        ///
+        /// This method may return MASK_COVERAGE_PARTIAL for any rectangle;
+        /// that is always correct, just slower.  The base class always
+        /// does.
+        virtual MaskCoverage GetCoverage (noise::int64 /* x */,
+          noise::int64 /* y */, noise::int64 /* width */,
+          noise::int64 /* height */) const
+        {
+          return MASK_COVERAGE_PARTIAL;
+        }
+
+        /// Determines which points of a run are set.
+        ///
+        /// @param x The x coordinate of the first point.
+        /// @param y The y coordinate of the points.
+        /// @param count The number of points.
+        /// @param pDest On exit, @a true for each point that is set.
+        virtual void GetRun (noise::int64 x, noise::int64 y,
+          noise::int64 count, bool* pDest) const = 0;
+
+    };
+
+    /// Region mask stored as a bitmap, with one bit for each point.
+    ///
+    /// The mask keeps a count of the points set in each block of
+    /// MASK_BLOCK_SIZE x MASK_BLOCK_SIZE points, so blocks that are all
+    /// clear or all set are recognized without reading their bits.  Points
+    /// outside the bitmap are never set.
+    class RegionMaskBitmap: public RegionMask
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// The bitmap is empty.
+        RegionMaskBitmap ();
+
+        /// Constructor.
+        ///
+        /// @param width The width of the bitmap.
+        /// @param height The height of the bitmap.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions of
+        /// the SetSize() method.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        RegionMaskBitmap (noise::int64 width, noise::int64 height);
+
+        /// Sets or clears every point of the bitmap.
+        ///
+        /// @param value @a true to set every point, @a false to clear
+        /// every point.
+        void Clear (bool value);
+
+        virtual MaskCoverage GetCoverage (noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
+
+        /// Returns the height of the bitmap.
+        ///
+        /// @returns The height of the bitmap.
+        noise::int64 GetHeight () const
+        {
+          return m_height;
+        }
+
+        virtual void GetRun (noise::int64 x, noise::int64 y,
+          noise::int64 count, bool* pDest) const;
+
+        /// Determines if a point is set.
+        ///
+        /// @param x The x coordinate of the point.
+        /// @param y The y coordinate of the point.
+        ///
+        /// @returns
+        /// - @a true if the point is set.
+        /// - @a false if the point is clear or outside the bitmap.
+        bool GetValue (noise::int64 x, noise::int64 y) const;
+
+        /// Returns the width of the bitmap.
+        ///
+        /// @returns The width of the bitmap.
+        noise::int64 GetWidth () const
+        {
+          return m_width;
+        }
+
+        /// Sets the new size for the bitmap.
+        ///
+        /// @param width The new width for the bitmap.
+        /// @param height The new height for the bitmap.
+        ///
+        /// @pre The width and height values are not negative.
+        /// @pre The width and height values do not exceed RASTER_MAX_WIDTH
+        /// and RASTER_MAX_HEIGHT.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// On exit, every point is clear.
+        void SetSize (noise::int64 width, noise::int64 height);
+
+        /// Sets or clears a point.
+        ///
+        /// @param x The x coordinate of the point.
+        /// @param y The y coordinate of the point.
+        /// @param value @a true to set the point, @a false to clear it.
+        ///
+        /// This method does nothing if the point is outside the bitmap.
+        void SetValue (noise::int64 x, noise::int64 y, bool value);
+
+      private:
+
+        /// Returns the number of points in a block, which is smaller along
+        /// the right and top edges of the bitmap.
+        ///
+        /// @param blockX The column of the block.
+        /// @param blockY The row of the block.
+        ///
+        /// @returns The number of points in the block.
+        noise::uint32 GetBlockArea (noise::int64 blockX, noise::int64 blockY)
+          const;
+
+        /// The number of points set in each block, row by row.
+        std::vector<noise::uint32> m_blockCounts;
+
+        /// The number of blocks across the bitmap.
+        noise::int64 m_blockCountX;
+
+        /// The bits, row by row, 64 bits to a word.
+        std::vector<noise::uint64> m_bits;
+
+        /// The height of the bitmap.
+        noise::int64 m_height;
+
+        /// The width of the bitmap.
+        noise::int64 m_width;
+
+        /// The number of words in each row of bits.
+        noise::int64 m_wordStride;
+
+    };
+
+    /// A pointer to a callback function used by the RegionMaskCallback
+    /// class.
+    ///
+    /// The parameters are the coordinates of a point and the context
+    /// pointer passed to the RegionMaskCallback constructor.  The function
+    /// returns @a true if the point is set.
+    typedef bool(*MaskCallback) (noise::int64 x, noise::int64 y,
+      void* pContext);
+
+    /// Region mask that asks a callback function about each point.
+    ///
+    /// The callback function may be called from several threads at the
+    /// same time.
+    class RegionMaskCallback: public RegionMask
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// @param pCallback The callback function.
+        /// @param pContext A pointer that is passed to the callback function.
+        RegionMaskCallback (MaskCallback pCallback, void* pContext = NULL):
+          m_pCallback (pCallback),
+          m_pContext (pContext)
+        {
+        }
+
+        virtual void GetRun (noise::int64 x, noise::int64 y,
+          noise::int64 count, bool* pDest) const
+        {
+          for (noise::int64 i = 0; i < count; i++) {
+            pDest[i] = (m_pCallback != NULL)
+              && m_pCallback (x + i, y, m_pContext);
+          }
+        }
+
+      private:
+
+        /// The callback function.
+        MaskCallback m_pCallback;
+
+        /// The pointer passed to the callback function.
+        void* m_pContext;
+
+    };
+
+    /// Region mask made of polygons.
+    ///
+    /// A point is set if its center lies inside the polygons, by the
+    /// even-odd rule: a point inside two overlapping polygons is not set,
+    /// so a polygon inside another one cuts a hole in it.  The vertices are
+    /// positions in the noise map, and the center of the point at (@a x,
+    /// @a y) is at (@a x + 0.5, @a y + 0.5).
+    class RegionMaskPolygon: public RegionMask
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// The mask contains no polygons.
+        RegionMaskPolygon ();
+
+        /// Adds a polygon to the mask.
+        ///
+        /// @param pVertices The coordinates of the vertices, as pairs of
+        /// @a x and @a y coordinates.
+        /// @param vertexCount The number of vertices.
+        ///
+        /// @pre There are at least three vertices.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The polygon is closed from its last vertex to its first.
+        void AddPolygon (const double* pVertices, size_t vertexCount);
+
+        /// Removes every polygon from the mask.
+        void Clear ();
+
+        virtual MaskCoverage GetCoverage (noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
+
+        virtual void GetRun (noise::int64 x, noise::int64 y,
+          noise::int64 count, bool* pDest) const;
+
+      private:
+
+        /// Determines if an edge touches a rectangle.
+        ///
+        /// @param pEdge The coordinates of the ends of the edge.
+        /// @param x0 The left side of the rectangle.
+        /// @param y0 The bottom side of the rectangle.
+        /// @param x1 The right side of the rectangle.
+        /// @param y1 The top side of the rectangle.
+        ///
+        /// @returns
+        /// - @a true if the edge touches the rectangle.
+        /// - @a false if the edge is outside the rectangle.
+        static bool IsEdgeInRect (const double* pEdge, double x0, double y0,
+          double x1, double y1);
+
+        /// Determines if a position lies inside the polygons.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns
+        /// - @a true if the position lies inside the polygons.
+        /// - @a false if the position lies outside the polygons.
+        bool IsInside (double x, double y) const;
+
+        /// The edges of every polygon, four coordinates per edge.
+        std::vector<double> m_edges;
+
+    };
+
+    /// Abstract base class for a noise-map builder
+    ///
+    /// A builder class builds a noise map by filling it with coherent-noise
+    /// values generated from the surface of a three-dimensional mathematical
+    /// object.  Each builder class defines a specific three-dimensional
+    /// surface, such as a cylinder, sphere, or plane.
+    ///
+    /// A builder class describes these input values using a coordinate system
+    /// applicable for the mathematical object (e.g., a latitude/longitude
+    /// coordinate system for the spherical noise-map builder.)  It then
+    /// "flattens" these coordinates onto a plane so that it can write the
+    /// coherent-noise values into a two-dimensional noise map.
+    ///
+    /// <b>Building the Noise Map</b>
+    ///
+    /// To build the noise map, perform the following steps:
+    /// - Pass the bounding coordinates to the SetBounds() method.
+    /// - Pass the noise map size, in points, to the SetDestSize() method.
+    /// - Pass a NoiseMap object to the SetDestNoiseMap() method.
+    /// - Pass a noise module (derived from noise::module::Module) to the
+    ///   SetSourceModule() method.
+    /// - Call the Build() method.
+    ///
+    /// You may also pass a callback function to the SetCallback() method.
+    /// The Build() method calls this callback function each time it fills a
+    /// row of the noise map with coherent-noise values.  This callback
+    /// function has a single integer parameter that contains a count of the
+    /// rows that have been completed.  It returns void.
+    ///
+    /// Note that SetBounds() is not defined in the abstract base class; it is
+    /// only defined in the derived classes.  This is because each model uses
+    /// a different coordinate system.
+    ///
+    /// <b>Building a noise map in pieces</b>
+    ///
+    /// The coordinates of each point are calculated from its integer
+    /// position in the noise map, never by stepping from the previous point,
+    /// so a point always receives the same coordinates no matter which other
+    /// points are built with it.
+    ///
+    /// To build part of a noise map, pass the size of the whole noise map to
+    /// the SetDestSize() method and pass the part to build to the
+    /// SetDestWindow() method.  The Build() method then resizes the
+    /// destination noise map to the size of the window and fills it with
+    /// the same values that a build of the whole noise map would place in
+    /// that window, bit for bit.  Any partition of a noise map into windows
+    /// can therefore be built separately (or in parallel, or on different
+    /// machines) and stitched together without seams.
+    ///
+    /// <b>Building part of a noise map</b>
+    ///
+    /// To calculate only some points of the noise map, such as the land of
+    /// a planet or the footprint of an island, pass a region mask to the
+    /// SetMask() method.  The points outside the mask receive the border
+    /// value of the destination noise map, and the source module is never
+    /// evaluated there.  Blocks of the noise map that the mask does not
+    /// cover at all cost almost nothing.
+    ///
+    /// <b>Progressive building</b>
+    ///
+    /// An interactive application can show a coarse noise map long before
+    /// the whole noise map is calculated.  Pass a power of two to the
+    /// SetProgressiveStep() method; the Build() method then calculates
+    /// every point whose coordinates are multiples of that step, fills the
+    /// other points by interpolating between them, and calls the pass
+    /// callback function set by SetPassCallback().  Each following pass
+    /// halves the step and calculates only the points that no earlier pass
+    /// calculated, until the last pass, with a step of 1, completes the
+    /// noise map.  The finished noise map is identical to a noise map built
+    /// in a single pass.  The pass callback function can stop the build
+    /// after any pass, leaving the interpolated noise map in place.
+    ///
+    /// <b>Adding octaves</b>
+    ///
+    /// If the source module is a noise::module::Perlin,
+    /// noise::module::Billow or noise::module::RidgedMulti noise module, an
+    /// application can build a noise map with a few octaves and add the
+    /// remaining octaves later, for example over several frames.  Pass the
+    /// range of octaves to the SetOctaveRange() method before each call to
+    /// the Build() method.  A range that starts at octave 0 replaces the
+    /// contents of the destination noise map; any other range adds its
+    /// octaves to the values built by the previous range.  The number of
+    /// octaves set on the source module is ignored.
+    ///
+    /// <b>Adaptive sampling</b>
+    ///
+    /// Smooth parts of a noise map can be interpolated from a few points
+    /// with little error.  Pass an error tolerance to the
+    /// SetAdaptiveTolerance() method; the Build() method then calculates
+    /// the corners of a coarse grid of cells, and for each cell calculates
+    /// the midpoints of its edges and its center.  If bilinear
+    /// interpolation between the corners predicts each of these values
+    /// within the tolerance, the rest of the cell is interpolated;
+    /// otherwise the cell is divided into four and each part is checked in
+    /// the same way.  The GetBuiltPointCount() method returns the number of
+    /// points that were actually calculated.
+    ///
+    /// The error is only checked at these points, so a feature smaller
+    /// than a cell may be missed; a smaller cell size, set by the
+    /// SetAdaptiveCellSize() method, makes this less likely.  A cell that
+    /// straddles the edge of the region mask is always divided.
+    ///
+    /// <b>Multi-rate evaluation</b>
+    ///
+    /// A noise::module::Resample noise module in the source module graph
+    /// calculates its slowly changing source module on a coarse lattice
+    /// and interpolates the rest.  Before each build, the Build() method
+    /// finds these noise modules and prepares their lattices for the box
+    /// that contains the input values of the window.  The spacing of each
+    /// lattice depends only on its noise module, so windows, tiles and
+    /// noise volumes built separately interpolate the same lattice points
+    /// and have no seams.  Noise modules below a noise module that moves
+    /// the input values, such as noise::module::ScalePoint or
+    /// noise::module::Turbulence, are not prepared and calculate their
+    /// source modules directly.
+    class NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilder ();
+
+        /// Builds the noise map.
+        ///
+        /// @pre SetBounds() was previously called.
+        /// @pre SetDestNoiseMap() was previously called.
+        /// @pre SetSourceModule() was previously called.
+        /// @pre The width and height values specified by SetDestSize() are
+        /// positive.
+        /// @pre The width and height values specified by SetDestSize() do not
+        /// exceed the maximum possible width and height for the noise map.
+        ///
+        /// @post The original contents of the destination noise map is
+        /// destroyed.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// If this method is successful, the destination noise map contains
+        /// the coherent-noise values from the noise module specified by
+        /// SetSourceModule().
+        virtual void Build () = 0;
+
+        /// Returns the height of the destination noise map.
+        ///
+        /// @returns The height of the destination noise map, in points.
+        ///
+        /// This object does not change the height in the destination noise
+        /// map object until the Build() method is called.
+        double GetDestHeight () const
+        {
+          return m_destHeight;
+        }
+
+        /// Returns the width of the destination noise map.
+        ///
+        /// @returns The width of the destination noise map, in points.
+        ///
+        /// This object does not change the height in the destination noise
+        /// map object until the Build() method is called.
+        double GetDestWidth () const
+        {
+          return m_destWidth;
+        }
+
+        /// Calculates a run of values of the noise map without storing them.
+        ///
+        /// @param x The x coordinate of the first value.
+        /// @param y The y coordinate of the values.
+        /// @param count The number of values to calculate.
+        /// @param pDest On exit, the values.
+        ///
+        /// @pre SetSourceModule() was previously called.
+        /// @pre SetDestSize() was previously called.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The coordinates are positions in the whole noise map; the
+        /// window, the destination noise map and the region mask are
+        /// ignored.  Each value is the same as the value that the Build()
+        /// method stores at that position.  This method may be called from
+        /// several threads at the same time.
+        void GetSlabValues (noise::int64 x, noise::int64 y, noise::int64 count,
+          float* pDest) const;
+
+        /// Returns the width and height of the cells of the coarse grid of
+        /// an adaptive build.
+        ///
+        /// @returns The width and height of the cells, in points.
+        noise::int64 GetAdaptiveCellSize () const
+        {
+          return m_adaptiveCellSize;
+        }
+
+        /// Returns the error tolerance of an adaptive build.
+        ///
+        /// @returns The largest error that interpolation may make, or 0.0
+        /// if adaptive sampling is disabled.
+        double GetAdaptiveTolerance () const
+        {
+          return m_adaptiveTolerance;
+        }
+
+        /// Returns the number of points that the last build calculated.
+        ///
+        /// @returns The number of times the last call to the Build() method
+        /// calculated a point with the source module.
+        ///
+        /// This is less than the number of points in the window if the last
+        /// build interpolated some points, reused the values of a previous
+        /// build, was stopped by the pass callback function, or skipped the
+        /// points outside the region mask.
+        noise::int64 GetBuiltPointCount () const
+        {
+          return m_builtPointCount;
+        }
+
+        /// Removes the range of octaves set by SetOctaveRange().
+        ///
+        /// The Build() method then calculates every octave of the source
+        /// module.
+        void ClearOctaveRange ()
+        {
+          m_firstOctave = 0;
+          m_lastOctave  = 0;
+        }
+
+        /// Returns the first octave that the Build() method calculates.
+        ///
+        /// @returns The first octave of the range set by SetOctaveRange(),
+        /// or 0 if no range is set.
+        int GetFirstOctave () const
+        {
+          return m_firstOctave;
+        }
+
+        /// Returns the octave after the last octave that the Build() method
+        /// calculates.
+        ///
+        /// @returns The octave after the last octave of the range set by
+        /// SetOctaveRange(), or 0 if no range is set.
+        int GetLastOctave () const
+        {
+          return m_lastOctave;
+        }
+
+        /// Returns the step of the first pass of a progressive build.
+        ///
+        /// @returns The spacing of the points calculated by the first pass,
+        /// in points, or 1 if the noise map is built in a single pass.
+        noise::int64 GetProgressiveStep () const
+        {
+          return m_progressiveStep;
+        }
+
+        /// Determines if the last build was stopped by the pass callback
+        /// function.
+        ///
+        /// @returns
+        /// - @a true if the pass callback function stopped the last build
+        ///   before its last pass.
+        /// - @a false if the last build completed.
+        ///
+        /// After a stopped build, the destination noise map holds the
+        /// interpolated values of the last completed pass.
+        bool IsBuildStopped () const
+        {
+          return m_passStep > 1;
+        }
+
+        /// Prepares the noise::module::Resample noise modules in the source
+        /// module graph for the whole destination noise map.
+        ///
+        /// @pre SetSourceModule() was previously called.
+        /// @pre SetDestSize() was previously called.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The Build() method prepares these noise modules for its window,
+        /// so call this method before building a noise map in several
+        /// windows, so that the lattices are calculated only once, or before
+        /// calling the GetSlabValues() method.
+        void PrepareResampleModules () const
+        {
+          PrepareResampleModules (0, 0, m_destWidth, m_destHeight);
+        }
+
+        /// Prepares the noise::module::Resample noise modules in the source
+        /// module graph for a region of the destination noise map.
+        ///
+        /// @param x The x coordinate of the lower-left corner of the region.
+        /// @param y The y coordinate of the lower-left corner of the region.
+        /// @param width The width of the region, in points.
+        /// @param height The height of the region, in points.
+        ///
+        /// @pre SetSourceModule() was previously called.
+        /// @pre The width and height are positive.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// If the builder cannot find the input value of each point, as for
+        /// a seamless planar noise map, the noise modules are not prepared.
+        ///
+        /// Do not call this method while another thread is calculating
+        /// values with the same noise modules.
+        void PrepareResampleModules (noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
+
+        /// Sets the width and height of the cells of the coarse grid of an
+        /// adaptive build.
+        ///
+        /// @param cellSize The width and height of the cells, in points.
+        ///
+        /// @pre The cell size is a power of two greater than 1.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetAdaptiveCellSize (noise::int64 cellSize)
+        {
+          if (cellSize < 2 || (cellSize & (cellSize - 1)) != 0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_adaptiveCellSize = cellSize;
+        }
+
+        /// Sets the error tolerance of an adaptive build.
+        ///
+        /// @param tolerance The largest error that interpolation may make
+        /// at the points where it is checked, or 0.0 to calculate every
+        /// point.
+        ///
+        /// @pre The tolerance is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// An adaptive build has a single pass and does not call the
+        /// callback function set by SetCallback().  A build of a range of
+        /// octaves is never adaptive.
+        void SetAdaptiveTolerance (double tolerance)
+        {
+          if (!(tolerance >= 0.0)) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_adaptiveTolerance = tolerance;
+        }
+
+        /// Restricts the Build() method to a range of octaves of the source
+        /// module.
+        ///
+        /// @param firstOctave The first octave to calculate.
+        /// @param lastOctave The octave after the last octave to calculate.
+        ///
+        /// @pre The first octave is not negative and is less than the last
+        /// octave.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The source module must be a noise::module::Perlin,
+        /// noise::module::Billow or noise::module::RidgedMulti noise module
+        /// with at least @a lastOctave octaves available.
+        ///
+        /// If @a firstOctave is 0, the Build() method replaces the contents
+        /// of the destination noise map.  Otherwise it adds the octaves to
+        /// the values of the destination noise map, which must hold the
+        /// result of the previous build, whose range of octaves ended at
+        /// @a firstOctave.  Every other setting of this object must be the
+        /// same for both builds.  For a noise::module::RidgedMulti noise
+        /// module, this object keeps the weight of each point between the
+        /// builds.
+        ///
+        /// The result of building the ranges [0, @a k) and [@a k, @a n) is
+        /// the result of building all @a n octaves, apart from
+        /// floating-point rounding.  If the destination noise map stores
+        /// 16-bit values, each build also rounds the sum to that format.
+        ///
+        /// A build of a range of octaves is never progressive.
+        void SetOctaveRange (int firstOctave, int lastOctave)
+        {
+          if (firstOctave < 0 || firstOctave >= lastOctave) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_firstOctave = firstOctave;
+          m_lastOctave  = lastOctave ;
+        }
+
+        /// Sets the callback function that Build() calls after each pass of
+        /// a progressive build.
+        ///
+        /// @param pCallback The callback function, or @a NULL.
+        /// @param pContext The context pointer passed to the callback
+        /// function.
+        ///
+        /// The callback function is called on the thread that called the
+        /// Build() method, after the destination noise map is filled with
+        /// the values of the pass.  It returns @a false to stop the build.
+        /// A build that is not progressive has a single pass with a step of
+        /// 1.
+        void SetPassCallback (NoiseMapPassCallback pCallback,
+          void* pContext = NULL)
+        {
+          m_pPassCallback = pCallback;
+          m_pPassContext  = pContext ;
+        }
+
+        /// Sets the step of the first pass of a progressive build.
+        ///
+        /// @param step The spacing of the points calculated by the first
+        /// pass, in points, or 1 to build the noise map in a single pass.
+        ///
+        /// @pre The step is a power of two.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetProgressiveStep (noise::int64 step)
+        {
+          if (step <= 0 || (step & (step - 1)) != 0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_progressiveStep = step;
+        }
+
+        /// Sets the callback function that Build() calls each time it fills a
+        /// row of the noise map with coherent-noise values.
+        ///
+        /// @param pCallback The callback function.
+        ///
+        /// This callback function has a single integer parameter that
+        /// contains a count of the rows that have been completed.  It returns
+        /// void.  Pass a function with this signature to the SetCallback()
+        /// method.
+        ///
+        /// If this object uses an executor, the rows may complete out of
+        /// order.  The callback function is never called by two threads at
+        /// the same time.
+        void SetCallback (NoiseMapCallback pCallback);
+
+        /// Sets the callback function that Build() calls each time it fills a
+        /// row of the noise map, passing a 64-bit count of the rows.
+        ///
+        /// @param pCallback The callback function.
+        ///
+        /// This callback function is called in the same way as the callback
+        /// function set by SetCallback(), and after it if both are set.
+        void SetCallback64 (NoiseMapCallback64 pCallback);
+
+        /// Returns the executor that runs the rows of the noise map.
+        ///
+        /// @returns The executor passed to SetExecutor(), the default
+        /// executor if none was passed, or @a NULL if the rows run on the
+        /// calling thread.
+        Executor* GetExecutor () const
+        {
+          return (m_pExecutor != NULL)? m_pExecutor: GetDefaultExecutor ();
+        }
+
+        /// Sets the executor that runs the rows of the noise map.
+        ///
+        /// @param pExecutor The executor, or @a NULL to use the default
+        /// executor.
+        ///
+        /// The Build() method splits the noise map into bands of rows and
+        /// submits them to the executor.  The source module is then called
+        /// from several threads at the same time, so every noise module
+        /// connected to it must be safe to call concurrently.  This is true
+        /// for every noise module in libnoise except noise::module::Cache.
+        ///
+        /// The executor must exist throughout the lifetime of this object
+        /// unless another executor replaces that executor.
+        void SetExecutor (Executor* pExecutor)
+        {
+          m_pExecutor = pExecutor;
+        }
+
+        /// Returns the destination noise map.
+        ///
+        /// @returns The destination noise map, or @a NULL if none was set.
+        NoiseMap* GetDestNoiseMap () const
+        {
+          return m_pDestNoiseMap;
+        }
+
+        /// Sets the destination noise map.
+        ///
+        /// @param destNoiseMap The destination noise map.
+        ///
+        /// The destination noise map will contain the coherent-noise values
+        /// from this noise map after a successful call to the Build() method.
+        ///
+        /// The destination noise map must exist throughout the lifetime of
+        /// this object unless another noise map replaces that noise map.
+        void SetDestNoiseMap (NoiseMap& destNoiseMap)
+        {
+          m_pDestNoiseMap = &destNoiseMap;
+        }
+
+        /// Returns the region mask.
+        ///
+        /// @returns The region mask, or @a NULL if every point is
+        /// calculated.
+        const RegionMask* GetMask () const
+        {
+          return m_pMask;
+        }
+
+        /// Sets the region mask that selects the points to calculate.
+        ///
+        /// @param pMask The region mask, or @a NULL to calculate every
+        /// point.
+        ///
+        /// The Build() method fills the points outside the mask with the
+        /// border value of the destination noise map.  The region mask must
+        /// exist throughout the lifetime of this object unless another
+        /// region mask replaces that region mask.
+        void SetMask (const RegionMask* pMask)
+        {
+          m_pMask = pMask;
+        }
+
+        /// Sets the source module.
+        ///
+        /// @param sourceModule The source module.
+        ///
+        /// This object fills in a noise map with the coherent-noise values
+        /// from this source module.
+        ///
+        /// The source module must exist throughout the lifetime of this
+        /// object unless another noise module replaces that noise module.
+        void SetSourceModule (const module::Module& sourceModule)
+        {
+          m_pSourceModule = &sourceModule;
+        }
+
+        /// Sets the size of the destination noise map.
+        ///
+        /// @param destWidth The width of the destination noise map, in
+        /// points.
+        /// @param destHeight The height of the destination noise map, in
+        /// points.
+        ///
+        /// This method does not change the size of the destination noise map
+        /// until the Build() method is called.
+        void SetDestSize (noise::int64 destWidth, noise::int64 destHeight)
+        {
+          m_destWidth  = destWidth ;
+          m_destHeight = destHeight;
+        }
+
+        /// Restricts the Build() method to a window of the noise map.
+        ///
+        /// @param x The x coordinate of the lower-left corner of the window.
+        /// @param y The y coordinate of the lower-left corner of the window.
+        /// @param width The width of the window, in points.
+        /// @param height The height of the window, in points.
+        ///
+        /// @pre The width and height of the window are positive.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The window is measured in points of the whole noise map, whose
+        /// size is set by SetDestSize().  The Build() method checks that
+        /// the window lies within the whole noise map, then resizes the
+        /// destination noise map to the size of the window; position (0, 0)
+        /// in the destination noise map is position ( @a x, @a y ) in the
+        /// whole noise map.
+        void SetDestWindow (noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height)
+        {
+          if (width <= 0 || height <= 0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_windowX      = x     ;
+          m_windowY      = y     ;
+          m_windowWidth  = width ;
+          m_windowHeight = height;
+        }
+
+        /// Removes the destination noise map set by SetDestNoiseMap().
+        void ClearDestNoiseMap ()
+        {
+          m_pDestNoiseMap = NULL;
+        }
+
+        /// Removes the window set by SetDestWindow().
+        ///
+        /// The Build() method then builds the whole noise map.
+        void ClearDestWindow ()
+        {
+          m_windowX      = 0;
+          m_windowY      = 0;
+          m_windowWidth  = 0;
+          m_windowHeight = 0;
+        }
+
+        /// Returns the height of the window that the Build() method builds.
+        ///
+        /// @returns The height of the window set by SetDestWindow(), or the
+        /// height of the destination noise map if no window is set.
+        noise::int64 GetDestWindowHeight () const
+        {
+          return (m_windowHeight > 0)? m_windowHeight: m_destHeight;
+        }
+
+        /// Returns the width of the window that the Build() method builds.
+        ///
+        /// @returns The width of the window set by SetDestWindow(), or the
+        /// width of the destination noise map if no window is set.
+        noise::int64 GetDestWindowWidth () const
+        {
+          return (m_windowWidth > 0)? m_windowWidth: m_destWidth;
+        }
+
+        /// Returns the x coordinate of the window that the Build() method
+        /// builds.
+        ///
+        /// @returns The x coordinate of the lower-left corner of the window,
+        /// in points of the whole noise map.
+        noise::int64 GetDestWindowX () const
+        {
+          return m_windowX;
+        }
+
+        /// Returns the y coordinate of the window that the Build() method
+        /// builds.
+        ///
+        /// @returns The y coordinate of the lower-left corner of the window,
+        /// in points of the whole noise map.
+        noise::int64 GetDestWindowY () const
+        {
+          return m_windowY;
+        }
+
+      protected:
+
+        /// The cosines and sines of an angle that increases in equal steps
+        /// from one column or row of the noise map to the next.
+        struct AngleTable
+        {
+          /// The angle at index 0, in degrees.
+          double lowerBound;
+
+          /// The angle one step past the last index, in degrees.
+          double upperBound;
+
+          /// The cosine of the angle at each index.
+          std::vector<double> cosines;
+
+          /// The sine of the angle at each index.
+          std::vector<double> sines;
+        };
+
+        /// Fills every row of the destination noise map.
+        ///
+        /// @pre The destination size and window are valid.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// This method resizes the destination noise map to the size of the
+        /// window, then calls FillSlab() for each row, either on the calling
+        /// thread or through the executor, and calls the callback function
+        /// after each row is complete.  In a progressive build, it fills the
+        /// noise map in passes and calls the callback function only during
+        /// the last pass.
+        void BuildRows ();
+
+        /// Fills one row of the destination noise map.
+        ///
+        /// @param row The row to fill, relative to the window.
+        ///
+        /// @returns The number of points calculated with the source module.
+        ///
+        /// If the destination noise map stores 16-bit values, this method
+        /// fills a small buffer of @a float values and converts them.
+        noise::int64 BuildRow (noise::int64 row) const;
+
+        /// Calculates the corners of the cells in one row of the coarse
+        /// grid of an adaptive build.
+        ///
+        /// @param index The index of the row among the rows of the grid.
+        void BuildAdaptiveGridRow (noise::int64 index) const;
+
+        /// Calculates the points in one row of the grid of the next level
+        /// of an adaptive build that the cells being tested need.
+        ///
+        /// @param index The index of the row among the rows of the grid of
+        /// the next level.
+        ///
+        /// The current level is the step of the current pass.
+        void BuildAdaptivePointRow (noise::int64 index) const;
+
+        /// Fills the points of one row of a progressive pass that no
+        /// earlier pass calculated.
+        ///
+        /// @param index The index of the row among the rows of the pass.
+        void BuildPassRow (noise::int64 index) const;
+
+        /// Fills part of one row of the destination noise map.
+        ///
+        /// @param row The row to fill, relative to the window.
+        /// @param x The first column to fill, relative to the window.
+        /// @param count The number of columns to fill.
+        ///
+        /// @returns The number of points calculated with the source module.
+        noise::int64 BuildRowPart (noise::int64 row, noise::int64 x,
+          noise::int64 count) const;
+
+        /// Fills part of a slab with coherent-noise values.
+        ///
+        /// @param pDest A pointer to the first value to fill.
+        /// @param x The x coordinate of the first value to fill.
+        /// @param y The y coordinate (row) of the values to fill.
+        /// @param count The number of values to fill.
+        ///
+        /// The coordinates are positions in the whole noise map, not in the
+        /// window.  Derived classes map each position onto the surface of
+        /// their mathematical object from the position alone, so the same
+        /// position always produces the same value.  This method may be
+        /// called from several threads at the same time.
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const = 0;
+
+        /// Calculates the cosine and sine of the angle at each index of an
+        /// angle table, unless the table already holds them.
+        ///
+        /// @param table The table to fill.
+        /// @param lowerBound The angle at index 0, in degrees.
+        /// @param upperBound The angle one step past the last index, in
+        /// degrees.
+        /// @param count The number of indices.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The angle at index @a i is @a lowerBound + @a i * (@a upperBound
+        /// - @a lowerBound) / @a count, so a column or row that is mapped
+        /// to an angle costs two multiplications instead of a cosine and a
+        /// sine.
+        static void FillAngleTable (AngleTable& table, double lowerBound,
+          double upperBound, noise::int64 count);
+
+        /// Fills part of a slab with the sum of the range of octaves set by
+        /// SetOctaveRange(), added to the values already in the slab if the
+        /// range does not start at octave 0.
+        ///
+        /// @param pDest A pointer to the first value to fill.
+        /// @param x The x coordinate of the first value to fill.
+        /// @param y The y coordinate (row) of the values to fill.
+        /// @param count The number of values to fill.
+        ///
+        /// The coordinates are positions in the whole noise map.
+        void FillOctaveSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        /// Fills part of a slab with coherent-noise values at the points
+        /// selected by the region mask, and with the border value
+        /// elsewhere.
+        ///
+        /// @param pDest A pointer to the first value to fill.
+        /// @param x The x coordinate of the first value to fill.
+        /// @param y The y coordinate (row) of the values to fill.
+        /// @param count The number of values to fill.
+        ///
+        /// @returns The number of points calculated with the source module.
+        ///
+        /// @pre The coverage of the mask blocks was found by BuildRows().
+        noise::int64 FillMaskedSlab (float* pDest, noise::int64 x,
+          noise::int64 y, noise::int64 count) const;
+
+        /// Finds the input value of the source module at a point of the
+        /// noise map.
+        ///
+        /// @param x The x coordinate of the point.
+        /// @param y The y coordinate of the point.
+        /// @param inputX On exit, the @a x coordinate of the input value.
+        /// @param inputY On exit, the @a y coordinate of the input value.
+        /// @param inputZ On exit, the @a z coordinate of the input value.
+        ///
+        /// @returns
+        /// - @a true if the value of the point is the output value of the
+        ///   source module at a single input value.
+        /// - @a false otherwise, in which case a range of octaves cannot be
+        ///   built.
+        ///
+        /// The coordinates are positions in the whole noise map.  The base
+        /// class returns @a false.
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+        /// Returns the number of points that the rows of the current pass
+        /// calculated with the source module.
+        ///
+        /// @returns The sum of the counts of the rows.
+        noise::int64 GetRowCountTotal () const;
+
+        /// Returns the cosine and sine of the angle at an index of an angle
+        /// table.
+        ///
+        /// @param table The table.
+        /// @param lowerBound The angle at index 0, in degrees.
+        /// @param upperBound The angle one step past the last index, in
+        /// degrees.
+        /// @param count The number of indices.
+        /// @param index The index of the angle.
+        /// @param cosAngle On exit, the cosine of the angle.
+        /// @param sinAngle On exit, the sine of the angle.
+        ///
+        /// If the table was not filled by FillAngleTable() with the same
+        /// bounds and count, this method calculates the cosine and sine, so
+        /// the results are the same either way.
+        static void GetTableAngle (const AngleTable& table,
+          double lowerBound, double upperBound, noise::int64 count,
+          noise::int64 index, double& cosAngle, double& sinAngle);
+
+        /// Determines if a cell of the current level of an adaptive build
+        /// is being tested.
+        ///
+        /// @param cellX The column of the cell.
+        /// @param cellY The row of the cell.
+        ///
+        /// @returns
+        /// - @a true if the cell is being tested.
+        /// - @a false if the cell is not being tested or does not exist.
+        bool IsAdaptiveCellTested (noise::int64 cellX, noise::int64 cellY)
+          const;
+
+        /// Determines if the destination size and window are valid.
+        ///
+        /// @returns
+        /// - @a true if the destination size is positive and the window lies
+        ///   within the destination noise map.
+        /// - @a false otherwise.
+        bool IsDestWindowValid () const;
+
+        /// Determines if the region mask selects a point.
+        ///
+        /// @param x The x coordinate of the point, relative to the window.
+        /// @param y The y coordinate of the point, relative to the window.
+        ///
+        /// @returns
+        /// - @a true if no region mask is set or the mask selects the point.
+        /// - @a false otherwise.
+        ///
+        /// @pre The coverage of the mask blocks was found by BuildRows().
+        bool IsPointSelected (noise::int64 x, noise::int64 y) const;
+
+        /// Tests the cells in one row of the current level of an adaptive
+        /// build.
+        ///
+        /// @param index The row of cells.
+        ///
+        /// @pre The points of the next level that the cells need were
+        /// calculated by BuildAdaptivePointRow().
+        ///
+        /// If bilinear interpolation between the corners of a cell predicts
+        /// the values of the points of the next level within the cell, this
+        /// method interpolates the rest of the cell.  Otherwise it marks the
+        /// four parts of the cell for testing at the next level.
+        ///
+        /// A cell fills the points on its left and bottom sides, but not on
+        /// its right and top sides unless they lie on the edge of the
+        /// window, so that no two cells of a level fill the same point.
+        void TestAdaptiveCellRow (noise::int64 index) const;
+
+        /// Fills the points of one row that the current pass of a
+        /// progressive build did not calculate, by interpolating between
+        /// the calculated points.
+        ///
+        /// @param row The row to fill, relative to the window.
+        void UpsampleRow (noise::int64 row) const;
+
+        /// The callback function that Build() calls each time it fills a row
+        /// of the noise map with coherent-noise values.
+        ///
+        /// This callback function has a single integer parameter that
+        /// contains a count of the rows that have been completed.  It returns
+        /// void.  Pass a function with this signature to the SetCallback()
+        /// method.
+        NoiseMapCallback m_pCallback;
+
+        /// The callback function set by SetCallback64().
+        NoiseMapCallback64 m_pCallback64;
+
+        /// The number of points that each row of the current pass
+        /// calculated with the source module.
+        mutable std::vector<noise::int64> m_rowCounts;
+
+        /// For each cell of the next level of an adaptive build, a flag
+        /// specifying whether the cell is tested.
+        mutable std::vector<noise::uint8> m_adaptiveNextTested;
+
+        /// For each cell of the current level of an adaptive build, a flag
+        /// specifying whether the cell is tested.
+        std::vector<noise::uint8> m_adaptiveTested;
+
+        /// The width and height of the cells of an adaptive build, in
+        /// points.
+        noise::int64 m_adaptiveCellSize;
+
+        /// The error tolerance of an adaptive build, or 0.0 to calculate
+        /// every point.
+        double m_adaptiveTolerance;
+
+        /// The number of points that the last build calculated.
+        noise::int64 m_builtPointCount;
+
+        /// Height of the destination noise map, in points.
+        noise::int64 m_destHeight;
+
+        /// Width of the destination noise map, in points.
+        noise::int64 m_destWidth;
+
+        /// Destination noise map that will contain the coherent-noise values.
+        NoiseMap* m_pDestNoiseMap;
+
+        /// The octave after the last octave of the previous build of a range
+        /// of octaves, or 0 if the previous build calculated every octave.
+        int m_builtLastOctave;
+
+        /// The first octave that the Build() method calculates.
+        int m_firstOctave;
+
+        /// The octave after the last octave that the Build() method
+        /// calculates, or 0 to calculate every octave.
+        int m_lastOctave;
+
+        /// The coverage of each mask block that overlaps the window, row by
+        /// row, found at the start of the Build() method.
+        std::vector<noise::uint8> m_maskCoverage;
+
+        /// The number of mask blocks across the window.
+        noise::int64 m_maskBlockCountX;
+
+        /// The column of the first mask block that overlaps the window.
+        noise::int64 m_maskFirstBlockX;
+
+        /// The row of the first mask block that overlaps the window.
+        noise::int64 m_maskFirstBlockY;
+
+        /// The weight of each point of the window between builds of ranges
+        /// of octaves of a noise::module::RidgedMulti noise module.
+        mutable std::vector<double> m_octaveWeights;
+
+        /// The executor that runs the rows, or @a NULL to use the default
+        /// executor.
+        Executor* m_pExecutor;
+
+        /// The region mask, or @a NULL to calculate every point.
+        const RegionMask* m_pMask;
+
+        /// The source module as a noise::module::Billow noise module during
+        /// a build of a range of octaves, or @a NULL.
+        const module::Billow* m_pOctaveBillow;
+
+        /// The source module as a noise::module::Perlin noise module during
+        /// a build of a range of octaves, or @a NULL.
+        const module::Perlin* m_pOctavePerlin;
+
+        /// The source module as a noise::module::RidgedMulti noise module
+        /// during a build of a range of octaves, or @a NULL.
+        const module::RidgedMulti* m_pOctaveRidged;
+
+        /// The callback function called after each pass of a progressive
+        /// build, or @a NULL.
+        NoiseMapPassCallback m_pPassCallback;
+
+        /// The context pointer passed to the pass callback function.
+        void* m_pPassContext;
+
+        /// The step of the current pass of a progressive build, or of the
+        /// last completed pass once the build returns.
+        noise::int64 m_passStep;
+
+        /// The step of the first pass of a progressive build, or 1 to
+        /// build the noise map in a single pass.
+        noise::int64 m_progressiveStep;
+
+        /// Source noise module that will generate the coherent-noise values.
+        const module::Module* m_pSourceModule;
+
+        /// Height of the window to build, in points, or 0 to build the
+        /// whole noise map.
+        noise::int64 m_windowHeight;
+
+        /// Width of the window to build, in points, or 0 to build the whole
+        /// noise map.
+        noise::int64 m_windowWidth;
+
+        /// The x coordinate of the lower-left corner of the window to build.
+        noise::int64 m_windowX;
+
+        /// The y coordinate of the lower-left corner of the window to build.
+        noise::int64 m_windowY;
+
+    };
+
+    /// Builds the faces of a cube-mapped spherical noise map.
+    ///
+    /// This class builds a noise map by filling it with coherent-noise values
+    /// generated from the surface of a sphere, like the
+    /// NoiseMapBuilderSphere class, but it describes the surface with the
+    /// six faces of a cube instead of with latitude and longitude.
+    ///
+    /// The sphere model has a radius of 1.0 unit.  Its center is at the
+    /// origin.
+    ///
+    /// The points of a face lie at equal angles from the center of the
+    /// cube, so they are spread almost evenly over the sphere: the points
+    /// are never more than about 1.4 times denser at one place than at
+    /// another.  A latitude/longitude noise map crowds its points together
+    /// near the poles instead, so six faces of @a n by @a n points cost
+    /// three quarters of the points of a 4 @a n by 2 @a n spherical noise
+    /// map with the same spacing at the equator, and reach the same
+    /// spacing everywhere else.
+    ///
+    /// The points lie at the centers of the cells of an @a n by @a n grid
+    /// that covers the face, so no point lies on an edge shared by two
+    /// faces.  The orientation of each face is described by the
+    /// noise::CubeFace enumeration; the x coordinate in the noise map
+    /// increases along the @a s coordinate of the face and the y
+    /// coordinate increases along its @a t coordinate.  The points match
+    /// the grid of a noise::module::CubeMap noise module with the same
+    /// orientation.
+    ///
+    /// By default, the noise map holds the face passed to the SetFace()
+    /// method, and its width and height must be equal.  To build all six
+    /// faces into one atlas, call the EnableAtlas() method; the noise map
+    /// then holds the faces side by side in the order of the
+    /// noise::CubeFace enumeration, and its width must be six times its
+    /// height.  A window, a region mask or a tiled build may select part
+    /// of the atlas.
+    class NoiseMapBuilderCube: public NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilderCube ();
+
+        virtual void Build ();
+
+        /// Enables or disables building all six faces into one atlas.
+        ///
+        /// @param enable A flag that enables or disables the atlas.
+        ///
+        /// If the atlas is enabled, the face set by SetFace() is ignored.
+        void EnableAtlas (bool enable = true)
+        {
+          m_isAtlasEnabled = enable;
+        }
+
+        /// Returns the face of the cube that the noise map holds.
+        ///
+        /// @returns The face of the cube that the noise map holds.
+        noise::CubeFace GetFace () const
+        {
+          return m_face;
+        }
+
+        /// Determines if all six faces are built into one atlas.
+        ///
+        /// @returns
+        /// - @a true if the atlas is enabled.
+        /// - @a false if the noise map holds a single face.
+        bool IsAtlasEnabled () const
+        {
+          return m_isAtlasEnabled;
+        }
+
+        /// Sets the face of the cube that the noise map holds.
+        ///
+        /// @param face The face of the cube.
+        ///
+        /// @pre @a face is one of the values of the noise::CubeFace
+        /// enumeration.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetFace (noise::CubeFace face)
+        {
+          if (face < noise::CUBE_FACE_POS_X || face > noise::CUBE_FACE_NEG_Z) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_face = face;
+        }
+
+      protected:
+
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+      private:
+
+        /// The face of the cube that the noise map holds.
+        noise::CubeFace m_face;
+
+        /// A flag specifying whether all six faces are built into one
+        /// atlas.
+        bool m_isAtlasEnabled;
+
+    };
+
+    /// Builds a cylindrical noise map.
+    ///
+    /// This class builds a noise map by filling it with coherent-noise values
+    /// generated from the surface of a cylinder.
+    ///
+    /// This class describes these input values using an (angle, height)
+    /// coordinate system.  After generating the coherent-noise value from the
+    /// input value, it then "flattens" these coordinates onto a plane so that
+    /// it can write the values into a two-dimensional noise map.
+    ///
+    /// The cylinder model has a radius of 1.0 unit and has infinite height.
+    /// The cylinder is oriented along the @a y axis.  Its center is at the
+    /// origin.
+    ///
+    /// The x coordinate in the noise map represents the angle around the
+    /// cylinder's y axis.  The y coordinate in the noise map represents the
+    /// height above the x-z plane.
+    ///
+    /// The application must provide the lower and upper angle bounds of the
+    /// noise map, in degrees, and the lower and upper height bounds of the
+    /// noise map, in units.
+    class NoiseMapBuilderCylinder: public NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilderCylinder ();
+
+        virtual void Build ();
+
+        /// Returns the lower angle boundary of the cylindrical noise map.
+        ///
+        /// @returns The lower angle boundary of the noise map, in degrees.
+        double GetLowerAngleBound () const
+        {
+          return m_lowerAngleBound;
+        }
+
+        /// Returns the lower height boundary of the cylindrical noise map.
+        ///
+        /// @returns The lower height boundary of the noise map, in units.
+        ///
+        /// One unit is equal to the radius of the cylinder.
+        double GetLowerHeightBound () const
+        {
+          return m_lowerHeightBound;
+        }
+
+        /// Returns the upper angle boundary of the cylindrical noise map.
+        ///
+        /// @returns The upper angle boundary of the noise map, in degrees.
+        double GetUpperAngleBound () const
+        {
+          return m_upperAngleBound;
+        }
+
+        /// Returns the upper height boundary of the cylindrical noise map.
+        ///
+        /// @returns The upper height boundary of the noise map, in units.
+        ///
+        /// One unit is equal to the radius of the cylinder.
+        double GetUpperHeightBound () const
+        {
+          return m_upperHeightBound;
+        }
+
+        /// Sets the coordinate boundaries of the noise map.
+        ///
+        /// @param lowerAngleBound The lower angle boundary of the noise map,
+        /// in degrees.
+        /// @param upperAngleBound The upper angle boundary of the noise map,
+        /// in degrees.
+        /// @param lowerHeightBound The lower height boundary of the noise
+        /// map, in units.
+        /// @param upperHeightBound The upper height boundary of the noise
+        /// map, in units.
+        ///
+        /// @pre The lower angle boundary is less than the upper angle
+        /// boundary.
+        /// @pre The lower height boundary is less than the upper height
+        /// boundary.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// One unit is equal to the radius of the cylinder.
+        void SetBounds (double lowerAngleBound, double upperAngleBound,
+          double lowerHeightBound, double upperHeightBound)
+        {
+          if (lowerAngleBound >= upperAngleBound
+            || lowerHeightBound >= upperHeightBound) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_lowerAngleBound  = lowerAngleBound ;
+          m_upperAngleBound  = upperAngleBound ;
+          m_lowerHeightBound = lowerHeightBound;
+          m_upperHeightBound = upperHeightBound;
+        }
+
+      protected:
+
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+      private:
+
+        /// The cosine and sine of the angle of each column, calculated by
+        /// the Build() method.
+        AngleTable m_angleTable;
+
+        /// Lower angle boundary of the cylindrical noise map, in degrees.
+        double m_lowerAngleBound;
+
+        /// Lower height boundary of the cylindrical noise map, in units.
+        double m_lowerHeightBound;
+
+        /// Upper angle boundary of the cylindrical noise map, in degrees.
+        double m_upperAngleBound;
+
+        /// Upper height boundary of the cylindrical noise map, in units.
+        double m_upperHeightBound;
+
+    };
+
+    /// Builds an equal-area spherical noise map.
+    ///
+    /// This class builds a noise map by filling it with coherent-noise values
+    /// generated from the surface of a sphere at the centers of the pixels of
+    /// a HEALPix (Hierarchical Equal Area isoLatitude Pixelization) grid.
+    /// Every pixel covers the same area of the sphere, so a plain average
+    /// of the values is an area-weighted average over the sphere, as
+    /// global statistics and simulations need.
+    ///
+    /// The sphere model has a radius of 1.0 unit.  Its center is at the
+    /// origin and its poles lie on the @a y axis, as in the
+    /// NoiseMapBuilderSphere class.
+    ///
+    /// <b>Pixels</b>
+    ///
+    /// The grid divides the sphere into 12 base pixels, and each base pixel
+    /// into @a nside by @a nside pixels, where @a nside is 2 to the power of
+    /// the order passed to the SetOrder() method.  The spacing of the
+    /// pixels is nearly the same everywhere, so a HEALPix grid needs about
+    /// two thirds of the points of a latitude/longitude noise map with the
+    /// same spacing at the equator, and none of its crowding at the poles.
+    ///
+    /// The noise map stores the base pixels one above the other, so it is
+    /// @a nside points wide and 12 @a nside points tall.  Base pixel @a f
+    /// occupies the rows from @a f * @a nside to (@a f + 1) * @a nside - 1,
+    /// and the x and y coordinates within it are the @a ix and @a iy
+    /// coordinates of the HEALPix pixel.  The whole noise map is stored
+    /// with no padding, and its rows are built in parallel like the rows of
+    /// any other noise map.
+    ///
+    /// <b>Nested indexing and coarsening</b>
+    ///
+    /// The GetNestedIndex() method returns the index of a point in the
+    /// HEALPix nested scheme, and the GetNestedValues() method copies the
+    /// whole noise map into a one-dimensional array in nested order.  In
+    /// that order the four pixels that make up pixel @a p of the next lower
+    /// order are the pixels 4 @a p to 4 @a p + 3.  In the noise map they
+    /// are a 2 by 2 block, so the Coarsen() method builds the noise map of
+    /// the next lower order by averaging each block, without evaluating the
+    /// source module again.
+    class NoiseMapBuilderHealpix: public NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilderHealpix ();
+
+        virtual void Build ();
+
+        /// Builds the noise map of the next lower order from a noise map of
+        /// this builder.
+        ///
+        /// @param sourceNoiseMap The noise map to coarsen.
+        /// @param destNoiseMap The noise map that receives the average of
+        /// each 2 by 2 block of the source noise map.
+        ///
+        /// @pre The source noise map has an order of at least 1, so it is
+        /// @a nside points wide and 12 @a nside points tall for a power of
+        /// two @a nside of at least 2.
+        /// @pre The source and destination noise maps are not the same
+        /// object.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// Each value of the destination noise map is the average of the
+        /// source module over its pixel, up to the resolution of the source
+        /// noise map.
+        static void Coarsen (const NoiseMap& sourceNoiseMap,
+          NoiseMap& destNoiseMap);
+
+        /// Returns the index of a point of the noise map in the HEALPix
+        /// nested scheme.
+        ///
+        /// @param nside The width of the noise map, a power of two.
+        /// @param x The x coordinate of the point.
+        /// @param y The y coordinate of the point.
+        ///
+        /// @returns The nested index of the point.
+        static noise::int64 GetNestedIndex (noise::int64 nside,
+          noise::int64 x, noise::int64 y);
+
+        /// Copies a noise map of this builder into an array in the order of
+        /// the HEALPix nested scheme.
+        ///
+        /// @param sourceNoiseMap The noise map to copy.
+        /// @param pDest The array that receives the 12 @a nside * @a nside
+        /// values of the noise map.
+        ///
+        /// @pre The source noise map is @a nside points wide and 12
+        /// @a nside points tall for a power of two @a nside.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        static void GetNestedValues (const NoiseMap& sourceNoiseMap,
+          float* pDest);
+
+        /// Returns the order of the grid.
+        ///
+        /// @returns The base-2 logarithm of the width of the noise map, or
+        /// -1 if the width is not a power of two.
+        int GetOrder () const;
+
+        /// Sets the order of the grid.
+        ///
+        /// @param order The order of the grid.
+        ///
+        /// @pre The order ranges from 0 to
+        /// noise::utils::HEALPIX_MAX_ORDER.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// This method sets the size of the destination noise map to 2 to
+        /// the power of @a order points wide and 12 times as many points
+        /// tall.
+        void SetOrder (int order);
+
+      protected:
+
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+    };
+
+    /// Builds a planar noise map.
+    ///
+    /// This class builds a noise map by filling it with coherent-noise values
+    /// generated from the surface of a plane.
+    ///
+    /// This class describes these input values using (x, z) coordinates.
+    /// Their y coordinates are always 0.0.
+    ///
+    /// The application must provide the lower and upper x coordinate bounds
+    /// of the noise map, in units, and the lower and upper z coordinate
+    /// bounds of the noise map, in units.
+    ///
+    /// To make a tileable noise map with no seams at the edges, call the
+    /// EnableSeamless() method.
+    ///
+    /// <b>Panning</b>
+    ///
+    /// An application that pans across the plane, such as a map viewer,
+    /// can call the EnableIncremental() method.  If the new bounds of a
+    /// build are the bounds of the previous build moved by a whole number
+    /// of points in each direction, with the same spacing between points,
+    /// the Build() method moves the values it already calculated and only
+    /// calculates the values along the newly exposed edges.  Otherwise it
+    /// calculates every point as usual.
+    class NoiseMapBuilderPlane: public NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilderPlane ();
+
+        virtual void Build ();
+
+        /// Enables or disables incremental building.
+        ///
+        /// @param enable A flag that enables or disables incremental
+        /// building.
+        ///
+        /// If incremental building is enabled and the bounds of a build are
+        /// the bounds of the previous build moved by a whole number of
+        /// points, the Build() method reuses the values of the previous
+        /// build and only calculates the newly exposed points, in a single
+        /// pass.  A build stopped by the pass callback function is never
+        /// reused.  Every other
+        /// setting, including the destination noise map, its size and
+        /// storage format, the window and the source module, must be the
+        /// same as in the previous build, and no region mask may be set.
+        ///
+        /// The reused values were calculated from the coordinates of the
+        /// previous build, so they may differ from the values of a full
+        /// build by the rounding of those coordinates.
+        ///
+        /// The builder cannot detect changes to the source module's
+        /// parameters or to the contents of the destination noise map.
+        /// After such a change, call the Invalidate() method.
+        void EnableIncremental (bool enable = true)
+        {
+          m_isIncrementalEnabled = enable;
+          m_hasPrevBuild = false;
+        }
+
+        /// Enables or disables seamless tiling.
+        ///
+        /// @param enable A flag that enables or disables seamless tiling.
+        ///
+        /// Enabling seamless tiling builds a noise map with no seams at the
+        /// edges.  This allows the noise map to be tileable.
+        ///
+        /// A seamless noise map depends on its bounds as a whole, so it is
+        /// never built incrementally.
+        ///
+        /// Seamless tiling evaluates the source module four times per point
+        /// and blends the results, which also softens the contrast of the
+        /// noise near the middle of the noise map.  If the generator modules
+        /// in the source module support periods (see
+        /// noise::module::Perlin::SetPeriod()), setting each period to the
+        /// size of the bounding rectangle tiles the noise map at the normal
+        /// cost, without enabling seamless tiling.
+        void EnableSeamless (bool enable = true)
+        {
+          m_isSeamlessEnabled = enable;
+        }
+
+        /// Returns the lower x boundary of the planar noise map.
+        ///
+        /// @returns The lower x boundary of the planar noise map, in units.
+        double GetLowerXBound () const
+        {
+          return m_lowerXBound;
+        }
+
+        /// Returns the lower z boundary of the planar noise map.
+        ///
+        /// @returns The lower z boundary of the noise map, in units.
+        double GetLowerZBound () const
+        {
+          return m_lowerZBound;
+        }
+
+        /// Returns the upper x boundary of the planar noise map.
+        ///
+        /// @returns The upper x boundary of the noise map, in units.
+        double GetUpperXBound () const
+        {
+          return m_upperXBound;
+        }
+
+        /// Returns the upper z boundary of the planar noise map.
+        ///
+        /// @returns The upper z boundary of the noise map, in units.
+        double GetUpperZBound () const
+        {
+          return m_upperZBound;
+        }
+
+        /// Makes the next build calculate every point.
+        ///
+        /// Call this method after changing the parameters of the source
+        /// module, or the contents of the destination noise map, while
+        /// incremental building is enabled.
+        void Invalidate ()
+        {
+          m_hasPrevBuild = false;
+        }
+
+        /// Determines if incremental building is enabled.
+        ///
+        /// @returns
+        /// - @a true if incremental building is enabled.
+        /// - @a false if incremental building is disabled.
+        bool IsIncrementalEnabled () const
+        {
+          return m_isIncrementalEnabled;
+        }
+
+        /// Determines if seamless tiling is enabled.
+        ///
+        /// @returns
+        /// - @a true if seamless tiling is enabled.
+        /// - @a false if seamless tiling is disabled.
+        ///
+        /// Enabling seamless tiling builds a noise map with no seams at the
+        /// edges.  This allows the noise map to be tileable.
+        bool IsSeamlessEnabled () const
+        {
+          return m_isSeamlessEnabled;
+        }
+
+        /// Sets the boundaries of the planar noise map.
+        ///
+        /// @param lowerXBound The lower x boundary of the noise map, in
+        /// units.
+        /// @param upperXBound The upper x boundary of the noise map, in
+        /// units.
+        /// @param lowerZBound The lower z boundary of the noise map, in
+        /// units.
+        /// @param upperZBound The upper z boundary of the noise map, in
+        /// units.
+        ///
+        /// @pre The lower x boundary is less than the upper x boundary.
+        /// @pre The lower z boundary is less than the upper z boundary.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetBounds (double lowerXBound, double upperXBound,
+          double lowerZBound, double upperZBound)
+        {
+          if (lowerXBound >= upperXBound
+            || lowerZBound >= upperZBound) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_lowerXBound = lowerXBound;
+          m_upperXBound = upperXBound;
+          m_lowerZBound = lowerZBound;
+          m_upperZBound = upperZBound;
+        }
+
+      protected:
+
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+      private:
+
+        /// The settings of a build, which the next build compares with its
+        /// own settings to find out whether it can reuse the values.
+        struct BuildState
+        {
+          NoiseMap* pDestNoiseMap;
+          const module::Module* pSourceModule;
+          noise::int64 destWidth;
+          noise::int64 destHeight;
+          noise::int64 windowX;
+          noise::int64 windowY;
+          noise::int64 windowWidth;
+          noise::int64 windowHeight;
+          NoiseMapFormat format;
+          float quantizationScale;
+          float quantizationBias;
+          double lowerXBound;
+          double lowerZBound;
+          double upperXBound;
+          double upperZBound;
+        };
+
+        /// Fills the points of one row that the previous build did not
+        /// calculate.
+        ///
+        /// @param row The row to fill, relative to the window.
+        void BuildExposedRow (noise::int64 row) const;
+
+        /// Returns the settings of the next build.
+        BuildState GetBuildState () const;
+
+        /// Moves the values of the previous build to their positions in
+        /// the next build, if the next build can reuse them.
+        ///
+        /// @returns
+        /// - @a true if the values were moved.
+        /// - @a false if the next build must calculate every point.
+        ///
+        /// If the values were moved, this method sets the range of reused
+        /// points.
+        bool ShiftPrevBuild ();
+
+        /// A flag specifying whether the settings of the previous build
+        /// are valid.
+        bool m_hasPrevBuild;
+
+        /// A flag specifying whether incremental building is enabled.
+        bool m_isIncrementalEnabled;
+
+        /// A flag specifying whether seamless tiling is enabled.
+        bool m_isSeamlessEnabled;
+
+        /// The x coordinate of the first reused point in each row, relative
+        /// to the window.
+        noise::int64 m_keptX0;
+
+        /// The x coordinate one past the last reused point in each row,
+        /// relative to the window.
+        noise::int64 m_keptX1;
+
+        /// The first row with reused points, relative to the window.
+        noise::int64 m_keptY0;
+
+        /// The row one past the last row with reused points, relative to
+        /// the window.
+        noise::int64 m_keptY1;
+
+        /// Lower x boundary of the planar noise map, in units.
+        double m_lowerXBound;
+
+        /// Lower z boundary of the planar noise map, in units.
+        double m_lowerZBound;
+
+        /// The settings of the previous build.
+        BuildState m_prevBuild;
+
+        /// Upper x boundary of the planar noise map, in units.
+        double m_upperXBound;
+
+        /// Upper z boundary of the planar noise map, in units.
+        double m_upperZBound;
+
+    };
+
+
+    /// Builds a spherical noise map.
+    ///
+    /// This class builds a noise map by filling it with coherent-noise values
+    /// generated from the surface of a sphere.
     ///
-    /// <b>Writing the noise map</b>
+    /// This class describes these input values using a (latitude, longitude)
+    /// coordinate system.  After generating the coherent-noise value from the
+    /// input value, it then "flattens" these coordinates onto a plane so that
+    /// it can write the values into a two-dimensional noise map.
     ///
-    /// To write the noise map, perform the following steps:
-    /// - Pass the filename to the SetDestFilename() method.
-    /// - Pass a NoiseMap object to the SetSourceNoiseMap() method.
-    /// - Call the WriteDestFile() method.
+    /// The sphere model has a radius of 1.0 unit.  Its center is at the
+    /// origin.
     ///
-    /// The SetDestFilename() and SetSourceNoiseMap() methods must be called
-    /// before calling the WriteDestFile() method.
-    class WriterTER
+    /// The x coordinate in the noise map represents the longitude.  The y
+    /// coordinate in the noise map represents the latitude.  
+    ///
+    /// The application must provide the southern, northern, western, and
+    /// eastern bounds of the noise map, in degrees.
+    class NoiseMapBuilderSphere: public NoiseMapBuilder
+    {
+
+      public:
+
+        /// Constructor.
+        NoiseMapBuilderSphere ();
+
+        virtual void Build ();
+
+        /// Returns the eastern boundary of the spherical noise map.
+        ///
+        /// @returns The eastern boundary of the noise map, in degrees.
+        double GetEastLonBound () const
+        {
+          return m_eastLonBound;
+        }
+
+        /// Returns the northern boundary of the spherical noise map
+        ///
+        /// @returns The northern boundary of the noise map, in degrees.
+        double GetNorthLatBound () const
+        {
+          return m_northLatBound;
+        }
+
+        /// Returns the southern boundary of the spherical noise map
+        ///
+        /// @returns The southern boundary of the noise map, in degrees.
+        double GetSouthLatBound () const
+        {
+          return m_southLatBound;
+        }
+
+        /// Returns the western boundary of the spherical noise map
+        ///
+        /// @returns The western boundary of the noise map, in degrees.
+        double GetWestLonBound () const
+        {
+          return m_westLonBound;
+        }
+
+        /// Sets the coordinate boundaries of the noise map.
+        ///
+        /// @param southLatBound The southern boundary of the noise map, in
+        /// degrees.
+        /// @param northLatBound The northern boundary of the noise map, in
+        /// degrees.
+        /// @param westLonBound The western boundary of the noise map, in
+        /// degrees.
+        /// @param eastLonBound The eastern boundary of the noise map, in
+        /// degrees.
+        ///
+        /// @pre The southern boundary is less than the northern boundary.
+        /// @pre The western boundary is less than the eastern boundary.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetBounds (double southLatBound, double northLatBound,
+          double westLonBound, double eastLonBound)
+        {
+          if (southLatBound >= northLatBound
+            || westLonBound >= eastLonBound) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_southLatBound = southLatBound;
+          m_northLatBound = northLatBound;
+          m_westLonBound  = westLonBound ;
+          m_eastLonBound  = eastLonBound ;
+        }
+
+      protected:
+
+        virtual void FillSlab (float* pDest, noise::int64 x, noise::int64 y,
+          noise::int64 count) const;
+
+        virtual bool GetPointPosition (noise::int64 x, noise::int64 y,
+          double& inputX, double& inputY, double& inputZ) const;
+
+      private:
+
+        /// Eastern boundary of the spherical noise map, in degrees.
+        double m_eastLonBound;
+
+        /// The cosine and sine of the latitude of each row, calculated by
+        /// the Build() method.
+        AngleTable m_latTable;
+
+        /// The cosine and sine of the longitude of each column, calculated
+        /// by the Build() method.
+        AngleTable m_lonTable;
+
+        /// Northern boundary of the spherical noise map, in degrees.
+        double m_northLatBound;
+
+        /// Southern boundary of the spherical noise map, in degrees.
+        double m_southLatBound;
+
+        /// Western boundary of the spherical noise map, in degrees.
+        double m_westLonBound;
+
+    };
+
+    /// Enumerates the contents of a noise volume relative to an iso level.
+    enum VolumeContents
+    {
+
+      /// Some values of the noise volume are below the iso level and some
+      /// are at or above it.
+      VOLUME_MIXED = 0,
+
+      /// Every value of the noise volume is below the iso level.
+      VOLUME_EMPTY = 1,
+
+      /// Every value of the noise volume is at or above the iso level.
+      VOLUME_SOLID = 2
+
+    };
+
+    /// Builds a noise volume, a chunk of a three-dimensional lattice of
+    /// points.
+    ///
+    /// This class fills a noise volume with the coherent-noise values of a
+    /// source module at the points of a lattice, so a voxel engine can fill
+    /// a whole chunk with one call instead of calling the GetValue() method
+    /// of the noise module once for each voxel.
+    ///
+    /// <b>Lattice</b>
+    ///
+    /// The lattice is set by the SetOrigin() method, which gives the input
+    /// value of lattice point (0, 0, 0), and by the SetSpacing() method,
+    /// which gives the distance between adjacent lattice points along each
+    /// axis.  The SetChunk() method selects the lattice point at position
+    /// (0, 0, 0) of the noise volume, and the SetDestSize() method sets the
+    /// number of points along each axis.
+    ///
+    /// The input value of each point is calculated from the index of its
+    /// lattice point alone, so two chunks that share a face calculate
+    /// bit-identical values on that face whatever their positions.  For
+    /// chunks of @a n cells that share their faces with their neighbors,
+    /// make the noise volume @a n + 1 points wide and place the chunks at
+    /// lattice points that are multiples of @a n.
+    ///
+    /// <b>Early-out</b>
+    ///
+    /// Most chunks of a voxel world lie wholly underground or wholly in the
+    /// air.  The GetContents() method returns whether the values of the
+    /// last noise volume that was built lie below the iso level set by the
+    /// SetIsoLevel() method (empty), at or above it (solid), or both.
+    ///
+    /// If the application passes the largest rate of change of the output
+    /// value of the source module to the SetMaxSlope() method, the Build()
+    /// method first calculates the source module at a coarse grid of
+    /// points, spaced GetProbeStep() points apart.  No point of the noise
+    /// volume is farther than half the diagonal of a grid cell from a grid
+    /// point, so the slope bounds how far its value can lie from the values
+    /// at the grid.  If that bound proves the noise volume to be wholly
+    /// empty or wholly solid, the Build() method fills the noise volume with
+    /// the grid value farthest from the iso level instead of calculating
+    /// each point, so the values still lie on the proven side of the iso
+    /// level.  The early-out is only as sound as the slope: a slope that is
+    /// too small can classify a chunk that contains a surface as uniform.
+    ///
+    /// <b>Multithreading</b>
+    ///
+    /// The Build() method splits the rows of the noise volume, ordered by
+    /// @a z and then by @a y, into bands and submits them to the executor
+    /// set by SetExecutor(), or to the default executor.  A band may start
+    /// or end within a layer.  Each row of a band is calculated as a run of
+    /// points with the same @a y and @a z coordinates, taking the @a x
+    /// coordinates from a table calculated once per build.  Before the
+    /// build, the noise::module::Resample noise modules in the source module
+    /// graph are prepared for the box that holds the noise volume.
+    class NoiseVolumeBuilder
     {
 
-      public:
+      public:
+
+        /// Constructor.
+        NoiseVolumeBuilder ();
+
+        /// Builds the noise volume.
+        ///
+        /// @pre SetDestNoiseVolume() was previously called.
+        /// @pre SetSourceModule() was previously called.
+        /// @pre The width, height and depth values specified by
+        /// SetDestSize() are positive.
+        /// @pre The width, height and depth values specified by
+        /// SetDestSize() do not exceed the maximum possible size of a
+        /// raster.
+        ///
+        /// @post The original contents of the destination noise volume is
+        /// destroyed.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// If this method is successful, the destination noise volume
+        /// contains the coherent-noise values from the noise module
+        /// specified by SetSourceModule(), unless the early-out proved the
+        /// noise volume to be uniform, in which case every point holds the
+        /// value of the coarse grid farthest from the iso level: the lowest
+        /// value if the noise volume is empty, or the highest if it is
+        /// solid.
+        void Build ();
+
+        /// Returns the number of points that the last build calculated.
+        ///
+        /// @returns The number of times the last call to the Build() method
+        /// calculated a point with the source module, including the points
+        /// of the coarse grid of the early-out.
+        noise::int64 GetBuiltPointCount () const
+        {
+          return m_builtPointCount;
+        }
+
+        /// Returns the x coordinate of the chunk.
+        ///
+        /// @returns The x index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        noise::int64 GetChunkX () const
+        {
+          return m_chunkX;
+        }
+
+        /// Returns the y coordinate of the chunk.
+        ///
+        /// @returns The y index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        noise::int64 GetChunkY () const
+        {
+          return m_chunkY;
+        }
+
+        /// Returns the z coordinate of the chunk.
+        ///
+        /// @returns The z index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        noise::int64 GetChunkZ () const
+        {
+          return m_chunkZ;
+        }
+
+        /// Returns the contents of the last noise volume that was built.
+        ///
+        /// @returns Whether the values of the noise volume lie below the iso
+        /// level, at or above it, or both, or VOLUME_MIXED if no noise
+        /// volume was built.
+        ///
+        /// If the early-out proved the noise volume to be uniform, this
+        /// method returns VOLUME_EMPTY or VOLUME_SOLID, and every point of
+        /// the noise volume holds a single value on that side of the iso
+        /// level.
+        VolumeContents GetContents () const
+        {
+          return m_contents;
+        }
+
+        /// Returns the depth of the destination noise volume.
+        ///
+        /// @returns The depth of the destination noise volume, in points.
+        noise::int64 GetDestDepth () const
+        {
+          return m_destDepth;
+        }
+
+        /// Returns the height of the destination noise volume.
+        ///
+        /// @returns The height of the destination noise volume, in points.
+        noise::int64 GetDestHeight () const
+        {
+          return m_destHeight;
+        }
+
+        /// Returns the width of the destination noise volume.
+        ///
+        /// @returns The width of the destination noise volume, in points.
+        noise::int64 GetDestWidth () const
+        {
+          return m_destWidth;
+        }
+
+        /// Returns the executor that runs the layers of the noise volume.
+        ///
+        /// @returns The executor passed to SetExecutor(), the default
+        /// executor if none was passed, or @a NULL if the layers run on the
+        /// calling thread.
+        Executor* GetExecutor () const
+        {
+          return (m_pExecutor != NULL)? m_pExecutor: GetDefaultExecutor ();
+        }
+
+        /// Returns the iso level that separates empty values from solid
+        /// values.
+        ///
+        /// @returns The iso level.
+        double GetIsoLevel () const
+        {
+          return m_isoLevel;
+        }
+
+        /// Returns the largest rate of change of the output value of the
+        /// source module.
+        ///
+        /// @returns The largest change of the output value per unit of
+        /// distance, or a negative value if the early-out is disabled.
+        double GetMaxSlope () const
+        {
+          return m_maxSlope;
+        }
+
+        /// Returns the x coordinate of the origin of the lattice.
+        ///
+        /// @returns The @a x coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double GetOriginX () const
+        {
+          return m_originX;
+        }
+
+        /// Returns the y coordinate of the origin of the lattice.
+        ///
+        /// @returns The @a y coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double GetOriginY () const
+        {
+          return m_originY;
+        }
+
+        /// Returns the z coordinate of the origin of the lattice.
+        ///
+        /// @returns The @a z coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double GetOriginZ () const
+        {
+          return m_originZ;
+        }
+
+        /// Finds the input value of the source module at a point of the
+        /// noise volume.
+        ///
+        /// @param x The x coordinate of the point.
+        /// @param y The y coordinate of the point.
+        /// @param z The z coordinate of the point.
+        /// @param inputX On exit, the @a x coordinate of the input value.
+        /// @param inputY On exit, the @a y coordinate of the input value.
+        /// @param inputZ On exit, the @a z coordinate of the input value.
+        ///
+        /// The coordinates are positions in the noise volume, relative to
+        /// the chunk.  They need not lie within the noise volume.
+        void GetPointPosition (noise::int64 x, noise::int64 y,
+          noise::int64 z, double& inputX, double& inputY, double& inputZ)
+          const
+        {
+          inputX = GetLatticeCoord (m_originX, m_spacingX, m_chunkX + x);
+          inputY = GetLatticeCoord (m_originY, m_spacingY, m_chunkY + y);
+          inputZ = GetLatticeCoord (m_originZ, m_spacingZ, m_chunkZ + z);
+        }
+
+        /// Returns the spacing of the points of the early-out's coarse
+        /// grid.
+        ///
+        /// @returns The spacing of the points, in points of the noise
+        /// volume.
+        noise::int64 GetProbeStep () const
+        {
+          return m_probeStep;
+        }
+
+        /// Returns the distance between adjacent lattice points along the
+        /// @a x axis.
+        ///
+        /// @returns The spacing along the @a x axis, in units.
+        double GetSpacingX () const
+        {
+          return m_spacingX;
+        }
 
-        /// Constructor.
-        WriterTER ():
-          m_metersPerPoint (DEFAULT_METERS_PER_POINT),
-          m_pSourceNoiseMap (NULL)
+        /// Returns the distance between adjacent lattice points along the
+        /// @a y axis.
+        ///
+        /// @returns The spacing along the @a y axis, in units.
+        double GetSpacingY () const
         {
+          return m_spacingY;
         }
 
-        /// Returns the name of the file to write.
+        /// Returns the distance between adjacent lattice points along the
+        /// @a z axis.
         ///
-        /// @returns The name of the file to write.
-        std::string GetDestFilename () const
+        /// @returns The spacing along the @a z axis, in units.
+        double GetSpacingZ () const
         {
-          return m_destFilename;
+          return m_spacingZ;
         }
 
-        /// Returns the distance separating adjacent points in the noise map,
-        /// in meters.
+        /// Sets the position of the chunk on the lattice.
         ///
-        /// @returns The distance separating adjacent points in the noise map.
-        float GetMetersPerPoint () const
+        /// @param x The x index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        /// @param y The y index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        /// @param z The z index of the lattice point at position (0, 0, 0)
+        /// of the noise volume.
+        void SetChunk (noise::int64 x, noise::int64 y, noise::int64 z)
         {
-          return m_metersPerPoint;
+          m_chunkX = x;
+          m_chunkY = y;
+          m_chunkZ = z;
         }
 
-        /// Sets the name of the file to write.
+        /// Sets the destination noise volume.
         ///
-        /// @param filename The name of the file to write.
+        /// @param destNoiseVolume The destination noise volume.
         ///
-        /// Call this method before calling the WriteDestFile() method.
-        void SetDestFilename (const std::string& filename)
+        /// The destination noise volume will contain the coherent-noise
+        /// values from the source module after a successful call to the
+        /// Build() method.
+        ///
+        /// The destination noise volume must exist throughout the lifetime
+        /// of this object unless another noise volume replaces that noise
+        /// volume.
+        void SetDestNoiseVolume (NoiseVolume& destNoiseVolume)
         {
-          m_destFilename = filename;
+          m_pDestNoiseVolume = &destNoiseVolume;
         }
 
-        /// Sets the distance separating adjacent points in the noise map, in
-        /// meters.
+        /// Sets the size of the destination noise volume.
         ///
-        /// @param metersPerPoint The distance separating adjacent points in
-        /// the noise map.
-        void SetMetersPerPoint (float metersPerPoint)
+        /// @param destWidth The width of the destination noise volume, in
+        /// points.
+        /// @param destHeight The height of the destination noise volume, in
+        /// points.
+        /// @param destDepth The depth of the destination noise volume, in
+        /// points.
+        ///
+        /// This method does not change the size of the destination noise
+        /// volume until the Build() method is called.
+        void SetDestSize (noise::int64 destWidth, noise::int64 destHeight,
+          noise::int64 destDepth)
         {
-          m_metersPerPoint = metersPerPoint;
+          m_destWidth  = destWidth ;
+          m_destHeight = destHeight;
+          m_destDepth  = destDepth ;
         }
 
-        /// Sets the noise map object that is written to the file.
+        /// Sets the executor that runs the layers of the noise volume.
         ///
-        /// @param sourceNoiseMap The noise map object to write.
+        /// @param pExecutor The executor, or @a NULL to use the default
+        /// executor.
         ///
-        /// This object only stores a pointer to a noise map object, so make
-        /// sure this object exists before calling the WriteDestFile() method.
-        void SetSourceNoiseMap (NoiseMap& sourceNoiseMap)
+        /// The source module is then called from several threads at the
+        /// same time, so every noise module connected to it must be safe to
+        /// call concurrently.  This is true for every noise module in
+        /// libnoise except noise::module::Cache.
+        ///
+        /// The executor must exist throughout the lifetime of this object
+        /// unless another executor replaces that executor.
+        void SetExecutor (Executor* pExecutor)
         {
-          m_pSourceNoiseMap = &sourceNoiseMap;
+          m_pExecutor = pExecutor;
         }
 
-        /// Writes the contents of the noise map object to the file.
+        /// Sets the iso level that separates empty values from solid
+        /// values.
         ///
-        /// @pre SetDestFilename() has been previously called.
-        /// @pre SetSourceNoiseMap() has been previously called.
+        /// @param isoLevel The iso level.
+        ///
+        /// Values below the iso level are empty, and values at or above it
+        /// are solid.  The default iso level is 0.0.
+        void SetIsoLevel (double isoLevel)
+        {
+          m_isoLevel = isoLevel;
+        }
+
+        /// Sets the largest rate of change of the output value of the
+        /// source module, which enables the early-out.
+        ///
+        /// @param maxSlope The largest change of the output value per unit
+        /// of distance between two input values, or a negative value to
+        /// disable the early-out.
+        ///
+        /// The early-out is disabled by default.
+        void SetMaxSlope (double maxSlope)
+        {
+          m_maxSlope = maxSlope;
+        }
+
+        /// Sets the origin of the lattice.
+        ///
+        /// @param x The @a x coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        /// @param y The @a y coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        /// @param z The @a z coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        void SetOrigin (double x, double y, double z)
+        {
+          m_originX = x;
+          m_originY = y;
+          m_originZ = z;
+        }
+
+        /// Sets the spacing of the points of the early-out's coarse grid.
+        ///
+        /// @param step The spacing of the points, in points of the noise
+        /// volume.
+        ///
+        /// @pre The step is positive.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
-        /// @throw noise::ExceptionOutOfMemory Out of memory.
-        /// @throw noise::ExceptionUnknown An unknown exception occurred.
-        /// Possibly the file could not be written.
         ///
-        /// This method encodes the contents of the noise map and writes it to
-        /// a file.  Before calling this method, call the SetSourceNoiseMap()
-        /// method to specify the noise map, then call the SetDestFilename()
-        /// method to specify the name of the file to write.
+        /// A larger step calculates fewer points, but the early-out then
+        /// needs the values to lie further from the iso level.
+        void SetProbeStep (noise::int64 step)
+        {
+          if (step <= 0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_probeStep = step;
+        }
+
+        /// Sets the source module.
         ///
-        /// This object assumes that the noise values represent elevations in
-        /// meters.
-        void WriteDestFile ();
+        /// @param sourceModule The source module.
+        ///
+        /// This object fills in a noise volume with the coherent-noise
+        /// values from this source module.
+        ///
+        /// The source module must exist throughout the lifetime of this
+        /// object unless another noise module replaces that noise module.
+        void SetSourceModule (const module::Module& sourceModule)
+        {
+          m_pSourceModule = &sourceModule;
+        }
+
+        /// Sets the distance between adjacent lattice points.
+        ///
+        /// @param x The spacing along the @a x axis, in units.
+        /// @param y The spacing along the @a y axis, in units.
+        /// @param z The spacing along the @a z axis, in units.
+        ///
+        /// @pre Each spacing is positive.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetSpacing (double x, double y, double z)
+        {
+          if (!(x > 0.0 && y > 0.0 && z > 0.0)) {
+            throw noise::ExceptionInvalidParam ();
+          }
+
+          m_spacingX = x;
+          m_spacingY = y;
+          m_spacingZ = z;
+        }
 
       protected:
-    
-        /// Calculates the width of one horizontal line in the file, in bytes.
+
+        /// Fills one row of the destination noise volume.
         ///
-        /// @param width The width of the noise map, in points.
+        /// @param row The row to fill; row @a y of layer @a z is row
+        /// @a z * height + @a y.
         ///
-        /// @returns The width of one horizontal line in the file.
-        int CalcWidthByteCount (int width) const;
+        /// This method also records whether the row holds empty or solid
+        /// values.
+        void BuildRow (noise::int64 row) const;
+
+        /// Returns the coordinate of a lattice point along one axis.
+        ///
+        /// @param origin The coordinate of lattice point 0.
+        /// @param spacing The distance between adjacent lattice points.
+        /// @param index The index of the lattice point.
+        ///
+        /// @returns The coordinate of the lattice point.
+        static double GetLatticeCoord (double origin, double spacing,
+          noise::int64 index)
+        {
+          return origin + (double)index * spacing;
+        }
+
+        /// Returns the number of points along one axis of the coarse grid
+        /// of the early-out.
+        ///
+        /// @param size The number of points along that axis of the noise
+        /// volume.
+        ///
+        /// @returns The number of points of the grid, including a point on
+        /// each face of the noise volume.
+        noise::int64 GetProbeCount (noise::int64 size) const
+        {
+          return (size - 1 + m_probeStep - 1) / m_probeStep + 1;
+        }
+
+        /// Finds the index in the noise volume of a point of the coarse grid
+        /// of the early-out.
+        ///
+        /// @param index The index of the point along one axis of the grid.
+        /// @param size The number of points along that axis of the noise
+        /// volume.
+        ///
+        /// @returns The index of the point, clamped so that the last point
+        /// of the grid lies on the far face of the noise volume.
+        noise::int64 GetProbeIndex (noise::int64 index, noise::int64 size)
+          const
+        {
+          return GetMin (index * m_probeStep, size - 1);
+        }
+
+        /// Calculates the points in one layer of the coarse grid of the
+        /// early-out and records the lowest and highest values.
+        ///
+        /// @param index The index of the layer among the layers of the
+        /// grid.
+        void ProbeLayer (noise::int64 index) const;
+
+        /// The number of points that the last build calculated.
+        noise::int64 m_builtPointCount;
+
+        /// The x index of the lattice point at position (0, 0, 0) of the
+        /// noise volume.
+        noise::int64 m_chunkX;
+
+        /// The y index of the lattice point at position (0, 0, 0) of the
+        /// noise volume.
+        noise::int64 m_chunkY;
+
+        /// The z index of the lattice point at position (0, 0, 0) of the
+        /// noise volume.
+        noise::int64 m_chunkZ;
+
+        /// The contents of the last noise volume that was built.
+        VolumeContents m_contents;
+
+        /// Depth of the destination noise volume, in points.
+        noise::int64 m_destDepth;
+
+        /// Height of the destination noise volume, in points.
+        noise::int64 m_destHeight;
+
+        /// Width of the destination noise volume, in points.
+        noise::int64 m_destWidth;
+
+        /// The iso level that separates empty values from solid values.
+        double m_isoLevel;
+
+        /// The largest rate of change of the output value of the source
+        /// module, or a negative value if the early-out is disabled.
+        double m_maxSlope;
+
+        /// The @a x coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double m_originX;
+
+        /// The @a y coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double m_originY;
+
+        /// The @a z coordinate of the input value of lattice point
+        /// (0, 0, 0).
+        double m_originZ;
+
+        /// Destination noise volume that will contain the coherent-noise
+        /// values.
+        NoiseVolume* m_pDestNoiseVolume;
+
+        /// The executor that runs the layers, or @a NULL to use the default
+        /// executor.
+        Executor* m_pExecutor;
+
+        /// Source noise module that will generate the coherent-noise values.
+        const module::Module* m_pSourceModule;
+
+        /// The highest value in each layer of the coarse grid of the
+        /// early-out.
+        mutable std::vector<double> m_probeMaxes;
+
+        /// The lowest value in each layer of the coarse grid of the
+        /// early-out.
+        mutable std::vector<double> m_probeMins;
+
+        /// The spacing of the points of the early-out's coarse grid, in
+        /// points of the noise volume.
+        noise::int64 m_probeStep;
+
+        /// For each row of the last build, a combination of the flags
+        /// VOLUME_EMPTY and VOLUME_SOLID for the values the row holds.
+        mutable std::vector<noise::uint8> m_rowContents;
+
+        /// Distance between adjacent lattice points along the @a x axis.
+        double m_spacingX;
+
+        /// Distance between adjacent lattice points along the @a y axis.
+        double m_spacingY;
+
+        /// Distance between adjacent lattice points along the @a z axis.
+        double m_spacingZ;
+
+        /// The @a x coordinate of the input value of each column of the
+        /// noise volume, calculated by the Build() method.
+        std::vector<double> m_xCoords;
+
+    };
+
+    /// Abstract base class for an object that receives the tiles of a noise
+    /// map built by a TiledNoiseMapBuilder object.
+    ///
+    /// A tiled noise-map builder passes each finished tile to the
+    /// WriteTile() method, then reuses the tile's memory for the next tile.
+    /// A sink that needs the values after WriteTile() returns must copy
+    /// them.
+    class TileSink
+    {
+
+      public:
+
+        /// Destructor.
+        virtual ~TileSink ()
+        {
+        }
+
+        /// Called once before the first tile of a noise map is written.
+        ///
+        /// @param width The width of the whole noise map, in points.
+        /// @param height The height of the whole noise map, in points.
+        ///
+        /// @throw noise::ExceptionUnknown An error occurred while preparing
+        /// the sink.
+        virtual void BeginMap (noise::int64 /* width */,
+          noise::int64 /* height */)
+        {
+        }
+
+        /// Called once after the last tile of a noise map is written.
+        ///
+        /// @throw noise::ExceptionUnknown An error occurred while finishing
+        /// the sink.
+        virtual void EndMap ()
+        {
+        }
+
+        /// Receives a finished tile.
+        ///
+        /// @param tile The tile.
+        /// @param x The x coordinate of the lower-left corner of the tile in
+        /// the whole noise map.
+        /// @param y The y coordinate of the lower-left corner of the tile in
+        /// the whole noise map.
+        ///
+        /// @throw noise::ExceptionUnknown An error occurred while writing
+        /// the tile.
+        virtual void WriteTile (const NoiseMap& tile, noise::int64 x,
+          noise::int64 y) = 0;
+
+    };
+
+    /// A pointer to a callback function used by the TileSinkCallback class.
+    ///
+    /// The parameters are the finished tile, the coordinates of its
+    /// lower-left corner in the whole noise map, and the context pointer
+    /// passed to the TileSinkCallback constructor.
+    typedef void(*TileCallback) (const NoiseMap& tile, noise::int64 x,
+      noise::int64 y, void* pContext);
+
+    /// Tile sink that passes each tile to a callback function.
+    class TileSinkCallback: public TileSink
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// @param pCallback The callback function.
+        /// @param pContext A pointer that is passed to the callback function.
+        TileSinkCallback (TileCallback pCallback, void* pContext = NULL):
+          m_pCallback (pCallback),
+          m_pContext (pContext)
+        {
+        }
+
+        virtual void WriteTile (const NoiseMap& tile, noise::int64 x,
+          noise::int64 y)
+        {
+          if (m_pCallback != NULL) {
+            m_pCallback (tile, x, y, m_pContext);
+          }
+        }
+
+      private:
+
+        /// The callback function.
+        TileCallback m_pCallback;
+
+        /// The pointer passed to the callback function.
+        void* m_pContext;
+
+    };
+
+    /// Tile sink that writes the whole noise map to a raw file.
+    ///
+    /// The file contains the values of the noise map as 32-bit IEEE
+    /// floating-point numbers in the byte order of the host, row by row
+    /// starting at the lower-left corner, with no header.  Each tile is
+    /// written to its place in the file as soon as it is finished, so the
+    /// whole noise map never needs to fit in memory.
+    class TileSinkRawFile: public TileSink
+    {
+
+      public:
+
+        /// Constructor.
+        TileSinkRawFile ();
+
+        /// Destructor.
+        virtual ~TileSinkRawFile ();
+
+        /// Returns the name of the file to write.
+        ///
+        /// @returns The name of the file to write.
+        std::string GetDestFilename () const
+        {
+          return m_destFilename;
+        }
+
+        /// Sets the name of the file to write.
+        ///
+        /// @param filename The name of the file to write.
+        ///
+        /// Call this method before building the noise map.
+        void SetDestFilename (const std::string& filename)
+        {
+          m_destFilename = filename;
+        }
+
+        virtual void BeginMap (noise::int64 width, noise::int64 height);
+
+        virtual void EndMap ();
+
+        virtual void WriteTile (const NoiseMap& tile, noise::int64 x,
+          noise::int64 y);
+
+      private:
+
+        /// Copy constructor.  Not implemented.
+        TileSinkRawFile (const TileSinkRawFile& rhs);
+
+        /// Assignment operator.  Not implemented.
+        TileSinkRawFile& operator= (const TileSinkRawFile& rhs);
 
         /// Name of the file to write.
         std::string m_destFilename;
 
-        /// The distance separating adjacent points in the noise map, in
-        /// meters.
-        float m_metersPerPoint;
+        /// The file stream, or @a NULL if no noise map is being written.
+        std::fstream* m_pStream;
 
-        /// A pointer to the noise map that will be written to the file.
-        NoiseMap* m_pSourceNoiseMap;
+        /// Width of the whole noise map, in points.
+        noise::int64 m_width;
 
     };
 
-    /// Abstract base class for a noise-map builder
+    /// A noise map that stores its values compressed in tiles.
     ///
-    /// A builder class builds a noise map by filling it with coherent-noise
-    /// values generated from the surface of a three-dimensional mathematical
-    /// object.  Each builder class defines a specific three-dimensional
-    /// surface, such as a cylinder, sphere, or plane.
+    /// Large parts of many noise maps barely vary, such as the oceans of a
+    /// planet or flat plains.  This class divides a noise map into tiles
+    /// and compresses each tile on its own, so that more of a world fits in
+    /// memory.  Tiles are decompressed on access into a small cache of
+    /// decoded tiles.
     ///
-    /// A builder class describes these input values using a coordinate system
-    /// applicable for the mathematical object (e.g., a latitude/longitude
-    /// coordinate system for the spherical noise-map builder.)  It then
-    /// "flattens" these coordinates onto a plane so that it can write the
-    /// coherent-noise values into a two-dimensional noise map.
+    /// <b>Compression</b>
     ///
-    /// <b>Building the Noise Map</b>
+    /// A tile whose values are all the same is stored as a single value.
+    /// Any other tile is stored as the difference between each value and
+    /// its left neighbor (or, at the start of a row, the value below it),
+    /// bit-packed row by row with the fewest bits that hold every
+    /// difference in that row.
     ///
-    /// To build the noise map, perform the following steps:
-    /// - Pass the bounding coordinates to the SetBounds() method.
-    /// - Pass the noise map size, in points, to the SetDestSize() method.
-    /// - Pass a NoiseMap object to the SetDestNoiseMap() method.
-    /// - Pass a noise module (derived from noise::module::Module) to the
-    ///   SetSourceModule() method.
-    /// - Call the Build() method.
+    /// By default the values are stored losslessly.  Pass a tolerance to
+    /// SetTolerance() to round each value to a multiple of twice the
+    /// tolerance before it is stored; the differences then need far fewer
+    /// bits, and no value changes by more than the tolerance, apart from the
+    /// rounding of the stored @a float.  A tile that holds an infinity, a
+    /// NaN, or a value too large to count in multiples of twice the
+    /// tolerance is stored losslessly instead.
     ///
-    /// You may also pass a callback function to the SetCallback() method.
-    /// The Build() method calls this callback function each time it fills a
-    /// row of the noise map with coherent-noise values.  This callback
-    /// function has a single integer parameter that contains a count of the
-    /// rows that have been completed.  It returns void.
+    /// <b>Building the noise map</b>
+    ///
+    /// This class is a tile sink, so pass it to the SetTileSink() method of
+    /// a TiledNoiseMapBuilder object to build a compressed noise map
+    /// without ever holding the whole noise map in memory.  For the best
+    /// results, make the tile size of the tiled noise-map builder a
+    /// multiple of the tile size of this object; otherwise, tiles that are
+    /// written in several parts are decompressed and compressed again.  To
+    /// compress a noise map that is already in memory, call the Compress()
+    /// method.
     ///
-    /// Note that SetBounds() is not defined in the abstract base class; it is
-    /// only defined in the derived classes.  This is because each model uses
-    /// a different coordinate system.
-    class NoiseMapBuilder
+    /// <b>Rendering the noise map</b>
+    ///
+    /// Call the DecompressRegion() method to decompress the part of the
+    /// noise map on screen into a noise map, then pass that noise map to
+    /// a renderer.  When lighting is enabled, decompress a margin of one
+    /// point around the part on screen so that the edges are lit
+    /// correctly.
+    ///
+    /// Several threads may read the same compressed noise map at the same
+    /// time.
+    class CompressedNoiseMap: public TileSink
     {
 
       public:
 
         /// Constructor.
-        NoiseMapBuilder ();
+        ///
+        /// The noise map is empty.  The tiles are 64 x 64 points, and the
+        /// cache holds 16 decoded tiles.
+        CompressedNoiseMap ();
 
-        /// Builds the noise map.
+        /// Destructor.
+        virtual ~CompressedNoiseMap ();
+
+        /// Compresses a noise map.
         ///
-        /// @pre SetBounds() was previously called.
-        /// @pre SetDestNoiseMap() was previously called.
-        /// @pre SetSourceModule() was previously called.
-        /// @pre The width and height values specified by SetDestSize() are
-        /// positive.
-        /// @pre The width and height values specified by SetDestSize() do not
-        /// exceed the maximum possible width and height for the noise map.
+        /// @param source The noise map to compress.
         ///
-        /// @post The original contents of the destination noise map is
-        /// destroyed.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// This object takes the size and the values of the source noise
+        /// map, which may store its values in any format.
+        void Compress (const NoiseMap& source);
+
+        /// Decompresses a rectangle of the noise map into another noise
+        /// map.
+        ///
+        /// @param dest The noise map that receives the values.
+        /// @param x The x coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param y The y coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param width The width of the rectangle.
+        /// @param height The height of the rectangle.
+        ///
+        /// @pre The width and height are not negative.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
         /// @throw noise::ExceptionOutOfMemory Out of memory.
         ///
-        /// If this method is successful, the destination noise map contains
-        /// the coherent-noise values from the noise module specified by
-        /// SetSourceModule().
-        virtual void Build () = 0;
+        /// The destination noise map is resized to the size of the
+        /// rectangle.  Positions of the rectangle outside this noise map
+        /// receive the border value.
+        void DecompressRegion (NoiseMap& dest, noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
 
-        /// Returns the height of the destination noise map.
+        /// Returns the allocator of the compressed tiles and the cache.
         ///
-        /// @returns The height of the destination noise map, in points.
+        /// @returns The allocator.
+        noise::Allocator* GetAllocator () const;
+
+        /// Returns the value used for all positions outside of the noise
+        /// map.
         ///
-        /// This object does not change the height in the destination noise
-        /// map object until the Build() method is called.
-        double GetDestHeight () const
-        {
-          return m_destHeight;
-        }
+        /// @returns The value used for all positions outside of the noise
+        /// map.
+        float GetBorderValue () const;
 
-        /// Returns the width of the destination noise map.
+        /// Returns the number of decoded tiles that the cache holds.
         ///
-        /// @returns The width of the destination noise map, in points.
+        /// @returns The number of decoded tiles that the cache holds.
+        size_t GetCacheSize () const;
+
+        /// Returns the amount of memory used by the compressed tiles.
         ///
-        /// This object does not change the height in the destination noise
-        /// map object until the Build() method is called.
-        double GetDestWidth () const
-        {
-          return m_destWidth;
-        }
+        /// @returns The number of bytes used by the compressed tiles and
+        /// the table of tiles.  The cache is not included.
+        size_t GetCompressedSize () const;
 
-        /// Sets the callback function that Build() calls each time it fills a
-        /// row of the noise map with coherent-noise values.
+        /// Returns the number of tiles stored as a single value.
         ///
-        /// @param pCallback The callback function.
+        /// @returns The number of constant tiles.
+        noise::int64 GetConstantTileCount () const;
+
+        /// Returns the height of the noise map.
         ///
-        /// This callback function has a single integer parameter that
-        /// contains a count of the rows that have been completed.  It returns
-        /// void.  Pass a function with this signature to the SetCallback()
-        /// method.
-        void SetCallback (NoiseMapCallback pCallback);
+        /// @returns The height of the noise map.
+        noise::int64 GetHeight () const;
 
-        /// Sets the destination noise map.
+        /// Returns the height of a tile.
         ///
-        /// @param destNoiseMap The destination noise map.
+        /// @returns The height of a tile, in points.
+        noise::int64 GetTileHeight () const;
+
+        /// Returns the width of a tile.
         ///
-        /// The destination noise map will contain the coherent-noise values
-        /// from this noise map after a successful call to the Build() method.
+        /// @returns The width of a tile, in points.
+        noise::int64 GetTileWidth () const;
+
+        /// Returns the tolerance of the compression.
         ///
-        /// The destination noise map must exist throughout the lifetime of
-        /// this object unless another noise map replaces that noise map.
-        void SetDestNoiseMap (NoiseMap& destNoiseMap)
-        {
-          m_pDestNoiseMap = &destNoiseMap;
-        }
+        /// @returns The largest change to a value made by the compression,
+        /// or 0 if the values are stored losslessly.
+        float GetTolerance () const;
 
-        /// Sets the source module.
+        /// Returns a value from the specified position in the noise map.
         ///
-        /// @param sourceModule The source module.
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
         ///
-        /// This object fills in a noise map with the coherent-noise values
-        /// from this source module.
+        /// @returns The value at that position.
         ///
-        /// The source module must exist throughout the lifetime of this
-        /// object unless another noise module replaces that noise module.
-        void SetSourceModule (const module::Module& sourceModule)
-        {
-          m_pSourceModule = &sourceModule;
-        }
+        /// This method returns the border value if the coordinates exist
+        /// outside of the noise map.  The tile that holds the position is
+        /// decoded into the cache if it is not already there.
+        float GetValue (noise::int64 x, noise::int64 y) const;
 
-        /// Sets the size of the destination noise map.
+        /// Returns the width of the noise map.
         ///
-        /// @param destWidth The width of the destination noise map, in
-        /// points.
-        /// @param destHeight The height of the destination noise map, in
-        /// points.
+        /// @returns The width of the noise map.
+        noise::int64 GetWidth () const;
+
+        /// Sets the allocator of the compressed tiles and the cache.
         ///
-        /// This method does not change the size of the destination noise map
-        /// until the Build() method is called.
-        void SetDestSize (int destWidth, int destHeight)
-        {
-          m_destWidth  = destWidth ;
-          m_destHeight = destHeight;
-        }
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The compressed tiles are moved into memory from the new
+        /// allocator, and the cache is emptied.
+        void SetAllocator (noise::Allocator* pAllocator);
 
-      protected:
+        /// Sets the value to use for all positions outside of the noise
+        /// map.
+        ///
+        /// @param borderValue The value to use for all positions outside of
+        /// the noise map.
+        void SetBorderValue (float borderValue);
 
-        /// The callback function that Build() calls each time it fills a row
-        /// of the noise map with coherent-noise values.
+        /// Sets the number of decoded tiles that the cache holds.
         ///
-        /// This callback function has a single integer parameter that
-        /// contains a count of the rows that have been completed.  It returns
-        /// void.  Pass a function with this signature to the SetCallback()
-        /// method.
-        NoiseMapCallback m_pCallback;
+        /// @param tileCount The number of decoded tiles.
+        ///
+        /// @pre The number of tiles is positive.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The cache is emptied.
+        void SetCacheSize (size_t tileCount);
 
-        /// Height of the destination noise map, in points.
-        int m_destHeight;
+        /// Sets the new size for the noise map.
+        ///
+        /// @param width The new width for the noise map.
+        /// @param height The new height for the noise map.
+        ///
+        /// @pre The width and height values are not negative.
+        /// @pre The width and height values do not exceed RASTER_MAX_WIDTH
+        /// and RASTER_MAX_HEIGHT.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// On exit, every value of the noise map is 0.
+        void SetSize (noise::int64 width, noise::int64 height);
 
-        /// Width of the destination noise map, in points.
-        int m_destWidth;
+        /// Sets the size of a tile.
+        ///
+        /// @param tileWidth The width of a tile, in points.
+        /// @param tileHeight The height of a tile, in points.
+        ///
+        /// @pre The width and height are positive and no greater than 4096.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// On exit, the noise map is empty.
+        void SetTileSize (noise::int64 tileWidth, noise::int64 tileHeight);
 
-        /// Destination noise map that will contain the coherent-noise values.
-        NoiseMap* m_pDestNoiseMap;
+        /// Sets the tolerance of the compression.
+        ///
+        /// @param tolerance The largest change to a value that the
+        /// compression may make, or 0 to store the values losslessly.
+        ///
+        /// @pre The tolerance is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The tolerance applies to the tiles written after this method is
+        /// called.
+        void SetTolerance (float tolerance);
 
-        /// Source noise module that will generate the coherent-noise values.
-        const module::Module* m_pSourceModule;
+        virtual void BeginMap (noise::int64 width, noise::int64 height);
+
+        virtual void WriteTile (const NoiseMap& tile, noise::int64 x,
+          noise::int64 y);
+
+      private:
+
+        /// Copy constructor.
+        ///
+        /// A compressed noise map cannot be copied.
+        CompressedNoiseMap (const CompressedNoiseMap& rhs);
+
+        /// Assignment operator.
+        ///
+        /// A compressed noise map cannot be copied.
+        CompressedNoiseMap& operator= (const CompressedNoiseMap& rhs);
+
+        /// The compressed tiles and the cache of decoded tiles.
+        CompressedNoiseMapImpl* m_pImpl;
 
     };
 
-    /// Builds a cylindrical noise map.
+    /// A noise map whose values are calculated on demand.
     ///
-    /// This class builds a noise map by filling it with coherent-noise values
-    /// generated from the surface of a cylinder.
+    /// Many applications read only small windows of a huge noise map, such
+    /// as the area around a player or the part of a map on screen.  A
+    /// virtual noise map stores no values of its own.  It divides the noise
+    /// map into tiles, calculates a tile through a noise-map builder the
+    /// first time one of its values is read, and keeps the most recently
+    /// read tiles in a cache.  Tiles that are never read are never
+    /// calculated.
     ///
-    /// This class describes these input values using an (angle, height)
-    /// coordinate system.  After generating the coherent-noise value from the
-    /// input value, it then "flattens" these coordinates onto a plane so that
-    /// it can write the values into a two-dimensional noise map.
+    /// The noise-map builder supplies the source module, the size of the
+    /// noise map and the mapping from positions in the noise map to the
+    /// surface of its mathematical object.  Each value is the same as the
+    /// value that the noise-map builder would store at that position.
     ///
-    /// The cylinder model has a radius of 1.0 unit and has infinite height.
-    /// The cylinder is oriented along the @a y axis.  Its center is at the
-    /// origin.
+    /// To read the values, call GetValue(), or call GetRegion() to copy a
+    /// window into a noise map that can be passed to a renderer.
+    /// GetRegion() calculates the missing tiles through the executor of
+    /// the noise-map builder.
     ///
-    /// The x coordinate in the noise map represents the angle around the
-    /// cylinder's y axis.  The y coordinate in the noise map represents the
-    /// height above the x-z plane.
+    /// The cached tiles are not updated when the noise-map builder or its
+    /// source module changes; call the Invalidate() method afterwards.
     ///
-    /// The application must provide the lower and upper angle bounds of the
-    /// noise map, in degrees, and the lower and upper height bounds of the
-    /// noise map, in units.
-    class NoiseMapBuilderCylinder: public NoiseMapBuilder
+    /// Several threads may read the same virtual noise map at the same
+    /// time.
+    class VirtualNoiseMap
     {
 
       public:
 
         /// Constructor.
-        NoiseMapBuilderCylinder ();
+        ///
+        /// The tiles are 64 x 64 points, and the cache holds 64 tiles.
+        VirtualNoiseMap ();
 
-        virtual void Build ();
+        /// Destructor.
+        ~VirtualNoiseMap ();
 
-        /// Returns the lower angle boundary of the cylindrical noise map.
+        /// Returns the allocator of the cache.
         ///
-        /// @returns The lower angle boundary of the noise map, in degrees.
-        double GetLowerAngleBound () const
-        {
-          return m_lowerAngleBound;
-        }
+        /// @returns The allocator of the cache.
+        noise::Allocator* GetAllocator () const;
 
-        /// Returns the lower height boundary of the cylindrical noise map.
+        /// Returns the value used for all positions outside of the noise
+        /// map.
         ///
-        /// @returns The lower height boundary of the noise map, in units.
+        /// @returns The value used for all positions outside of the noise
+        /// map.
+        float GetBorderValue () const;
+
+        /// Returns the number of tiles that the cache holds.
         ///
-        /// One unit is equal to the radius of the cylinder.
-        double GetLowerHeightBound () const
-        {
-          return m_lowerHeightBound;
-        }
+        /// @returns The number of tiles that the cache holds.
+        size_t GetCacheSize () const;
 
-        /// Returns the upper angle boundary of the cylindrical noise map.
+        /// Returns the height of the noise map.
         ///
-        /// @returns The upper angle boundary of the noise map, in degrees.
-        double GetUpperAngleBound () const
-        {
-          return m_upperAngleBound;
-        }
+        /// @returns The destination height of the noise-map builder, or 0
+        /// if there is no noise-map builder.
+        noise::int64 GetHeight () const;
 
-        /// Returns the upper height boundary of the cylindrical noise map.
+        /// Copies a rectangle of the noise map into another noise map.
         ///
-        /// @returns The upper height boundary of the noise map, in units.
+        /// @param dest The noise map that receives the values.
+        /// @param x The x coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param y The y coordinate of the lower-left corner of the
+        /// rectangle.
+        /// @param width The width of the rectangle.
+        /// @param height The height of the rectangle.
         ///
-        /// One unit is equal to the radius of the cylinder.
-        double GetUpperHeightBound () const
-        {
-          return m_upperHeightBound;
-        }
+        /// @pre SetBuilder() was previously called.
+        /// @pre The noise-map builder has a source module.
+        /// @pre The width and height are not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The destination noise map is resized to the size of the
+        /// rectangle.  Positions of the rectangle outside this noise map
+        /// receive the border value.
+        void GetRegion (NoiseMap& dest, noise::int64 x, noise::int64 y,
+          noise::int64 width, noise::int64 height) const;
 
-        /// Sets the coordinate boundaries of the noise map.
+        /// Returns the number of tiles calculated so far.
         ///
-        /// @param lowerAngleBound The lower angle boundary of the noise map,
-        /// in degrees.
-        /// @param upperAngleBound The upper angle boundary of the noise map,
-        /// in degrees.
-        /// @param lowerHeightBound The lower height boundary of the noise
-        /// map, in units.
-        /// @param upperHeightBound The upper height boundary of the noise
-        /// map, in units.
+        /// @returns The number of tiles calculated since this object was
+        /// created, including tiles calculated again after they left the
+        /// cache.
+        noise::uint64 GetTileBuildCount () const;
+
+        /// Returns the height of a tile.
+        ///
+        /// @returns The height of a tile, in points.
+        noise::int64 GetTileHeight () const;
+
+        /// Returns the width of a tile.
+        ///
+        /// @returns The width of a tile, in points.
+        noise::int64 GetTileWidth () const;
+
+        /// Returns a value from the specified position in the noise map.
+        ///
+        /// @param x The x coordinate of the position.
+        /// @param y The y coordinate of the position.
+        ///
+        /// @returns The value at that position.
+        ///
+        /// @pre SetBuilder() was previously called.
+        /// @pre The noise-map builder has a source module.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// This method returns the border value if the coordinates exist
+        /// outside of the noise map.  The tile that holds the position is
+        /// calculated if it is not in the cache.
+        float GetValue (noise::int64 x, noise::int64 y) const;
+
+        /// Returns the width of the noise map.
+        ///
+        /// @returns The destination width of the noise-map builder, or 0
+        /// if there is no noise-map builder.
+        noise::int64 GetWidth () const;
+
+        /// Empties the cache.
+        ///
+        /// Call this method after changing the noise-map builder or its
+        /// source module.
+        void Invalidate ();
+
+        /// Sets the allocator of the cache.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// The cache is emptied.
+        void SetAllocator (noise::Allocator* pAllocator);
+
+        /// Sets the value to use for all positions outside of the noise
+        /// map.
+        ///
+        /// @param borderValue The value to use for all positions outside of
+        /// the noise map.
+        void SetBorderValue (float borderValue);
+
+        /// Sets the noise-map builder that calculates the tiles.
+        ///
+        /// @param builder The noise-map builder.
+        ///
+        /// The noise-map builder must be configured with its bounds, source
+        /// module and destination size.  Its destination noise map and
+        /// window are not used.  The noise-map builder must exist
+        /// throughout the lifetime of this object unless another noise-map
+        /// builder replaces that noise-map builder.  The cache is emptied.
+        void SetBuilder (const NoiseMapBuilder& builder);
+
+        /// Sets the number of tiles that the cache holds.
         ///
-        /// @pre The lower angle boundary is less than the upper angle
-        /// boundary.
-        /// @pre The lower height boundary is less than the upper height
-        /// boundary.
+        /// @param tileCount The number of tiles.
+        ///
+        /// @pre The number of tiles is positive.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
         ///
-        /// One unit is equal to the radius of the cylinder.
-        void SetBounds (double lowerAngleBound, double upperAngleBound,
-          double lowerHeightBound, double upperHeightBound)
-        {
-          if (lowerAngleBound >= upperAngleBound
-            || lowerHeightBound >= upperHeightBound) {
-            throw noise::ExceptionInvalidParam ();
-          }
+        /// The cache is emptied.
+        void SetCacheSize (size_t tileCount);
 
-          m_lowerAngleBound  = lowerAngleBound ;
-          m_upperAngleBound  = upperAngleBound ;
-          m_lowerHeightBound = lowerHeightBound;
-          m_upperHeightBound = upperHeightBound;
-        }
+        /// Sets the size of a tile.
+        ///
+        /// @param tileWidth The width of a tile, in points.
+        /// @param tileHeight The height of a tile, in points.
+        ///
+        /// @pre The width and height are positive and no greater than 4096.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// The cache is emptied.
+        void SetTileSize (noise::int64 tileWidth, noise::int64 tileHeight);
 
       private:
 
-        /// Lower angle boundary of the cylindrical noise map, in degrees.
-        double m_lowerAngleBound;
-
-        /// Lower height boundary of the cylindrical noise map, in units.
-        double m_lowerHeightBound;
+        /// Copy constructor.
+        ///
+        /// A virtual noise map cannot be copied.
+        VirtualNoiseMap (const VirtualNoiseMap& rhs);
 
-        /// Upper angle boundary of the cylindrical noise map, in degrees.
-        double m_upperAngleBound;
+        /// Assignment operator.
+        ///
+        /// A virtual noise map cannot be copied.
+        VirtualNoiseMap& operator= (const VirtualNoiseMap& rhs);
 
-        /// Upper height boundary of the cylindrical noise map, in units.
-        double m_upperHeightBound;
+        /// The cache of calculated tiles.
+        VirtualNoiseMapImpl* m_pImpl;
 
     };
 
-    /// Builds a planar noise map.
+    /// Builds a noise map too large to fit in memory, one tile at a time.
     ///
-    /// This class builds a noise map by filling it with coherent-noise values
-    /// generated from the surface of a plane.
+    /// This class drives a noise-map builder that has been configured with
+    /// its bounds, source module and destination size as usual.  Instead of
+    /// building the whole noise map at once, it divides the noise map into
+    /// tiles, builds each tile through NoiseMapBuilder::SetDestWindow() and
+    /// passes the finished tile to a tile sink.  Because a noise-map builder
+    /// calculates each point from its position in the whole noise map, the
+    /// tiles join without seams.
     ///
-    /// This class describes these input values using (x, z) coordinates.
-    /// Their y coordinates are always 0.0.
+    /// <b>Memory use</b>
     ///
-    /// The application must provide the lower and upper x coordinate bounds
-    /// of the noise map, in units, and the lower and upper z coordinate
-    /// bounds of the noise map, in units.
+    /// This object holds a single tile in memory and reuses it for every
+    /// tile, so the memory it uses depends only on the tile size, never on
+    /// the size of the whole noise map.  Pass the maximum number of bytes
+    /// the tile may use to SetMemoryBudget().  If no tile size is passed to
+    /// SetTileSize(), this object uses the largest square tile that fits in
+    /// the budget, or tiles of DEFAULT_TILE_SIZE points square if there is no
+    /// budget.
     ///
-    /// To make a tileable noise map with no seams at the edges, call the
-    /// EnableSeamless() method.
-    class NoiseMapBuilderPlane: public NoiseMapBuilder
+    /// <b>Building the noise map</b>
+    ///
+    /// To build the noise map, perform the following steps:
+    /// - Configure a noise-map builder with SetBounds(), SetDestSize() and
+    ///   SetSourceModule(), and pass it to the SetBuilder() method.
+    /// - Pass a tile sink to the SetTileSink() method.
+    /// - Pass the tile size to the SetTileSize() method or the memory
+    ///   budget to the SetMemoryBudget() method (optional).
+    /// - Call the Build() method.
+    ///
+    /// The noise-map builder keeps its executor, so the rows of each tile
+    /// are filled in parallel if the builder has an executor.
+    class TiledNoiseMapBuilder
     {
 
       public:
 
         /// Constructor.
-        NoiseMapBuilderPlane ();
+        TiledNoiseMapBuilder ();
 
-        virtual void Build ();
-
-        /// Enables or disables seamless tiling.
+        /// Builds the noise map and passes its tiles to the tile sink.
         ///
-        /// @param enable A flag that enables or disables seamless tiling.
+        /// @pre SetBuilder() was previously called.
+        /// @pre SetTileSink() was previously called.
+        /// @pre The noise-map builder is ready to build.
+        /// @pre A tile fits in the memory budget.
         ///
-        /// Enabling seamless tiling builds a noise map with no seams at the
-        /// edges.  This allows the noise map to be tileable.
-        void EnableSeamless (bool enable = true)
-        {
-          m_isSeamlessEnabled = enable;
-        }
-
-        /// Returns the lower x boundary of the planar noise map.
+        /// @post The noise-map builder has its original destination noise
+        /// map again, and its window is cleared.
         ///
-        /// @returns The lower x boundary of the planar noise map, in units.
-        double GetLowerXBound () const
-        {
-          return m_lowerXBound;
-        }
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        /// @throw noise::ExceptionUnknown The tile sink failed.
+        ///
+        /// The tiles are built in rows of tiles from the lower-left corner
+        /// of the noise map.  The tiles along the right and top edges are
+        /// smaller if the tile size does not divide the size of the noise
+        /// map.
+        void Build ();
 
-        /// Returns the lower z boundary of the planar noise map.
+        /// Returns the allocator of the tile.
         ///
-        /// @returns The lower z boundary of the noise map, in units.
-        double GetLowerZBound () const
+        /// @returns The allocator of the tile.
+        noise::Allocator* GetAllocator () const
         {
-          return m_lowerZBound;
+          return m_tile.GetAllocator ();
         }
 
-        /// Returns the upper x boundary of the planar noise map.
+        /// Returns the memory budget.
         ///
-        /// @returns The upper x boundary of the noise map, in units.
-        double GetUpperXBound () const
+        /// @returns The maximum number of bytes a tile may use, or 0 if the
+        /// memory is not limited.
+        size_t GetMemoryBudget () const
         {
-          return m_upperXBound;
+          return m_memoryBudget;
         }
 
-        /// Returns the upper z boundary of the planar noise map.
+        /// Returns the height of a tile.
         ///
-        /// @returns The upper z boundary of the noise map, in units.
-        double GetUpperZBound () const
+        /// @returns The height of a tile, in points, or 0 if the tile size
+        /// is calculated from the memory budget.
+        noise::int64 GetTileHeight () const
         {
-          return m_upperZBound;
+          return m_tileHeight;
         }
 
-        /// Determines if seamless tiling is enabled.
-        ///
-        /// @returns
-        /// - @a true if seamless tiling is enabled.
-        /// - @a false if seamless tiling is disabled.
+        /// Returns the width of a tile.
         ///
-        /// Enabling seamless tiling builds a noise map with no seams at the
-        /// edges.  This allows the noise map to be tileable.
-        bool IsSeamlessEnabled () const
+        /// @returns The width of a tile, in points, or 0 if the tile size
+        /// is calculated from the memory budget.
+        noise::int64 GetTileWidth () const
         {
-          return m_isSeamlessEnabled;
+          return m_tileWidth;
         }
 
-        /// Sets the boundaries of the planar noise map.
-        ///
-        /// @param lowerXBound The lower x boundary of the noise map, in
-        /// units.
-        /// @param upperXBound The upper x boundary of the noise map, in
-        /// units.
-        /// @param lowerZBound The lower z boundary of the noise map, in
-        /// units.
-        /// @param upperZBound The upper z boundary of the noise map, in
-        /// units.
+        /// Sets the allocator of the tile.
         ///
-        /// @pre The lower x boundary is less than the upper x boundary.
-        /// @pre The lower z boundary is less than the upper z boundary.
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
         ///
-        /// @throw noise::ExceptionInvalidParam See the preconditions.
-        void SetBounds (double lowerXBound, double upperXBound,
-          double lowerZBound, double upperZBound)
+        /// The tile is allocated at the start of the Build() method and
+        /// freed at its end, so a RasterBufferPool object lets repeated
+        /// builds reuse the same buffer.
+        void SetAllocator (noise::Allocator* pAllocator)
         {
-          if (lowerXBound >= upperXBound
-            || lowerZBound >= upperZBound) {
-            throw noise::ExceptionInvalidParam ();
-          }
-
-          m_lowerXBound = lowerXBound;
-          m_upperXBound = upperXBound;
-          m_lowerZBound = lowerZBound;
-          m_upperZBound = upperZBound;
+          m_tile.SetAllocator (pAllocator);
         }
 
-      private:
-
-        /// A flag specifying whether seamless tiling is enabled.
-        bool m_isSeamlessEnabled;
-
-        /// Lower x boundary of the planar noise map, in units.
-        double m_lowerXBound;
-
-        /// Lower z boundary of the planar noise map, in units.
-        double m_lowerZBound;
-
-        /// Upper x boundary of the planar noise map, in units.
-        double m_upperXBound;
-
-        /// Upper z boundary of the planar noise map, in units.
-        double m_upperZBound;
-
-    };
-
-
-    /// Builds a spherical noise map.
-    ///
-    /// This class builds a noise map by filling it with coherent-noise values
-    /// generated from the surface of a sphere.
-    ///
-    /// This class describes these input values using a (latitude, longitude)
-    /// coordinate system.  After generating the coherent-noise value from the
-    /// input value, it then "flattens" these coordinates onto a plane so that
-    /// it can write the values into a two-dimensional noise map.
-    ///
-    /// The sphere model has a radius of 1.0 unit.  Its center is at the
-    /// origin.
-    ///
-    /// The x coordinate in the noise map represents the longitude.  The y
-    /// coordinate in the noise map represents the latitude.  
-    ///
-    /// The application must provide the southern, northern, western, and
-    /// eastern bounds of the noise map, in degrees.
-    class NoiseMapBuilderSphere: public NoiseMapBuilder
-    {
-
-      public:
-
-        /// Constructor.
-        NoiseMapBuilderSphere ();
-
-        virtual void Build ();
-
-        /// Returns the eastern boundary of the spherical noise map.
+        /// Sets the noise-map builder that builds the tiles.
         ///
-        /// @returns The eastern boundary of the noise map, in degrees.
-        double GetEastLonBound () const
-        {
-          return m_eastLonBound;
-        }
-
-        /// Returns the northern boundary of the spherical noise map
+        /// @param builder The noise-map builder.
         ///
-        /// @returns The northern boundary of the noise map, in degrees.
-        double GetNorthLatBound () const
+        /// The noise-map builder must exist throughout the lifetime of this
+        /// object unless another noise-map builder replaces that noise-map
+        /// builder.
+        void SetBuilder (NoiseMapBuilder& builder)
         {
-          return m_northLatBound;
+          m_pBuilder = &builder;
         }
 
-        /// Returns the southern boundary of the spherical noise map
+        /// Sets the memory budget.
         ///
-        /// @returns The southern boundary of the noise map, in degrees.
-        double GetSouthLatBound () const
+        /// @param memoryBudget The maximum number of bytes a tile may use,
+        /// or 0 to not limit the memory.
+        void SetMemoryBudget (size_t memoryBudget)
         {
-          return m_southLatBound;
+          m_memoryBudget = memoryBudget;
         }
 
-        /// Returns the western boundary of the spherical noise map
+        /// Sets the tile sink that receives the tiles.
         ///
-        /// @returns The western boundary of the noise map, in degrees.
-        double GetWestLonBound () const
+        /// @param tileSink The tile sink.
+        ///
+        /// The tile sink must exist throughout the lifetime of this object
+        /// unless another tile sink replaces that tile sink.
+        void SetTileSink (TileSink& tileSink)
         {
-          return m_westLonBound;
+          m_pTileSink = &tileSink;
         }
 
-        /// Sets the coordinate boundaries of the noise map.
+        /// Sets the size of a tile.
         ///
-        /// @param southLatBound The southern boundary of the noise map, in
-        /// degrees.
-        /// @param northLatBound The northern boundary of the noise map, in
-        /// degrees.
-        /// @param westLonBound The western boundary of the noise map, in
-        /// degrees.
-        /// @param eastLonBound The eastern boundary of the noise map, in
-        /// degrees.
+        /// @param tileWidth The width of a tile, in points.
+        /// @param tileHeight The height of a tile, in points.
         ///
-        /// @pre The southern boundary is less than the northern boundary.
-        /// @pre The western boundary is less than the eastern boundary.
+        /// @pre The width and height are both positive, or both 0 to
+        /// calculate the tile size from the memory budget.
+        /// @pre The width and height do not exceed RASTER_MAX_WIDTH and
+        /// RASTER_MAX_HEIGHT.
         ///
         /// @throw noise::ExceptionInvalidParam See the preconditions.
-        void SetBounds (double southLatBound, double northLatBound,
-          double westLonBound, double eastLonBound)
+        void SetTileSize (noise::int64 tileWidth, noise::int64 tileHeight)
         {
-          if (southLatBound >= northLatBound
-            || westLonBound >= eastLonBound) {
+          if ((tileWidth == 0) != (tileHeight == 0)
+            || tileWidth  < 0 || tileWidth  > RASTER_MAX_WIDTH
+            || tileHeight < 0 || tileHeight > RASTER_MAX_HEIGHT) {
             throw noise::ExceptionInvalidParam ();
           }
 
-          m_southLatBound = southLatBound;
-          m_northLatBound = northLatBound;
-          m_westLonBound  = westLonBound ;
-          m_eastLonBound  = eastLonBound ;
+          m_tileWidth  = tileWidth ;
+          m_tileHeight = tileHeight;
         }
 
       private:
 
-        /// Eastern boundary of the spherical noise map, in degrees.
-        double m_eastLonBound;
+        /// Calculates the size of the tiles to build.
+        ///
+        /// @param tileWidth On return, the width of a tile, in points.
+        /// @param tileHeight On return, the height of a tile, in points.
+        ///
+        /// @throw noise::ExceptionInvalidParam A tile does not fit in the
+        /// memory budget.
+        void CalcTileSize (noise::int64& tileWidth, noise::int64& tileHeight)
+          const;
 
-        /// Northern boundary of the spherical noise map, in degrees.
-        double m_northLatBound;
+        /// Restores the noise-map builder after a build.
+        ///
+        /// @param pDestNoiseMap The destination noise map that the
+        /// noise-map builder had before the build, or @a NULL.
+        ///
+        /// Clears the window of the noise-map builder and empties the tile.
+        void RestoreBuilder (NoiseMap* pDestNoiseMap);
 
-        /// Southern boundary of the spherical noise map, in degrees.
-        double m_southLatBound;
+        /// Maximum number of bytes a tile may use, or 0 if unlimited.
+        size_t m_memoryBudget;
 
-        /// Western boundary of the spherical noise map, in degrees.
-        double m_westLonBound;
+        /// The noise-map builder that builds the tiles.
+        NoiseMapBuilder* m_pBuilder;
+
+        /// The noise map that stores the tile being built.  It is emptied
+        /// after each build.
+        NoiseMap m_tile;
+
+        /// The tile sink that receives the tiles.
+        TileSink* m_pTileSink;
+
+        /// The height of a tile, in points, or 0 to use the memory budget.
+        noise::int64 m_tileHeight;
+
+        /// The width of a tile, in points, or 0 to use the memory budget.
+        noise::int64 m_tileWidth;
 
     };
 
@@ -2000,6 +6559,16 @@ namespace noise
           m_isWrapEnabled = enable;
         }
 
+        /// Returns the executor that renders the rows of the image.
+        ///
+        /// @returns The executor passed to SetExecutor(), the default
+        /// executor if none was passed, or @a NULL if the rows are rendered
+        /// on the calling thread.
+        Executor* GetExecutor () const
+        {
+          return (m_pExecutor != NULL)? m_pExecutor: GetDefaultExecutor ();
+        }
+
         /// Returns the azimuth of the light source, in degrees.
         ///
         /// @returns The azimuth of the light source.
@@ -2149,6 +6718,21 @@ namespace noise
           m_pDestImage = &destImage;
         }
 
+        /// Sets the executor that renders the rows of the image.
+        ///
+        /// @param pExecutor The executor, or @a NULL to use the default
+        /// executor.
+        ///
+        /// The Render() method splits the image into bands of rows and
+        /// submits them to the executor.
+        ///
+        /// The executor must exist throughout the lifetime of this object
+        /// unless another executor replaces that executor.
+        void SetExecutor (Executor* pExecutor)
+        {
+          m_pExecutor = pExecutor;
+        }
+
         /// Sets the azimuth of the light source, in degrees.
         ///
         /// @param lightAzimuth The azimuth of the light source.
@@ -2292,9 +6876,36 @@ namespace noise
         /// @param up Elevation of the point directly above the center point.
         ///
         /// These values come directly from the noise map.
+        ///
+        /// @pre CalcLightValues() has been called since the light
+        /// parameters last changed.
         double CalcLightIntensity (double center, double left, double right,
           double down, double up) const;
 
+        /// Recalculates the sine and cosine of the light direction if the
+        /// light parameters have changed.
+        ///
+        /// The Render() method calls this method once before rendering any
+        /// rows, so the rows can be rendered from several threads.
+        void CalcLightValues () const;
+
+        /// Renders one row of the destination image.
+        ///
+        /// @param row The row to render.
+        ///
+        /// This method calls RenderRowFrom() with the reader that matches
+        /// the storage format of the source noise map.
+        void RenderRow (noise::int64 row) const;
+
+        /// Renders one row of the destination image from the values stored
+        /// in the source noise map.
+        ///
+        /// @param row The row to render.
+        /// @param reader Converts a pointer to a stored value into a
+        /// floating-point value.
+        template <class Reader>
+        void RenderRowFrom (noise::int64 row, const Reader& reader) const;
+
         /// The cosine of the azimuth of the light source.
         mutable double m_cosAzimuth;
 
@@ -2334,14 +6945,18 @@ namespace noise
         /// A pointer to the destination image.
         Image* m_pDestImage;
 
+        /// The executor that renders the rows, or @a NULL to use the default
+        /// executor.
+        Executor* m_pExecutor;
+
         /// A pointer to the source noise map.
         const NoiseMap* m_pSourceNoiseMap;
 
-        /// Used by the CalcLightIntensity() method to recalculate the light
+        /// Used by the CalcLightValues() method to recalculate the light
         /// values only if the light parameters change.
         ///
         /// When the light parameters change, this value is set to True.  When
-        /// the CalcLightIntensity() method is called, this value is set to
+        /// the CalcLightValues() method is called, this value is set to
         /// false.
         mutable bool m_recalcLightValues;
 
@@ -2421,6 +7036,16 @@ namespace noise
           return m_bumpHeight;
         }
 
+        /// Returns the executor that renders the rows of the image.
+        ///
+        /// @returns The executor passed to SetExecutor(), the default
+        /// executor if none was passed, or @a NULL if the rows are rendered
+        /// on the calling thread.
+        Executor* GetExecutor () const
+        {
+          return (m_pExecutor != NULL)? m_pExecutor: GetDefaultExecutor ();
+        }
+
         /// Determines if noise-map wrapping is enabled.
         ///
         /// @returns
@@ -2468,6 +7093,21 @@ namespace noise
           m_bumpHeight = bumpHeight;
         }
 
+        /// Sets the executor that renders the rows of the image.
+        ///
+        /// @param pExecutor The executor, or @a NULL to use the default
+        /// executor.
+        ///
+        /// The Render() method splits the image into bands of rows and
+        /// submits them to the executor.
+        ///
+        /// The executor must exist throughout the lifetime of this object
+        /// unless another executor replaces that executor.
+        void SetExecutor (Executor* pExecutor)
+        {
+          m_pExecutor = pExecutor;
+        }
+
         /// Sets the destination image.
         ///
         /// @param destImage The destination image.
@@ -2519,6 +7159,23 @@ namespace noise
         Color CalcNormalColor (double nc, double nr, double nu,
           double bumpHeight) const;
 
+        /// Renders one row of the destination image.
+        ///
+        /// @param row The row to render.
+        ///
+        /// This method calls RenderRowFrom() with the reader that matches
+        /// the storage format of the source noise map.
+        void RenderRow (noise::int64 row) const;
+
+        /// Renders one row of the destination image from the values stored
+        /// in the source noise map.
+        ///
+        /// @param row The row to render.
+        /// @param reader Converts a pointer to a stored value into a
+        /// floating-point value.
+        template <class Reader>
+        void RenderRowFrom (noise::int64 row, const Reader& reader) const;
+
         /// The bump height for the normal map.
         double m_bumpHeight;
 
@@ -2528,6 +7185,10 @@ namespace noise
         /// A pointer to the destination image.
         Image* m_pDestImage;
 
+        /// The executor that renders the rows, or @a NULL to use the default
+        /// executor.
+        Executor* m_pExecutor;
+
         /// A pointer to the source noise map.
         const NoiseMap* m_pSourceNoiseMap;
 
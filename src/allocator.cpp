@@ -0,0 +1,78 @@
+// allocator.cpp
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <stdlib.h>
+#if defined(_WIN32)
+#  include <malloc.h>
+#endif
+
+#include "noise/allocator.h"
+
+using namespace noise;
+
+namespace
+{
+
+  // The allocator used when the application has not set one.
+  HeapAllocator g_heapAllocator;
+
+  // The allocator that new objects take.
+  Allocator* g_pDefaultAllocator = &g_heapAllocator;
+
+}
+
+void* HeapAllocator::Allocate (size_t byteCount, size_t alignment)
+{
+  void* pMemory = NULL;
+#if defined(_WIN32)
+  pMemory = _aligned_malloc (byteCount, alignment);
+#else
+  // posix_memalign() requires a multiple of the pointer size.
+  if (alignment < sizeof (void*)) {
+    alignment = sizeof (void*);
+  }
+  if (posix_memalign (&pMemory, alignment, byteCount) != 0) {
+    pMemory = NULL;
+  }
+#endif
+  if (pMemory == NULL) {
+    throw noise::ExceptionOutOfMemory ();
+  }
+  return pMemory;
+}
+
+void HeapAllocator::Deallocate (void* pMemory, size_t /* byteCount */,
+  size_t /* alignment */)
+{
+#if defined(_WIN32)
+  _aligned_free (pMemory);
+#else
+  free (pMemory);
+#endif
+}
+
+Allocator* noise::GetDefaultAllocator ()
+{
+  return g_pDefaultAllocator;
+}
+
+void noise::SetDefaultAllocator (Allocator* pAllocator)
+{
+  g_pDefaultAllocator = (pAllocator != NULL)? pAllocator: &g_heapAllocator;
+}
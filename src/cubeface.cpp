@@ -0,0 +1,82 @@
+// cubeface.cpp
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <math.h>
+#include "noise/cubeface.h"
+#include "noise/mathconsts.h"
+
+using namespace noise;
+
+namespace noise
+{
+
+  // The direction of the center of each face, followed by the directions
+  // in which the s and t coordinates of the face increase.
+  const double CUBE_FACE_AXES[CUBE_FACE_COUNT][3][3] = {
+    {{ 1.0,  0.0,  0.0}, { 0.0,  0.0, -1.0}, { 0.0,  1.0,  0.0}},
+    {{-1.0,  0.0,  0.0}, { 0.0,  0.0,  1.0}, { 0.0,  1.0,  0.0}},
+    {{ 0.0,  1.0,  0.0}, { 1.0,  0.0,  0.0}, { 0.0,  0.0, -1.0}},
+    {{ 0.0, -1.0,  0.0}, { 1.0,  0.0,  0.0}, { 0.0,  0.0,  1.0}},
+    {{ 0.0,  0.0,  1.0}, { 1.0,  0.0,  0.0}, { 0.0,  1.0,  0.0}},
+    {{ 0.0,  0.0, -1.0}, {-1.0,  0.0,  0.0}, { 0.0,  1.0,  0.0}}
+  };
+
+}
+
+void noise::CubeFaceToXYZ (CubeFace face, double s, double t, double& x,
+  double& y, double& z)
+{
+  const double (*pAxes)[3] = CUBE_FACE_AXES[face];
+  double u = tan (s * PI / 4.0);
+  double v = tan (t * PI / 4.0);
+  double r = 1.0 / sqrt (1.0 + u * u + v * v);
+  x = (pAxes[0][0] + u * pAxes[1][0] + v * pAxes[2][0]) * r;
+  y = (pAxes[0][1] + u * pAxes[1][1] + v * pAxes[2][1]) * r;
+  z = (pAxes[0][2] + u * pAxes[1][2] + v * pAxes[2][2]) * r;
+}
+
+CubeFace noise::XYZToCubeFace (double x, double y, double z, double& s,
+  double& t)
+{
+  // The face is the one whose axis is closest to the direction of the
+  // point.
+  CubeFace face;
+  double ax = fabs (x);
+  double ay = fabs (y);
+  double az = fabs (z);
+  if (ax >= ay && ax >= az) {
+    face = (x >= 0.0)? CUBE_FACE_POS_X: CUBE_FACE_NEG_X;
+  } else if (ay >= az) {
+    face = (y >= 0.0)? CUBE_FACE_POS_Y: CUBE_FACE_NEG_Y;
+  } else {
+    face = (z >= 0.0)? CUBE_FACE_POS_Z: CUBE_FACE_NEG_Z;
+  }
+
+  const double (*pAxes)[3] = CUBE_FACE_AXES[face];
+  double major = x * pAxes[0][0] + y * pAxes[0][1] + z * pAxes[0][2];
+  s = 0.0;
+  t = 0.0;
+  if (major > 0.0) {
+    s = atan ((x * pAxes[1][0] + y * pAxes[1][1] + z * pAxes[1][2])
+      / major) * 4.0 / PI;
+    t = atan ((x * pAxes[2][0] + y * pAxes[2][1] + z * pAxes[2][2])
+      / major) * 4.0 / PI;
+  }
+  return face;
+}
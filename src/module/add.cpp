@@ -20,6 +20,7 @@
 // off every 'zig'.)
 //
 
+#include "misc.h"
 #include "module/add.h"
 
 using namespace noise::module;
@@ -29,6 +30,16 @@ Add::Add ():
 {
 }
 
+double Add::GetMaxFrequency () const
+{
+  double frequency0 = GetSourceMaxFrequency (0);
+  double frequency1 = GetSourceMaxFrequency (1);
+  if (frequency0 < 0.0 || frequency1 < 0.0) {
+    return -1.0;
+  }
+  return GetMax (frequency0, frequency1);
+}
+
 double Add::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
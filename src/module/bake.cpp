@@ -0,0 +1,334 @@
+// bake.cpp
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <string.h>
+#include "byteorder.h"
+#include "interp.h"
+#include "misc.h"
+#include "module/bake.h"
+
+using namespace noise::module;
+
+using namespace noise;
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    // Identifies a grid written by Bake::WriteGrid().
+    const char BAKE_GRID_MAGIC[8] = {
+      'L', 'N', 'B', 'A', 'K', 'E', '\0', '\0'
+    };
+
+    // Version of the grid format.
+    const noise::uint32 BAKE_GRID_VERSION = 1;
+
+    // Determines if a grid with the given number of points along each axis
+    // fits in memory.
+    inline bool IsGridSizeValid (const int* pResolution)
+    {
+      double size = (double)pResolution[0] * (double)pResolution[1]
+        * (double)pResolution[2];
+      return size <= (double)((size_t)-1 / sizeof (float));
+    }
+
+  }
+
+}
+
+Bake::Bake ():
+  Module (GetSourceModuleCount ()),
+  m_pGrid (NULL),
+  m_interp (DEFAULT_BAKE_INTERP)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    m_lowerBound[axis] = -1.0;
+    m_upperBound[axis] =  1.0;
+    m_resolution[axis] = DEFAULT_BAKE_RESOLUTION;
+  }
+}
+
+Bake::~Bake ()
+{
+  ClearGrid ();
+}
+
+void Bake::BuildGrid ()
+{
+  if (m_pSourceModule[0] == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // The grid points are calculated from their indices so that the last
+  // point lies exactly on the upper boundary.
+  double delta[3];
+  for (int axis = 0; axis < 3; axis++) {
+    delta[axis] = (m_resolution[axis] > 1)
+      ? (m_upperBound[axis] - m_lowerBound[axis])
+        / (double)(m_resolution[axis] - 1)
+      : 0.0;
+  }
+  float* pGrid = AllocateArray<float> (m_pAllocator, GetGridSize ());
+  try {
+    float* pValue = pGrid;
+    for (int k = 0; k < m_resolution[2]; k++) {
+      double z = m_lowerBound[2] + (double)k * delta[2];
+      for (int j = 0; j < m_resolution[1]; j++) {
+        double y = m_lowerBound[1] + (double)j * delta[1];
+        for (int i = 0; i < m_resolution[0]; i++) {
+          double x = m_lowerBound[0] + (double)i * delta[0];
+          *pValue++ = (float)m_pSourceModule[0]->GetValue (x, y, z);
+        }
+      }
+    }
+  }
+  catch (...) {
+    DeallocateArray (m_pAllocator, pGrid, GetGridSize ());
+    throw;
+  }
+  ClearGrid ();
+  m_pGrid = pGrid;
+}
+
+void Bake::ClearGrid ()
+{
+  DeallocateArray (m_pAllocator, m_pGrid, GetGridSize ());
+  m_pGrid = NULL;
+}
+
+double Bake::GetMaxFrequency () const
+{
+  if (m_pGrid == NULL) {
+    return GetSourceMaxFrequency (0);
+  }
+
+  // The grid cannot hold a frequency higher than half a cycle per grid
+  // cell.
+  double frequency = 0.0;
+  for (int axis = 0; axis < 3; axis++) {
+    double extent = m_upperBound[axis] - m_lowerBound[axis];
+    if (m_resolution[axis] > 1 && extent > 0.0) {
+      frequency = GetMax (frequency,
+        0.5 * (double)(m_resolution[axis] - 1) / extent);
+    }
+  }
+  return frequency;
+}
+
+double Bake::GetValue (double x, double y, double z) const
+{
+  if (m_pGrid == NULL) {
+    assert (m_pSourceModule[0] != NULL);
+    return m_pSourceModule[0]->GetValue (x, y, z);
+  }
+
+  // Find the grid cell that contains the input value, clamped to the box,
+  // and the offsets of the grid points around it.  Grid points beyond the
+  // edges of the grid repeat the points on the edges.
+  const double input[3] = {x, y, z};
+  double alpha[3];
+  size_t offsets[3][4];
+  size_t stride = 1;
+  for (int axis = 0; axis < 3; axis++) {
+    int count = m_resolution[axis];
+    double extent = m_upperBound[axis] - m_lowerBound[axis];
+    double position = 0.0;
+    if (count > 1 && extent > 0.0) {
+      position = (input[axis] - m_lowerBound[axis]) / extent
+        * (double)(count - 1);
+      if (!(position > 0.0)) {
+        position = 0.0;
+      } else if (position > (double)(count - 1)) {
+        position = (double)(count - 1);
+      }
+    }
+    int cell = GetMin ((int)position, GetMax (count - 2, 0));
+    alpha[axis] = position - (double)cell;
+    for (int n = 0; n < 4; n++) {
+      offsets[axis][n] = (size_t)ClampValue (cell - 1 + n, 0, count - 1)
+        * stride;
+    }
+    stride *= (size_t)count;
+  }
+
+  if (m_interp == RESAMPLE_LINEAR) {
+    double rows[2][2];
+    for (int k = 0; k < 2; k++) {
+      for (int j = 0; j < 2; j++) {
+        const float* pRow = m_pGrid + offsets[2][k + 1] + offsets[1][j + 1];
+        rows[k][j] = LinearInterp (pRow[offsets[0][1]], pRow[offsets[0][2]],
+          alpha[0]);
+      }
+    }
+    return LinearInterp (
+      LinearInterp (rows[0][0], rows[0][1], alpha[1]),
+      LinearInterp (rows[1][0], rows[1][1], alpha[1]), alpha[2]);
+  }
+
+  double planes[4];
+  for (int k = 0; k < 4; k++) {
+    double rows[4];
+    for (int j = 0; j < 4; j++) {
+      const float* pRow = m_pGrid + offsets[2][k] + offsets[1][j];
+      rows[j] = CatmullRomInterp (pRow[offsets[0][0]], pRow[offsets[0][1]],
+        pRow[offsets[0][2]], pRow[offsets[0][3]], alpha[0]);
+    }
+    planes[k] = CatmullRomInterp (rows[0], rows[1], rows[2], rows[3],
+      alpha[1]);
+  }
+  return CatmullRomInterp (planes[0], planes[1], planes[2], planes[3],
+    alpha[2]);
+}
+
+void Bake::ReadGrid (std::istream& is)
+{
+  // Read and check the header before allocating the grid.
+  char magic[sizeof (BAKE_GRID_MAGIC)];
+  is.read (magic, sizeof (magic));
+  noise::uint32 version = ReadLittle32 (is);
+  noise::uint32 interp  = ReadLittle32 (is);
+  int resolution[3];
+  double lowerBound[3];
+  double upperBound[3];
+  for (int axis = 0; axis < 3; axis++) {
+    resolution[axis] = (int)ReadLittle32 (is);
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    lowerBound[axis] = ReadLittleDouble (is);
+    upperBound[axis] = ReadLittleDouble (is);
+  }
+  bool isValid = is.good ()
+    && memcmp (magic, BAKE_GRID_MAGIC, sizeof (magic)) == 0
+    && version == BAKE_GRID_VERSION
+    && (interp == RESAMPLE_LINEAR || interp == RESAMPLE_CUBIC);
+  for (int axis = 0; isValid && axis < 3; axis++) {
+    isValid = resolution[axis] >= 1
+      && lowerBound[axis] <= upperBound[axis];
+  }
+  if (!isValid || !IsGridSizeValid (resolution)) {
+    throw noise::ExceptionUnknown ();
+  }
+
+  size_t size = (size_t)resolution[0] * (size_t)resolution[1]
+    * (size_t)resolution[2];
+  float* pGrid = AllocateArray<float> (m_pAllocator, size);
+  for (size_t i = 0; i < size; i++) {
+    pGrid[i] = ReadLittleFloat (is);
+  }
+  if (!is.good ()) {
+    DeallocateArray (m_pAllocator, pGrid, size);
+    throw noise::ExceptionUnknown ();
+  }
+
+  ClearGrid ();
+  m_pGrid = pGrid;
+  m_interp = (ResampleInterp)interp;
+  for (int axis = 0; axis < 3; axis++) {
+    m_lowerBound[axis] = lowerBound[axis];
+    m_upperBound[axis] = upperBound[axis];
+    m_resolution[axis] = resolution[axis];
+  }
+}
+
+void Bake::SetAllocator (Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the grid into memory from the new allocator before the base
+  // class switches to that allocator; a grid that was read cannot be built
+  // again.
+  Allocator* pOldAllocator = m_pAllocator;
+  float* pNewGrid = NULL;
+  if (m_pGrid != NULL) {
+    pNewGrid = AllocateArray<float> (pAllocator, GetGridSize ());
+    memcpy (pNewGrid, m_pGrid, GetGridSize () * sizeof (float));
+  }
+  try {
+    Module::SetAllocator (pAllocator);
+  }
+  catch (...) {
+    DeallocateArray (pAllocator, pNewGrid, GetGridSize ());
+    throw;
+  }
+  DeallocateArray (pOldAllocator, m_pGrid, GetGridSize ());
+  m_pGrid = pNewGrid;
+}
+
+void Bake::SetBounds (double lowerX, double lowerY, double lowerZ,
+  double upperX, double upperY, double upperZ)
+{
+  if (!(lowerX <= upperX && lowerY <= upperY && lowerZ <= upperZ)) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  ClearGrid ();
+  m_lowerBound[0] = lowerX;
+  m_lowerBound[1] = lowerY;
+  m_lowerBound[2] = lowerZ;
+  m_upperBound[0] = upperX;
+  m_upperBound[1] = upperY;
+  m_upperBound[2] = upperZ;
+}
+
+void Bake::SetResolution (int xResolution, int yResolution,
+  int zResolution)
+{
+  const int resolution[3] = {xResolution, yResolution, zResolution};
+  if (xResolution < 1 || yResolution < 1 || zResolution < 1
+    || !IsGridSizeValid (resolution)) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  ClearGrid ();
+  for (int axis = 0; axis < 3; axis++) {
+    m_resolution[axis] = resolution[axis];
+  }
+}
+
+void Bake::WriteGrid (std::ostream& os) const
+{
+  if (m_pGrid == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  os.write (BAKE_GRID_MAGIC, sizeof (BAKE_GRID_MAGIC));
+  WriteLittle32 (os, BAKE_GRID_VERSION);
+  WriteLittle32 (os, (noise::uint32)m_interp);
+  for (int axis = 0; axis < 3; axis++) {
+    WriteLittle32 (os, (noise::uint32)m_resolution[axis]);
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    WriteLittleDouble (os, m_lowerBound[axis]);
+    WriteLittleDouble (os, m_upperBound[axis]);
+  }
+  size_t size = GetGridSize ();
+  for (size_t i = 0; i < size; i++) {
+    WriteLittleFloat (os, m_pGrid[i]);
+  }
+  if (!os.good ()) {
+    throw noise::ExceptionUnknown ();
+  }
+}
@@ -31,44 +31,82 @@ Billow::Billow ():
   m_noiseQuality (DEFAULT_BILLOW_QUALITY     ),
   m_octaveCount  (DEFAULT_BILLOW_OCTAVE_COUNT),
   m_persistence  (DEFAULT_BILLOW_PERSISTENCE ),
-  m_seed         (DEFAULT_BILLOW_SEED)
+  m_seed         (DEFAULT_BILLOW_SEED),
+  m_xPeriod      (0.0),
+  m_yPeriod      (0.0),
+  m_zPeriod      (0.0)
 {
 }
 
-double Billow::GetValue (double x, double y, double z) const
+double Billow::GetOctaveRangeValue (double x, double y, double z,
+  int firstOctave, int lastOctave) const
 {
+  if (firstOctave < 0 || firstOctave > lastOctave
+    || lastOctave > BILLOW_MAX_OCTAVE) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
   double value = 0.0;
   double signal = 0.0;
   double curPersistence = 1.0;
+  double curFrequency = m_frequency;
   double nx, ny, nz;
+  int xCells, yCells, zCells;
   int seed;
+  bool isPeriodic = IsPeriodic ();
+  double xInput = x;
+  double yInput = y;
+  double zInput = z;
 
   x *= m_frequency;
   y *= m_frequency;
   z *= m_frequency;
 
-  for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
+  for (int curOctave = 0; curOctave < lastOctave; curOctave++) {
 
-    // Make sure that these floating-point values have the same range as a 32-
-    // bit integer so that we can pass them to the coherent-noise functions.
-    nx = MakeInt32Range (x);
-    ny = MakeInt32Range (y);
-    nz = MakeInt32Range (z);
+    // The octaves before the range only advance the frequency and the
+    // persistence.
+    if (curOctave >= firstOctave) {
 
-    // Get the coherent-noise value from the input value and add it to the
-    // final result.
-    seed = (m_seed + curOctave) & 0xffffffff;
-    signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
-    signal = 2.0 * fabs (signal) - 1.0;
-    value += signal * curPersistence;
+      // Get the coherent-noise value from the input value and add it to the
+      // final result.
+      seed = (m_seed + curOctave) & 0xffffffff;
+      if (isPeriodic) {
+        // Fit a whole number of lattice cells into each period so that this
+        // octave repeats along with the others.
+        nx = MakePeriodicCoord (xInput, curFrequency, m_xPeriod, xCells);
+        ny = MakePeriodicCoord (yInput, curFrequency, m_yPeriod, yCells);
+        nz = MakePeriodicCoord (zInput, curFrequency, m_zPeriod, zCells);
+        signal = PeriodicGradientCoherentNoise3D (nx, ny, nz, xCells,
+          yCells, zCells, seed, m_noiseQuality);
+      } else {
+        // Make sure that these floating-point values have the same range as
+        // a 32-bit integer so that we can pass them to the coherent-noise
+        // functions.
+        nx = MakeInt32Range (x);
+        ny = MakeInt32Range (y);
+        nz = MakeInt32Range (z);
+        signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+      }
+      signal = 2.0 * fabs (signal) - 1.0;
+      value += signal * curPersistence;
+    }
 
     // Prepare the next octave.
     x *= m_lacunarity;
     y *= m_lacunarity;
     z *= m_lacunarity;
+    curFrequency *= m_lacunarity;
     curPersistence *= m_persistence;
   }
-  value += 0.5;
+  if (firstOctave == 0) {
+    value += 0.5;
+  }
 
   return value;
 }
+
+double Billow::GetValue (double x, double y, double z) const
+{
+  return GetOctaveRangeValue (x, y, z, 0, m_octaveCount);
+}
@@ -22,6 +22,7 @@
 
 #include "module/blend.h"
 #include "interp.h"
+#include "misc.h"
 
 using namespace noise::module;
 
@@ -30,6 +31,19 @@ Blend::Blend ():
 {
 }
 
+double Blend::GetMaxFrequency () const
+{
+  // The control module multiplies the output values from the source
+  // modules, so its frequencies add to theirs.
+  double frequency0 = GetSourceMaxFrequency (0);
+  double frequency1 = GetSourceMaxFrequency (1);
+  double controlFrequency = GetSourceMaxFrequency (2);
+  if (frequency0 < 0.0 || frequency1 < 0.0 || controlFrequency < 0.0) {
+    return -1.0;
+  }
+  return GetMax (frequency0, frequency1) + controlFrequency;
+}
+
 double Blend::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
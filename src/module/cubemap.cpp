@@ -0,0 +1,263 @@
+// cubemap.cpp
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <string.h>
+#include "byteorder.h"
+#include "cubeface.h"
+#include "interp.h"
+#include "mathconsts.h"
+#include "misc.h"
+#include "module/cubemap.h"
+
+using namespace noise::module;
+
+using namespace noise;
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    // Identifies a cube map written by CubeMap::WriteGrid().
+    const char CUBE_MAP_MAGIC[8] = {
+      'L', 'N', 'C', 'U', 'B', 'E', '\0', '\0'
+    };
+
+    // Version of the cube map format.
+    const noise::uint32 CUBE_MAP_VERSION = 1;
+
+    // Determines if the faces with the given number of grid points along
+    // each edge fit in memory.
+    inline bool IsCubeMapSizeValid (int resolution)
+    {
+      double stride = (double)resolution + 2.0;
+      return 6.0 * stride * stride
+        <= (double)((size_t)-1 / sizeof (float));
+    }
+
+  }
+
+}
+
+CubeMap::CubeMap ():
+  Module (GetSourceModuleCount ()),
+  m_pGrid (NULL),
+  m_interp (DEFAULT_CUBE_MAP_INTERP),
+  m_resolution (DEFAULT_CUBE_MAP_RESOLUTION)
+{
+}
+
+CubeMap::~CubeMap ()
+{
+  ClearGrid ();
+}
+
+void CubeMap::BuildGrid ()
+{
+  if (m_pSourceModule[0] == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // The grid points of a face lie at equal angles from the center of the
+  // cube.  The ring of points beyond the edges of a face continues the
+  // same spacing, so those points lie on the neighboring faces.
+  int stride = m_resolution + 2;
+  float* pGrid = AllocateArray<float> (m_pAllocator, GetGridSize ());
+  try {
+    float* pValue = pGrid;
+    for (int face = 0; face < CUBE_FACE_COUNT; face++) {
+      for (int j = 0; j < stride; j++) {
+        double t = (double)(j - 1) / (double)(m_resolution - 1) * 2.0 - 1.0;
+        for (int i = 0; i < stride; i++) {
+          double s = (double)(i - 1) / (double)(m_resolution - 1) * 2.0
+            - 1.0;
+          double x, y, z;
+          CubeFaceToXYZ ((CubeFace)face, s, t, x, y, z);
+          *pValue++ = (float)m_pSourceModule[0]->GetValue (x, y, z);
+        }
+      }
+    }
+  }
+  catch (...) {
+    DeallocateArray (m_pAllocator, pGrid, GetGridSize ());
+    throw;
+  }
+  ClearGrid ();
+  m_pGrid = pGrid;
+}
+
+void CubeMap::ClearGrid ()
+{
+  DeallocateArray (m_pAllocator, m_pGrid, GetGridSize ());
+  m_pGrid = NULL;
+}
+
+double CubeMap::GetMaxFrequency () const
+{
+  if (m_pGrid == NULL) {
+    return GetSourceMaxFrequency (0);
+  }
+
+  // Each face spans a quarter of a great circle, so the grid cells span
+  // (PI / 2) / (resolution - 1) radians on the unit sphere.  The faces
+  // cannot hold a frequency higher than half a cycle per grid cell.
+  return (double)(m_resolution - 1) / PI;
+}
+
+double CubeMap::GetValue (double x, double y, double z) const
+{
+  if (m_pGrid == NULL) {
+    assert (m_pSourceModule[0] != NULL);
+    return m_pSourceModule[0]->GetValue (x, y, z);
+  }
+
+  // Convert the direction of the input value into grid coordinates on a
+  // face; the grid points of the face are numbered from 1 because of the
+  // ring of points beyond its edges.
+  double input[2];
+  CubeFace face = XYZToCubeFace (x, y, z, input[0], input[1]);
+  double alpha[2];
+  int offsets[2][4];
+  int stride = m_resolution + 2;
+  for (int axis = 0; axis < 2; axis++) {
+    double position = (input[axis] + 1.0) * 0.5
+      * (double)(m_resolution - 1) + 1.0;
+    position = GetMin (GetMax (position, 1.0), (double)m_resolution);
+    int cell = GetMin ((int)position, m_resolution - 1);
+    alpha[axis] = position - (double)cell;
+    for (int n = 0; n < 4; n++) {
+      offsets[axis][n] = cell - 1 + n;
+    }
+  }
+  for (int n = 0; n < 4; n++) {
+    offsets[1][n] *= stride;
+  }
+  const float* pFace = m_pGrid + (size_t)face * (size_t)stride
+    * (size_t)stride;
+
+  if (m_interp == RESAMPLE_LINEAR) {
+    const float* pRow0 = pFace + offsets[1][1];
+    const float* pRow1 = pFace + offsets[1][2];
+    return LinearInterp (
+      LinearInterp (pRow0[offsets[0][1]], pRow0[offsets[0][2]], alpha[0]),
+      LinearInterp (pRow1[offsets[0][1]], pRow1[offsets[0][2]], alpha[0]),
+      alpha[1]);
+  }
+
+  double rows[4];
+  for (int j = 0; j < 4; j++) {
+    const float* pRow = pFace + offsets[1][j];
+    rows[j] = CatmullRomInterp (pRow[offsets[0][0]], pRow[offsets[0][1]],
+      pRow[offsets[0][2]], pRow[offsets[0][3]], alpha[0]);
+  }
+  return CatmullRomInterp (rows[0], rows[1], rows[2], rows[3], alpha[1]);
+}
+
+void CubeMap::ReadGrid (std::istream& is)
+{
+  // Read and check the header before allocating the faces.
+  char magic[sizeof (CUBE_MAP_MAGIC)];
+  is.read (magic, sizeof (magic));
+  noise::uint32 version    = ReadLittle32 (is);
+  noise::uint32 interp     = ReadLittle32 (is);
+  noise::uint32 resolution = ReadLittle32 (is);
+  if (!is.good ()
+    || memcmp (magic, CUBE_MAP_MAGIC, sizeof (magic)) != 0
+    || version != CUBE_MAP_VERSION
+    || (interp != RESAMPLE_LINEAR && interp != RESAMPLE_CUBIC)
+    || resolution < 4 || resolution > 0x7fffffff
+    || !IsCubeMapSizeValid ((int)resolution)) {
+    throw noise::ExceptionUnknown ();
+  }
+
+  size_t stride = (size_t)resolution + 2;
+  size_t size = 6 * stride * stride;
+  float* pGrid = AllocateArray<float> (m_pAllocator, size);
+  for (size_t i = 0; i < size; i++) {
+    pGrid[i] = ReadLittleFloat (is);
+  }
+  if (!is.good ()) {
+    DeallocateArray (m_pAllocator, pGrid, size);
+    throw noise::ExceptionUnknown ();
+  }
+
+  ClearGrid ();
+  m_pGrid = pGrid;
+  m_interp = (ResampleInterp)interp;
+  m_resolution = (int)resolution;
+}
+
+void CubeMap::SetAllocator (Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the faces into memory from the new allocator before the base
+  // class switches to that allocator; faces that were read cannot be built
+  // again.
+  Allocator* pOldAllocator = m_pAllocator;
+  float* pNewGrid = NULL;
+  if (m_pGrid != NULL) {
+    pNewGrid = AllocateArray<float> (pAllocator, GetGridSize ());
+    memcpy (pNewGrid, m_pGrid, GetGridSize () * sizeof (float));
+  }
+  try {
+    Module::SetAllocator (pAllocator);
+  }
+  catch (...) {
+    DeallocateArray (pAllocator, pNewGrid, GetGridSize ());
+    throw;
+  }
+  DeallocateArray (pOldAllocator, m_pGrid, GetGridSize ());
+  m_pGrid = pNewGrid;
+}
+
+void CubeMap::SetResolution (int resolution)
+{
+  if (resolution < 4 || !IsCubeMapSizeValid (resolution)) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  ClearGrid ();
+  m_resolution = resolution;
+}
+
+void CubeMap::WriteGrid (std::ostream& os) const
+{
+  if (m_pGrid == NULL) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  os.write (CUBE_MAP_MAGIC, sizeof (CUBE_MAP_MAGIC));
+  WriteLittle32 (os, CUBE_MAP_VERSION);
+  WriteLittle32 (os, (noise::uint32)m_interp);
+  WriteLittle32 (os, (noise::uint32)m_resolution);
+  size_t size = GetGridSize ();
+  for (size_t i = 0; i < size; i++) {
+    WriteLittleFloat (os, m_pGrid[i]);
+  }
+  if (!os.good ()) {
+    throw noise::ExceptionUnknown ();
+  }
+}
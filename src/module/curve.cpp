@@ -35,7 +35,7 @@ Curve::Curve ():
 
 Curve::~Curve ()
 {
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
 }
 
 void Curve::AddControlPoint (double inputValue, double outputValue)
@@ -49,7 +49,7 @@ void Curve::AddControlPoint (double inputValue, double outputValue)
 
 void Curve::ClearAllControlPoints ()
 {
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
   m_pControlPoints = NULL;
   m_controlPointCount = 0;
 }
@@ -124,7 +124,8 @@ void Curve::InsertAtPos (int insertionPos, double inputValue,
   // control point array.  The position is determined by the input value of
   // the control point; the control points must be sorted by input value
   // within that array.
-  ControlPoint* newControlPoints = new ControlPoint[m_controlPointCount + 1];
+  ControlPoint* newControlPoints = AllocateArray<ControlPoint> (m_pAllocator,
+    m_controlPointCount + 1);
   for (int i = 0; i < m_controlPointCount; i++) {
     if (i < insertionPos) {
       newControlPoints[i] = m_pControlPoints[i];
@@ -132,7 +133,7 @@ void Curve::InsertAtPos (int insertionPos, double inputValue,
       newControlPoints[i + 1] = m_pControlPoints[i];
     }
   }
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
   m_pControlPoints = newControlPoints;
   ++m_controlPointCount;
 
@@ -141,3 +142,34 @@ void Curve::InsertAtPos (int insertionPos, double inputValue,
   m_pControlPoints[insertionPos].inputValue  = inputValue ;
   m_pControlPoints[insertionPos].outputValue = outputValue;
 }
+
+void Curve::SetAllocator (Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the control point array into memory from the new allocator before
+  // the base class switches to that allocator.
+  Allocator* pOldAllocator = m_pAllocator;
+  ControlPoint* newControlPoints = NULL;
+  if (m_pControlPoints != NULL) {
+    newControlPoints = AllocateArray<ControlPoint> (pAllocator,
+      m_controlPointCount);
+    for (int i = 0; i < m_controlPointCount; i++) {
+      newControlPoints[i] = m_pControlPoints[i];
+    }
+  }
+  try {
+    Module::SetAllocator (pAllocator);
+  }
+  catch (...) {
+    DeallocateArray (pAllocator, newControlPoints, m_controlPointCount);
+    throw;
+  }
+  DeallocateArray (pOldAllocator, m_pControlPoints, m_controlPointCount);
+  m_pControlPoints = newControlPoints;
+}
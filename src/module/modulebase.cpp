@@ -24,23 +24,46 @@
 
 using namespace noise::module;
 
-Module::Module (int sourceModuleCount)
+Module::Module (int sourceModuleCount):
+  m_pAllocator (GetDefaultAllocator ()),
+  m_pSourceModule (NULL),
+  m_sourceModuleCount (0)
 {
-  m_pSourceModule = NULL;
-
   // Create an array of pointers to all source modules required by this
   // noise module.  Set these pointers to NULL.
   if (sourceModuleCount > 0) {
-    m_pSourceModule = new const Module*[sourceModuleCount];
+    m_pSourceModule = AllocateArray<const Module*> (m_pAllocator,
+      sourceModuleCount);
     for (int i = 0; i < sourceModuleCount; i++) {
       m_pSourceModule[i] = NULL;
     }
-  } else {
-    m_pSourceModule = NULL;
+    m_sourceModuleCount = sourceModuleCount;
   }
 }
 
 Module::~Module ()
 {
-  delete[] m_pSourceModule;
+  DeallocateArray (m_pAllocator, m_pSourceModule, m_sourceModuleCount);
+}
+
+void Module::SetAllocator (Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the source module array into memory from the new allocator.
+  if (m_pSourceModule != NULL) {
+    const Module** pNewSourceModule = AllocateArray<const Module*> (
+      pAllocator, m_sourceModuleCount);
+    for (int i = 0; i < m_sourceModuleCount; i++) {
+      pNewSourceModule[i] = m_pSourceModule[i];
+    }
+    DeallocateArray (m_pAllocator, m_pSourceModule, m_sourceModuleCount);
+    m_pSourceModule = pNewSourceModule;
+  }
+  m_pAllocator = pAllocator;
 }
@@ -29,6 +29,18 @@ Multiply::Multiply ():
 {
 }
 
+double Multiply::GetMaxFrequency () const
+{
+  // The frequencies of a product are sums of the frequencies of its
+  // factors.
+  double frequency0 = GetSourceMaxFrequency (0);
+  double frequency1 = GetSourceMaxFrequency (1);
+  if (frequency0 < 0.0 || frequency1 < 0.0) {
+    return -1.0;
+  }
+  return frequency0 + frequency1;
+}
+
 double Multiply::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -0,0 +1,295 @@
+// resample.cpp
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "interp.h"
+#include "misc.h"
+#include "module/resample.h"
+
+using namespace noise::module;
+
+using namespace noise;
+
+Resample::Resample ():
+  Module (GetSourceModuleCount ()),
+  m_errorBudget (DEFAULT_RESAMPLE_ERROR_BUDGET),
+  m_interp (DEFAULT_RESAMPLE_INTERP),
+  m_latticeCountX (0),
+  m_latticeCountY (0),
+  m_latticeCountZ (0),
+  m_latticeSpacing (0.0),
+  m_latticeX0 (0),
+  m_latticeY0 (0),
+  m_latticeZ0 (0),
+  m_maxFrequency (0.0),
+  m_pLattice (NULL),
+  m_samplesPerCycle (DEFAULT_RESAMPLE_SAMPLES_PER_CYCLE),
+  m_spacing (0.0),
+  m_status (RESAMPLE_UNPREPARED)
+{
+}
+
+Resample::~Resample ()
+{
+  FreeLattice ();
+}
+
+bool Resample::BuildLattice (const double lower[3], const double upper[3],
+  double spacing)
+{
+  // Find the lattice points around the box.
+  int margin = (m_interp == RESAMPLE_CUBIC)? 1: 0;
+  noise::int64 first[3];
+  int count[3];
+  double size = 1.0;
+  for (int axis = 0; axis < 3; axis++) {
+    double firstIndex = floor (lower[axis] / spacing) - margin;
+    double lastIndex  = floor (upper[axis] / spacing) + 1 + margin;
+    size *= lastIndex - firstIndex + 1.0;
+    if (!(size <= (double)RESAMPLE_MAX_LATTICE_SIZE)) {
+      return false;
+    }
+    first[axis] = (noise::int64)firstIndex;
+    count[axis] = (int)(lastIndex - firstIndex + 1.0);
+  }
+
+  // Calculate the source module at each lattice point.
+  double* pLattice = AllocateArray<double> (m_pAllocator, (size_t)size);
+  try {
+    double* pValue = pLattice;
+    for (int k = 0; k < count[2]; k++) {
+      double z = (double)(first[2] + k) * spacing;
+      for (int j = 0; j < count[1]; j++) {
+        double y = (double)(first[1] + j) * spacing;
+        for (int i = 0; i < count[0]; i++) {
+          double x = (double)(first[0] + i) * spacing;
+          *pValue++ = m_pSourceModule[0]->GetValue (x, y, z);
+        }
+      }
+    }
+  }
+  catch (...) {
+    DeallocateArray (m_pAllocator, pLattice, (size_t)size);
+    throw;
+  }
+  FreeLattice ();
+  m_pLattice = pLattice;
+  m_latticeCountX = count[0];
+  m_latticeCountY = count[1];
+  m_latticeCountZ = count[2];
+  m_latticeSpacing = spacing;
+  m_latticeX0 = first[0];
+  m_latticeY0 = first[1];
+  m_latticeZ0 = first[2];
+  return true;
+}
+
+double Resample::CalcLatticeSpacing (double frequency)
+{
+  double spacing = 1.0 / (frequency * m_samplesPerCycle);
+  if (m_errorBudget <= 0.0) {
+    return spacing;
+  }
+
+  // Check the error on a fixed cube at the origin instead of on the box
+  // being prepared, so that every box gets the same spacing and the
+  // lattices of neighboring boxes interpolate the same lattice points.
+  double extent = RESAMPLE_CALIBRATION_CELLS * spacing;
+  const double lower[3] = {0.0, 0.0, 0.0};
+  const double upper[3] = {extent, extent, extent};
+  for (;;) {
+    if (!BuildLattice (lower, upper, spacing)) {
+      return -1.0;
+    }
+    if (GetLatticeError () <= m_errorBudget) {
+      return spacing;
+    }
+    spacing *= 0.5;
+  }
+}
+
+void Resample::ClearLattice ()
+{
+  FreeLattice ();
+  m_spacing = 0.0;
+  m_status = RESAMPLE_UNPREPARED;
+}
+
+void Resample::FreeLattice ()
+{
+  DeallocateArray (m_pAllocator, m_pLattice, (size_t)m_latticeCountX
+    * (size_t)m_latticeCountY * (size_t)m_latticeCountZ);
+  m_pLattice = NULL;
+  m_latticeCountX = 0;
+  m_latticeCountY = 0;
+  m_latticeCountZ = 0;
+}
+
+double Resample::GetLatticeError () const
+{
+  // Interpolation is least accurate at the center of a cell.  Only the
+  // cells that the lattice can interpolate are checked.
+  int margin = (m_interp == RESAMPLE_CUBIC)? 1: 0;
+  double error = 0.0;
+  for (int k = margin; k < m_latticeCountZ - 1 - margin; k++) {
+    double z = ((double)(m_latticeZ0 + k) + 0.5) * m_latticeSpacing;
+    for (int j = margin; j < m_latticeCountY - 1 - margin; j++) {
+      double y = ((double)(m_latticeY0 + j) + 0.5) * m_latticeSpacing;
+      for (int i = margin; i < m_latticeCountX - 1 - margin; i++) {
+        double x = ((double)(m_latticeX0 + i) + 0.5) * m_latticeSpacing;
+        double value;
+        if (InterpLattice (x, y, z, value)) {
+          error = GetMax (error,
+            fabs (m_pSourceModule[0]->GetValue (x, y, z) - value));
+        }
+      }
+    }
+  }
+  return error;
+}
+
+double Resample::GetValue (double x, double y, double z) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  // Calculate the input values that the lattice does not cover directly.
+  double value;
+  if (!InterpLattice (x, y, z, value)) {
+    value = m_pSourceModule[0]->GetValue (x, y, z);
+  }
+  return value;
+}
+
+bool Resample::InterpLattice (double x, double y, double z, double& value)
+  const
+{
+  if (m_pLattice == NULL) {
+    return false;
+  }
+
+  // Find the lattice cell that contains the input value.  Cubic
+  // interpolation also needs the lattice points around the cell.
+  double cellX = floor (x / m_latticeSpacing);
+  double cellY = floor (y / m_latticeSpacing);
+  double cellZ = floor (z / m_latticeSpacing);
+  double alphaX = x / m_latticeSpacing - cellX;
+  double alphaY = y / m_latticeSpacing - cellY;
+  double alphaZ = z / m_latticeSpacing - cellZ;
+  cellX -= (double)m_latticeX0;
+  cellY -= (double)m_latticeY0;
+  cellZ -= (double)m_latticeZ0;
+  int margin = (m_interp == RESAMPLE_CUBIC)? 1: 0;
+  if (!(cellX >= margin && cellX <= m_latticeCountX - 2 - margin
+    &&  cellY >= margin && cellY <= m_latticeCountY - 2 - margin
+    &&  cellZ >= margin && cellZ <= m_latticeCountZ - 2 - margin)) {
+    return false;
+  }
+  size_t strideY = (size_t)m_latticeCountX;
+  size_t strideZ = strideY * (size_t)m_latticeCountY;
+  const double* pCorner = m_pLattice + ((size_t)cellZ - margin) * strideZ
+    + ((size_t)cellY - margin) * strideY + ((size_t)cellX - margin);
+
+  if (m_interp == RESAMPLE_LINEAR) {
+    double rows[2][2];
+    for (int k = 0; k < 2; k++) {
+      for (int j = 0; j < 2; j++) {
+        const double* pRow = pCorner + k * strideZ + j * strideY;
+        rows[k][j] = LinearInterp (pRow[0], pRow[1], alphaX);
+      }
+    }
+    value = LinearInterp (
+      LinearInterp (rows[0][0], rows[0][1], alphaY),
+      LinearInterp (rows[1][0], rows[1][1], alphaY), alphaZ);
+  } else {
+    double planes[4];
+    for (int k = 0; k < 4; k++) {
+      double rows[4];
+      for (int j = 0; j < 4; j++) {
+        const double* pRow = pCorner + k * strideZ + j * strideY;
+        rows[j] = CatmullRomInterp (pRow[0], pRow[1], pRow[2], pRow[3],
+          alphaX);
+      }
+      planes[k] = CatmullRomInterp (rows[0], rows[1], rows[2], rows[3],
+        alphaY);
+    }
+    value = CatmullRomInterp (planes[0], planes[1], planes[2], planes[3],
+      alphaZ);
+  }
+  return true;
+}
+
+void Resample::Prepare (double lowerX, double lowerY, double lowerZ,
+  double upperX, double upperY, double upperZ)
+{
+  if (m_pSourceModule[0] == NULL
+    || !(lowerX <= upperX && lowerY <= upperY && lowerZ <= upperZ)) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  // A source module whose frequency is unknown is always calculated
+  // directly.
+  double frequency = GetMaxFrequency ();
+  if (frequency < 0.0) {
+    FreeLattice ();
+    m_status = RESAMPLE_UNKNOWN_FREQUENCY;
+    return;
+  }
+
+  // Keep a lattice that already covers the box.
+  double corner;
+  if (InterpLattice (lowerX, lowerY, lowerZ, corner)
+    && InterpLattice (upperX, upperY, upperZ, corner)) {
+    m_status = RESAMPLE_LATTICE;
+    return;
+  }
+
+  // The spacing is calculated once from the source module.  A constant
+  // source module is interpolated exactly, so it needs only a single cell
+  // over the box.
+  double spacing;
+  if (frequency > 0.0) {
+    if (m_spacing == 0.0) {
+      m_spacing = CalcLatticeSpacing (frequency);
+    }
+    spacing = m_spacing;
+  } else {
+    spacing = GetMax (GetMax (upperX - lowerX, upperY - lowerY),
+      upperZ - lowerZ);
+    if (spacing <= 0.0) {
+      spacing = 1.0;
+    }
+  }
+
+  const double lower[3] = {lowerX, lowerY, lowerZ};
+  const double upper[3] = {upperX, upperY, upperZ};
+  if (spacing < 0.0 || !BuildLattice (lower, upper, spacing)) {
+    FreeLattice ();
+    m_status = RESAMPLE_LATTICE_TOO_LARGE;
+    return;
+  }
+  m_status = RESAMPLE_LATTICE;
+}
+
+void Resample::SetAllocator (Allocator* pAllocator)
+{
+  // The next call to Prepare() calculates the lattice again with memory
+  // from the new allocator.  The spacing does not depend on the allocator.
+  FreeLattice ();
+  m_status = RESAMPLE_UNPREPARED;
+  Module::SetAllocator (pAllocator);
+}
@@ -30,7 +30,10 @@ RidgedMulti::RidgedMulti ():
   m_lacunarity   (DEFAULT_RIDGED_LACUNARITY  ),
   m_noiseQuality (DEFAULT_RIDGED_QUALITY     ),
   m_octaveCount  (DEFAULT_RIDGED_OCTAVE_COUNT),
-  m_seed         (DEFAULT_RIDGED_SEED)
+  m_seed         (DEFAULT_RIDGED_SEED),
+  m_xPeriod      (0.0),
+  m_yPeriod      (0.0),
+  m_zPeriod      (0.0)
 {
   CalcSpectralWeights ();
 }
@@ -52,33 +55,63 @@ void RidgedMulti::CalcSpectralWeights ()
 
 // Multifractal code originally written by F. Kenton "Doc Mojo" Musgrave,
 // 1998.  Modified by jas for use with libnoise.
-double RidgedMulti::GetValue (double x, double y, double z) const
+double RidgedMulti::GetOctaveRangeValue (double x, double y, double z,
+  int firstOctave, int lastOctave, double& weight) const
 {
+  if (firstOctave < 0 || firstOctave > lastOctave
+    || lastOctave > RIDGED_MAX_OCTAVE) {
+    throw noise::ExceptionInvalidParam ();
+  }
+
+  bool isPeriodic = IsPeriodic ();
+  double xInput = x;
+  double yInput = y;
+  double zInput = z;
+  double curFrequency = m_frequency;
+
   x *= m_frequency;
   y *= m_frequency;
   z *= m_frequency;
 
+  // Skip the octaves before the range.
+  for (int curOctave = 0; curOctave < firstOctave; curOctave++) {
+    x *= m_lacunarity;
+    y *= m_lacunarity;
+    z *= m_lacunarity;
+    curFrequency *= m_lacunarity;
+  }
+
   double signal = 0.0;
   double value  = 0.0;
-  double weight = 1.0;
 
   // These parameters should be user-defined; they may be exposed in a
   // future version of libnoise.
   double offset = 1.0;
   double gain = 2.0;
 
-  for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
-
-    // Make sure that these floating-point values have the same range as a 32-
-    // bit integer so that we can pass them to the coherent-noise functions.
-    double nx, ny, nz;
-    nx = MakeInt32Range (x);
-    ny = MakeInt32Range (y);
-    nz = MakeInt32Range (z);
+  for (int curOctave = firstOctave; curOctave < lastOctave; curOctave++) {
 
     // Get the coherent-noise value.
+    double nx, ny, nz;
     int seed = (m_seed + curOctave) & 0x7fffffff;
-    signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    if (isPeriodic) {
+      // Fit a whole number of lattice cells into each period so that this
+      // octave repeats along with the others.
+      int xCells, yCells, zCells;
+      nx = MakePeriodicCoord (xInput, curFrequency, m_xPeriod, xCells);
+      ny = MakePeriodicCoord (yInput, curFrequency, m_yPeriod, yCells);
+      nz = MakePeriodicCoord (zInput, curFrequency, m_zPeriod, zCells);
+      signal = PeriodicGradientCoherentNoise3D (nx, ny, nz, xCells, yCells,
+        zCells, seed, m_noiseQuality);
+    } else {
+      // Make sure that these floating-point values have the same range as a
+      // 32-bit integer so that we can pass them to the coherent-noise
+      // functions.
+      nx = MakeInt32Range (x);
+      ny = MakeInt32Range (y);
+      nz = MakeInt32Range (z);
+      signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    }
 
     // Make the ridges.
     signal = fabs (signal);
@@ -108,7 +141,17 @@ double RidgedMulti::GetValue (double x, double y, double z) const
     x *= m_lacunarity;
     y *= m_lacunarity;
     z *= m_lacunarity;
+    curFrequency *= m_lacunarity;
+  }
+
+  if (firstOctave == 0) {
+    return (value * 1.25) - 1.0;
   }
+  return value * 1.25;
+}
 
-  return (value * 1.25) - 1.0;
+double RidgedMulti::GetValue (double x, double y, double z) const
+{
+  double weight = 1.0;
+  return GetOctaveRangeValue (x, y, z, 0, m_octaveCount, weight);
 }
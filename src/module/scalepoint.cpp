@@ -20,6 +20,7 @@
 // off every 'zig'.)
 //
 
+#include "misc.h"
 #include "module/scalepoint.h"
 
 using namespace noise::module;
@@ -32,6 +33,16 @@ ScalePoint::ScalePoint ():
 {
 }
 
+double ScalePoint::GetMaxFrequency () const
+{
+  double frequency = GetSourceMaxFrequency (0);
+  if (frequency < 0.0) {
+    return -1.0;
+  }
+  return frequency * GetMax (GetMax (fabs (m_xScale), fabs (m_yScale)),
+    fabs (m_zScale));
+}
+
 double ScalePoint::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -38,7 +38,7 @@ Terrace::Terrace ():
 
 Terrace::~Terrace ()
 {
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
 }
 
 void Terrace::AddControlPoint (double value)
@@ -52,7 +52,7 @@ void Terrace::AddControlPoint (double value)
 
 void Terrace::ClearAllControlPoints ()
 {
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
   m_pControlPoints = NULL;
   m_controlPointCount = 0;
 }
@@ -126,7 +126,8 @@ void Terrace::InsertAtPos (int insertionPos, double value)
   // the control point array.  The position is determined by the value of
   // the control point; the control points must be sorted by value within
   // that array.
-  double* newControlPoints = new double[m_controlPointCount + 1];
+  double* newControlPoints = AllocateArray<double> (m_pAllocator,
+    m_controlPointCount + 1);
   for (int i = 0; i < m_controlPointCount; i++) {
     if (i < insertionPos) {
       newControlPoints[i] = m_pControlPoints[i];
@@ -134,7 +135,7 @@ void Terrace::InsertAtPos (int insertionPos, double value)
       newControlPoints[i + 1] = m_pControlPoints[i];
     }
   }
-  delete[] m_pControlPoints;
+  DeallocateArray (m_pAllocator, m_pControlPoints, m_controlPointCount);
   m_pControlPoints = newControlPoints;
   ++m_controlPointCount;
 
@@ -158,3 +159,34 @@ void Terrace::MakeControlPoints (int controlPointCount)
     curValue += terraceStep;
   }
 }
+
+void Terrace::SetAllocator (Allocator* pAllocator)
+{
+  if (pAllocator == NULL) {
+    pAllocator = GetDefaultAllocator ();
+  }
+  if (pAllocator == m_pAllocator) {
+    return;
+  }
+
+  // Copy the control point array into memory from the new allocator before
+  // the base class switches to that allocator.
+  Allocator* pOldAllocator = m_pAllocator;
+  double* newControlPoints = NULL;
+  if (m_pControlPoints != NULL) {
+    newControlPoints = AllocateArray<double> (pAllocator,
+      m_controlPointCount);
+    for (int i = 0; i < m_controlPointCount; i++) {
+      newControlPoints[i] = m_pControlPoints[i];
+    }
+  }
+  try {
+    Module::SetAllocator (pAllocator);
+  }
+  catch (...) {
+    DeallocateArray (pAllocator, newControlPoints, m_controlPointCount);
+    throw;
+  }
+  DeallocateArray (pOldAllocator, m_pControlPoints, m_controlPointCount);
+  m_pControlPoints = newControlPoints;
+}
@@ -30,7 +30,10 @@ Voronoi::Voronoi ():
   m_displacement   (DEFAULT_VORONOI_DISPLACEMENT),
   m_enableDistance (false                       ),
   m_frequency      (DEFAULT_VORONOI_FREQUENCY   ),
-  m_seed           (DEFAULT_VORONOI_SEED        )
+  m_seed           (DEFAULT_VORONOI_SEED        ),
+  m_xPeriod        (0.0                         ),
+  m_yPeriod        (0.0                         ),
+  m_zPeriod        (0.0                         )
 {
 }
 
@@ -39,9 +42,24 @@ double Voronoi::GetValue (double x, double y, double z) const
   // This method could be more efficient by caching the seed values.  Fix
   // later.
 
-  x *= m_frequency;
-  y *= m_frequency;
-  z *= m_frequency;
+  // Along a periodic axis, the seed points repeat every xCells cells, so
+  // move the input value into the first period and hash the wrapped cell
+  // coordinates.  Along the other axes, the cell counts are 0.
+  int xCells = 0;
+  int yCells = 0;
+  int zCells = 0;
+  if (IsPeriodic ()) {
+    x = WrapPeriodicCoord (MakePeriodicCoord (x, m_frequency, m_xPeriod,
+      xCells), xCells);
+    y = WrapPeriodicCoord (MakePeriodicCoord (y, m_frequency, m_yPeriod,
+      yCells), yCells);
+    z = WrapPeriodicCoord (MakePeriodicCoord (z, m_frequency, m_zPeriod,
+      zCells), zCells);
+  } else {
+    x *= m_frequency;
+    y *= m_frequency;
+    z *= m_frequency;
+  }
 
   int xInt = (x > 0.0? (int)x: (int)x - 1);
   int yInt = (y > 0.0? (int)y: (int)y - 1);
@@ -61,9 +79,12 @@ double Voronoi::GetValue (double x, double y, double z) const
 
         // Calculate the position and distance to the seed point inside of
         // this unit cube.
-        double xPos = xCur + ValueNoise3D (xCur, yCur, zCur, m_seed    );
-        double yPos = yCur + ValueNoise3D (xCur, yCur, zCur, m_seed + 1);
-        double zPos = zCur + ValueNoise3D (xCur, yCur, zCur, m_seed + 2);
+        int xHash = WrapLatticeCoord (xCur, xCells);
+        int yHash = WrapLatticeCoord (yCur, yCells);
+        int zHash = WrapLatticeCoord (zCur, zCells);
+        double xPos = xCur + ValueNoise3D (xHash, yHash, zHash, m_seed    );
+        double yPos = yCur + ValueNoise3D (xHash, yHash, zHash, m_seed + 1);
+        double zPos = zCur + ValueNoise3D (xHash, yHash, zHash, m_seed + 2);
         double xDist = xPos - x;
         double yDist = yPos - y;
         double zDist = zPos - z;
@@ -95,7 +116,7 @@ double Voronoi::GetValue (double x, double y, double z) const
 
   // Return the calculated distance with the displacement value applied.
   return value + (m_displacement * (double)ValueNoise3D (
-    (int)(floor (xCandidate)),
-    (int)(floor (yCandidate)),
-    (int)(floor (zCandidate))));
+    WrapLatticeCoord ((int)(floor (xCandidate)), xCells),
+    WrapLatticeCoord ((int)(floor (yCandidate)), yCells),
+    WrapLatticeCoord ((int)(floor (zCandidate)), zCells)));
 }
@@ -0,0 +1,169 @@
+// allocator.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_ALLOCATOR_H
+#define NOISE_ALLOCATOR_H
+
+#include <stddef.h>
+#include <new>
+#include "exception.h"
+
+namespace noise
+{
+
+  /// @addtogroup libnoise
+  /// @{
+
+  /// Abstract base class for a memory allocator.
+  ///
+  /// Every buffer that libnoise and noiseutils allocate, such as the source
+  /// module arrays of noise modules, the control points of curves and
+  /// terraces, and the buffers of noise maps and images, comes from an
+  /// allocator.  An application that tracks its memory or serves
+  /// short-lived builds from an arena can derive a class from this class
+  /// and pass it to the SetDefaultAllocator() function or to the
+  /// SetAllocator() method of an object.  The HeapAllocator class is the
+  /// allocator supplied by this library.
+  ///
+  /// An object takes the default allocator when it is constructed and
+  /// frees its memory with the same allocator, so changing the default
+  /// allocator later does not affect existing objects.  An allocator must
+  /// exist until every object that uses it is destroyed.
+  ///
+  /// An allocator may be called from several threads at the same time.
+  class Allocator
+  {
+
+    public:
+
+      /// Destructor.
+      virtual ~Allocator ()
+      {
+      }
+
+      /// Allocates a block of memory.
+      ///
+      /// @param byteCount The size of the block, in bytes.
+      /// @param alignment The alignment of the block, in bytes.
+      ///
+      /// @returns A pointer to the block.
+      ///
+      /// @pre The size is positive.
+      /// @pre The alignment is a power of two.
+      ///
+      /// @throw noise::ExceptionOutOfMemory Out of memory.
+      ///
+      /// The returned pointer is a multiple of @a alignment and is never
+      /// @a NULL.
+      virtual void* Allocate (size_t byteCount, size_t alignment) = 0;
+
+      /// Frees a block of memory.
+      ///
+      /// @param pMemory A pointer to the block.
+      /// @param byteCount The size of the block, in bytes.
+      /// @param alignment The alignment of the block, in bytes.
+      ///
+      /// @pre The block was returned by the Allocate() method of this
+      /// allocator, and @a byteCount and @a alignment are the values
+      /// passed to that call.
+      virtual void Deallocate (void* pMemory, size_t byteCount,
+        size_t alignment) = 0;
+
+  };
+
+  /// An allocator that allocates memory from the heap.
+  ///
+  /// This is the default allocator.  It uses @a posix_memalign, or
+  /// @a _aligned_malloc on Windows, so blocks of any alignment can be
+  /// allocated.
+  class HeapAllocator: public Allocator
+  {
+
+    public:
+
+      virtual void* Allocate (size_t byteCount, size_t alignment);
+
+      virtual void Deallocate (void* pMemory, size_t byteCount,
+        size_t alignment);
+
+  };
+
+  /// Returns the allocator that new objects take.
+  ///
+  /// @returns The default allocator.
+  ///
+  /// Until the application calls the SetDefaultAllocator() function, the
+  /// default allocator is a HeapAllocator object.
+  Allocator* GetDefaultAllocator ();
+
+  /// Sets the allocator that new objects take.
+  ///
+  /// @param pAllocator The allocator, or @a NULL to use the heap.
+  ///
+  /// Objects that already exist keep their allocators.  Call this function
+  /// during initialization, before other threads create objects.
+  void SetDefaultAllocator (Allocator* pAllocator);
+
+  /// Allocates and default-constructs an array of objects.
+  ///
+  /// @param pAllocator The allocator.
+  /// @param count The number of objects.
+  ///
+  /// @returns A pointer to the first object.
+  ///
+  /// @pre The number of objects is positive.
+  ///
+  /// @throw noise::ExceptionOutOfMemory Out of memory.
+  ///
+  /// Free the array with the DeallocateArray() function.
+  template <class T> T* AllocateArray (Allocator* pAllocator, size_t count)
+  {
+    if (count > (size_t)-1 / sizeof (T)) {
+      throw noise::ExceptionOutOfMemory ();
+    }
+    T* pArray = (T*)pAllocator->Allocate (count * sizeof (T), alignof (T));
+    for (size_t i = 0; i < count; i++) {
+      new (pArray + i) T;
+    }
+    return pArray;
+  }
+
+  /// Destroys and frees an array allocated by the AllocateArray() function.
+  ///
+  /// @param pAllocator The allocator passed to AllocateArray().
+  /// @param pArray A pointer to the first object, or @a NULL.
+  /// @param count The number of objects passed to AllocateArray().
+  ///
+  /// This function does nothing if @a pArray is @a NULL.
+  template <class T> void DeallocateArray (Allocator* pAllocator, T* pArray,
+    size_t count)
+  {
+    if (pArray != NULL) {
+      for (size_t i = 0; i < count; i++) {
+        pArray[i].~T ();
+      }
+      pAllocator->Deallocate (pArray, count * sizeof (T), alignof (T));
+    }
+  }
+
+  /// @}
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+// byteorder.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_BYTEORDER_H
+#define NOISE_BYTEORDER_H
+
+#include <istream>
+#include <ostream>
+#include <string.h>
+#include "basictypes.h"
+
+namespace noise
+{
+
+  /// @addtogroup libnoise
+  /// @{
+
+  /// Reads a little-endian 32-bit unsigned integer from a stream.
+  ///
+  /// @param is The stream to read from.
+  ///
+  /// @returns The integer.
+  ///
+  /// If the stream could not be read, its state says so and the returned
+  /// value is undefined.
+  inline noise::uint32 ReadLittle32 (std::istream& is)
+  {
+    unsigned char bytes[4] = {0, 0, 0, 0};
+    is.read ((char*)bytes, sizeof (bytes));
+    return (noise::uint32)bytes[0]
+      | ((noise::uint32)bytes[1] <<  8)
+      | ((noise::uint32)bytes[2] << 16)
+      | ((noise::uint32)bytes[3] << 24);
+  }
+
+  /// Reads a little-endian 64-bit floating-point number from a stream.
+  ///
+  /// @param is The stream to read from.
+  ///
+  /// @returns The number.
+  inline double ReadLittleDouble (std::istream& is)
+  {
+    noise::uint64 bits = (noise::uint64)ReadLittle32 (is);
+    bits |= (noise::uint64)ReadLittle32 (is) << 32;
+    double value;
+    memcpy (&value, &bits, sizeof (value));
+    return value;
+  }
+
+  /// Reads a little-endian 32-bit floating-point number from a stream.
+  ///
+  /// @param is The stream to read from.
+  ///
+  /// @returns The number.
+  inline float ReadLittleFloat (std::istream& is)
+  {
+    noise::uint32 bits = ReadLittle32 (is);
+    float value;
+    memcpy (&value, &bits, sizeof (value));
+    return value;
+  }
+
+  /// Writes a 32-bit unsigned integer to a stream in little-endian order.
+  ///
+  /// @param os The stream to write to.
+  /// @param value The integer.
+  inline void WriteLittle32 (std::ostream& os, noise::uint32 value)
+  {
+    char bytes[4];
+    bytes[0] = (char)( value        & 0xff);
+    bytes[1] = (char)((value >>  8) & 0xff);
+    bytes[2] = (char)((value >> 16) & 0xff);
+    bytes[3] = (char)((value >> 24) & 0xff);
+    os.write (bytes, sizeof (bytes));
+  }
+
+  /// Writes a 64-bit floating-point number to a stream in little-endian
+  /// order.
+  ///
+  /// @param os The stream to write to.
+  /// @param value The number.
+  inline void WriteLittleDouble (std::ostream& os, double value)
+  {
+    noise::uint64 bits;
+    memcpy (&bits, &value, sizeof (bits));
+    WriteLittle32 (os, (noise::uint32)(bits & 0xffffffff));
+    WriteLittle32 (os, (noise::uint32)(bits >> 32));
+  }
+
+  /// Writes a 32-bit floating-point number to a stream in little-endian
+  /// order.
+  ///
+  /// @param os The stream to write to.
+  /// @param value The number.
+  inline void WriteLittleFloat (std::ostream& os, float value)
+  {
+    noise::uint32 bits;
+    memcpy (&bits, &value, sizeof (bits));
+    WriteLittle32 (os, bits);
+  }
+
+  /// @}
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+// cubeface.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_CUBEFACE_H
+#define NOISE_CUBEFACE_H
+
+namespace noise
+{
+
+  /// @addtogroup libnoise
+  /// @{
+
+  /// Enumerates the faces of a cube centered at the origin, each named
+  /// after the axis that passes through its center.
+  ///
+  /// Each face is seen from outside the cube.  Its @a s coordinate
+  /// increases towards the right and its @a t coordinate increases
+  /// upwards, along these axes:
+  /// - +X: @a s along -z, @a t along +y.
+  /// - -X: @a s along +z, @a t along +y.
+  /// - +Y: @a s along +x, @a t along -z.
+  /// - -Y: @a s along +x, @a t along +z.
+  /// - +Z: @a s along +x, @a t along +y.
+  /// - -Z: @a s along -x, @a t along +y.
+  ///
+  /// The four faces around the @a y axis therefore form a strip in the
+  /// order +X, -Z, -X, +Z.
+  enum CubeFace
+  {
+
+    /// The face through which the positive @a x axis passes.
+    CUBE_FACE_POS_X = 0,
+
+    /// The face through which the negative @a x axis passes.
+    CUBE_FACE_NEG_X = 1,
+
+    /// The face through which the positive @a y axis passes.
+    CUBE_FACE_POS_Y = 2,
+
+    /// The face through which the negative @a y axis passes.
+    CUBE_FACE_NEG_Y = 3,
+
+    /// The face through which the positive @a z axis passes.
+    CUBE_FACE_POS_Z = 4,
+
+    /// The face through which the negative @a z axis passes.
+    CUBE_FACE_NEG_Z = 5
+
+  };
+
+  /// The number of faces of a cube.
+  const int CUBE_FACE_COUNT = 6;
+
+  /// Converts coordinates on a face of a cube into 3D Cartesian coordinates
+  /// on a unit sphere.
+  ///
+  /// @param face The face of the cube.
+  /// @param s The horizontal coordinate on the face.
+  /// @param t The vertical coordinate on the face.
+  /// @param x On exit, this parameter contains the @a x coordinate.
+  /// @param y On exit, this parameter contains the @a y coordinate.
+  /// @param z On exit, this parameter contains the @a z coordinate.
+  ///
+  /// @pre @a s and @a t range from @b -1 to @b +1 on the face.
+  ///
+  /// The face coordinates are proportional to the angle from the center
+  /// of the face rather than to the distance on the face, so points with
+  /// evenly spaced coordinates are nearly evenly spaced on the sphere.
+  /// Coordinates slightly beyond @b -1 or @b +1 continue the same spacing
+  /// onto the neighboring faces.
+  void CubeFaceToXYZ (CubeFace face, double s, double t, double& x,
+    double& y, double& z);
+
+  /// Converts 3D Cartesian coordinates into coordinates on the face of a
+  /// cube that the direction of the point passes through.
+  ///
+  /// @param x The @a x coordinate.
+  /// @param y The @a y coordinate.
+  /// @param z The @a z coordinate.
+  /// @param s On exit, this parameter contains the horizontal coordinate
+  /// on the face.
+  /// @param t On exit, this parameter contains the vertical coordinate on
+  /// the face.
+  ///
+  /// @returns The face that the direction of the point passes through.
+  ///
+  /// This function is the inverse of CubeFaceToXYZ(); the distance of the
+  /// point from the origin is ignored.  The origin itself lies at the
+  /// center of the +X face.
+  CubeFace XYZToCubeFace (double x, double y, double z, double& s,
+    double& t);
+
+  /// @}
+
+}
+
+#endif
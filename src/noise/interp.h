@@ -29,6 +29,33 @@ namespace noise
   /// @addtogroup libnoise
   /// @{
 
+  /// Performs Catmull-Rom spline interpolation between two values bound
+  /// between two other values.
+  ///
+  /// @param n0 The value before the first value.
+  /// @param n1 The first value.
+  /// @param n2 The second value.
+  /// @param n3 The value after the second value.
+  /// @param a The alpha value.
+  ///
+  /// @returns The interpolated value.
+  ///
+  /// The alpha value should range from 0.0 to 1.0.  If the alpha value is
+  /// 0.0, this function returns @a n1.  If the alpha value is 1.0, this
+  /// function returns @a n2.
+  ///
+  /// Unlike CubicInterp(), this function reproduces values sampled from a
+  /// quadratic function exactly, so it is suited to resampling smooth
+  /// values from evenly spaced samples.
+  inline double CatmullRomInterp (double n0, double n1, double n2,
+    double n3, double a)
+  {
+    double p = 3.0 * (n1 - n2) + n3 - n0;
+    double q = 2.0 * n0 - 5.0 * n1 + 4.0 * n2 - n3;
+    double r = n2 - n0;
+    return n1 + 0.5 * a * (r + a * (q + a * p));
+  }
+
   /// Performs cubic interpolation between two values bound between two other
   /// values.
   ///
@@ -55,6 +55,8 @@ namespace noise
         /// Constructor.
         Add ();
 
+        virtual double GetMaxFrequency () const;
+
         virtual int GetSourceModuleCount () const
         {
           return 2;
@@ -0,0 +1,325 @@
+// bake.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_MODULE_BAKE_H
+#define NOISE_MODULE_BAKE_H
+
+#include <iosfwd>
+#include "modulebase.h"
+#include "resample.h"
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    /// @addtogroup libnoise
+    /// @{
+
+    /// @addtogroup modules
+    /// @{
+
+    /// @addtogroup miscmodules
+    /// @{
+
+    /// Default number of grid points along each axis for the
+    /// noise::module::Bake noise module.
+    const int DEFAULT_BAKE_RESOLUTION = 64;
+
+    /// Default interpolation for the noise::module::Bake noise module.
+    const ResampleInterp DEFAULT_BAKE_INTERP = RESAMPLE_CUBIC;
+
+    /// Noise module that samples a source module once into a 3D grid and
+    /// interpolates between the grid points.
+    ///
+    /// A deep subgraph that changes slowly, such as a large-scale domain
+    /// warp, can be queried millions of times.  This noise module samples
+    /// it at the points of a grid over a box, then answers each query from
+    /// the nearest grid points, so the cost of a query no longer depends on
+    /// the subgraph.
+    ///
+    /// <b>Grid</b>
+    ///
+    /// To set the box, call the SetBounds() method; to set the number of
+    /// grid points along each axis, call the SetResolution() method.  Then
+    /// call the BuildGrid() method to sample the source module.  The grid
+    /// points include the corners of the box.  Input values outside the
+    /// box take the value at the nearest point of the box.
+    ///
+    /// Until a grid is built or read, the GetValue() method calculates the
+    /// source module directly.
+    ///
+    /// <b>Saving a grid</b>
+    ///
+    /// The WriteGrid() method writes the grid to a stream, and the
+    /// ReadGrid() method reads it back, so an application can build the
+    /// grid once and load it at startup.  A noise module that reads its
+    /// grid does not need a source module.
+    ///
+    /// This noise module has one source module, which is needed only to
+    /// build the grid.
+    class NOISE_EXPORT Bake: public Module
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// The default box is the cube from -1.0 to +1.0 along each axis.
+        ///
+        /// The default number of grid points along each axis is set to
+        /// noise::module::DEFAULT_BAKE_RESOLUTION.
+        ///
+        /// The default interpolation is set to
+        /// noise::module::DEFAULT_BAKE_INTERP.
+        Bake ();
+
+        /// Destructor.
+        ~Bake ();
+
+        /// Samples the source module at each point of the grid.
+        ///
+        /// @pre A source module was passed to the SetSourceModule() method.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// Do not call this method while another thread is calling the
+        /// GetValue() method.
+        void BuildGrid ();
+
+        /// Frees the grid.
+        ///
+        /// The GetValue() method then calculates the source module directly.
+        void ClearGrid ();
+
+        /// Returns the interpolation between the grid points.
+        ///
+        /// @returns The interpolation between the grid points.
+        ResampleInterp GetInterp () const
+        {
+          return m_interp;
+        }
+
+        /// Returns the lower @a x boundary of the box.
+        ///
+        /// @returns The lower @a x boundary of the box.
+        double GetLowerXBound () const
+        {
+          return m_lowerBound[0];
+        }
+
+        /// Returns the lower @a y boundary of the box.
+        ///
+        /// @returns The lower @a y boundary of the box.
+        double GetLowerYBound () const
+        {
+          return m_lowerBound[1];
+        }
+
+        /// Returns the lower @a z boundary of the box.
+        ///
+        /// @returns The lower @a z boundary of the box.
+        double GetLowerZBound () const
+        {
+          return m_lowerBound[2];
+        }
+
+        virtual double GetMaxFrequency () const;
+
+        virtual int GetSourceModuleCount () const
+        {
+          return 1;
+        }
+
+        /// Returns the upper @a x boundary of the box.
+        ///
+        /// @returns The upper @a x boundary of the box.
+        double GetUpperXBound () const
+        {
+          return m_upperBound[0];
+        }
+
+        /// Returns the upper @a y boundary of the box.
+        ///
+        /// @returns The upper @a y boundary of the box.
+        double GetUpperYBound () const
+        {
+          return m_upperBound[1];
+        }
+
+        /// Returns the upper @a z boundary of the box.
+        ///
+        /// @returns The upper @a z boundary of the box.
+        double GetUpperZBound () const
+        {
+          return m_upperBound[2];
+        }
+
+        virtual double GetValue (double x, double y, double z) const;
+
+        /// Returns the number of grid points along the @a x axis.
+        ///
+        /// @returns The number of grid points along the @a x axis.
+        int GetXResolution () const
+        {
+          return m_resolution[0];
+        }
+
+        /// Returns the number of grid points along the @a y axis.
+        ///
+        /// @returns The number of grid points along the @a y axis.
+        int GetYResolution () const
+        {
+          return m_resolution[1];
+        }
+
+        /// Returns the number of grid points along the @a z axis.
+        ///
+        /// @returns The number of grid points along the @a z axis.
+        int GetZResolution () const
+        {
+          return m_resolution[2];
+        }
+
+        /// Determines if this noise module holds a grid.
+        ///
+        /// @returns
+        /// - @a true if a grid was built or read.
+        /// - @a false otherwise.
+        bool IsGridBuilt () const
+        {
+          return m_pGrid != NULL;
+        }
+
+        /// Reads a grid written by the WriteGrid() method.
+        ///
+        /// @param is The stream to read from.
+        ///
+        /// @throw noise::ExceptionUnknown The stream could not be read or
+        /// does not hold a grid.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The box, the number of grid points and the interpolation are
+        /// read along with the grid.  If this method throws an exception,
+        /// this noise module is unchanged.
+        void ReadGrid (std::istream& is);
+
+        virtual void SetAllocator (Allocator* pAllocator);
+
+        /// Sets the box that the grid covers.
+        ///
+        /// @param lowerX The lower @a x boundary of the box.
+        /// @param lowerY The lower @a y boundary of the box.
+        /// @param lowerZ The lower @a z boundary of the box.
+        /// @param upperX The upper @a x boundary of the box.
+        /// @param upperY The upper @a y boundary of the box.
+        /// @param upperZ The upper @a z boundary of the box.
+        ///
+        /// @pre The lower boundaries are not greater than the upper
+        /// boundaries.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// This method frees the grid.
+        void SetBounds (double lowerX, double lowerY, double lowerZ,
+          double upperX, double upperY, double upperZ);
+
+        /// Sets the interpolation between the grid points.
+        ///
+        /// @param interp The interpolation between the grid points.
+        ///
+        /// The grid is kept.
+        void SetInterp (ResampleInterp interp)
+        {
+          m_interp = interp;
+        }
+
+        /// Sets the number of grid points along each axis.
+        ///
+        /// @param xResolution The number of grid points along the @a x axis.
+        /// @param yResolution The number of grid points along the @a y axis.
+        /// @param zResolution The number of grid points along the @a z axis.
+        ///
+        /// @pre Each number of grid points is at least 1.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// Use a single grid point along an axis on which the box is flat.
+        /// This method frees the grid.
+        void SetResolution (int xResolution, int yResolution,
+          int zResolution);
+
+        /// Writes the grid to a stream.
+        ///
+        /// @param os The stream to write to.
+        ///
+        /// @pre The grid was built or read.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionUnknown The stream could not be written.
+        ///
+        /// The values are written as little-endian 32-bit floating-point
+        /// numbers, so the grid can be read on any platform.  Open a file
+        /// stream in binary mode.
+        void WriteGrid (std::ostream& os) const;
+
+      protected:
+
+        /// Returns the number of points in the grid.
+        ///
+        /// @returns The number of points in the grid.
+        size_t GetGridSize () const
+        {
+          return (size_t)m_resolution[0] * (size_t)m_resolution[1]
+            * (size_t)m_resolution[2];
+        }
+
+        /// The values at the grid points, ordered by @a z, then @a y, then
+        /// @a x, or @a NULL if there is no grid.
+        float* m_pGrid;
+
+        /// The interpolation between the grid points.
+        ResampleInterp m_interp;
+
+        /// The lower boundaries of the box along the @a x, @a y and @a z
+        /// axes.
+        double m_lowerBound[3];
+
+        /// The number of grid points along the @a x, @a y and @a z axes.
+        int m_resolution[3];
+
+        /// The upper boundaries of the box along the @a x, @a y and @a z
+        /// axes.
+        double m_upperBound[3];
+
+    };
+
+    /// @}
+
+    /// @}
+
+    /// @}
+
+  }
+
+}
+
+#endif
@@ -75,6 +75,14 @@ namespace noise
     /// this noise module modifies each octave with an absolute-value
     /// function.  See the documentation of noise::module::Perlin for more
     /// information.
+    ///
+    /// Like noise::module::Perlin, this noise module can return the sum of
+    /// a range of octaves with the GetOctaveRangeValue() method, so that an
+    /// application can add octaves to values it already calculated.
+    ///
+    /// Like noise::module::Perlin, this noise module can repeat itself so
+    /// that it tiles; call the SetPeriod() method with the size of the tile
+    /// along each axis.
     class NOISE_EXPORT Billow : public Module
     {
 
@@ -117,6 +125,12 @@ namespace noise
           return m_lacunarity;
         }
 
+        virtual double GetMaxFrequency () const
+        {
+          // Taking the absolute value of an octave doubles its frequency.
+          return 2.0 * m_frequency * pow (m_lacunarity, m_octaveCount - 1);
+        }
+
         /// Returns the quality of the billowy noise.
         ///
         /// @returns The quality of the billowy noise.
@@ -139,6 +153,33 @@ namespace noise
           return m_octaveCount;
         }
 
+        /// Returns the sum of a range of octaves at the specified input
+        /// value.
+        ///
+        /// @param x The @a x coordinate of the input value.
+        /// @param y The @a y coordinate of the input value.
+        /// @param z The @a z coordinate of the input value.
+        /// @param firstOctave The first octave of the range.
+        /// @param lastOctave The octave after the last octave of the range.
+        ///
+        /// @returns The sum of the octaves from @a firstOctave up to, but
+        /// not including, @a lastOctave.
+        ///
+        /// @pre The first octave is no greater than the last octave.
+        /// @pre The last octave is no greater than
+        /// noise::module::BILLOW_MAX_OCTAVE.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The constant offset of the billowy noise is part of the range
+        /// that starts at octave 0, so the sums of the ranges [0, @a k) and
+        /// [@a k, @a n) add up to the output value of this noise module with
+        /// @a n octaves, apart from floating-point rounding.  The number of
+        /// octaves set by SetOctaveCount() is ignored.
+        double GetOctaveRangeValue (double x, double y, double z,
+          int firstOctave, int lastOctave) const;
+
         /// Returns the persistence value of the billowy noise.
         ///
         /// @returns The persistence value of the billowy noise.
@@ -164,6 +205,43 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        /// Returns the period of the billowy noise along the @a x axis.
+        ///
+        /// @returns The period along the @a x axis, or 0.0 if the
+        /// billowy noise does not repeat along that axis.
+        double GetXPeriod () const
+        {
+          return m_xPeriod;
+        }
+
+        /// Returns the period of the billowy noise along the @a y axis.
+        ///
+        /// @returns The period along the @a y axis, or 0.0 if the
+        /// billowy noise does not repeat along that axis.
+        double GetYPeriod () const
+        {
+          return m_yPeriod;
+        }
+
+        /// Returns the period of the billowy noise along the @a z axis.
+        ///
+        /// @returns The period along the @a z axis, or 0.0 if the
+        /// billowy noise does not repeat along that axis.
+        double GetZPeriod () const
+        {
+          return m_zPeriod;
+        }
+
+        /// Determines if the billowy noise repeats along at least one axis.
+        ///
+        /// @returns
+        /// - @a true if a period was set along at least one axis.
+        /// - @a false if the billowy noise does not repeat.
+        bool IsPeriodic () const
+        {
+          return m_xPeriod > 0.0 || m_yPeriod > 0.0 || m_zPeriod > 0.0;
+        }
+
         /// Sets the frequency of the first octave.
         ///
         /// @param frequency The frequency of the first octave.
@@ -221,6 +299,30 @@ namespace noise
           m_octaveCount = octaveCount;
         }
 
+        /// Sets the period of the billowy noise along each axis.
+        ///
+        /// @param xPeriod The period along the @a x axis, or 0.0.
+        /// @param yPeriod The period along the @a y axis, or 0.0.
+        /// @param zPeriod The period along the @a z axis, or 0.0.
+        ///
+        /// @pre Each period is at least 0.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The output value repeats every @a xPeriod units along the @a x
+        /// axis, and so on for the other axes.  A period of 0.0 leaves that
+        /// axis unbounded, which is the default.
+        void SetPeriod (double xPeriod, double yPeriod, double zPeriod)
+        {
+          if (xPeriod < 0.0 || yPeriod < 0.0 || zPeriod < 0.0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_xPeriod = xPeriod;
+          m_yPeriod = yPeriod;
+          m_zPeriod = zPeriod;
+        }
+
         /// Sets the persistence value of the billowy noise.
         ///
         /// @param persistence The persistence value of the billowy noise.
@@ -262,6 +364,15 @@ namespace noise
         /// Seed value used by the billowy-noise function.
         int m_seed;
 
+        /// Period along the @a x axis, or 0.0 if it does not repeat.
+        double m_xPeriod;
+
+        /// Period along the @a y axis, or 0.0 if it does not repeat.
+        double m_yPeriod;
+
+        /// Period along the @a z axis, or 0.0 if it does not repeat.
+        double m_zPeriod;
+
     };
 
     /// @}
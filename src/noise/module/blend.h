@@ -98,6 +98,8 @@ namespace noise
           return *(m_pSourceModule[2]);
         }
 
+        virtual double GetMaxFrequency () const;
+
         virtual int GetSourceModuleCount () const
         {
           return 3;
@@ -72,6 +72,11 @@ namespace noise
         /// Constructor.
         Cache ();
 
+        virtual double GetMaxFrequency () const
+        {
+          return GetSourceMaxFrequency (0);
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
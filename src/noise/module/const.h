@@ -73,6 +73,11 @@ namespace noise
           return m_constValue;
         }
 
+        virtual double GetMaxFrequency () const
+        {
+          return 0.0;
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 0;
@@ -0,0 +1,238 @@
+// cubemap.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_MODULE_CUBEMAP_H
+#define NOISE_MODULE_CUBEMAP_H
+
+#include <iosfwd>
+#include "modulebase.h"
+#include "resample.h"
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    /// @addtogroup libnoise
+    /// @{
+
+    /// @addtogroup modules
+    /// @{
+
+    /// @addtogroup miscmodules
+    /// @{
+
+    /// Default number of grid points along each edge of a face for the
+    /// noise::module::CubeMap noise module.
+    const int DEFAULT_CUBE_MAP_RESOLUTION = 256;
+
+    /// Default interpolation for the noise::module::CubeMap noise module.
+    const ResampleInterp DEFAULT_CUBE_MAP_INTERP = RESAMPLE_CUBIC;
+
+    /// Noise module that samples a source module once over the surface of
+    /// the unit sphere and interpolates between the samples.
+    ///
+    /// This noise module is the counterpart of noise::module::Bake for
+    /// planets: it stores the source module on the six faces of a cube
+    /// map, so its memory grows with the surface of the sphere rather
+    /// than with the volume of a box.  Spherical noise maps and
+    /// noise::model::Sphere queries then cost a fixed number of memory
+    /// reads, however deep the source module graph is.
+    ///
+    /// <b>Faces</b>
+    ///
+    /// Each face holds a square grid of points; to set the number of
+    /// points along each edge, call the SetResolution() method.  The grid
+    /// points are spaced by equal angles rather than by equal distances on
+    /// the face, so the grid cells near the corners of a face are not much
+    /// smaller than those near its center.  Each face also holds a ring of
+    /// points just beyond its edges, so cubic interpolation needs no
+    /// points from the neighboring faces and the faces meet without seams.
+    ///
+    /// Call the BuildGrid() method to sample the source module at the
+    /// point on the unit sphere in the direction of each grid point.  The
+    /// GetValue() method returns the value in the direction of the input
+    /// value; its distance from the origin is ignored.  Until a grid is
+    /// built or read, the GetValue() method calculates the source module
+    /// directly.
+    ///
+    /// <b>Saving a grid</b>
+    ///
+    /// The WriteGrid() method writes the faces to a stream, and the
+    /// ReadGrid() method reads them back, so an application can build the
+    /// faces once and load them at startup.  A noise module that reads its
+    /// grid does not need a source module.
+    ///
+    /// This noise module has one source module, which is needed only to
+    /// build the grid.
+    class NOISE_EXPORT CubeMap: public Module
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// The default number of grid points along each edge of a face is
+        /// set to noise::module::DEFAULT_CUBE_MAP_RESOLUTION.
+        ///
+        /// The default interpolation is set to
+        /// noise::module::DEFAULT_CUBE_MAP_INTERP.
+        CubeMap ();
+
+        /// Destructor.
+        ~CubeMap ();
+
+        /// Samples the source module at each grid point of the faces.
+        ///
+        /// @pre A source module was passed to the SetSourceModule() method.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// Do not call this method while another thread is calling the
+        /// GetValue() method.
+        void BuildGrid ();
+
+        /// Frees the faces.
+        ///
+        /// The GetValue() method then calculates the source module directly.
+        void ClearGrid ();
+
+        /// Returns the interpolation between the grid points.
+        ///
+        /// @returns The interpolation between the grid points.
+        ResampleInterp GetInterp () const
+        {
+          return m_interp;
+        }
+
+        virtual double GetMaxFrequency () const;
+
+        /// Returns the number of grid points along each edge of a face.
+        ///
+        /// @returns The number of grid points along each edge of a face.
+        int GetResolution () const
+        {
+          return m_resolution;
+        }
+
+        virtual int GetSourceModuleCount () const
+        {
+          return 1;
+        }
+
+        virtual double GetValue (double x, double y, double z) const;
+
+        /// Determines if this noise module holds the faces.
+        ///
+        /// @returns
+        /// - @a true if the faces were built or read.
+        /// - @a false otherwise.
+        bool IsGridBuilt () const
+        {
+          return m_pGrid != NULL;
+        }
+
+        /// Reads the faces written by the WriteGrid() method.
+        ///
+        /// @param is The stream to read from.
+        ///
+        /// @throw noise::ExceptionUnknown The stream could not be read or
+        /// does not hold a cube map.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The number of grid points and the interpolation are read along
+        /// with the faces.  If this method throws an exception, this noise
+        /// module is unchanged.
+        void ReadGrid (std::istream& is);
+
+        virtual void SetAllocator (Allocator* pAllocator);
+
+        /// Sets the interpolation between the grid points.
+        ///
+        /// @param interp The interpolation between the grid points.
+        ///
+        /// The faces are kept.
+        void SetInterp (ResampleInterp interp)
+        {
+          m_interp = interp;
+        }
+
+        /// Sets the number of grid points along each edge of a face.
+        ///
+        /// @param resolution The number of grid points along each edge.
+        ///
+        /// @pre The number of grid points is at least 4.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// This method frees the faces.
+        void SetResolution (int resolution);
+
+        /// Writes the faces to a stream.
+        ///
+        /// @param os The stream to write to.
+        ///
+        /// @pre The faces were built or read.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionUnknown The stream could not be written.
+        ///
+        /// The values are written as little-endian 32-bit floating-point
+        /// numbers, so the faces can be read on any platform.  Open a file
+        /// stream in binary mode.
+        void WriteGrid (std::ostream& os) const;
+
+      protected:
+
+        /// Returns the number of points stored for the faces, including
+        /// the rings of points beyond their edges.
+        ///
+        /// @returns The number of points stored for the faces.
+        size_t GetGridSize () const
+        {
+          size_t stride = (size_t)m_resolution + 2;
+          return 6 * stride * stride;
+        }
+
+        /// The values at the grid points of each face and of the rings
+        /// around them, ordered by face, then by row, then by column, or
+        /// @a NULL if there are no faces.
+        float* m_pGrid;
+
+        /// The interpolation between the grid points.
+        ResampleInterp m_interp;
+
+        /// The number of grid points along each edge of a face.
+        int m_resolution;
+
+    };
+
+    /// @}
+
+    /// @}
+
+    /// @}
+
+  }
+
+}
+
+#endif
@@ -137,6 +137,8 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void SetAllocator (Allocator* pAllocator);
+
       protected:
 
         /// Determines the array index in which to insert the control point
@@ -53,6 +53,11 @@ namespace noise
         /// Constructor.
         Invert ();
 
+        virtual double GetMaxFrequency () const
+        {
+          return GetSourceMaxFrequency (0);
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
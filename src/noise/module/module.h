@@ -25,12 +25,14 @@
 
 #include "add.h"
 #include "abs.h"
+#include "bake.h"
 #include "billow.h"
 #include "blend.h"
 #include "cache.h"
 #include "checkerboard.h"
 #include "clamp.h"
 #include "const.h"
+#include "cubemap.h"
 #include "curve.h"
 #include "cylinders.h"
 #include "displace.h"
@@ -41,6 +43,7 @@
 #include "multiply.h"
 #include "perlin.h"
 #include "power.h"
+#include "resample.h"
 #include "ridgedmulti.h"
 #include "rotatepoint.h"
 #include "scalebias.h"
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
+#include "../allocator.h"
 #include "../basictypes.h"
 #include "../exception.h"
 #include "../noisegen.h"
@@ -229,6 +230,10 @@ namespace noise
     /// attempts to call the GetValue() method, your module will raise an
     /// assertion.
     ///
+    /// If your noise module allocates memory of its own, allocate it from the
+    /// allocator returned by GetAllocator() and override the SetAllocator()
+    /// method to move that memory to the new allocator.
+    ///
     /// It shouldn't be too difficult to create your own noise module.  If you
     /// still have some problems, take a look at the source code for
     /// noise::module::Add, which is a very simple noise module.
@@ -243,6 +248,37 @@ namespace noise
         /// Destructor.
         virtual ~Module ();
 
+        /// Returns the allocator used by this noise module.
+        ///
+        /// @returns The allocator used by this noise module.
+        ///
+        /// A noise module takes the default allocator when it is
+        /// constructed.
+        Allocator* GetAllocator () const
+        {
+          return m_pAllocator;
+        }
+
+        /// Returns the highest spatial frequency of the output values from
+        /// this noise module.
+        ///
+        /// @returns The highest frequency, in cycles per unit, or a negative
+        /// value if this noise module cannot bound it.
+        ///
+        /// Output values that change slowly can be calculated at a few
+        /// points and interpolated between them; see
+        /// noise::module::Resample.  The bound is a guide rather than a
+        /// guarantee, since coherent noise is not strictly band-limited.
+        ///
+        /// The base class returns a negative value.  A noise module that
+        /// can bound the frequency of its output values overrides this
+        /// method; modules that create sharp edges, such as
+        /// noise::module::Select or noise::module::Terrace, do not.
+        virtual double GetMaxFrequency () const
+        {
+          return -1.0;
+        }
+
         /// Returns a reference to a source module connected to this noise
         /// module.
         ///
@@ -346,12 +382,48 @@ namespace noise
           m_pSourceModule[index] = &sourceModule;
         }
 
+        /// Sets the allocator used by this noise module.
+        ///
+        /// @param pAllocator The allocator, or @a NULL to use the default
+        /// allocator.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// The memory of this noise module is moved to the new allocator.
+        /// The allocator must exist until this noise module is destroyed or
+        /// uses another allocator.
+        ///
+        /// Do not call this method while another thread is calling the
+        /// GetValue() method.
+        virtual void SetAllocator (Allocator* pAllocator);
+
       protected:
 
+        /// Returns the highest spatial frequency of the output values from
+        /// a source module.
+        ///
+        /// @param index The index value assigned to the source module.
+        ///
+        /// @returns The highest frequency, in cycles per unit, or a negative
+        /// value if the source module cannot bound it or is not connected.
+        double GetSourceMaxFrequency (int index) const
+        {
+          if (m_pSourceModule[index] == NULL) {
+            return -1.0;
+          }
+          return m_pSourceModule[index]->GetMaxFrequency ();
+        }
+
+        /// The allocator that owns the memory of this noise module.
+        Allocator* m_pAllocator;
+
         /// An array containing the pointers to each source module required by
         /// this noise module.
         const Module** m_pSourceModule;
 
+        /// The number of elements in the source module array.
+        int m_sourceModuleCount;
+
       private:
 
         /// Assignment operator.
@@ -360,7 +432,7 @@ namespace noise
         /// This restriction is necessary because if this object was copied,
         /// all source modules assigned to this noise module would need to be
         /// copied as well.
-        const Module& operator= (const Module& m)
+        const Module& operator= (const Module& /* m */)
         {
           return *this;
         }
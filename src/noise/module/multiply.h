@@ -54,6 +54,8 @@ namespace noise
         /// Constructor.
         Multiply ();
 
+        virtual double GetMaxFrequency () const;
+
         virtual int GetSourceModuleCount () const
         {
           return 2;
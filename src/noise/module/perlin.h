@@ -98,6 +98,11 @@ namespace noise
     /// An application may specify the number of octaves that generate Perlin
     /// noise by calling the SetOctaveCount() method.
     ///
+    /// Because the octaves are added together, an application can add
+    /// detail to values it already calculated with fewer octaves: the
+    /// GetOctaveRangeValue() method returns the sum of a range of octaves,
+    /// and the sums of adjacent ranges add up to the output value.
+    ///
     /// These coherent-noise functions are called octaves because each octave
     /// has, by default, double the frequency of the previous octave.  Musical
     /// tones have this property as well; a musical C tone that is one octave
@@ -132,6 +137,15 @@ namespace noise
     /// with the lacunarity value to determine the effects.  For best results,
     /// set the lacunarity to a number between 1.5 and 3.5.
     ///
+    /// <b>Tiling</b>
+    ///
+    /// By default, Perlin noise does not repeat.  To generate a texture that
+    /// tiles, call the SetPeriod() method with the size of the tile along
+    /// each axis.  The output value then repeats every period, at the same
+    /// cost as noise that does not repeat.  To fit a whole number of lattice
+    /// cells into each period, each octave rounds its frequency to the
+    /// nearest multiple of the reciprocal of the period.
+    ///
     /// <b>References &amp; acknowledgments</b>
     ///
     /// <a href=http://www.noisemachine.com/talk1/>The Noise Machine</a> -
@@ -199,6 +213,11 @@ namespace noise
           return m_lacunarity;
         }
 
+        virtual double GetMaxFrequency () const
+        {
+          return m_frequency * pow (m_lacunarity, m_octaveCount - 1);
+        }
+
         /// Returns the quality of the Perlin noise.
         ///
         /// @returns The quality of the Perlin noise.
@@ -221,6 +240,32 @@ namespace noise
           return m_octaveCount;
         }
 
+        /// Returns the sum of a range of octaves at the specified input
+        /// value.
+        ///
+        /// @param x The @a x coordinate of the input value.
+        /// @param y The @a y coordinate of the input value.
+        /// @param z The @a z coordinate of the input value.
+        /// @param firstOctave The first octave of the range.
+        /// @param lastOctave The octave after the last octave of the range.
+        ///
+        /// @returns The sum of the octaves from @a firstOctave up to, but
+        /// not including, @a lastOctave.
+        ///
+        /// @pre The first octave is no greater than the last octave.
+        /// @pre The last octave is no greater than
+        /// noise::module::PERLIN_MAX_OCTAVE.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The sums of the ranges [0, @a k) and [@a k, @a n) add up to the
+        /// output value of this noise module with @a n octaves, apart from
+        /// floating-point rounding.  The number of octaves set by
+        /// SetOctaveCount() is ignored.
+        double GetOctaveRangeValue (double x, double y, double z,
+          int firstOctave, int lastOctave) const;
+
         /// Returns the persistence value of the Perlin noise.
         ///
         /// @returns The persistence value of the Perlin noise.
@@ -246,6 +291,43 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        /// Returns the period of the Perlin noise along the @a x axis.
+        ///
+        /// @returns The period along the @a x axis, or 0.0 if the
+        /// Perlin noise does not repeat along that axis.
+        double GetXPeriod () const
+        {
+          return m_xPeriod;
+        }
+
+        /// Returns the period of the Perlin noise along the @a y axis.
+        ///
+        /// @returns The period along the @a y axis, or 0.0 if the
+        /// Perlin noise does not repeat along that axis.
+        double GetYPeriod () const
+        {
+          return m_yPeriod;
+        }
+
+        /// Returns the period of the Perlin noise along the @a z axis.
+        ///
+        /// @returns The period along the @a z axis, or 0.0 if the
+        /// Perlin noise does not repeat along that axis.
+        double GetZPeriod () const
+        {
+          return m_zPeriod;
+        }
+
+        /// Determines if the Perlin noise repeats along at least one axis.
+        ///
+        /// @returns
+        /// - @a true if a period was set along at least one axis.
+        /// - @a false if the Perlin noise does not repeat.
+        bool IsPeriodic () const
+        {
+          return m_xPeriod > 0.0 || m_yPeriod > 0.0 || m_zPeriod > 0.0;
+        }
+
         /// Sets the frequency of the first octave.
         ///
         /// @param frequency The frequency of the first octave.
@@ -303,6 +385,30 @@ namespace noise
           m_octaveCount = octaveCount;
         }
 
+        /// Sets the period of the Perlin noise along each axis.
+        ///
+        /// @param xPeriod The period along the @a x axis, or 0.0.
+        /// @param yPeriod The period along the @a y axis, or 0.0.
+        /// @param zPeriod The period along the @a z axis, or 0.0.
+        ///
+        /// @pre Each period is at least 0.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The output value repeats every @a xPeriod units along the @a x
+        /// axis, and so on for the other axes.  A period of 0.0 leaves that
+        /// axis unbounded, which is the default.
+        void SetPeriod (double xPeriod, double yPeriod, double zPeriod)
+        {
+          if (xPeriod < 0.0 || yPeriod < 0.0 || zPeriod < 0.0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_xPeriod = xPeriod;
+          m_yPeriod = yPeriod;
+          m_zPeriod = zPeriod;
+        }
+
         /// Sets the persistence value of the Perlin noise.
         ///
         /// @param persistence The persistence value of the Perlin noise.
@@ -344,6 +450,15 @@ namespace noise
         /// Seed value used by the Perlin-noise function.
         int m_seed;
 
+        /// Period along the @a x axis, or 0.0 if it does not repeat.
+        double m_xPeriod;
+
+        /// Period along the @a y axis, or 0.0 if it does not repeat.
+        double m_yPeriod;
+
+        /// Period along the @a z axis, or 0.0 if it does not repeat.
+        double m_zPeriod;
+
     };
 
     /// @}
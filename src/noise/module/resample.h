@@ -0,0 +1,449 @@
+// resample.h
+//
+// Copyright (C) 2026 The libnoise contributors
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_MODULE_RESAMPLE_H
+#define NOISE_MODULE_RESAMPLE_H
+
+#include "modulebase.h"
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    /// @addtogroup libnoise
+    /// @{
+
+    /// @addtogroup modules
+    /// @{
+
+    /// @addtogroup miscmodules
+    /// @{
+
+    /// Enumerates the ways that the noise::module::Resample noise module
+    /// interpolates between the points of its lattice.
+    enum ResampleInterp
+    {
+
+      /// Interpolates linearly between the eight nearest lattice points.
+      /// This is the fastest, but its slope is discontinuous at the faces
+      /// of the lattice cells.
+      RESAMPLE_LINEAR = 0,
+
+      /// Interpolates with Catmull-Rom splines through the 64 nearest
+      /// lattice points.  This needs fewer lattice points than linear
+      /// interpolation for the same error.
+      RESAMPLE_CUBIC = 1
+
+    };
+
+    /// Enumerates the outcomes of the last call to the Prepare() method of
+    /// the noise::module::Resample noise module.
+    enum ResampleStatus
+    {
+
+      /// The Prepare() method has not been called since the lattice was
+      /// last cleared.
+      RESAMPLE_UNPREPARED = 0,
+
+      /// The lattice was calculated, so the input values within its box
+      /// are interpolated.
+      RESAMPLE_LATTICE = 1,
+
+      /// The highest frequency of the source module is unknown, so the
+      /// source module is calculated directly.
+      RESAMPLE_UNKNOWN_FREQUENCY = 2,
+
+      /// The lattice would have more than
+      /// noise::module::RESAMPLE_MAX_LATTICE_SIZE points, so the source
+      /// module is calculated directly.  This is usual for a fractal
+      /// source module with many octaves, whose highest frequency is high.
+      RESAMPLE_LATTICE_TOO_LARGE = 3
+
+    };
+
+    /// Default error budget for the noise::module::Resample noise module.
+    const double DEFAULT_RESAMPLE_ERROR_BUDGET = 0.0;
+
+    /// Default interpolation for the noise::module::Resample noise module.
+    const ResampleInterp DEFAULT_RESAMPLE_INTERP = RESAMPLE_CUBIC;
+
+    /// Default number of lattice points per cycle of the highest frequency
+    /// for the noise::module::Resample noise module.
+    const double DEFAULT_RESAMPLE_SAMPLES_PER_CYCLE = 8.0;
+
+    /// Maximum number of points in the lattice of the
+    /// noise::module::Resample noise module.  A larger lattice would cost
+    /// more than calculating the source module directly.
+    const size_t RESAMPLE_MAX_LATTICE_SIZE = 1 << 22;
+
+    /// Number of cells along each axis of the region at the origin on
+    /// which the noise::module::Resample noise module checks its error
+    /// budget, counted at the spacing before any halving.
+    const int RESAMPLE_CALIBRATION_CELLS = 8;
+
+    /// Noise module that calculates a slowly changing source module on a
+    /// coarse lattice and interpolates between the lattice points.
+    ///
+    /// Large noise-module graphs often contain subgraphs that change much
+    /// more slowly than the output of the whole graph, such as the
+    /// subgraph that places continents on a planet.  Calculating such a
+    /// subgraph at every point of a large noise map wastes most of the
+    /// time; this noise module calculates it a few times per cycle of its
+    /// highest frequency instead, and interpolates between those values
+    /// before passing them to the noise modules that use it.
+    ///
+    /// <b>Lattice</b>
+    ///
+    /// Before the lattice can be used, call the Prepare() method with the
+    /// box that contains the input values.  The noise-map builders in
+    /// noiseutils do this for every noise module of this type that they
+    /// find in their source module graphs.  Until then, and for input
+    /// values outside the box, the GetValue() method calculates the source
+    /// module directly.  The GetStatus() method tells whether the last
+    /// call to Prepare() calculated a lattice, and if not, why.
+    ///
+    /// The spacing of the lattice depends only on this noise module and
+    /// its source module, never on the box, and the lattice points lie on
+    /// a grid aligned to the origin.  Two lattices calculated for
+    /// different boxes therefore have the same values where they overlap,
+    /// and noise maps built in tiles or windows have no seams.
+    ///
+    /// <b>Frequency</b>
+    ///
+    /// The spacing of the lattice is one cycle of the highest frequency of
+    /// the source module divided by the number of samples per cycle.  An
+    /// application may declare the highest frequency by calling the
+    /// SetMaxFrequency() method; otherwise this noise module asks the
+    /// source module by calling its GetMaxFrequency() method.  If neither
+    /// is known, this noise module always calculates the source module
+    /// directly.
+    ///
+    /// <b>Error budget</b>
+    ///
+    /// If the error budget set by the SetErrorBudget() method is positive,
+    /// the first call to the Prepare() method also calculates the source
+    /// module at the center of each lattice cell, where interpolation is
+    /// least accurate, and halves the spacing of the lattice until the
+    /// largest error at the centers is within the budget.  The error is
+    /// checked on a cube of noise::module::RESAMPLE_CALIBRATION_CELLS cells
+    /// at the origin rather than on the box, so that the spacing is the
+    /// same for every box.  The spacing is kept until the lattice is
+    /// cleared.
+    ///
+    /// This noise module requires one source module.
+    class NOISE_EXPORT Resample: public Module
+    {
+
+      public:
+
+        /// Constructor.
+        ///
+        /// The default error budget is set to
+        /// noise::module::DEFAULT_RESAMPLE_ERROR_BUDGET.
+        ///
+        /// The default interpolation is set to
+        /// noise::module::DEFAULT_RESAMPLE_INTERP.
+        ///
+        /// The default number of samples per cycle is set to
+        /// noise::module::DEFAULT_RESAMPLE_SAMPLES_PER_CYCLE.
+        ///
+        /// The highest frequency is taken from the source module.
+        Resample ();
+
+        /// Destructor.
+        ~Resample ();
+
+        /// Frees the lattice and forgets its spacing.
+        ///
+        /// The GetValue() method then calculates the source module directly
+        /// until the Prepare() method is called again.  Call this method
+        /// after changing a noise module in the source module graph.
+        void ClearLattice ();
+
+        /// Returns the error budget.
+        ///
+        /// @returns The largest error allowed at the centers of the lattice
+        /// cells, or 0.0 if the error is not checked.
+        double GetErrorBudget () const
+        {
+          return m_errorBudget;
+        }
+
+        /// Returns the interpolation between the lattice points.
+        ///
+        /// @returns The interpolation between the lattice points.
+        ResampleInterp GetInterp () const
+        {
+          return m_interp;
+        }
+
+        /// Returns the distance between adjacent lattice points.
+        ///
+        /// @returns The distance between adjacent lattice points, or 0.0 if
+        /// there is no lattice.
+        double GetLatticeSpacing () const
+        {
+          return (m_pLattice != NULL)? m_latticeSpacing: 0.0;
+        }
+
+        virtual double GetMaxFrequency () const
+        {
+          return (m_maxFrequency > 0.0)? m_maxFrequency:
+            GetSourceMaxFrequency (0);
+        }
+
+        /// Returns the number of lattice points per cycle of the highest
+        /// frequency.
+        ///
+        /// @returns The number of lattice points per cycle.
+        double GetSamplesPerCycle () const
+        {
+          return m_samplesPerCycle;
+        }
+
+        virtual int GetSourceModuleCount () const
+        {
+          return 1;
+        }
+
+        /// Returns the outcome of the last call to the Prepare() method.
+        ///
+        /// @returns The outcome of the last call to the Prepare() method.
+        ///
+        /// Unless this method returns noise::module::RESAMPLE_LATTICE, the
+        /// GetValue() method calculates the source module directly.
+        ResampleStatus GetStatus () const
+        {
+          return m_status;
+        }
+
+        virtual double GetValue (double x, double y, double z) const;
+
+        /// Calculates the lattice for the input values within a box.
+        ///
+        /// @param lowerX The lower @a x coordinate of the box.
+        /// @param lowerY The lower @a y coordinate of the box.
+        /// @param lowerZ The lower @a z coordinate of the box.
+        /// @param upperX The upper @a x coordinate of the box.
+        /// @param upperY The upper @a y coordinate of the box.
+        /// @param upperZ The upper @a z coordinate of the box.
+        ///
+        /// @pre The lower coordinates are not greater than the upper
+        /// coordinates.
+        /// @pre A source module was passed to the SetSourceModule() method.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        ///
+        /// This method does nothing if the lattice already covers the box.
+        /// If the highest frequency is unknown, or the lattice would have
+        /// more than noise::module::RESAMPLE_MAX_LATTICE_SIZE points, this
+        /// method frees the lattice instead; the GetStatus() method then
+        /// returns the reason.
+        ///
+        /// Do not call this method while another thread is calling the
+        /// GetValue() method.
+        void Prepare (double lowerX, double lowerY, double lowerZ,
+          double upperX, double upperY, double upperZ);
+
+        virtual void SetAllocator (Allocator* pAllocator);
+
+        /// Sets the error budget.
+        ///
+        /// @param errorBudget The largest error allowed at the centers of
+        /// the lattice cells, or 0.0 to not check the error.
+        ///
+        /// @pre The error budget is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        ///
+        /// Checking the error doubles the cost of the Prepare() method.
+        void SetErrorBudget (double errorBudget)
+        {
+          if (!(errorBudget >= 0.0)) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          ClearLattice ();
+          m_errorBudget = errorBudget;
+        }
+
+        /// Sets the interpolation between the lattice points.
+        ///
+        /// @param interp The interpolation between the lattice points.
+        void SetInterp (ResampleInterp interp)
+        {
+          ClearLattice ();
+          m_interp = interp;
+        }
+
+        /// Declares the highest frequency of the source module.
+        ///
+        /// @param maxFrequency The highest frequency, in cycles per unit, or
+        /// 0.0 to take it from the source module.
+        ///
+        /// @pre The frequency is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetMaxFrequency (double maxFrequency)
+        {
+          if (!(maxFrequency >= 0.0)) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          ClearLattice ();
+          m_maxFrequency = maxFrequency;
+        }
+
+        /// Sets the number of lattice points per cycle of the highest
+        /// frequency.
+        ///
+        /// @param samplesPerCycle The number of lattice points per cycle.
+        ///
+        /// @pre The number of lattice points per cycle is at least 2.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam See the preconditions.
+        void SetSamplesPerCycle (double samplesPerCycle)
+        {
+          if (!(samplesPerCycle >= 2.0)) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          ClearLattice ();
+          m_samplesPerCycle = samplesPerCycle;
+        }
+
+        virtual void SetSourceModule (int index, const Module& sourceModule)
+        {
+          Module::SetSourceModule (index, sourceModule);
+          ClearLattice ();
+        }
+
+      protected:
+
+        /// Calculates the source module at the lattice points around a box.
+        ///
+        /// @param lower The lower coordinates of the box.
+        /// @param upper The upper coordinates of the box.
+        /// @param spacing The distance between adjacent lattice points.
+        ///
+        /// @returns
+        /// - @a true if the lattice was calculated.
+        /// - @a false if it would have more than
+        ///   noise::module::RESAMPLE_MAX_LATTICE_SIZE points, in which case
+        ///   the lattice is unchanged.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        bool BuildLattice (const double lower[3], const double upper[3],
+          double spacing);
+
+        /// Calculates the spacing of the lattice from the highest frequency
+        /// and the error budget.
+        ///
+        /// @param frequency The highest frequency of the source module.
+        ///
+        /// @returns The spacing, or -1.0 if no spacing that meets the error
+        /// budget fits in the lattice.
+        ///
+        /// @throw noise::ExceptionOutOfMemory Out of memory.
+        double CalcLatticeSpacing (double frequency);
+
+        /// Frees the lattice, but keeps its spacing.
+        void FreeLattice ();
+
+        /// Returns the largest error of interpolation at the centers of the
+        /// lattice cells.
+        ///
+        /// @returns The largest error.
+        double GetLatticeError () const;
+
+        /// Interpolates between the lattice points.
+        ///
+        /// @param x The @a x coordinate of the input value.
+        /// @param y The @a y coordinate of the input value.
+        /// @param z The @a z coordinate of the input value.
+        /// @param value On exit, the interpolated value.
+        ///
+        /// @returns
+        /// - @a true if the lattice covers the input value.
+        /// - @a false otherwise, in which case @a value is unchanged.
+        bool InterpLattice (double x, double y, double z, double& value)
+          const;
+
+        /// The largest error allowed at the centers of the lattice cells.
+        double m_errorBudget;
+
+        /// The interpolation between the lattice points.
+        ResampleInterp m_interp;
+
+        /// Number of lattice points along the @a x axis.
+        int m_latticeCountX;
+
+        /// Number of lattice points along the @a y axis.
+        int m_latticeCountY;
+
+        /// Number of lattice points along the @a z axis.
+        int m_latticeCountZ;
+
+        /// Distance between adjacent lattice points.
+        double m_latticeSpacing;
+
+        /// Index of the first lattice point along the @a x axis, counted
+        /// from the origin.
+        noise::int64 m_latticeX0;
+
+        /// Index of the first lattice point along the @a y axis, counted
+        /// from the origin.
+        noise::int64 m_latticeY0;
+
+        /// Index of the first lattice point along the @a z axis, counted
+        /// from the origin.
+        noise::int64 m_latticeZ0;
+
+        /// The declared highest frequency, or 0.0 to take it from the
+        /// source module.
+        double m_maxFrequency;
+
+        /// The output values from the source module at the lattice points,
+        /// ordered by @a z, then @a y, then @a x, or @a NULL if there is no
+        /// lattice.
+        double* m_pLattice;
+
+        /// Number of lattice points per cycle of the highest frequency.
+        double m_samplesPerCycle;
+
+        /// The spacing calculated for the source module, 0.0 if it has not
+        /// been calculated yet, or -1.0 if no spacing fits in the lattice.
+        double m_spacing;
+
+        /// The outcome of the last call to the Prepare() method.
+        ResampleStatus m_status;
+
+    };
+
+    /// @}
+
+    /// @}
+
+    /// @}
+
+  }
+
+}
+
+#endif
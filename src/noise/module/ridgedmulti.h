@@ -98,6 +98,12 @@ namespace noise
     /// An application may specify the number of octaves that generate
     /// ridged-multifractal noise by calling the SetOctaveCount() method.
     ///
+    /// Each octave is weighted by the signal of the previous octave, so to
+    /// add octaves to values it already calculated, an application must
+    /// keep this weight for each value.  The GetOctaveRangeValue() method
+    /// takes the weight left by the previous range of octaves and returns
+    /// the weight for the next range.
+    ///
     /// <b>Frequency</b>
     ///
     /// An application may specify the frequency of the first octave by
@@ -112,6 +118,14 @@ namespace noise
     /// with the lacunarity value to determine the effects.  For best results,
     /// set the lacunarity to a number between 1.5 and 3.5.
     ///
+    /// <b>Tiling</b>
+    ///
+    /// By default, ridged-multifractal noise does not repeat.  To generate a
+    /// texture that tiles, call the SetPeriod() method with the size of the
+    /// tile along each axis.  As with noise::module::Perlin, each octave
+    /// rounds its frequency so that a whole number of lattice cells fits
+    /// into each period.
+    ///
     /// <b>References &amp; Acknowledgments</b>
     ///
     /// <a href=http://www.texturingandmodeling.com/Musgrave.html>F.
@@ -164,6 +178,12 @@ namespace noise
           return m_lacunarity;
         }
 
+        virtual double GetMaxFrequency () const
+        {
+          // Taking the absolute value of an octave doubles its frequency.
+          return 2.0 * m_frequency * pow (m_lacunarity, m_octaveCount - 1);
+        }
+
         /// Returns the quality of the ridged-multifractal noise.
         ///
         /// @returns The quality of the ridged-multifractal noise.
@@ -188,6 +208,38 @@ namespace noise
           return m_octaveCount;
         }
 
+        /// Returns the sum of a range of octaves at the specified input
+        /// value.
+        ///
+        /// @param x The @a x coordinate of the input value.
+        /// @param y The @a y coordinate of the input value.
+        /// @param z The @a z coordinate of the input value.
+        /// @param firstOctave The first octave of the range.
+        /// @param lastOctave The octave after the last octave of the range.
+        /// @param weight On entry, the weight left by the range of octaves
+        /// that ended at @a firstOctave, or 1.0 if @a firstOctave is 0.  On
+        /// exit, the weight for the range of octaves that starts at
+        /// @a lastOctave.
+        ///
+        /// @returns The sum of the octaves from @a firstOctave up to, but
+        /// not including, @a lastOctave.
+        ///
+        /// @pre The first octave is no greater than the last octave.
+        /// @pre The last octave is no greater than
+        /// noise::module::RIDGED_MAX_OCTAVE.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The constant offset of the ridged-multifractal noise is part of
+        /// the range that starts at octave 0, so the sums of the ranges
+        /// [0, @a k) and [@a k, @a n) add up to the output value of this
+        /// noise module with @a n octaves, apart from floating-point
+        /// rounding.  The number of octaves set by SetOctaveCount() is
+        /// ignored.
+        double GetOctaveRangeValue (double x, double y, double z,
+          int firstOctave, int lastOctave, double& weight) const;
+
         /// Returns the seed value used by the ridged-multifractal-noise
         /// function.
         ///
@@ -204,6 +256,47 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        /// Returns the period of the ridged-multifractal noise along the
+        /// @a x axis.
+        ///
+        /// @returns The period along the @a x axis, or 0.0 if the
+        /// ridged-multifractal noise does not repeat along that axis.
+        double GetXPeriod () const
+        {
+          return m_xPeriod;
+        }
+
+        /// Returns the period of the ridged-multifractal noise along the
+        /// @a y axis.
+        ///
+        /// @returns The period along the @a y axis, or 0.0 if the
+        /// ridged-multifractal noise does not repeat along that axis.
+        double GetYPeriod () const
+        {
+          return m_yPeriod;
+        }
+
+        /// Returns the period of the ridged-multifractal noise along the
+        /// @a z axis.
+        ///
+        /// @returns The period along the @a z axis, or 0.0 if the
+        /// ridged-multifractal noise does not repeat along that axis.
+        double GetZPeriod () const
+        {
+          return m_zPeriod;
+        }
+
+        /// Determines if the ridged-multifractal noise repeats along at least
+        /// one axis.
+        ///
+        /// @returns
+        /// - @a true if a period was set along at least one axis.
+        /// - @a false if the ridged-multifractal noise does not repeat.
+        bool IsPeriodic () const
+        {
+          return m_xPeriod > 0.0 || m_yPeriod > 0.0 || m_zPeriod > 0.0;
+        }
+
         /// Sets the frequency of the first octave.
         ///
         /// @param frequency The frequency of the first octave.
@@ -263,6 +356,30 @@ namespace noise
           m_octaveCount = octaveCount;
         }
 
+        /// Sets the period of the ridged-multifractal noise along each axis.
+        ///
+        /// @param xPeriod The period along the @a x axis, or 0.0.
+        /// @param yPeriod The period along the @a y axis, or 0.0.
+        /// @param zPeriod The period along the @a z axis, or 0.0.
+        ///
+        /// @pre Each period is at least 0.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The output value repeats every @a xPeriod units along the @a x
+        /// axis, and so on for the other axes.  A period of 0.0 leaves that
+        /// axis unbounded, which is the default.
+        void SetPeriod (double xPeriod, double yPeriod, double zPeriod)
+        {
+          if (xPeriod < 0.0 || yPeriod < 0.0 || zPeriod < 0.0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_xPeriod = xPeriod;
+          m_yPeriod = yPeriod;
+          m_zPeriod = zPeriod;
+        }
+
         /// Sets the seed value used by the ridged-multifractal-noise
         /// function.
         ///
@@ -298,6 +415,15 @@ namespace noise
         /// Seed value used by the ridged-multfractal-noise function.
         int m_seed;
 
+        /// Period along the @a x axis, or 0.0 if it does not repeat.
+        double m_xPeriod;
+
+        /// Period along the @a y axis, or 0.0 if it does not repeat.
+        double m_yPeriod;
+
+        /// Period along the @a z axis, or 0.0 if it does not repeat.
+        double m_zPeriod;
+
     };
 
     /// @}
@@ -86,6 +86,11 @@ namespace noise
         /// set to noise::module::DEFAULT_ROTATE_Z.
         RotatePoint ();
 
+        virtual double GetMaxFrequency () const
+        {
+          return GetSourceMaxFrequency (0);
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
@@ -81,6 +81,11 @@ namespace noise
           return m_bias;
         }
 
+        virtual double GetMaxFrequency () const
+        {
+          return GetSourceMaxFrequency (0);
+        }
+
         /// Returns the scaling factor to apply to the output value from the
         /// source module.
         ///
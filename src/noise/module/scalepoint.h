@@ -82,6 +82,8 @@ namespace noise
         /// to noise::module::DEFAULT_SCALE_POINT_Z.
         ScalePoint ();
 
+        virtual double GetMaxFrequency () const;
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
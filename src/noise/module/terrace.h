@@ -180,6 +180,8 @@ namespace noise
         /// increases.  At the control points, its slope resets to zero.
         void MakeControlPoints (int controlPointCount);
 
+        virtual void SetAllocator (Allocator* pAllocator);
+
     	protected:
 
 	      /// Determines the array index in which to insert the control point
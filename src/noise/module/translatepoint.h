@@ -83,6 +83,11 @@ namespace noise
         /// set to noise::module::DEFAULT_TRANSLATE_POINT_Z.
         TranslatePoint ();
 
+        virtual double GetMaxFrequency () const
+        {
+          return GetSourceMaxFrequency (0);
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
@@ -179,6 +179,33 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        /// Returns the period of the turbulence along the @a x axis.
+        ///
+        /// @returns The period along the @a x axis, or 0.0 if the
+        /// displacement does not repeat along that axis.
+        double GetXPeriod () const
+        {
+          return m_xDistortModule.GetXPeriod ();
+        }
+
+        /// Returns the period of the turbulence along the @a y axis.
+        ///
+        /// @returns The period along the @a y axis, or 0.0 if the
+        /// displacement does not repeat along that axis.
+        double GetYPeriod () const
+        {
+          return m_xDistortModule.GetYPeriod ();
+        }
+
+        /// Returns the period of the turbulence along the @a z axis.
+        ///
+        /// @returns The period along the @a z axis, or 0.0 if the
+        /// displacement does not repeat along that axis.
+        double GetZPeriod () const
+        {
+          return m_xDistortModule.GetZPeriod ();
+        }
+
         /// Sets the frequency of the turbulence.
         ///
         /// @param frequency The frequency of the turbulence.
@@ -193,6 +220,28 @@ namespace noise
           m_zDistortModule.SetFrequency (frequency);
         }
 
+        /// Sets the period of the turbulence along each axis.
+        ///
+        /// @param xPeriod The period along the @a x axis, or 0.0.
+        /// @param yPeriod The period along the @a y axis, or 0.0.
+        /// @param zPeriod The period along the @a z axis, or 0.0.
+        ///
+        /// @pre Each period is at least 0.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The displacement then repeats every @a xPeriod units along the
+        /// @a x axis, and so on for the other axes.  The output value only
+        /// repeats if the source module repeats with the same periods.
+        void SetPeriod (double xPeriod, double yPeriod, double zPeriod)
+        {
+          // Set the period of each Perlin-noise module.
+          m_xDistortModule.SetPeriod (xPeriod, yPeriod, zPeriod);
+          m_yDistortModule.SetPeriod (xPeriod, yPeriod, zPeriod);
+          m_zDistortModule.SetPeriod (xPeriod, yPeriod, zPeriod);
+        }
+
         /// Sets the power of the turbulence.
         ///
         /// @param power The power of the turbulence.
@@ -86,6 +86,10 @@ namespace noise
     /// Voronoi cells are often used to generate cracked-mud terrain
     /// formations or crystal-like textures
     ///
+    /// To generate cells that tile, call the SetPeriod() method with the
+    /// size of the tile along each axis.  This noise module rounds the
+    /// frequency so that a whole number of cells fits into each period.
+    ///
     /// This noise module requires no source modules.
     class NOISE_EXPORT Voronoi : public Module
     {
@@ -179,6 +183,43 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        /// Returns the period of the Voronoi cells along the @a x axis.
+        ///
+        /// @returns The period along the @a x axis, or 0.0 if the
+        /// Voronoi cells do not repeat along that axis.
+        double GetXPeriod () const
+        {
+          return m_xPeriod;
+        }
+
+        /// Returns the period of the Voronoi cells along the @a y axis.
+        ///
+        /// @returns The period along the @a y axis, or 0.0 if the
+        /// Voronoi cells do not repeat along that axis.
+        double GetYPeriod () const
+        {
+          return m_yPeriod;
+        }
+
+        /// Returns the period of the Voronoi cells along the @a z axis.
+        ///
+        /// @returns The period along the @a z axis, or 0.0 if the
+        /// Voronoi cells do not repeat along that axis.
+        double GetZPeriod () const
+        {
+          return m_zPeriod;
+        }
+
+        /// Determines if the Voronoi cells repeat along at least one axis.
+        ///
+        /// @returns
+        /// - @a true if a period was set along at least one axis.
+        /// - @a false if the Voronoi cells do not repeat.
+        bool IsPeriodic () const
+        {
+          return m_xPeriod > 0.0 || m_yPeriod > 0.0 || m_zPeriod > 0.0;
+        }
+
         /// Sets the displacement value of the Voronoi cells.
         ///
         /// @param displacement The displacement value of the Voronoi cells.
@@ -203,6 +244,30 @@ namespace noise
           m_frequency = frequency;
         }
 
+        /// Sets the period of the Voronoi cells along each axis.
+        ///
+        /// @param xPeriod The period along the @a x axis, or 0.0.
+        /// @param yPeriod The period along the @a y axis, or 0.0.
+        /// @param zPeriod The period along the @a z axis, or 0.0.
+        ///
+        /// @pre Each period is at least 0.0.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The output value repeats every @a xPeriod units along the @a x
+        /// axis, and so on for the other axes.  A period of 0.0 leaves that
+        /// axis unbounded, which is the default.
+        void SetPeriod (double xPeriod, double yPeriod, double zPeriod)
+        {
+          if (xPeriod < 0.0 || yPeriod < 0.0 || zPeriod < 0.0) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_xPeriod = xPeriod;
+          m_yPeriod = yPeriod;
+          m_zPeriod = zPeriod;
+        }
+
         /// Sets the seed value used by the Voronoi cells
         ///
         /// @param seed The seed value.
@@ -231,6 +296,15 @@ namespace noise
         /// positions of the seed points.
         int m_seed;
 
+        /// Period along the @a x axis, or 0.0 if it does not repeat.
+        double m_xPeriod;
+
+        /// Period along the @a y axis, or 0.0 if it does not repeat.
+        double m_yPeriod;
+
+        /// Period along the @a z axis, or 0.0 if it does not repeat.
+        double m_zPeriod;
+
     };
 
     /// @}
@@ -66,6 +66,7 @@
 /// address is jlbezigvins@gmzigail.com (For great email, take off every
 /// <a href=http://www.planettribes.com/allyourbase/story.shtml>zig</a>.)
 
+#include "allocator.h"
 #include "module/module.h"
 #include "model/model.h"
 #include "misc.h"
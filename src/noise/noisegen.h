@@ -166,6 +166,91 @@ namespace noise
     }
   }
 
+  /// Scales a coordinate of an input value onto the lattice of a periodic
+  /// coherent-noise function.
+  ///
+  /// @param n The coordinate of the input value.
+  /// @param frequency The frequency of the coherent noise.
+  /// @param period The period of the coherent noise in input units, or 0.
+  /// @param latticePeriod On exit, the period of the lattice, to pass to
+  /// a periodic coherent-noise function, or 0 if the coordinate does not
+  /// repeat.
+  ///
+  /// @returns The coordinate on the lattice.
+  ///
+  /// A lattice can only repeat after a whole number of cells, so this
+  /// function rounds the number of cells in one period, @a period *
+  /// @a frequency, to the nearest whole number of at least 1, and adjusts
+  /// the frequency to fit.  The adjustment never exceeds half a cycle per
+  /// period, so it is barely visible.
+  ///
+  /// If @a period is 0, or so large that the number of cells would not fit
+  /// in a 32-bit integer, the coordinate does not repeat and this function
+  /// returns MakeInt32Range (@a n * @a frequency).
+  inline double MakePeriodicCoord (double n, double frequency, double period,
+    int& latticePeriod)
+  {
+    latticePeriod = 0;
+    if (period > 0.0) {
+      double cellCount = floor (period * frequency + 0.5);
+      if (cellCount < 1073741824.0) {
+        latticePeriod = (cellCount < 1.0)? 1: (int)cellCount;
+        return n * (double)latticePeriod / period;
+      }
+    }
+    return MakeInt32Range (n * frequency);
+  }
+
+  /// Generates a gradient-coherent-noise value that repeats along each
+  /// axis from the coordinates of a three-dimensional input value.
+  ///
+  /// @param x The @a x coordinate of the input value.
+  /// @param y The @a y coordinate of the input value.
+  /// @param z The @a z coordinate of the input value.
+  /// @param xPeriod The period along the @a x axis, or 0.
+  /// @param yPeriod The period along the @a y axis, or 0.
+  /// @param zPeriod The period along the @a z axis, or 0.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @returns The generated gradient-coherent-noise value.
+  ///
+  /// @pre Each period is at least 0.
+  ///
+  /// The return value ranges from -1.0 to +1.0.
+  ///
+  /// The integer coordinates of the lattice wrap around modulo each
+  /// nonzero period, so adding the period to a coordinate of the input
+  /// value does not change the output value.  A period of 0 leaves that
+  /// axis unbounded, as in GradientCoherentNoise3D().  Along an unbounded
+  /// axis, pass the coordinate through MakeInt32Range() first.
+  double PeriodicGradientCoherentNoise3D (double x, double y, double z,
+    int xPeriod, int yPeriod, int zPeriod, int seed = 0,
+    NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Generates a value-coherent-noise value that repeats along each axis
+  /// from the coordinates of a three-dimensional input value.
+  ///
+  /// @param x The @a x coordinate of the input value.
+  /// @param y The @a y coordinate of the input value.
+  /// @param z The @a z coordinate of the input value.
+  /// @param xPeriod The period along the @a x axis, or 0.
+  /// @param yPeriod The period along the @a y axis, or 0.
+  /// @param zPeriod The period along the @a z axis, or 0.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @returns The generated value-coherent-noise value.
+  ///
+  /// @pre Each period is at least 0.
+  ///
+  /// The return value ranges from -1.0 to +1.0.
+  ///
+  /// See PeriodicGradientCoherentNoise3D() for the meaning of the periods.
+  double PeriodicValueCoherentNoise3D (double x, double y, double z,
+    int xPeriod, int yPeriod, int zPeriod, int seed = 0,
+    NoiseQuality noiseQuality = QUALITY_STD);
+
   /// Generates a value-coherent-noise value from the coordinates of a
   /// three-dimensional input value.
   ///
@@ -201,6 +286,38 @@ namespace noise
   /// to it.
   double ValueNoise3D (int x, int y, int z, int seed = 0);
 
+  /// Wraps an integer lattice coordinate into the first period.
+  ///
+  /// @param n The lattice coordinate.
+  /// @param period The period of the lattice, or 0.
+  ///
+  /// @returns The lattice coordinate modulo @a period, which is at least 0
+  /// and less than @a period, or @a n itself if @a period is 0.
+  inline int WrapLatticeCoord (int n, int period)
+  {
+    if (period <= 0) {
+      return n;
+    }
+    int wrapped = n % period;
+    return (wrapped < 0)? wrapped + period: wrapped;
+  }
+
+  /// Moves a coordinate of an input value into the first period of a
+  /// periodic lattice.
+  ///
+  /// @param n The coordinate on the lattice.
+  /// @param period The period of the lattice, or 0.
+  ///
+  /// @returns The coordinate modulo @a period, or @a n itself if @a period
+  /// is 0.
+  inline double WrapPeriodicCoord (double n, int period)
+  {
+    if (period <= 0) {
+      return n;
+    }
+    return n - floor (n / (double)period) * (double)period;
+  }
+
   /// @}
 
 }
@@ -55,6 +55,58 @@ const int SEED_NOISE_GEN = 1013;
 const int SHIFT_NOISE_GEN = 8;
 #endif
 
+// Generates a gradient-noise value like GradientNoise3D(), but takes the
+// gradient vector from the lattice point (hx, hy, hz) rather than from
+// (ix, iy, iz).  A periodic lattice passes the wrapped coordinates of the
+// lattice point as (hx, hy, hz).
+static inline double LatticeGradientNoise3D (double fx, double fy,
+  double fz, int ix, int iy, int iz, int hx, int hy, int hz, int seed)
+{
+  // Randomly generate a gradient vector given the integer coordinates of the
+  // input value.  This implementation generates a random number and uses it
+  // as an index into a normalized-vector lookup table.
+  int vectorIndex = (
+      X_NOISE_GEN    * hx
+    + Y_NOISE_GEN    * hy
+    + Z_NOISE_GEN    * hz
+    + SEED_NOISE_GEN * seed)
+    & 0xffffffff;
+  vectorIndex ^= (vectorIndex >> SHIFT_NOISE_GEN);
+  vectorIndex &= 0xff;
+
+  double xvGradient = g_randomVectors[(vectorIndex << 2)    ];
+  double yvGradient = g_randomVectors[(vectorIndex << 2) + 1];
+  double zvGradient = g_randomVectors[(vectorIndex << 2) + 2];
+
+  // Set up us another vector equal to the distance between the two vectors
+  // passed to this function.
+  double xvPoint = (fx - (double)ix);
+  double yvPoint = (fy - (double)iy);
+  double zvPoint = (fz - (double)iz);
+
+  // Now compute the dot product of the gradient vector with the distance
+  // vector.  The resulting value is gradient noise.  Apply a scaling value
+  // so that this noise value ranges from -1.0 to 1.0.
+  return ((xvGradient * xvPoint)
+    + (yvGradient * yvPoint)
+    + (zvGradient * zvPoint)) * 2.12;
+}
+
+// Maps the position of the input value within a lattice cell onto an
+// S-curve for the given noise quality.
+static inline double MapSCurve (double a, NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_FAST:
+      return a;
+    case QUALITY_STD:
+      return SCurve3 (a);
+    case QUALITY_BEST:
+      return SCurve5 (a);
+  }
+  return 0.0;
+}
+
 double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
   NoiseQuality noiseQuality)
 {
@@ -114,34 +166,7 @@ double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
 double noise::GradientNoise3D (double fx, double fy, double fz, int ix,
   int iy, int iz, int seed)
 {
-  // Randomly generate a gradient vector given the integer coordinates of the
-  // input value.  This implementation generates a random number and uses it
-  // as an index into a normalized-vector lookup table.
-  int vectorIndex = (
-      X_NOISE_GEN    * ix
-    + Y_NOISE_GEN    * iy
-    + Z_NOISE_GEN    * iz
-    + SEED_NOISE_GEN * seed)
-    & 0xffffffff;
-  vectorIndex ^= (vectorIndex >> SHIFT_NOISE_GEN);
-  vectorIndex &= 0xff;
-
-  double xvGradient = g_randomVectors[(vectorIndex << 2)    ];
-  double yvGradient = g_randomVectors[(vectorIndex << 2) + 1];
-  double zvGradient = g_randomVectors[(vectorIndex << 2) + 2];
-
-  // Set up us another vector equal to the distance between the two vectors
-  // passed to this function.
-  double xvPoint = (fx - (double)ix);
-  double yvPoint = (fy - (double)iy);
-  double zvPoint = (fz - (double)iz);
-
-  // Now compute the dot product of the gradient vector with the distance
-  // vector.  The resulting value is gradient noise.  Apply a scaling value
-  // so that this noise value ranges from -1.0 to 1.0.
-  return ((xvGradient * xvPoint)
-    + (yvGradient * yvPoint)
-    + (zvGradient * zvPoint)) * 2.12;
+  return LatticeGradientNoise3D (fx, fy, fz, ix, iy, iz, ix, iy, iz, seed);
 }
 
 int noise::IntValueNoise3D (int x, int y, int z, int seed)
@@ -158,6 +183,96 @@ int noise::IntValueNoise3D (int x, int y, int z, int seed)
   return (n * (n * n * 60493 + 19990303) + 1376312589) & 0x7fffffff;
 }
 
+double noise::PeriodicGradientCoherentNoise3D (double x, double y,
+  double z, int xPeriod, int yPeriod, int zPeriod, int seed,
+  NoiseQuality noiseQuality)
+{
+  // Move the input value into the first period, then create a unit-length
+  // cube aligned along an integer boundary that surrounds it.  The
+  // gradient vectors are taken from the wrapped lattice points, so a cube
+  // at the end of a period uses the vectors at the start of the period.
+  x = WrapPeriodicCoord (x, xPeriod);
+  y = WrapPeriodicCoord (y, yPeriod);
+  z = WrapPeriodicCoord (z, zPeriod);
+  int x0 = (x > 0.0? (int)x: (int)x - 1);
+  int x1 = x0 + 1;
+  int y0 = (y > 0.0? (int)y: (int)y - 1);
+  int y1 = y0 + 1;
+  int z0 = (z > 0.0? (int)z: (int)z - 1);
+  int z1 = z0 + 1;
+  int hx0 = WrapLatticeCoord (x0, xPeriod);
+  int hx1 = WrapLatticeCoord (x1, xPeriod);
+  int hy0 = WrapLatticeCoord (y0, yPeriod);
+  int hy1 = WrapLatticeCoord (y1, yPeriod);
+  int hz0 = WrapLatticeCoord (z0, zPeriod);
+  int hz1 = WrapLatticeCoord (z1, zPeriod);
+
+  double xs = MapSCurve (x - (double)x0, noiseQuality);
+  double ys = MapSCurve (y - (double)y0, noiseQuality);
+  double zs = MapSCurve (z - (double)z0, noiseQuality);
+
+  // Interpolate the noise values at the vertices of the cube, as
+  // GradientCoherentNoise3D() does.
+  double n0, n1, ix0, ix1, iy0, iy1;
+  n0  = LatticeGradientNoise3D (x, y, z, x0, y0, z0, hx0, hy0, hz0, seed);
+  n1  = LatticeGradientNoise3D (x, y, z, x1, y0, z0, hx1, hy0, hz0, seed);
+  ix0 = LinearInterp (n0, n1, xs);
+  n0  = LatticeGradientNoise3D (x, y, z, x0, y1, z0, hx0, hy1, hz0, seed);
+  n1  = LatticeGradientNoise3D (x, y, z, x1, y1, z0, hx1, hy1, hz0, seed);
+  ix1 = LinearInterp (n0, n1, xs);
+  iy0 = LinearInterp (ix0, ix1, ys);
+  n0  = LatticeGradientNoise3D (x, y, z, x0, y0, z1, hx0, hy0, hz1, seed);
+  n1  = LatticeGradientNoise3D (x, y, z, x1, y0, z1, hx1, hy0, hz1, seed);
+  ix0 = LinearInterp (n0, n1, xs);
+  n0  = LatticeGradientNoise3D (x, y, z, x0, y1, z1, hx0, hy1, hz1, seed);
+  n1  = LatticeGradientNoise3D (x, y, z, x1, y1, z1, hx1, hy1, hz1, seed);
+  ix1 = LinearInterp (n0, n1, xs);
+  iy1 = LinearInterp (ix0, ix1, ys);
+
+  return LinearInterp (iy0, iy1, zs);
+}
+
+double noise::PeriodicValueCoherentNoise3D (double x, double y, double z,
+  int xPeriod, int yPeriod, int zPeriod, int seed, NoiseQuality noiseQuality)
+{
+  // Move the input value into the first period and find the cube around
+  // it, as PeriodicGradientCoherentNoise3D() does.  Value noise only
+  // depends on the lattice points, so only the wrapped points are needed.
+  x = WrapPeriodicCoord (x, xPeriod);
+  y = WrapPeriodicCoord (y, yPeriod);
+  z = WrapPeriodicCoord (z, zPeriod);
+  int x0 = (x > 0.0? (int)x: (int)x - 1);
+  int y0 = (y > 0.0? (int)y: (int)y - 1);
+  int z0 = (z > 0.0? (int)z: (int)z - 1);
+  int hx0 = WrapLatticeCoord (x0    , xPeriod);
+  int hx1 = WrapLatticeCoord (x0 + 1, xPeriod);
+  int hy0 = WrapLatticeCoord (y0    , yPeriod);
+  int hy1 = WrapLatticeCoord (y0 + 1, yPeriod);
+  int hz0 = WrapLatticeCoord (z0    , zPeriod);
+  int hz1 = WrapLatticeCoord (z0 + 1, zPeriod);
+
+  double xs = MapSCurve (x - (double)x0, noiseQuality);
+  double ys = MapSCurve (y - (double)y0, noiseQuality);
+  double zs = MapSCurve (z - (double)z0, noiseQuality);
+
+  double n0, n1, ix0, ix1, iy0, iy1;
+  n0  = ValueNoise3D (hx0, hy0, hz0, seed);
+  n1  = ValueNoise3D (hx1, hy0, hz0, seed);
+  ix0 = LinearInterp (n0, n1, xs);
+  n0  = ValueNoise3D (hx0, hy1, hz0, seed);
+  n1  = ValueNoise3D (hx1, hy1, hz0, seed);
+  ix1 = LinearInterp (n0, n1, xs);
+  iy0 = LinearInterp (ix0, ix1, ys);
+  n0  = ValueNoise3D (hx0, hy0, hz1, seed);
+  n1  = ValueNoise3D (hx1, hy0, hz1, seed);
+  ix0 = LinearInterp (n0, n1, xs);
+  n0  = ValueNoise3D (hx0, hy1, hz1, seed);
+  n1  = ValueNoise3D (hx1, hy1, hz1, seed);
+  ix1 = LinearInterp (n0, n1, xs);
+  iy1 = LinearInterp (ix0, ix1, ys);
+  return LinearInterp (iy0, iy1, zs);
+}
+
 double noise::ValueCoherentNoise3D (double x, double y, double z, int seed,
   NoiseQuality noiseQuality)
 {